@@ -0,0 +1,204 @@
+#pragma once
+
+// Engine
+#include <DECore/Container/HashMap.h>
+#include <DECore/Container/RingBuffer.h>
+#include <DECore/Container/StableVector.h>
+#include <DECore/Memory/Handle.h>
+// Cpp
+#include <assert.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace DE
+{
+
+/** @brief	K is the key, V is the item, Hash and Equal are function objects of the key
+*		A hash map shared by many threads, e.g. an asset cache filled by loader jobs.
+*		Buckets are singly linked lists whose nodes are published with a release store,
+*		so Find() never locks. Inserting locks one of STRIPE_NUM mutexes chosen by the
+*		bucket, so only inserts into buckets of the same stripe serialize. Nodes are
+*		appended to a StableVector instead of allocated one by one. The map is insert
+*		only and the bucket count is fixed at construction: items never move and the
+*		returned pointers stay valid until Clear() or destruction
+*/
+template <class K, class V, class Hash = DefaultHash<K>, class Equal = DefaultEqual<K>>
+class ConcurrentHashMap
+{
+	static constexpr uint32_t STRIPE_NUM = 64;
+
+	struct Node
+	{
+		template <class Q, class... Args>
+		Node(size_t hashed, Q&& key, Args&&... args)
+			: m_iHash(hashed)
+			, m_Key(std::forward<Q>(key))
+			, m_Item(std::forward<Args>(args)...)
+		{}
+
+		std::atomic<Node*>	m_pNext = { nullptr };
+		size_t				m_iHash;
+		K					m_Key;
+		V					m_Item;
+	};
+
+	struct alignas(CACHE_LINE_SIZE) Stripe
+	{
+		std::mutex			m_Mutex;
+	};
+
+public:
+
+	/** @brief	Construct the map with a fixed number of buckets, size it to the expected
+	*		number of items as the lists only get longer beyond that
+	*
+	*	@param bucketNum: rounded up to power of two
+	*/
+	explicit ConcurrentHashMap(uint32_t bucketNum = 1024)
+	{
+		m_iBucketNum = 1;
+		while (m_iBucketNum < bucketNum)
+		{
+			m_iBucketNum <<= 1;
+		}
+		m_hBuckets.Set(sizeof(std::atomic<Node*>) * m_iBucketNum, alignof(std::atomic<Node*>), MemoryTag::Container);
+		m_pBuckets = reinterpret_cast<std::atomic<Node*>*>(m_hBuckets.Raw());
+		assert(m_pBuckets && "out of memory");
+		for (uint32_t i = 0; i < m_iBucketNum; ++i)
+		{
+			new (&m_pBuckets[i]) std::atomic<Node*>(nullptr);
+		}
+	}
+
+	ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+	ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+	/** @brief Destroy the items and free the memory, no thread may be using the map */
+	~ConcurrentHashMap()
+	{
+		Clear();
+		m_hBuckets.Free();
+	}
+
+	/** @brief	Return the item of a key without locking, thread safe
+	*
+	*	@param key: the key
+	*	@return V*: the item, nullptr if not found
+	*/
+	V* Find(const K& key) const
+	{
+		const size_t hashed = m_Hash(key);
+		Node* pNode = find(m_pBuckets[hashed & (m_iBucketNum - 1)].load(std::memory_order_acquire), hashed, key);
+		return pNode ? &pNode->m_Item : nullptr;
+	}
+
+	/** @brief Return whether the map contains the key, thread safe */
+	bool Contain(const K& key) const
+	{
+		return Find(key) != nullptr;
+	}
+
+	/** @brief	Return the item of a key, constructing it from args if no thread did yet.
+	*		The item is published after its constructor returns, expensive work should be
+	*		done after insertion by the caller that got true, not in the constructor
+	*
+	*	@param key: the key
+	*	@param args: the parameter forward to V's constructor
+	*	@return pair of the item, and true if this call inserted it
+	*/
+	template <class Q, class... Args>
+	std::pair<V*, bool> FindOrInsert(Q&& key, Args&&... args)
+	{
+		const size_t hashed = m_Hash(key);
+		const uint32_t bucketIndex = static_cast<uint32_t>(hashed & (m_iBucketNum - 1));
+		std::atomic<Node*>& bucket = m_pBuckets[bucketIndex];
+		Node* pHead = bucket.load(std::memory_order_acquire);
+		if (Node* pNode = find(pHead, hashed, key))
+		{
+			return { &pNode->m_Item, false };
+		}
+
+		// every insert to a bucket takes the same stripe
+		std::lock_guard<std::mutex> lock(m_Stripes[bucketIndex % STRIPE_NUM].m_Mutex);
+		// only nodes prepended since the first search need to be checked again
+		Node* pNewHead = bucket.load(std::memory_order_acquire);
+		for (Node* pNode = pNewHead; pNode != pHead; pNode = pNode->m_pNext.load(std::memory_order_acquire))
+		{
+			if (pNode->m_iHash == hashed && m_Equal(pNode->m_Key, key))
+			{
+				return { &pNode->m_Item, false };
+			}
+		}
+
+		Node* pNode = &m_Nodes.emplace_back(hashed, std::forward<Q>(key), std::forward<Args>(args)...);
+		pNode->m_pNext.store(pNewHead, std::memory_order_relaxed);
+		bucket.store(pNode, std::memory_order_release);
+		m_iSize.fetch_add(1, std::memory_order_relaxed);
+		return { &pNode->m_Item, true };
+	}
+
+	/** @brief Return the number of items, thread safe */
+	uint32_t Size() const
+	{
+		return m_iSize.load(std::memory_order_relaxed);
+	}
+
+	/** @brief Return the number of buckets */
+	uint32_t BucketNum() const
+	{
+		return m_iBucketNum;
+	}
+
+	/** @brief	Iterate all pairs, must not run concurrently with FindOrInsert
+	*
+	*	@param func function taking (const K&, V&), called in insertion order
+	*/
+	template <class Func>
+	void ForEachPair(Func&& func)
+	{
+		for (Node& node : m_Nodes)
+		{
+			func(static_cast<const K&>(node.m_Key), node.m_Item);
+		}
+	}
+
+	/** @brief Destroy all items, the node memory is kept for reuse. No thread may be using the map */
+	void Clear()
+	{
+		for (uint32_t i = 0; i < m_iBucketNum; ++i)
+		{
+			m_pBuckets[i].store(nullptr, std::memory_order_relaxed);
+		}
+		m_Nodes.clear();
+		m_iSize.store(0, std::memory_order_relaxed);
+	}
+
+private:
+
+	template <class Q>
+	Node* find(Node* pNode, size_t hashed, const Q& key) const
+	{
+		for (; pNode != nullptr; pNode = pNode->m_pNext.load(std::memory_order_acquire))
+		{
+			if (pNode->m_iHash == hashed && m_Equal(pNode->m_Key, key))
+			{
+				return pNode;
+			}
+		}
+		return nullptr;
+	}
+
+	Handle						m_hBuckets;				// the memory of the bucket heads
+	std::atomic<Node*>*			m_pBuckets = nullptr;	// the cached pointer to the bucket heads
+	uint32_t					m_iBucketNum = 0;		// number of buckets, power of two
+	std::atomic<uint32_t>		m_iSize = { 0 };		// number of items
+	StableVector<Node>			m_Nodes;				// the nodes in insertion order, never moved
+	Stripe						m_Stripes[STRIPE_NUM];	// the insert locks
+	Hash						m_Hash;
+	Equal						m_Equal;
+};
+
+} // namespace DE
@@ -0,0 +1,451 @@
+#pragma once
+
+// Engine
+#include <DECore/Container/Vector.h>
+// Cpp
+#include <assert.h>
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define DE_FLATMAP_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+#define DE_FLATMAP_PREFETCH(address)
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace DE
+{
+
+namespace detail
+{
+
+/** @brief	The sorted keys of FlatMap and FlatSet and the search over them. Up to
+*		EYTZINGER_MIN_SIZE keys are searched with a branchless lower bound on the sorted
+*		array, which touches log2(n) keys but only a few cache lines while the array is
+*		small. From EYTZINGER_MIN_SIZE keys a copy in Eytzinger (breadth first) order is
+*		kept as well: the keys compared by a search are then packed at the front of the
+*		array and the ones four levels down share a cache line, which is prefetched
+*/
+template <class K, class Less>
+class FlatKeys
+{
+public:
+
+	static constexpr uint32_t EYTZINGER_MIN_SIZE = 1024;
+
+	FlatKeys() = default;
+	FlatKeys(FlatKeys&&) = default;
+	FlatKeys& operator=(FlatKeys&&) = default;
+
+	inline size_t Size() const
+	{
+		return m_Sorted.size();
+	}
+
+	inline const K& operator[](size_t index) const
+	{
+		return m_Sorted.data()[index];
+	}
+
+	void Reserve(size_t num)
+	{
+		m_Sorted.reserve(num);
+	}
+
+	/** @brief Return the index of the first key not less than the key, Size() if none */
+	template <class Q>
+	uint32_t LowerBound(const Q& key) const
+	{
+		if (m_Eytzinger.empty())
+		{
+			return lowerBoundSorted(key);
+		}
+		return lowerBoundEytzinger(key);
+	}
+
+	/** @brief Return the index of the key, Size() if it does not exist */
+	template <class Q>
+	uint32_t IndexOf(const Q& key) const
+	{
+		const uint32_t index = LowerBound(key);
+		return index < Size() && !Less()(key, m_Sorted.data()[index]) ? index : static_cast<uint32_t>(Size());
+	}
+
+	/** @brief Insert a key at its sorted index, which must come from LowerBound */
+	template <class Q>
+	void Insert(uint32_t index, Q&& key)
+	{
+		m_Sorted.emplace(m_Sorted.begin() + index, std::forward<Q>(key));
+		rebuildEytzinger();
+	}
+
+	void Erase(uint32_t index)
+	{
+		m_Sorted.erase(m_Sorted.begin() + index);
+		rebuildEytzinger();
+	}
+
+	/** @brief Take unsorted keys, return the order to apply to their items: order[i] is the old index of sorted key i */
+	Vector<uint32_t> Build(Vector<K>&& keys)
+	{
+		Vector<uint32_t> order(keys.size());
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+		}
+		K* pKeys = keys.data();
+		std::sort(order.begin(), order.end(), [pKeys](uint32_t lhs, uint32_t rhs) { return Less()(pKeys[lhs], pKeys[rhs]); });
+
+		m_Sorted.clear();
+		m_Sorted.reserve(keys.size());
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			assert((i == 0 || Less()(m_Sorted.back(), pKeys[order[i]])) && "this key exists");
+			m_Sorted.push_back(std::move(pKeys[order[i]]));
+		}
+		keys.clear();
+		rebuildEytzinger();
+		return order;
+	}
+
+	void Clear()
+	{
+		m_Sorted.clear();
+		m_Eytzinger.clear();
+		m_EytzingerToSorted.clear();
+	}
+
+private:
+
+	template <class Q>
+	uint32_t lowerBoundSorted(const Q& key) const
+	{
+		const K* pBase = m_Sorted.data();
+		size_t num = m_Sorted.size();
+		if (num == 0)
+		{
+			return 0;
+		}
+		// the answer stays in [pBase, pBase + num], the select compiles to a conditional move
+		while (num > 1)
+		{
+			const size_t half = num / 2;
+			pBase = Less()(pBase[half], key) ? pBase + half : pBase;
+			num -= half;
+		}
+		return static_cast<uint32_t>(pBase - m_Sorted.data()) + (Less()(*pBase, key) ? 1 : 0);
+	}
+
+	template <class Q>
+	uint32_t lowerBoundEytzinger(const Q& key) const
+	{
+		const K* pKeys = m_Eytzinger.data();	// 1-based, node k has children 2k and 2k + 1
+		const uint32_t num = static_cast<uint32_t>(m_Sorted.size());
+		uint32_t k = 1;
+		while (k <= num)
+		{
+			if (16 * k <= num)
+			{
+				DE_FLATMAP_PREFETCH(pKeys + 16 * k);
+			}
+			k = 2 * k + (Less()(pKeys[k], key) ? 1 : 0);
+		}
+		// the answer is where the search last went left: drop the trailing right turns and that left turn
+		k >>= trailingZero(~k) + 1;
+		return k == 0 ? num : m_EytzingerToSorted.data()[k];
+	}
+
+	static uint32_t trailingZero(uint32_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+	}
+
+	/** @brief Fill the Eytzinger node k and its subtree in order from sorted index i, return the next sorted index */
+	uint32_t fillEytzinger(uint32_t i, uint32_t k)
+	{
+		const uint32_t num = static_cast<uint32_t>(m_Sorted.size());
+		if (k <= num)
+		{
+			i = fillEytzinger(i, 2 * k);
+			m_Eytzinger[k] = m_Sorted.data()[i];
+			m_EytzingerToSorted[k] = i;
+			i = fillEytzinger(i + 1, 2 * k + 1);
+		}
+		return i;
+	}
+
+	void rebuildEytzinger()
+	{
+		if (m_Sorted.size() < EYTZINGER_MIN_SIZE)
+		{
+			m_Eytzinger.clear();
+			m_EytzingerToSorted.clear();
+			return;
+		}
+		m_Eytzinger.resize(m_Sorted.size() + 1);
+		m_EytzingerToSorted.resize(m_Sorted.size() + 1);
+		fillEytzinger(0, 1);
+	}
+
+	Vector<K>			m_Sorted;				// the keys in ascending order
+	Vector<K>			m_Eytzinger;			// the keys in breadth first order from index 1, empty below EYTZINGER_MIN_SIZE
+	Vector<uint32_t>	m_EytzingerToSorted;	// the sorted index of each Eytzinger node
+};
+
+} // namespace detail
+
+/** @brief	K is the key, V is the item, Less is the function object ordering the keys
+*		A map stored as sorted contiguous arrays, for small to medium tables that are
+*		read far more often than written, e.g. ids to resources looked up per draw.
+*		Keys and items live in separate arrays so a lookup compares keys only and
+*		touches the item once; small maps fit the keys in one or two cache lines.
+*		Find is O(log n) without branching on the keys, Add and Remove are O(n) as
+*		they shift the arrays: fill a large map with Build instead
+*/
+template <class K, class V, class Less = std::less<K>>
+class FlatMap
+{
+public:
+
+	/** @brief Construct an empty map, no memory is allocated until the first Add or Build */
+	FlatMap() = default;
+	FlatMap(FlatMap&&) = default;
+	FlatMap& operator=(FlatMap&&) = default;
+
+	/** @brief Return the number of pairs */
+	inline size_t Size() const
+	{
+		return m_Keys.Size();
+	}
+
+	/** @brief Make room for the number of pairs */
+	void Reserve(size_t num)
+	{
+		m_Keys.Reserve(num);
+		m_Items.reserve(num);
+	}
+
+	/** @brief	Replace the content with unsorted pairs in one sort, assert on duplicated keys
+	*
+	*	@param keys: the keys, taken
+	*	@param items: items[i] is paired with keys[i], taken
+	*/
+	void Build(Vector<K>&& keys, Vector<V>&& items)
+	{
+		assert(keys.size() == items.size());
+		const Vector<uint32_t> order = m_Keys.Build(std::move(keys));
+		m_Items.clear();
+		m_Items.reserve(order.size());
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			m_Items.push_back(std::move(items[order[i]]));
+		}
+		items.clear();
+	}
+
+	/** @brief	Add a pair, assert if the key exists
+	*
+	*	@param key: the key paired with this item
+	*	@param item: the item to be added
+	*	@return V&: the item stored
+	*/
+	template <class Q, class T>
+	V& Add(Q&& key, T&& item)
+	{
+		const uint32_t index = m_Keys.LowerBound(key);
+		assert((index == Size() || Less()(key, m_Keys[index])) && "this key exists");
+		m_Keys.Insert(index, std::forward<Q>(key));
+		return *m_Items.emplace(m_Items.begin() + index, std::forward<T>(item));
+	}
+
+	/** @brief	Remove the pair with the key, assert if it does not exist
+	*
+	*	@param key: the key
+	*/
+	void Remove(const K& key)
+	{
+		const uint32_t index = m_Keys.IndexOf(key);
+		assert(index != Size() && "this key does not exist");
+		m_Keys.Erase(index);
+		m_Items.erase(m_Items.begin() + index);
+	}
+
+	/** @brief Destroy all pairs, keeping the allocated arrays */
+	void Clear()
+	{
+		m_Keys.Clear();
+		m_Items.clear();
+	}
+
+	/** @brief	Check if this map contains a pair with the key
+	*
+	*	@param key: the key
+	*	@return bool: True if the key exists
+	*/
+	bool Contain(const K& key) const
+	{
+		return m_Keys.IndexOf(key) != Size();
+	}
+
+	/** @brief	Return the item of the key, nullptr if it does not exist
+	*
+	*	@param key: the key
+	*	@return V*: the item, or nullptr
+	*/
+	V* Find(const K& key)
+	{
+		const uint32_t index = m_Keys.IndexOf(key);
+		return index != Size() ? &m_Items[index] : nullptr;
+	}
+	const V* Find(const K& key) const
+	{
+		return const_cast<FlatMap*>(this)->Find(key);
+	}
+
+	/** @brief	Return the item of the key, assert if it does not exist
+	*
+	*	@param key: the key
+	*	@return V&: the item associated with the key
+	*/
+	V& operator[](const K& key)
+	{
+		V* pItem = Find(key);
+		assert(pItem && "this key does not exist");
+		return *pItem;
+	}
+
+	/** @brief	Run the function with every item in key order
+	*
+	*	@param function: called as function(V&), can be a lambda, function pointer or function object
+	*/
+	template <typename F>
+	void ForEachItem(F function)
+	{
+		for (V& item : m_Items)
+		{
+			function(item);
+		}
+	}
+
+	/** @brief	Run the function with every pair in key order
+	*
+	*	@param function: called as function(const K&, V&), can be a lambda, function pointer or function object
+	*/
+	template <typename F>
+	void ForEachPair(F function)
+	{
+		for (uint32_t i = 0; i < Size(); ++i)
+		{
+			function(m_Keys[i], m_Items[i]);
+		}
+	}
+
+private:
+
+	detail::FlatKeys<K, Less>	m_Keys;		// the sorted keys and the search over them
+	Vector<V>					m_Items;	// m_Items[i] is paired with m_Keys[i]
+};
+
+/** @brief	K is the key, Less is the function object ordering the keys
+*		A set stored as a sorted contiguous array, see FlatMap
+*/
+template <class K, class Less = std::less<K>>
+class FlatSet
+{
+public:
+
+	/** @brief Construct an empty set, no memory is allocated until the first Add or Build */
+	FlatSet() = default;
+	FlatSet(FlatSet&&) = default;
+	FlatSet& operator=(FlatSet&&) = default;
+
+	/** @brief Return the number of keys */
+	inline size_t Size() const
+	{
+		return m_Keys.Size();
+	}
+
+	/** @brief Make room for the number of keys */
+	void Reserve(size_t num)
+	{
+		m_Keys.Reserve(num);
+	}
+
+	/** @brief	Replace the content with unsorted keys in one sort, assert on duplicated keys
+	*
+	*	@param keys: the keys, taken
+	*/
+	void Build(Vector<K>&& keys)
+	{
+		m_Keys.Build(std::move(keys));
+	}
+
+	/** @brief	Add a key, assert if it exists
+	*
+	*	@param key: the key
+	*/
+	template <class Q>
+	void Add(Q&& key)
+	{
+		const uint32_t index = m_Keys.LowerBound(key);
+		assert((index == Size() || Less()(key, m_Keys[index])) && "this key exists");
+		m_Keys.Insert(index, std::forward<Q>(key));
+	}
+
+	/** @brief	Remove a key, assert if it does not exist
+	*
+	*	@param key: the key
+	*/
+	void Remove(const K& key)
+	{
+		const uint32_t index = m_Keys.IndexOf(key);
+		assert(index != Size() && "this key does not exist");
+		m_Keys.Erase(index);
+	}
+
+	/** @brief Remove all keys, keeping the allocated array */
+	void Clear()
+	{
+		m_Keys.Clear();
+	}
+
+	/** @brief	Check if this set contains the key
+	*
+	*	@param key: the key
+	*	@return bool: True if the key exists
+	*/
+	bool Contain(const K& key) const
+	{
+		return m_Keys.IndexOf(key) != Size();
+	}
+
+	/** @brief	Run the function with every key in order
+	*
+	*	@param function: called as function(const K&), can be a lambda, function pointer or function object
+	*/
+	template <typename F>
+	void ForEach(F function) const
+	{
+		for (uint32_t i = 0; i < Size(); ++i)
+		{
+			function(m_Keys[i]);
+		}
+	}
+
+private:
+
+	detail::FlatKeys<K, Less>	m_Keys;		// the sorted keys and the search over them
+};
+
+} // namespace DE
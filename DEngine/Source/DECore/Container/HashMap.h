@@ -2,340 +2,519 @@
 
 // Engine include
 #include <DECore/Memory/Handle.h>
-#include "Vector.h"
+#include <DECore/String/StringId.h>
 
 // C++ include
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
 #include <functional>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DE_HASHMAP_SSE2 1
+#else
+#define DE_HASHMAP_SSE2 0
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace DE
 {
 
-/*
-*	TEMPLATE CLASS: MyHashMap
-*	T is the class of the item to be stored
-*	This is the default C string hash map to be used in DEngine, it behaves in similar
-*	way as std::unordered_map. The key is a C string (i.e. char*) and the item is 
-*	any class provided. This uses a djb2 hash function and by default allocated 157 
-*	spaces for the item. This uses linear probing to resolve collision. It is strongly 
-*	recommended to use this class instead of std::unordered_map or other STL data 
-*	structure to keep clean record of memory usage and avoid dynamic memory allocation 
-*	during gameplay
-*	Use Add to insert a new pair, DO NOT use operator[] to insert
+/** @brief Transparent string hash (64-bit FNV-1a), lets a map keyed by std::string be
+*		searched with std::string_view or a C string without constructing a key
 */
-template <class T>
+struct StringHash
+{
+	using is_transparent = void;
+
+	size_t operator()(std::string_view str) const
+	{
+		return static_cast<size_t>(HashString(str));
+	}
+};
+
+/** @brief Transparent string equality, pairs with StringHash */
+struct StringEqual
+{
+	using is_transparent = void;
+
+	bool operator()(std::string_view lhs, std::string_view rhs) const
+	{
+		return lhs == rhs;
+	}
+};
+
+/** @brief Default hash of HashMap, std::hash with the bits mixed as std::hash of integer
+*		is the identity on some platforms and the control byte needs the low bits to vary
+*/
+template <class K>
+struct DefaultHash
+{
+	size_t operator()(const K& key) const
+	{
+		uint64_t hashed = static_cast<uint64_t>(std::hash<K>()(key));
+		hashed ^= hashed >> 33;
+		hashed *= 0xff51afd7ed558ccdull;
+		hashed ^= hashed >> 33;
+		return static_cast<size_t>(hashed);
+	}
+};
+template <> struct DefaultHash<std::string> : StringHash {};
+template <> struct DefaultHash<std::string_view> : StringHash {};
+template <> struct DefaultHash<StringId> : std::hash<StringId> {};	// already a well mixed hash
+
+template <class K> struct DefaultEqual : std::equal_to<K> {};
+template <> struct DefaultEqual<std::string> : StringEqual {};
+template <> struct DefaultEqual<std::string_view> : StringEqual {};
+
+/** @brief	K is the key, V is the item, Hash and Equal are function objects of the key
+*		This is the default hash map to be used in DEngine, an open addressing table in
+*		the SwissTable layout. Every slot has a control byte holding 7 bits of its hash,
+*		or marking it empty or deleted, and a probe compares a group of 16 control bytes
+*		at once with SSE2, so a lookup touches the pairs only on likely match. The table
+*		grows by doubling at 7/8 load, Remove leaves a tombstone only when needed to keep
+*		probe chains intact. Memory comes from MemoryManager under MemoryTag::Container.
+*		If Hash and Equal both define is_transparent, lookup accepts any key-like type,
+*		e.g. std::string_view on a map keyed by std::string
+*		Use Add to insert a new pair, DO NOT use operator[] to insert
+*/
+template <class K, class V, class Hash = DefaultHash<K>, class Equal = DefaultEqual<K>>
 class MyHashMap
 {
+	static constexpr uint32_t GROUP_WIDTH = 16;		// control bytes scanned at once
+	static constexpr int8_t CTRL_EMPTY = -128;		// 0b10000000
+	static constexpr int8_t CTRL_DELETED = -2;		// 0b11111110, full slots are 0b0xxxxxxx
 
 public:
 
-	/*
-	*	CLASS: MyHashMap<T>::HashMapPair
-	*	T is the class of the item to be stored
-	*	The hash map pair is a struct consists of a C string as the key, and the template
-	*	class T as the item
-	*/
+	/** @brief The pair of key and item stored in a slot */
 	struct HashMapPair
 	{
-		/** @brief	default consturctor **/
-		HashMapPair() = default;
-
-		/********************************************************************************
-		*	--- Constructor:
-		*	HashMapPair(const char*, T)
-		*	This constructor will construct an hash map pair with the give C string as
-		*	key and the other as item
-		*
-		*	--- Parameters:
-		*	@ cString: the key of this pair
-		*	@ item: the item of this pair
-		********************************************************************************/
-		HashMapPair(const char* cString, T item)
-			: m_Item(item)
+		K					m_Key;		// this pair's key
+		V					m_Item;		// this pair's item
+	};
+
+	/** @brief	Construct an empty hash map, no memory is allocated until the first Add
+	*
+	*	@param capacity: number of pair to reserve space for, 0 to allocate lazily
+	*/
+	MyHashMap(size_t capacity = 0)
+	{
+		if (capacity > 0)
 		{
-			strcpy(m_Key, cString);
+			Reserve(capacity);
 		}
+	}
+
+	MyHashMap(const MyHashMap&) = delete;
+	MyHashMap& operator=(const MyHashMap&) = delete;
 
-		/********************************************************************************
-		*	--- Assignment Operator:
-		*	operator=(HashMapPair&)
-		*	This operator will assign the key and item from another pair to the caller
-		*	pair
-		*
-		*	--- Parameters:
-		*	@ other: the other existing hash map pair
-		*
-		*	--- Return:
-		*	@ HashMapPair&: the result hash map pair after assignment
-		********************************************************************************/
-		HashMapPair& operator=(HashMapPair& other)
+	/** @brief Move constructor, other is left empty */
+	MyHashMap(MyHashMap&& other)
+	{
+		*this = std::move(other);
+	}
+
+	/** @brief Move assignment, other is left empty */
+	MyHashMap& operator=(MyHashMap&& other)
+	{
+		if (this != &other)
 		{
-			strcpy(this->m_Key, other.m_Key);
-			this->m_Item = other.m_Item;
-			return *this;
+			release();
+			m_hTable = other.m_hTable;
+			m_pCtrl = other.m_pCtrl;
+			m_pSlots = other.m_pSlots;
+			m_iCapacity = other.m_iCapacity;
+			m_iSize = other.m_iSize;
+			m_iGrowthLeft = other.m_iGrowthLeft;
+			other.m_hTable = Handle();
+			other.m_pCtrl = nullptr;
+			other.m_pSlots = nullptr;
+			other.m_iCapacity = 0;
+			other.m_iSize = 0;
+			other.m_iGrowthLeft = 0;
 		}
+		return *this;
+	}
 
-		char				m_Key[256];		// this pair's key
-		T					m_Item;		// thie pair's item
-	};
-
-	/********************************************************************************
-	*	--- Constructor:
-	*	MyHashMap(size_t)
-	*	This constructor will construct an hash map with an MyArray as the container.
-	*	By default the size is 157, it can be extended to support dynamic size
-	*
-	*	--- Parameters:
-	*	@ size: the size of this hash map
-	********************************************************************************/
-	MyHashMap(size_t size = 157)
-		:m_iArray(size)
+	/** @brief Destroy all pairs and free the table */
+	~MyHashMap()
 	{
-		m_iMapSize = static_cast<uint32_t>(size);
-		m_iSize = 0;
+		release();
 	}
 
-	/********************************************************************************
-	*	--- Destructor:
-	*	~MyArray()
-	*	This destructor will free the memory used by this hash map's items
-	*
-	*	--- Parameters:
-	*	@ void
-	********************************************************************************/
-	~MyHashMap() = default;
-
-	/********************************************************************************
-	*	--- Function:
-	*	Size()
-	*	This function will return the current size of this hash map
-	*
-	*	--- Parameters:
-	*	@ void
-	*
-	*	--- Return:
-	*	@ size_t: the current size (number of items) of this hash map
-	********************************************************************************/
-	inline size_t Size()
+	/** @brief Return the number of pairs */
+	inline size_t Size() const
 	{
 		return m_iSize;
 	}
 
-	/********************************************************************************
-	*	--- Function:
-	*	Hash(const char*)
-	*	This function will hash a C string key to an index using Bernstein's hash
-	*	function djb2 (universal string hashing with initial value 5381 and "a" equals
-	*	33).
-	*
-	*	--- Parameters:
-	*	@ key: the C string key
+	/** @brief Return the number of slots, a multiple of 16 */
+	inline size_t Capacity() const
+	{
+		return m_iCapacity;
+	}
+
+	/** @brief	Make room for the number of pairs without growing
 	*
-	*	--- Return:
-	*	@ uint32_t: hashed index of this key
-	********************************************************************************/
-	uint32_t Hash(const char* key)
+	*	@param num: number of pair
+	*/
+	void Reserve(size_t num)
 	{
-		uint32_t hashed = 5381;
-		while (*key)
+		uint32_t capacity = GROUP_WIDTH;
+		while (maxLoad(capacity) < num)
+		{
+			capacity *= 2;
+		}
+		if (capacity > m_iCapacity)
 		{
-			hashed = hashed * 33 + (*key);
-			key++;
+			rehash(capacity);
 		}
-		return hashed % m_iMapSize;
 	}
 
-	/********************************************************************************
-	*	--- Function:
-	*	Add(const char*, T)
-	*	This function will add a pair to this hash map
+	/** @brief	Add a pair, assert if the key exists
 	*
-	*	--- Parameters:
-	*	@ key: the key paired with this item
-	*	@ item: the item to be added, should be the same as the template class
-	*
-	*	--- Return:
-	*	@ void:
-	********************************************************************************/
-	void Add(const char* key, T item)
-	{
-		uint32_t index = Hash(key);
-		HashMapPair pair(key, item);
-		m_iArray[index] = pair;
+	*	@param key: the key paired with this item
+	*	@param item: the item to be added
+	*	@return V&: the item stored
+	*/
+	template <class Q, class T>
+	V& Add(Q&& key, T&& item)
+	{
+		K newKey(std::forward<Q>(key));
+		const size_t hashed = Hash()(newKey);
+		assert(findIndex(newKey, hashed) == m_iCapacity && "this key exists");
+		if (m_iGrowthLeft == 0)
+		{
+			// tombstones are purged at the same capacity unless the table is more than half full
+			rehash(m_iSize + 1 > maxLoad(m_iCapacity) / 2 ? (m_iCapacity == 0 ? GROUP_WIDTH : m_iCapacity * 2) : m_iCapacity);
+		}
+		const uint32_t index = findInsertIndex(hashed);
+		m_iGrowthLeft -= m_pCtrl[index] == CTRL_EMPTY ? 1 : 0;
+		m_pCtrl[index] = h2(hashed);
+		new (&m_pSlots[index]) HashMapPair{ std::move(newKey), V(std::forward<T>(item)) };
 		m_iSize++;
+		return m_pSlots[index].m_Item;
 	}
 
-	/********************************************************************************
-	*	--- Function:
-	*	Remove(const char*)
-	*	This function will remove a pair with the given key
+	/** @brief	Remove the pair with the key, assert if it does not exist
 	*
-	*	--- Parameters:
-	*	@ key: the key paired with this item
-	*
-	*	--- Return:
-	*	@ void:
-	********************************************************************************/
-	void Remove(const char* key)
+	*	@param key: the key, or a key-like type with transparent Hash and Equal
+	*/
+	void Remove(const K& key)
+	{
+		removeImpl(key);
+	}
+	template <class Q, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+	void Remove(const Q& key)
+	{
+		removeImpl(key);
+	}
+
+	/** @brief Destroy all pairs, keeping the allocated table */
+	void Clear()
 	{
-		uint32_t index = Hash(key);
-		while (strcmp(m_iArray[index].m_Key, key) != 0)
+		for (uint32_t i = 0; i < m_iCapacity; ++i)
 		{
-			if (index >= m_iMapSize)
+			if (m_pCtrl[i] >= 0)
 			{
-				assert(false && "this key does not exist");
+				m_pSlots[i].~HashMapPair();
 			}
-			index++;
 		}
-		memset(m_iArray[index].m_Key, NULL, 256);
-		m_iSize--;
+		if (m_iCapacity > 0)
+		{
+			memset(m_pCtrl, CTRL_EMPTY, m_iCapacity);
+		}
+		m_iSize = 0;
+		m_iGrowthLeft = maxLoad(m_iCapacity);
 	}
 
-	/********************************************************************************
-	*	--- Function:
-	*	Clear()
-	*	This function will clear the items in this hash map, leaving the allocated
-	*	memory unchanged
+	/** @brief	Check if this hash map contains a pair with the key
 	*
-	*	--- Parameters:
-	*	@ void
+	*	@param key: the key, or a key-like type with transparent Hash and Equal
+	*	@return bool: True if the key exists
+	*/
+	bool Contain(const K& key) const
+	{
+		return findIndex(key, Hash()(key)) != m_iCapacity;
+	}
+	template <class Q, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+	bool Contain(const Q& key) const
+	{
+		return findIndex(key, Hash()(key)) != m_iCapacity;
+	}
+
+	/** @brief	Return the item of the key, nullptr if it does not exist
 	*
-	*	--- Return:
-	*	@ void
-	********************************************************************************/
-	void Clear()
+	*	@param key: the key, or a key-like type with transparent Hash and Equal
+	*	@return V*: the item, or nullptr
+	*/
+	V* Find(const K& key)
 	{
-		m_iArray.Clear();
-		m_iSize = 0;
+		return findItem(key);
+	}
+	const V* Find(const K& key) const
+	{
+		return const_cast<MyHashMap*>(this)->findItem(key);
+	}
+	template <class Q, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+	V* Find(const Q& key)
+	{
+		return findItem(key);
+	}
+	template <class Q, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+	const V* Find(const Q& key) const
+	{
+		return const_cast<MyHashMap*>(this)->findItem(key);
 	}
 
-	/********************************************************************************
-	*	--- Function:
-	*	Contain(const char*)
-	*	This function will check if this hash map contains a pair with the given key
+	/** @brief	Return the item of the key, assert if it does not exist
 	*
-	*	--- Parameters:
-	*	@ key: the C string as the key
+	*	@param key: the key, or a key-like type with transparent Hash and Equal
+	*	@return V&: the item associated with the key
+	*/
+	V& operator[](const K& key)
+	{
+		V* pItem = findItem(key);
+		assert(pItem && "this key does not exist");
+		return *pItem;
+	}
+	template <class Q, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+	V& operator[](const Q& key)
+	{
+		V* pItem = findItem(key);
+		assert(pItem && "this key does not exist");
+		return *pItem;
+	}
+
+	/** @brief	Run the function with every item
 	*
-	*	--- Return:
-	*	@ bool: True if this hash map contains pair with this key; False if this hash
-	*	map does NOT contain a pair with this key
-	********************************************************************************/
-	bool Contain(const char* key)
-	{
-		uint32_t index = Hash(key);
-		const char* a = m_iArray[index].m_Key;
-		while (strlen(m_iArray[index].m_Key) != 0 && index < m_iMapSize)
+	*	@param function: called as function(V&), can be a lambda, function pointer or function object
+	*/
+	template <typename F>
+	void ForEachItem(F function)
+	{
+		for (uint32_t i = 0; i < m_iCapacity; ++i)
 		{
-			if (strcmp(m_iArray[index].m_Key, key) == 0)
+			if (m_pCtrl[i] >= 0)
 			{
-				return true;
+				function(m_pSlots[i].m_Item);
 			}
-			index++;
 		}
-		return false;
 	}
 
-	/********************************************************************************
-	*	--- Function:
-	*	operator[](const char*)
-	*	This function will return the element associated with this key. Currently
-	*	assert if key does not exist
-	*
-	*	--- Parameters:
-	*	@ key: the C string key
+	/** @brief	Run the function with every pair
 	*
-	*	--- Return:
-	*	@ T&: the item associated with the key
-	********************************************************************************/
-	T& operator[](const char* key)
+	*	@param function: called as function(HashMapPair&), can be a lambda, function pointer or function object
+	*/
+	template <typename F>
+	void ForEachPair(F function)
 	{
-		uint32_t index = Hash(key);
-		while (strcmp(m_iArray[index].m_Key, key) != 0)
+		for (uint32_t i = 0; i < m_iCapacity; ++i)
 		{
-			if (index >= m_iMapSize)
+			if (m_pCtrl[i] >= 0)
 			{
-				assert(false && "this key does not exist");
+				function(m_pSlots[i]);
 			}
-			index++;
 		}
-		return m_iArray[index].m_Item;
 	}
 
-	/********************************************************************************
-	*	--- Function:
-	*	Raw()
-	*	This function will return the pointer to the beginning of the array container
-	*
-	*	--- Parameters:
-	*	@ void:
-	*
-	*	--- Return:
-	*	@ T*: the pointer of the first element
-	********************************************************************************/
-	T* Raw()
+private:
+
+	static uint32_t maxLoad(uint32_t capacity)
 	{
-		return m_iArray.Raw();
+		return capacity - capacity / 8;
 	}
 
-	/********************************************************************************
-	*	--- Template Function:
-	*	F is the class with a operator() defined
-	*	ForEachItem(F)
-	*	This function will run the given function with all items with non empty key
-	*
-	*	--- Parameters:
-	*	@ function: the function that will be run for all items, can be a lambda,
-	*	function pointer or function object
-	*
-	*	--- Return:
-	*	@ void
-	********************************************************************************/
-	template <typename F>
-	void ForEachItem(F function)
+	static int8_t h2(size_t hashed)
+	{
+		return static_cast<int8_t>(hashed & 0x7F);
+	}
+
+	static uint32_t lowestBit(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	/** @brief Bit i set if control byte i of the group equals value */
+	static uint32_t matchByte(const int8_t* group, int8_t value)
+	{
+#if DE_HASHMAP_SSE2
+		const __m128i ctrl = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#else
+		uint32_t mask = 0;
+		for (uint32_t i = 0; i < GROUP_WIDTH; ++i)
+		{
+			mask |= (group[i] == value ? 1u : 0u) << i;
+		}
+		return mask;
+#endif
+	}
+
+	/** @brief Bit i set if slot i of the group is empty or deleted */
+	static uint32_t matchEmptyOrDeleted(const int8_t* group)
+	{
+#if DE_HASHMAP_SSE2
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(group))));
+#else
+		uint32_t mask = 0;
+		for (uint32_t i = 0; i < GROUP_WIDTH; ++i)
+		{
+			mask |= (group[i] < 0 ? 1u : 0u) << i;
+		}
+		return mask;
+#endif
+	}
+
+	/** @brief Return the slot of the key, m_iCapacity if it does not exist. Groups are probed quadratically from the hash */
+	template <class Q>
+	uint32_t findIndex(const Q& key, size_t hashed) const
 	{
-		for (int i = 0; i < m_iMapSize; ++i)
+		if (m_iCapacity == 0)
 		{
-			if (strlen(m_iArray[i].m_Key) != 0)
+			return 0;
+		}
+		const uint32_t groupMask = m_iCapacity / GROUP_WIDTH - 1;
+		uint32_t group = static_cast<uint32_t>(hashed >> 7) & groupMask;
+		for (uint32_t step = 1; step <= groupMask + 1; ++step)
+		{
+			const int8_t* pGroup = m_pCtrl + group * GROUP_WIDTH;
+			for (uint32_t match = matchByte(pGroup, h2(hashed)); match != 0; match &= match - 1)
+			{
+				const uint32_t index = group * GROUP_WIDTH + lowestBit(match);
+				if (Equal()(m_pSlots[index].m_Key, key))
+				{
+					return index;
+				}
+			}
+			if (matchByte(pGroup, CTRL_EMPTY) != 0)
 			{
-				function(m_iArray[i].m_Item);
+				return m_iCapacity;
 			}
+			group = (group + step) & groupMask;
 		}
+		return m_iCapacity;
 	}
 
-	/********************************************************************************
-	*	--- Template Function:
-	*	F is the class with a operator() defined
-	*	ForEachPair(F)
-	*	This function will run the given function with all key-item pairs with 
-	*	non empty key
-	*
-	*	--- Parameters:
-	*	@ function: the function that will be run for all pairs, can be a lambda,
-	*	function pointer or function object
-	*
-	*	--- Return:
-	*	@ void
-	********************************************************************************/
-	template <typename F>
-	void ForEachPair(F function)
+	/** @brief Return the first empty or deleted slot on the probe sequence, the table must have one */
+	uint32_t findInsertIndex(size_t hashed) const
 	{
-		for (int i = 0; i < m_iMapSize; ++i)
+		const uint32_t groupMask = m_iCapacity / GROUP_WIDTH - 1;
+		uint32_t group = static_cast<uint32_t>(hashed >> 7) & groupMask;
+		for (uint32_t step = 1;; ++step)
 		{
-			if (strlen(m_iArray[i].m_Key) != 0)
+			const uint32_t match = matchEmptyOrDeleted(m_pCtrl + group * GROUP_WIDTH);
+			if (match != 0)
 			{
-				function(m_iArray[i]);
+				return group * GROUP_WIDTH + lowestBit(match);
 			}
+			group = (group + step) & groupMask;
 		}
 	}
 
-private:
+	template <class Q>
+	V* findItem(const Q& key)
+	{
+		const uint32_t index = findIndex(key, Hash()(key));
+		return index == m_iCapacity ? nullptr : &m_pSlots[index].m_Item;
+	}
+
+	template <class Q>
+	void removeImpl(const Q& key)
+	{
+		const uint32_t index = findIndex(key, Hash()(key));
+		assert(index != m_iCapacity && "this key does not exist");
+		m_pSlots[index].~HashMapPair();
+		m_iSize--;
+		// a group with an empty slot already ends every probe passing through it, no tombstone needed
+		if (matchByte(m_pCtrl + index / GROUP_WIDTH * GROUP_WIDTH, CTRL_EMPTY) != 0)
+		{
+			m_pCtrl[index] = CTRL_EMPTY;
+			m_iGrowthLeft++;
+		}
+		else
+		{
+			m_pCtrl[index] = CTRL_DELETED;
+		}
+	}
+
+	/** @brief Move every pair into a new table of the capacity, dropping the tombstones */
+	void rehash(uint32_t capacity)
+	{
+		assert(capacity % GROUP_WIDTH == 0 && (capacity & (capacity - 1)) == 0);
+		const size_t ctrlSize = capacity;
+		const size_t slotOffset = (ctrlSize + alignof(HashMapPair) - 1) / alignof(HashMapPair) * alignof(HashMapPair);
+		const size_t alignment = alignof(HashMapPair) > GROUP_WIDTH ? alignof(HashMapPair) : GROUP_WIDTH;
+		Handle hTable(slotOffset + sizeof(HashMapPair) * capacity, alignment, MemoryTag::Container);
+		int8_t* pCtrl = reinterpret_cast<int8_t*>(hTable.Raw());
+		assert(pCtrl && "out of memory");
+		HashMapPair* pSlots = reinterpret_cast<HashMapPair*>(pCtrl + slotOffset);
+		memset(pCtrl, CTRL_EMPTY, ctrlSize);
+
+		Handle hOldTable = m_hTable;
+		int8_t* pOldCtrl = m_pCtrl;
+		HashMapPair* pOldSlots = m_pSlots;
+		const uint32_t oldCapacity = m_iCapacity;
+		m_hTable = hTable;
+		m_pCtrl = pCtrl;
+		m_pSlots = pSlots;
+		m_iCapacity = capacity;
+		m_iGrowthLeft = maxLoad(capacity) - m_iSize;
+
+		for (uint32_t i = 0; i < oldCapacity; ++i)
+		{
+			if (pOldCtrl[i] >= 0)
+			{
+				const size_t hashed = Hash()(pOldSlots[i].m_Key);
+				const uint32_t index = findInsertIndex(hashed);
+				m_pCtrl[index] = h2(hashed);
+				new (&m_pSlots[index]) HashMapPair(std::move(pOldSlots[i]));
+				pOldSlots[i].~HashMapPair();
+			}
+		}
+		if (oldCapacity > 0)
+		{
+			hOldTable.Free();
+		}
+	}
+
+	void release()
+	{
+		if (m_iCapacity > 0)
+		{
+			Clear();
+			m_hTable.Free();
+		}
+		m_pCtrl = nullptr;
+		m_pSlots = nullptr;
+		m_iCapacity = 0;
+		m_iSize = 0;
+		m_iGrowthLeft = 0;
+	}
 
-	MyArray<HashMapPair>			m_iArray;		// the array containing the pair
-	uint32_t						m_iSize;		// the current number of items
-	uint32_t						m_iMapSize;		// the allocated size of the whole map
+	Handle							m_hTable;				// control bytes followed by the slots
+	int8_t*							m_pCtrl = nullptr;		// one control byte per slot
+	HashMapPair*					m_pSlots = nullptr;		// pairs, valid where the control byte is full
+	uint32_t						m_iCapacity = 0;		// number of slot, 0 or a power of two no less than 16
+	uint32_t						m_iSize = 0;			// the current number of pair
+	uint32_t						m_iGrowthLeft = 0;		// pairs that can be added before rehash, tombstones count as used
 };
 
-template<class T>
-using HashMap = MyHashMap<T>;
+template <class K, class V, class Hash = DefaultHash<K>, class Equal = DefaultEqual<K>>
+using HashMap = MyHashMap<K, V, Hash, Equal>;
 
-} // namespace DE
\ No newline at end of file
+} // namespace DE
@@ -0,0 +1,375 @@
+#pragma once
+
+// Cpp
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace DE
+{
+
+constexpr size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
+
+/** @brief	T is the class of the item to be stored, Capacity is the maximum number of items
+*		A fixed-capacity queue between exactly one producer thread and one consumer
+*		thread. Every operation is wait-free: the producer only writes the tail and
+*		the consumer only writes the head, each keeps a cached copy of the other
+*		index so the shared cache line is read only when the queue looks full or empty
+*/
+template <class T, uint32_t Capacity>
+class SPSCRingBuffer
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be power of two");
+	static_assert(Capacity <= (1u << 31), "index difference must fit in 32 bits");
+
+	static constexpr uint32_t MASK = Capacity - 1;
+
+public:
+
+	SPSCRingBuffer() = default;
+	SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+	SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+	/** @brief Destroy the items left in the queue, no thread may be using it */
+	~SPSCRingBuffer()
+	{
+		const uint32_t tail = m_iTail.load(std::memory_order_acquire);
+		for (uint32_t head = m_iHead.load(std::memory_order_relaxed); head != tail; ++head)
+		{
+			at(head)->~T();
+		}
+	}
+
+	/** @brief	Construct an item at the tail, producer thread only
+	*
+	*	@param args the parameter forward to T's constructor
+	*	@return false if the queue is full
+	*/
+	template <class... Args>
+	bool TryEnqueue(Args&&... args)
+	{
+		const uint32_t tail = m_iTail.load(std::memory_order_relaxed);
+		if (tail - m_iCachedHead == Capacity)
+		{
+			m_iCachedHead = m_iHead.load(std::memory_order_acquire);
+			if (tail - m_iCachedHead == Capacity)
+			{
+				return false;
+			}
+		}
+		new (at(tail)) T(std::forward<Args>(args)...);
+		m_iTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** @brief	Copy as many items as fit to the tail, published at once, producer thread only
+	*
+	*	@param pItems the items to be copied
+	*	@param num the number of items
+	*	@return the number of items enqueued, from the front of pItems
+	*/
+	uint32_t EnqueueBatch(const T* pItems, uint32_t num)
+	{
+		const uint32_t tail = m_iTail.load(std::memory_order_relaxed);
+		if (Capacity - (tail - m_iCachedHead) < num)
+		{
+			m_iCachedHead = m_iHead.load(std::memory_order_acquire);
+		}
+		const uint32_t space = Capacity - (tail - m_iCachedHead);
+		num = num < space ? num : space;
+		for (uint32_t i = 0; i < num; ++i)
+		{
+			new (at(tail + i)) T(pItems[i]);
+		}
+		m_iTail.store(tail + num, std::memory_order_release);
+		return num;
+	}
+
+	/** @brief	Move the item at the head out, consumer thread only
+	*
+	*	@param item the item to be moved to
+	*	@return false if the queue is empty
+	*/
+	bool TryDequeue(T& item)
+	{
+		const uint32_t head = m_iHead.load(std::memory_order_relaxed);
+		if (head == m_iCachedTail)
+		{
+			m_iCachedTail = m_iTail.load(std::memory_order_acquire);
+			if (head == m_iCachedTail)
+			{
+				return false;
+			}
+		}
+		T* pItem = at(head);
+		item = std::move(*pItem);
+		pItem->~T();
+		m_iHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** @brief	Move up to maxNum items out, released at once, consumer thread only
+	*
+	*	@param pItems the array to be moved to
+	*	@param maxNum the size of pItems
+	*	@return the number of items dequeued
+	*/
+	uint32_t DequeueBatch(T* pItems, uint32_t maxNum)
+	{
+		const uint32_t head = m_iHead.load(std::memory_order_relaxed);
+		if (m_iCachedTail - head < maxNum)
+		{
+			m_iCachedTail = m_iTail.load(std::memory_order_acquire);
+		}
+		const uint32_t available = m_iCachedTail - head;
+		const uint32_t num = maxNum < available ? maxNum : available;
+		for (uint32_t i = 0; i < num; ++i)
+		{
+			T* pItem = at(head + i);
+			pItems[i] = std::move(*pItem);
+			pItem->~T();
+		}
+		m_iHead.store(head + num, std::memory_order_release);
+		return num;
+	}
+
+	/** @brief Return the number of items, only a snapshot if the other thread is active */
+	uint32_t Size() const
+	{
+		return m_iTail.load(std::memory_order_acquire) - m_iHead.load(std::memory_order_acquire);
+	}
+
+	/** @brief Return whether the queue is empty, only a snapshot if the other thread is active */
+	bool Empty() const
+	{
+		return Size() == 0;
+	}
+
+private:
+
+	T* at(uint32_t index)
+	{
+		return reinterpret_cast<T*>(m_Items) + (index & MASK);
+	}
+
+	alignas(CACHE_LINE_SIZE) std::atomic<uint32_t>	m_iHead = { 0 };		// the next item to dequeue, written by the consumer
+	uint32_t										m_iCachedTail = 0;		// the consumer's copy of m_iTail
+	alignas(CACHE_LINE_SIZE) std::atomic<uint32_t>	m_iTail = { 0 };		// the next item to enqueue, written by the producer
+	uint32_t										m_iCachedHead = 0;		// the producer's copy of m_iHead
+	alignas(CACHE_LINE_SIZE) alignas(T) unsigned char	m_Items[sizeof(T) * Capacity];	// the items
+};
+
+/** @brief	T is the class of the item to be stored, Capacity is the maximum number of items
+*		A fixed-capacity queue for any number of producer and consumer threads. Each
+*		cell carries a sequence number telling which lap of the ring it is ready for,
+*		so a thread claims a cell with a single compare-exchange on the tail or head
+*		and no thread ever waits for another to finish. A batch claims the run of
+*		consecutive ready cells in one compare-exchange
+*/
+template <class T, uint32_t Capacity>
+class MPMCRingBuffer
+{
+	static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "capacity must be power of two");
+	static_assert(Capacity <= (1u << 30), "index difference must fit in 32 bits");
+
+	static constexpr uint32_t MASK = Capacity - 1;
+
+	struct Cell
+	{
+		std::atomic<uint32_t>		m_iSequence;			// index of the enqueue this cell waits for, or the index + 1 once filled
+		alignas(T) unsigned char	m_Item[sizeof(T)];		// the item
+	};
+
+public:
+
+	MPMCRingBuffer()
+	{
+		for (uint32_t i = 0; i < Capacity; ++i)
+		{
+			m_Cells[i].m_iSequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	MPMCRingBuffer(const MPMCRingBuffer&) = delete;
+	MPMCRingBuffer& operator=(const MPMCRingBuffer&) = delete;
+
+	/** @brief Destroy the items left in the queue, no thread may be using it */
+	~MPMCRingBuffer()
+	{
+		const uint32_t tail = m_iTail.load(std::memory_order_acquire);
+		for (uint32_t head = m_iHead.load(std::memory_order_relaxed); head != tail; ++head)
+		{
+			reinterpret_cast<T*>(m_Cells[head & MASK].m_Item)->~T();
+		}
+	}
+
+	/** @brief	Construct an item at the tail, thread safe
+	*
+	*	@param args the parameter forward to T's constructor
+	*	@return false if the queue is full
+	*/
+	template <class... Args>
+	bool TryEnqueue(Args&&... args)
+	{
+		uint32_t tail = m_iTail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = m_Cells[tail & MASK];
+			const int32_t diff = static_cast<int32_t>(cell.m_iSequence.load(std::memory_order_acquire) - tail);
+			if (diff == 0)
+			{
+				if (m_iTail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+				{
+					new (cell.m_Item) T(std::forward<Args>(args)...);
+					cell.m_iSequence.store(tail + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				tail = m_iTail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/** @brief	Copy as many items as fit to the tail, thread safe. The items of one call
+	*		stay consecutive in the queue
+	*
+	*	@param pItems the items to be copied
+	*	@param num the number of items
+	*	@return the number of items enqueued, from the front of pItems
+	*/
+	uint32_t EnqueueBatch(const T* pItems, uint32_t num)
+	{
+		uint32_t tail = m_iTail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			uint32_t ready = 0;
+			while (ready < num && m_Cells[(tail + ready) & MASK].m_iSequence.load(std::memory_order_acquire) == tail + ready)
+			{
+				ready++;
+			}
+			if (ready == 0)
+			{
+				const int32_t diff = static_cast<int32_t>(m_Cells[tail & MASK].m_iSequence.load(std::memory_order_acquire) - tail);
+				if (diff < 0)
+				{
+					return 0;
+				}
+				tail = m_iTail.load(std::memory_order_relaxed);
+			}
+			else if (m_iTail.compare_exchange_weak(tail, tail + ready, std::memory_order_relaxed))
+			{
+				for (uint32_t i = 0; i < ready; ++i)
+				{
+					Cell& cell = m_Cells[(tail + i) & MASK];
+					new (cell.m_Item) T(pItems[i]);
+					cell.m_iSequence.store(tail + i + 1, std::memory_order_release);
+				}
+				return ready;
+			}
+		}
+	}
+
+	/** @brief	Move the item at the head out, thread safe
+	*
+	*	@param item the item to be moved to
+	*	@return false if the queue is empty
+	*/
+	bool TryDequeue(T& item)
+	{
+		uint32_t head = m_iHead.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = m_Cells[head & MASK];
+			const int32_t diff = static_cast<int32_t>(cell.m_iSequence.load(std::memory_order_acquire) - (head + 1));
+			if (diff == 0)
+			{
+				if (m_iHead.compare_exchange_weak(head, head + 1, std::memory_order_relaxed))
+				{
+					T* pItem = reinterpret_cast<T*>(cell.m_Item);
+					item = std::move(*pItem);
+					pItem->~T();
+					cell.m_iSequence.store(head + Capacity, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				head = m_iHead.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/** @brief	Move up to maxNum consecutive items out, thread safe
+	*
+	*	@param pItems the array to be moved to
+	*	@param maxNum the size of pItems
+	*	@return the number of items dequeued
+	*/
+	uint32_t DequeueBatch(T* pItems, uint32_t maxNum)
+	{
+		uint32_t head = m_iHead.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			uint32_t ready = 0;
+			while (ready < maxNum && m_Cells[(head + ready) & MASK].m_iSequence.load(std::memory_order_acquire) == head + ready + 1)
+			{
+				ready++;
+			}
+			if (ready == 0)
+			{
+				const int32_t diff = static_cast<int32_t>(m_Cells[head & MASK].m_iSequence.load(std::memory_order_acquire) - (head + 1));
+				if (diff < 0)
+				{
+					return 0;
+				}
+				head = m_iHead.load(std::memory_order_relaxed);
+			}
+			else if (m_iHead.compare_exchange_weak(head, head + ready, std::memory_order_relaxed))
+			{
+				for (uint32_t i = 0; i < ready; ++i)
+				{
+					Cell& cell = m_Cells[(head + i) & MASK];
+					T* pItem = reinterpret_cast<T*>(cell.m_Item);
+					pItems[i] = std::move(*pItem);
+					pItem->~T();
+					cell.m_iSequence.store(head + i + Capacity, std::memory_order_release);
+				}
+				return ready;
+			}
+		}
+	}
+
+	/** @brief Return the number of claimed items, only a snapshot if other threads are active */
+	uint32_t Size() const
+	{
+		const uint32_t head = m_iHead.load(std::memory_order_acquire);
+		const uint32_t tail = m_iTail.load(std::memory_order_acquire);
+		return static_cast<int32_t>(tail - head) > 0 ? tail - head : 0;
+	}
+
+	/** @brief Return whether the queue is empty, only a snapshot if other threads are active */
+	bool Empty() const
+	{
+		return Size() == 0;
+	}
+
+private:
+
+	alignas(CACHE_LINE_SIZE) std::atomic<uint32_t>	m_iHead = { 0 };		// the next cell to dequeue
+	alignas(CACHE_LINE_SIZE) std::atomic<uint32_t>	m_iTail = { 0 };		// the next cell to enqueue
+	alignas(CACHE_LINE_SIZE) Cell					m_Cells[Capacity];		// the ring
+};
+
+} // namespace DE
@@ -0,0 +1,346 @@
+#pragma once
+
+// Engine
+#include <DECore/Container/Vector.h>
+#include <DECore/Memory/Handle.h>
+// Cpp
+#include <assert.h>
+#include <new>
+#include <utility>
+
+namespace DE
+{
+
+/** @brief	4 byte generation-checked reference to an element of a SlotMap, the slot
+*		index stays the same for the element's lifetime while the generation is bumped
+*		every time the element is removed, so a handle to a removed element is detected
+*		instead of silently referring to its successor. Generation 0 is never issued
+*/
+struct SlotMapHandle
+{
+	static constexpr uint32_t INDEX_BITS = 20;
+	static constexpr uint32_t GENERATION_BITS = 12;
+	static constexpr uint32_t MAX_INDEX = (1u << INDEX_BITS) - 1;
+	static constexpr uint32_t MAX_GENERATION = (1u << GENERATION_BITS) - 1;
+
+	/** @brief Construct an invalid handle */
+	SlotMapHandle()
+		: m_iIndex(0)
+		, m_iGeneration(0)
+	{}
+
+	SlotMapHandle(uint32_t index, uint32_t generation)
+		: m_iIndex(index)
+		, m_iGeneration(generation)
+	{}
+
+	/** @brief Return the handle packed into an integer, for storing in plain data */
+	uint32_t Value() const
+	{
+		return m_iGeneration << INDEX_BITS | m_iIndex;
+	}
+
+	/** @brief Return the handle from an integer returned by Value() */
+	static SlotMapHandle FromValue(uint32_t value)
+	{
+		return SlotMapHandle(value & MAX_INDEX, value >> INDEX_BITS);
+	}
+
+	/** @brief Return whether the handle was issued by a SlotMap, it may still be stale */
+	bool IsValid() const
+	{
+		return m_iGeneration != 0;
+	}
+
+	bool operator==(SlotMapHandle other) const { return Value() == other.Value(); }
+	bool operator!=(SlotMapHandle other) const { return Value() != other.Value(); }
+
+	uint32_t m_iIndex : INDEX_BITS;				// the slot in the indirection table
+	uint32_t m_iGeneration : GENERATION_BITS;	// the generation of the slot when issued
+};
+
+/** @brief	T is the class of the item to be stored, ChunkSize is the number of items per
+*		allocation. The items are packed densely for iteration and referenced through
+*		an indirection table of slots by SlotMapHandle, adding and removing are O(1),
+*		a removal moves the last item into the hole. Growing allocates another chunk,
+*		so an item never moves until an item is removed. A slot whose generation is
+*		exhausted is retired instead of reused
+*/
+template <class T, uint32_t ChunkSize = 64>
+class SlotMap
+{
+	static_assert(ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0, "chunk size must be power of two");
+
+	struct Slot
+	{
+		uint32_t		m_iDense;			// the dense index of the item, or the next free slot
+		uint32_t		m_iGeneration;		// the generation of the current item, or the next one if free
+	};
+
+	struct Chunk
+	{
+		Handle			m_hMemory;			// the allocation of ChunkSize items
+		T*				m_pItems;			// the address of the allocation, it has no relocation listener so it never moves
+	};
+
+	static constexpr uint32_t INVALID_SLOT = ~0u;
+
+public:
+
+	/** @brief Default constructor, no memory is allocated until the first Add() **/
+	SlotMap() = default;
+
+	SlotMap(const SlotMap&) = delete;
+	SlotMap& operator=(const SlotMap&) = delete;
+
+	/** @brief	Move the items from another map, and leave it empty
+	*
+	*	@param other the other SlotMap object
+	*/
+	SlotMap(SlotMap&& other)
+	{
+		takeFrom(other);
+	}
+
+	/** @brief	Move the items from another map, and leave it empty
+	*
+	*	@param other the other SlotMap object
+	*/
+	SlotMap& operator=(SlotMap&& other)
+	{
+		if (this != &other)
+		{
+			Clear();
+			release();
+			takeFrom(other);
+		}
+		return *this;
+	}
+
+	/** @brief Destroy the items and free the chunks */
+	~SlotMap()
+	{
+		Clear();
+		release();
+	}
+
+	/** @brief	Construct an item in place
+	*
+	*	@param args the parameter forward to T's constructor
+	*	@return the handle of the new item
+	*/
+	template <class... Args>
+	SlotMapHandle Add(Args&&... args)
+	{
+		const uint32_t dense = m_iSize;
+		if (dense == m_Chunks.size() * ChunkSize)
+		{
+			addChunk();
+		}
+		new (at(dense)) T(std::forward<Args>(args)...);
+
+		uint32_t index = m_iFreeSlot;
+		if (index != INVALID_SLOT)
+		{
+			m_iFreeSlot = m_Slots[index].m_iDense;
+		}
+		else
+		{
+			index = static_cast<uint32_t>(m_Slots.size());
+			assert(index <= SlotMapHandle::MAX_INDEX && "SlotMap is full");
+			m_Slots.push_back(Slot{ 0, 1 });
+		}
+		Slot& slot = m_Slots[index];
+		slot.m_iDense = dense;
+		m_DenseToSlot.push_back(index);
+		m_iSize++;
+		return SlotMapHandle(index, slot.m_iGeneration);
+	}
+
+	/** @brief	Destroy the item of a handle, the last item is moved into its place
+	*
+	*	@param handle the handle of the item, asserts if stale
+	*/
+	void Remove(SlotMapHandle handle)
+	{
+		assert(Contain(handle));
+		Slot& slot = m_Slots[handle.m_iIndex];
+		const uint32_t dense = slot.m_iDense;
+		const uint32_t last = m_iSize - 1;
+		T* pItem = at(dense);
+		pItem->~T();
+		if (dense != last)
+		{
+			T* pLast = at(last);
+			new (pItem) T(std::move(*pLast));
+			pLast->~T();
+			const uint32_t lastSlot = m_DenseToSlot[last];
+			m_Slots[lastSlot].m_iDense = dense;
+			m_DenseToSlot[dense] = lastSlot;
+		}
+		m_DenseToSlot.pop_back();
+		m_iSize--;
+		freeSlot(handle.m_iIndex);
+	}
+
+	/** @brief Return whether the handle refers to a live item */
+	bool Contain(SlotMapHandle handle) const
+	{
+		return handle.IsValid()
+			&& handle.m_iIndex < m_Slots.size()
+			&& m_Slots[handle.m_iIndex].m_iGeneration == handle.m_iGeneration;
+	}
+
+	/** @brief	Return the item of a handle
+	*
+	*	@param handle the handle of the item
+	*	@return the pointer to the item, nullptr if the handle is stale
+	*/
+	T* Find(SlotMapHandle handle) const
+	{
+		if (!Contain(handle))
+		{
+			return nullptr;
+		}
+		return at(m_Slots[handle.m_iIndex].m_iDense);
+	}
+
+	/** @brief Return the item of a handle, asserts if stale */
+	T& operator[](SlotMapHandle handle) const
+	{
+		assert(Contain(handle));
+		return *at(m_Slots[handle.m_iIndex].m_iDense);
+	}
+
+	/** @brief Return the item at a dense index, the order changes on Remove() */
+	T& GetDense(uint32_t dense) const
+	{
+		assert(dense < m_iSize);
+		return *at(dense);
+	}
+
+	/** @brief Return the handle of the item at a dense index */
+	SlotMapHandle GetDenseHandle(uint32_t dense) const
+	{
+		assert(dense < m_iSize);
+		const uint32_t index = m_DenseToSlot[dense];
+		return SlotMapHandle(index, m_Slots[index].m_iGeneration);
+	}
+
+	/** @brief	Iterate all items in dense order, items must not be added or removed
+	*
+	*	@param func function taking T&
+	*/
+	template <class Func>
+	void ForEachItem(Func&& func) const
+	{
+		for (uint32_t chunk = 0; chunk * ChunkSize < m_iSize; ++chunk)
+		{
+			T* pChunk = m_Chunks[chunk].m_pItems;
+			const uint32_t remain = m_iSize - chunk * ChunkSize;
+			const uint32_t num = remain < ChunkSize ? remain : ChunkSize;
+			for (uint32_t i = 0; i < num; ++i)
+			{
+				func(pChunk[i]);
+			}
+		}
+	}
+
+	/** @brief Reserve chunks for the given number of items */
+	void Reserve(uint32_t capacity)
+	{
+		m_Chunks.reserve((capacity + ChunkSize - 1) / ChunkSize);
+		while (m_Chunks.size() * ChunkSize < capacity)
+		{
+			addChunk();
+		}
+		m_DenseToSlot.reserve(capacity);
+	}
+
+	/** @brief	Destroy all items, keep the chunks. Handles issued before become stale
+	*		as the slots are freed with their generations
+	*/
+	void Clear()
+	{
+		for (uint32_t dense = 0; dense < m_iSize; ++dense)
+		{
+			at(dense)->~T();
+			freeSlot(m_DenseToSlot[dense]);
+		}
+		m_DenseToSlot.clear();
+		m_iSize = 0;
+	}
+
+	/** @brief Return the number of items */
+	uint32_t Size() const
+	{
+		return m_iSize;
+	}
+
+	/** @brief Return the number of items the allocated chunks can hold */
+	uint32_t Capacity() const
+	{
+		return static_cast<uint32_t>(m_Chunks.size()) * ChunkSize;
+	}
+
+private:
+
+	T* at(uint32_t dense) const
+	{
+		return m_Chunks[dense / ChunkSize].m_pItems + dense % ChunkSize;
+	}
+
+	/** @brief Allocate ChunkSize more items and cache their address, so a lookup never resolves a Handle */
+	void addChunk()
+	{
+		Handle hChunk(sizeof(T) * ChunkSize, alignof(T), MemoryTag::Container);
+		T* pItems = reinterpret_cast<T*>(hChunk.Raw());
+		assert(pItems && "out of memory");
+		m_Chunks.push_back(Chunk{ hChunk, pItems });
+	}
+
+	/** @brief Invalidate the handles of a slot and reuse it unless its generation is exhausted */
+	void freeSlot(uint32_t index)
+	{
+		Slot& slot = m_Slots[index];
+		slot.m_iGeneration++;
+		if (slot.m_iGeneration <= SlotMapHandle::MAX_GENERATION)
+		{
+			slot.m_iDense = m_iFreeSlot;
+			m_iFreeSlot = index;
+		}
+	}
+
+	void release()
+	{
+		for (auto& chunk : m_Chunks)
+		{
+			chunk.m_hMemory.Free();
+		}
+		m_Chunks.clear();
+		m_Chunks.shrink_to_fit();
+		m_Slots.clear();
+		m_Slots.shrink_to_fit();
+		m_DenseToSlot.shrink_to_fit();
+		m_iFreeSlot = INVALID_SLOT;
+	}
+
+	void takeFrom(SlotMap& other)
+	{
+		m_Chunks = std::move(other.m_Chunks);
+		m_Slots = std::move(other.m_Slots);
+		m_DenseToSlot = std::move(other.m_DenseToSlot);
+		m_iFreeSlot = other.m_iFreeSlot;
+		m_iSize = other.m_iSize;
+		other.m_iFreeSlot = INVALID_SLOT;
+		other.m_iSize = 0;
+	}
+
+	Vector<Chunk>			m_Chunks;						// the chunks of ChunkSize items, never moved
+	Vector<Slot>			m_Slots;						// the indirection table indexed by SlotMapHandle
+	Vector<uint32_t>		m_DenseToSlot;					// the slot of each item, to fix up the slot of a moved item
+	uint32_t				m_iFreeSlot = INVALID_SLOT;		// the head of the free slot list
+	uint32_t				m_iSize = 0;					// the number of items
+};
+
+} // namespace DE
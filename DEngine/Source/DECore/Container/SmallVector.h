@@ -0,0 +1,301 @@
+#pragma once
+
+// Engine
+#include <DECore/Memory/Handle.h>
+// Cpp
+#include <assert.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace DE
+{
+
+/** @brief T is the class of the item to be stored, N is the number of item stored inline
+*		A contiguous array with the same interface as Vector that keeps up to N
+*		elements inside the object and only allocates from the pool beyond that, for
+*		short lived lists that are usually tiny. The spilled memory is pinned, never
+*		moved by the defragmenter. Moving a SmallVector moves the inline elements
+*		one by one, so keep N small
+*/
+template <class T, uint32_t N>
+class SmallVector
+{
+	static_assert(N > 0, "use Vector for no inline storage");
+
+	using iterator = T*;
+	using reference = T&;
+	using const_iterator = const T*;
+	using const_reference = const T&;
+
+public:
+
+	/** @brief Default constructor **/
+	SmallVector() = default;
+
+	/** @brief	Construct an array with given size and construct elements
+	*
+	*	@param size
+	*/
+	SmallVector(size_t size)
+	{
+		resize(size);
+	}
+
+	SmallVector(const SmallVector&) = delete;
+	SmallVector& operator=(const SmallVector&) = delete;
+
+	/** @brief	Move the elements from another array, and leave it empty
+	*
+	*	@param other the other SmallVector object
+	*/
+	SmallVector(SmallVector&& other)
+	{
+		moveFrom(other);
+	}
+
+	/** @brief	Move the elements from another array, and leave it empty
+	*
+	*	@param other the other SmallVector object
+	*/
+	SmallVector& operator=(SmallVector&& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			releaseHeap();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	/** @brief Destroy the elements and free the spilled memory */
+	~SmallVector()
+	{
+		clear();
+		releaseHeap();
+	}
+
+	/** @brief Return the current size */
+	inline size_t size() const
+	{
+		return m_iSize;
+	}
+
+	/** @brief Return the current capacity, at least N */
+	inline size_t capacity() const
+	{
+		return m_iCapacity;
+	}
+
+	/** @brief Return if the array is empty */
+	inline bool empty() const
+	{
+		return m_iSize == 0;
+	}
+
+	/** @brief Return if the elements are stored inline */
+	inline bool is_inline() const
+	{
+		return m_pBegin == inlineBegin();
+	}
+
+	/** @brief Add an element at the end of this array */
+	void push_back(const T& item)
+	{
+		emplace_back(item);
+	}
+
+	/** @brief Add an movable element at the end of this array */
+	void push_back(T&& item)
+	{
+		emplace_back(std::move(item));
+	}
+
+	/** @brief Construct an element in place at the end of this array
+	*
+	*	@param args the parameter forward to T's constructor
+	*	@return the new element
+	*/
+	template<class... Args>
+	T& emplace_back(Args&&... args)
+	{
+		if (m_iSize == m_iCapacity)
+		{
+			// args may refer to an element about to be moved
+			T item(std::forward<Args>(args)...);
+			reserve(m_iCapacity * 2);
+			T* pItem = new (&m_pBegin[m_iSize]) T(std::move(item));
+			m_iSize++;
+			return *pItem;
+		}
+		T* pItem = new (&m_pBegin[m_iSize]) T(std::forward<Args>(args)...);
+		m_iSize++;
+		return *pItem;
+	}
+
+	/** @brief Remove the last element, keep capacity unchanged */
+	void pop_back()
+	{
+		assert(m_iSize > 0);
+		back().~T();
+		m_iSize--;
+	}
+
+	/** @brief Resize the array, constructing or destroying elements at the end
+	*
+	*	@param size the new size
+	*/
+	void resize(size_t size)
+	{
+		reserve(size);
+		for (size_t i = m_iSize; i < size; ++i)
+		{
+			new (&m_pBegin[i]) T();
+		}
+		for (size_t i = size; i < m_iSize; ++i)
+		{
+			m_pBegin[i].~T();
+		}
+		m_iSize = size;
+	}
+
+	/** @brief Reserve the array's capacity, spilling to the pool beyond N
+	*
+	*	@param capacity the new capacity
+	*/
+	void reserve(size_t capacity)
+	{
+		if (capacity <= m_iCapacity)
+		{
+			return;
+		}
+		Handle hNewElements(sizeof(T) * capacity, alignof(T), MemoryTag::Container);
+		T* pNewBegin = reinterpret_cast<T*>(hNewElements.Raw());
+		assert(pNewBegin && "out of memory");
+		relocate(m_pBegin, pNewBegin, m_iSize);
+		releaseHeap();
+		m_hElements = hNewElements;
+		m_pBegin = pNewBegin;
+		m_iCapacity = capacity;
+	}
+
+	/** @brief Clear the items in this array, leaving the capacity and allocated memory unchanged */
+	void clear()
+	{
+		for (size_t i = 0; i < m_iSize; ++i)
+		{
+			m_pBegin[i].~T();
+		}
+		m_iSize = 0;
+	}
+
+	/** @brief Return the element located the index-th element */
+	T& operator[](const size_t index) const
+	{
+		return m_pBegin[index];
+	}
+
+	/** @brief Return the pointer to the first element */
+	T* data() const
+	{
+		return m_pBegin;
+	}
+
+	iterator begin()
+	{
+		return m_pBegin;
+	}
+
+	const_iterator begin() const
+	{
+		return m_pBegin;
+	}
+
+	iterator end()
+	{
+		return m_pBegin + m_iSize;
+	}
+
+	const_iterator end() const
+	{
+		return m_pBegin + m_iSize;
+	}
+
+	reference back()
+	{
+		return end()[-1];
+	}
+
+	const_reference back() const
+	{
+		return end()[-1];
+	}
+
+private:
+
+	T* inlineBegin() const
+	{
+		return reinterpret_cast<T*>(const_cast<unsigned char*>(m_Inline));
+	}
+
+	/** @brief Move construct num elements to uninitialized memory and destroy the source */
+	static void relocate(T* pFrom, T* pTo, size_t num)
+	{
+		if constexpr (std::is_trivially_copyable<T>::value)
+		{
+			if (num > 0)
+			{
+				memcpy(pTo, pFrom, sizeof(T) * num);
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < num; ++i)
+			{
+				new (&pTo[i]) T(std::move(pFrom[i]));
+				pFrom[i].~T();
+			}
+		}
+	}
+
+	void releaseHeap()
+	{
+		if (!is_inline())
+		{
+			m_hElements.Free();
+			m_hElements = Handle();
+			m_pBegin = inlineBegin();
+			m_iCapacity = N;
+		}
+	}
+
+	/** @brief Take the elements of other, this array must be empty and inline */
+	void moveFrom(SmallVector& other)
+	{
+		if (other.is_inline())
+		{
+			relocate(other.m_pBegin, m_pBegin, other.m_iSize);
+		}
+		else
+		{
+			m_hElements = other.m_hElements;
+			m_pBegin = other.m_pBegin;
+			m_iCapacity = other.m_iCapacity;
+			other.m_hElements = Handle();
+			other.m_pBegin = other.inlineBegin();
+			other.m_iCapacity = N;
+		}
+		m_iSize = other.m_iSize;
+		other.m_iSize = 0;
+	}
+
+	alignas(T) unsigned char	m_Inline[sizeof(T) * N];			// storage of the first N elements
+	Handle						m_hElements;						// the handle of the spilled elements, invalid when inline
+	T*							m_pBegin = inlineBegin();			// the pointer to the first element, inline or spilled
+	size_t						m_iSize = 0;						// the current size of array
+	size_t						m_iCapacity = N;					// the current capacity
+};
+
+} // namespace DE
@@ -0,0 +1,487 @@
+#pragma once
+
+// Engine
+#include <DECore/Container/Vector.h>
+#include <DECore/Memory/Handle.h>
+// Cpp
+#include <assert.h>
+#include <string.h>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace DE
+{
+
+/** @brief	Fields are the member types of one element, each stored in its own array
+*		A struct-of-arrays counterpart of Vector for loops touching only some members,
+*		e.g. SoAVector<float, float, float, float> for bounding sphere x, y, z, radius.
+*		All arrays share one allocation and start on a cache line so data<I>() can be
+*		streamed by SIMD kernels. operator[] and iteration give a std::tuple of
+*		references to the fields, usable with structured bindings:
+*		for (auto [x, y, z, r] : spheres)
+*/
+template <class... Fields>
+class SoAVector
+{
+	static_assert(sizeof...(Fields) > 0, "SoAVector needs at least one field");
+
+	static constexpr size_t FIELD_NUM = sizeof...(Fields);
+	static constexpr size_t ARRAY_ALIGNMENT = 64;
+	using Indices = std::index_sequence_for<Fields...>;
+
+	template <bool bConst>
+	class Iterator
+	{
+		using Owner = std::conditional_t<bConst, const SoAVector, SoAVector>;
+
+	public:
+		Iterator(Owner* pOwner, size_t index)
+			: m_pOwner(pOwner)
+			, m_iIndex(index)
+		{}
+
+		auto operator*() const { return (*m_pOwner)[m_iIndex]; }
+		Iterator& operator++() { ++m_iIndex; return *this; }
+		bool operator==(const Iterator& other) const { return m_iIndex == other.m_iIndex; }
+		bool operator!=(const Iterator& other) const { return m_iIndex != other.m_iIndex; }
+
+	private:
+		Owner*		m_pOwner;
+		size_t		m_iIndex;
+	};
+
+public:
+
+	template <size_t I>
+	using FieldType = std::tuple_element_t<I, std::tuple<Fields...>>;
+	using reference = std::tuple<Fields&...>;
+	using const_reference = std::tuple<const Fields&...>;
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	/** @brief Default constructor **/
+	SoAVector() = default;
+
+	/** @brief	Construct with given size and value-initialized elements
+	*
+	*	@param size
+	*/
+	explicit SoAVector(size_t size)
+	{
+		resize(size);
+	}
+
+	SoAVector(const SoAVector&) = delete;
+	SoAVector& operator=(const SoAVector&) = delete;
+
+	/** @brief	Move the arrays from another SoAVector, and leave it empty
+	*
+	*	@param other the other SoAVector object
+	*/
+	SoAVector(SoAVector&& other)
+	{
+		takeFrom(other);
+	}
+
+	/** @brief	Move the arrays from another SoAVector, and leave it empty
+	*
+	*	@param other the other SoAVector object
+	*/
+	SoAVector& operator=(SoAVector&& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			release();
+			takeFrom(other);
+		}
+		return *this;
+	}
+
+	/** @brief Destroy the elements and free the arrays */
+	~SoAVector()
+	{
+		clear();
+		release();
+	}
+
+	/** @brief Return the current size */
+	inline size_t size() const
+	{
+		return m_iSize;
+	}
+
+	/** @brief Return the current capacity */
+	inline size_t capacity() const
+	{
+		return m_iCapacity;
+	}
+
+	/** @brief Return if the container is empty */
+	inline bool empty() const
+	{
+		return m_iSize == 0;
+	}
+
+	/** @brief	Add an element at the end, one argument per field
+	*
+	*	@param args the value of each field, forwarded to its constructor
+	*/
+	template <class... Args>
+	void emplace_back(Args&&... args)
+	{
+		static_assert(sizeof...(Args) == FIELD_NUM, "one argument per field");
+		if (m_iSize >= m_iCapacity)
+		{
+			// args may refer to an element about to be relocated
+			std::tuple<Fields...> item(std::forward<Args>(args)...);
+			reserve(m_iCapacity == 0 ? 16 : m_iCapacity * 2);
+			constructFrom(m_iSize, std::move(item), Indices());
+		}
+		else
+		{
+			construct(m_iSize, Indices(), std::forward<Args>(args)...);
+		}
+		m_iSize++;
+	}
+
+	/** @brief Add an element at the end, one value per field */
+	void push_back(const Fields&... values)
+	{
+		emplace_back(values...);
+	}
+
+	/** @brief Remove the last element, keep capacity unchanged */
+	void pop_back()
+	{
+		assert(m_iSize > 0);
+		m_iSize--;
+		destroy(m_iSize, 1, Indices());
+	}
+
+	/** @brief	Remove the element at index by moving the last element into its place,
+	*		changes the order of elements
+	*
+	*	@param index the element to remove
+	*/
+	void swap_remove(size_t index)
+	{
+		assert(index < m_iSize);
+		if (index != m_iSize - 1)
+		{
+			moveAssign(index, m_iSize - 1, Indices());
+		}
+		pop_back();
+	}
+
+	/** @brief	Resize the container, value-initializing new elements or destroying the
+	*		ones beyond the new size
+	*
+	*	@param size the new size
+	*/
+	void resize(size_t size)
+	{
+		if (size > m_iSize)
+		{
+			reserve(size);
+			constructDefault(m_iSize, size - m_iSize, Indices());
+		}
+		else
+		{
+			destroy(size, m_iSize - size, Indices());
+		}
+		m_iSize = size;
+	}
+
+	/** @brief	Reserve the capacity of every array
+	*
+	*	@param capacity the new capacity
+	*/
+	void reserve(size_t capacity)
+	{
+		if (capacity > m_iCapacity)
+		{
+			reallocate(capacity);
+		}
+	}
+
+	/** @brief Destroy the elements, leaving the capacity and allocated memory unchanged */
+	void clear()
+	{
+		destroy(0, m_iSize, Indices());
+		m_iSize = 0;
+	}
+
+	/** @brief Return the references to the fields of the index-th element */
+	reference operator[](size_t index)
+	{
+		return element(index, Indices());
+	}
+
+	/** @brief Return the const references to the fields of the index-th element */
+	const_reference operator[](size_t index) const
+	{
+		return element(index, Indices());
+	}
+
+	/** @brief Return the I-th field of the index-th element */
+	template <size_t I>
+	FieldType<I>& get(size_t index)
+	{
+		return data<I>()[index];
+	}
+
+	/** @brief Return the I-th field of the index-th element */
+	template <size_t I>
+	const FieldType<I>& get(size_t index) const
+	{
+		return data<I>()[index];
+	}
+
+	/** @brief Return the array of the I-th field, aligned to a cache line */
+	template <size_t I>
+	FieldType<I>* data()
+	{
+		return static_cast<FieldType<I>*>(m_pArrays[I]);
+	}
+
+	/** @brief Return the array of the I-th field, aligned to a cache line */
+	template <size_t I>
+	const FieldType<I>* data() const
+	{
+		return static_cast<const FieldType<I>*>(m_pArrays[I]);
+	}
+
+	iterator begin()
+	{
+		return iterator(this, 0);
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(this, 0);
+	}
+
+	iterator end()
+	{
+		return iterator(this, m_iSize);
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator(this, m_iSize);
+	}
+
+private:
+
+	static constexpr size_t roundUp(size_t size)
+	{
+		return (size + ARRAY_ALIGNMENT - 1) & ~(ARRAY_ALIGNMENT - 1);
+	}
+
+	template <size_t... I>
+	reference element(size_t index, std::index_sequence<I...>)
+	{
+		return reference(data<I>()[index]...);
+	}
+
+	template <size_t... I>
+	const_reference element(size_t index, std::index_sequence<I...>) const
+	{
+		return const_reference(data<I>()[index]...);
+	}
+
+	template <size_t... I, class... Args>
+	void construct(size_t index, std::index_sequence<I...>, Args&&... args)
+	{
+		(new (&data<I>()[index]) FieldType<I>(std::forward<Args>(args)), ...);
+	}
+
+	template <size_t... I>
+	void constructFrom(size_t index, std::tuple<Fields...>&& item, std::index_sequence<I...>)
+	{
+		(new (&data<I>()[index]) FieldType<I>(std::move(std::get<I>(item))), ...);
+	}
+
+	template <size_t... I>
+	void constructDefault(size_t index, size_t num, std::index_sequence<I...>)
+	{
+		(constructDefaultField<I>(index, num), ...);
+	}
+
+	template <size_t I>
+	void constructDefaultField(size_t index, size_t num)
+	{
+		using T = FieldType<I>;
+		if constexpr (std::is_trivially_default_constructible<T>::value)
+		{
+			if (num > 0)
+			{
+				memset(&data<I>()[index], 0, sizeof(T) * num);
+			}
+		}
+		else
+		{
+			for (size_t i = index; i < index + num; ++i)
+			{
+				new (&data<I>()[i]) T();
+			}
+		}
+	}
+
+	template <size_t... I>
+	void destroy(size_t index, size_t num, std::index_sequence<I...>)
+	{
+		(destroyField<I>(index, num), ...);
+	}
+
+	template <size_t I>
+	void destroyField(size_t index, size_t num)
+	{
+		using T = FieldType<I>;
+		if constexpr (!std::is_trivially_destructible<T>::value)
+		{
+			for (size_t i = index; i < index + num; ++i)
+			{
+				data<I>()[i].~T();
+			}
+		}
+	}
+
+	template <size_t... I>
+	void moveAssign(size_t to, size_t from, std::index_sequence<I...>)
+	{
+		((data<I>()[to] = std::move(data<I>()[from])), ...);
+	}
+
+	/** @brief Move every array to a new allocation of the capacity, which must hold the elements */
+	void reallocate(size_t capacity)
+	{
+		static_assert(((alignof(Fields) <= ARRAY_ALIGNMENT) && ...), "field is over-aligned");
+		const size_t sizes[] = { sizeof(Fields)... };
+		size_t offsets[FIELD_NUM];
+		size_t total = 0;
+		for (size_t i = 0; i < FIELD_NUM; ++i)
+		{
+			offsets[i] = total;
+			total += roundUp(sizes[i] * capacity);
+		}
+
+		Handle hNewArrays(total, ARRAY_ALIGNMENT, MemoryTag::Container);
+		unsigned char* pNewBase = reinterpret_cast<unsigned char*>(hNewArrays.Raw());
+		assert(pNewBase && "out of memory");
+		void* pNewArrays[FIELD_NUM];
+		for (size_t i = 0; i < FIELD_NUM; ++i)
+		{
+			pNewArrays[i] = pNewBase + offsets[i];
+		}
+		relocate(pNewArrays, Indices());
+		if (m_iCapacity > 0)
+		{
+			m_hArrays.Free();
+		}
+		m_hArrays = hNewArrays;
+		for (size_t i = 0; i < FIELD_NUM; ++i)
+		{
+			m_pArrays[i] = pNewArrays[i];
+		}
+		m_iCapacity = capacity;
+		registerRelocation();
+	}
+
+	template <size_t... I>
+	void relocate(void* const* pNewArrays, std::index_sequence<I...>)
+	{
+		(relocateField<I>(static_cast<FieldType<I>*>(pNewArrays[I])), ...);
+	}
+
+	template <size_t I>
+	void relocateField(FieldType<I>* pTo)
+	{
+		using T = FieldType<I>;
+		T* pFrom = data<I>();
+		if constexpr (IsTriviallyRelocatable<T>::value)
+		{
+			if (m_iSize > 0)
+			{
+				memcpy(pTo, pFrom, sizeof(T) * m_iSize);
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < m_iSize; ++i)
+			{
+				new (&pTo[i]) T(std::move(pFrom[i]));
+				pFrom[i].~T();
+			}
+		}
+	}
+
+	/** @brief Free the memory, the elements must be destroyed */
+	void release()
+	{
+		if (m_iCapacity > 0)
+		{
+			m_hArrays.Free();
+		}
+		m_hArrays = Handle();
+		for (size_t i = 0; i < FIELD_NUM; ++i)
+		{
+			m_pArrays[i] = nullptr;
+		}
+		m_iCapacity = 0;
+	}
+
+	/** @brief Take the memory of other, this container must be empty without memory */
+	void takeFrom(SoAVector& other)
+	{
+		m_hArrays = other.m_hArrays;
+		for (size_t i = 0; i < FIELD_NUM; ++i)
+		{
+			m_pArrays[i] = other.m_pArrays[i];
+			other.m_pArrays[i] = nullptr;
+		}
+		m_iSize = other.m_iSize;
+		m_iCapacity = other.m_iCapacity;
+		other.m_hArrays = Handle();
+		other.m_iSize = 0;
+		other.m_iCapacity = 0;
+		registerRelocation();
+	}
+
+	/** @brief	Shift the cached array pointers after the defragmenter moved the allocation
+	*
+	*	@param pOwner the container owning the moved memory
+	*	@param pNewAddress the new address of the first array
+	*/
+	static void onRelocate(void* pOwner, void* pNewAddress)
+	{
+		SoAVector* pThis = static_cast<SoAVector*>(pOwner);
+		unsigned char* pOldBase = static_cast<unsigned char*>(pThis->m_pArrays[0]);
+		for (size_t i = 0; i < FIELD_NUM; ++i)
+		{
+			pThis->m_pArrays[i] = static_cast<unsigned char*>(pNewAddress) + (static_cast<unsigned char*>(pThis->m_pArrays[i]) - pOldBase);
+		}
+	}
+
+	/** @brief Let the defragmenter move the arrays, only when a byte copy is a valid move of every field */
+	void registerRelocation()
+	{
+		if constexpr ((IsTriviallyRelocatable<Fields>::value && ...))
+		{
+			if (m_iCapacity > 0)
+			{
+				m_hArrays.SetRelocationListener(&onRelocate, this);
+			}
+		}
+	}
+
+	Handle					m_hArrays;						// the allocation holding every array
+	void*					m_pArrays[FIELD_NUM] = {};		// the cached pointer to the array of each field
+	size_t					m_iSize = 0;					// the number of elements
+	size_t					m_iCapacity = 0;				// the number of elements every array can hold
+};
+
+} // namespace DE
@@ -0,0 +1,274 @@
+#pragma once
+
+// Engine
+#include <DECore/Memory/Handle.h>
+// Cpp
+#include <assert.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace DE
+{
+
+/** @brief	T is the class of the item to be stored, FirstChunkSize is the number of items
+*		in the first chunk, each following chunk doubles the previous one
+*		An indexed array whose elements never move, so pointers handed out stay valid
+*		until the element is destroyed. Index i lives in chunk floor(log2(i + FirstChunkSize))
+*		of a fixed chunk table, found with one bit scan. emplace_back and push_back
+*		are thread safe against each other: the index is claimed with an atomic
+*		counter and a missing chunk is allocated by one thread under a lock, the
+*		others wait for it rather than allocating their own copy. Reading an
+*		element appended by another thread needs the usual synchronization, e.g.
+*		waiting on the job counter. Other functions are not thread safe
+*/
+template <class T, uint32_t FirstChunkSize = 16>
+class StableVector
+{
+	static_assert(FirstChunkSize > 0 && (FirstChunkSize & (FirstChunkSize - 1)) == 0, "first chunk size must be power of two");
+
+	static constexpr uint32_t log2(uint32_t value)
+	{
+		return value <= 1 ? 0 : 1 + log2(value >> 1);
+	}
+
+	static constexpr uint32_t FIRST_SHIFT = log2(FirstChunkSize);
+	static constexpr uint32_t CHUNK_NUM = 32 - FIRST_SHIFT;
+
+	template <bool bConst>
+	class Iterator
+	{
+		using Owner = std::conditional_t<bConst, const StableVector, StableVector>;
+		using Item = std::conditional_t<bConst, const T, T>;
+
+	public:
+		Iterator(Owner* pOwner, uint32_t index)
+			: m_pOwner(pOwner)
+			, m_iIndex(index)
+		{}
+
+		Item& operator*() const { return (*m_pOwner)[m_iIndex]; }
+		Item* operator->() const { return &(*m_pOwner)[m_iIndex]; }
+		Iterator& operator++() { ++m_iIndex; return *this; }
+		bool operator==(const Iterator& other) const { return m_iIndex == other.m_iIndex; }
+		bool operator!=(const Iterator& other) const { return m_iIndex != other.m_iIndex; }
+
+	private:
+		Owner*		m_pOwner;
+		uint32_t	m_iIndex;
+	};
+
+public:
+
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+
+	/** @brief Default constructor, no memory is allocated until the first element **/
+	StableVector() = default;
+
+	StableVector(const StableVector&) = delete;
+	StableVector& operator=(const StableVector&) = delete;
+
+	/** @brief Destroy the elements and free the chunks */
+	~StableVector()
+	{
+		clear();
+		for (uint32_t chunk = 0; chunk < CHUNK_NUM; ++chunk)
+		{
+			if (m_pChunks[chunk].load(std::memory_order_relaxed) != nullptr)
+			{
+				m_hChunks[chunk].Free();
+			}
+		}
+	}
+
+	/** @brief Return the number of elements, including the ones being constructed by other threads */
+	inline size_t size() const
+	{
+		return m_iSize.load(std::memory_order_acquire);
+	}
+
+	/** @brief Return if the array is empty */
+	inline bool empty() const
+	{
+		return size() == 0;
+	}
+
+	/** @brief Add an element at the end of this array, thread safe against other appends */
+	T& push_back(const T& item)
+	{
+		return emplace_back(item);
+	}
+
+	/** @brief Add an movable element at the end of this array, thread safe against other appends */
+	T& push_back(T&& item)
+	{
+		return emplace_back(std::move(item));
+	}
+
+	/** @brief	Construct an element in place at the end of this array, thread safe against
+	*		other appends. Never moves the existing elements
+	*
+	*	@param args the parameter forward to T's constructor
+	*	@return the new element, its address is stable
+	*/
+	template <class... Args>
+	T& emplace_back(Args&&... args)
+	{
+		const uint32_t index = m_iSize.fetch_add(1, std::memory_order_relaxed);
+		assert(index < UINT32_MAX - FirstChunkSize && "StableVector is full");
+		uint32_t offset;
+		const uint32_t chunk = locate(index, offset);
+		T* pItem = acquireChunk(chunk) + offset;
+		return *new (pItem) T(std::forward<Args>(args)...);
+	}
+
+	/** @brief Remove the last element, the chunks are kept */
+	void pop_back()
+	{
+		assert(!empty());
+		back().~T();
+		m_iSize.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	/** @brief Allocate the chunks to hold the given number of elements, so appending does not allocate */
+	void reserve(size_t capacity)
+	{
+		if (capacity == 0)
+		{
+			return;
+		}
+		uint32_t offset;
+		const uint32_t lastChunk = locate(static_cast<uint32_t>(capacity - 1), offset);
+		for (uint32_t chunk = 0; chunk <= lastChunk; ++chunk)
+		{
+			acquireChunk(chunk);
+		}
+	}
+
+	/** @brief Destroy the elements, leaving the chunks allocated */
+	void clear()
+	{
+		const uint32_t num = static_cast<uint32_t>(size());
+		for (uint32_t i = 0; i < num; ++i)
+		{
+			(*this)[i].~T();
+		}
+		m_iSize.store(0, std::memory_order_relaxed);
+	}
+
+	/** @brief Return the element located the index-th element */
+	T& operator[](size_t index)
+	{
+		uint32_t offset;
+		const uint32_t chunk = locate(static_cast<uint32_t>(index), offset);
+		return m_pChunks[chunk].load(std::memory_order_acquire)[offset];
+	}
+
+	/** @brief Return the element located the index-th element */
+	const T& operator[](size_t index) const
+	{
+		uint32_t offset;
+		const uint32_t chunk = locate(static_cast<uint32_t>(index), offset);
+		return m_pChunks[chunk].load(std::memory_order_acquire)[offset];
+	}
+
+	T& back()
+	{
+		return (*this)[size() - 1];
+	}
+
+	const T& back() const
+	{
+		return (*this)[size() - 1];
+	}
+
+	/** @brief	Iterate the contiguous runs of elements, e.g. to pass them to an API taking
+	*		an array
+	*
+	*	@param func function taking (T* pFirst, uint32_t num)
+	*/
+	template <class Func>
+	void ForEachChunk(Func&& func)
+	{
+		const uint32_t num = static_cast<uint32_t>(size());
+		uint32_t begin = 0;
+		for (uint32_t chunk = 0; begin < num; ++chunk)
+		{
+			const uint32_t chunkSize = FirstChunkSize << chunk;
+			const uint32_t remain = num - begin;
+			func(m_pChunks[chunk].load(std::memory_order_acquire), remain < chunkSize ? remain : chunkSize);
+			begin += chunkSize;
+		}
+	}
+
+	iterator begin()
+	{
+		return iterator(this, 0);
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(this, 0);
+	}
+
+	iterator end()
+	{
+		return iterator(this, static_cast<uint32_t>(size()));
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator(this, static_cast<uint32_t>(size()));
+	}
+
+private:
+
+	/** @brief Return the chunk of an index and the offset in it */
+	static uint32_t locate(uint32_t index, uint32_t& offset)
+	{
+		const uint32_t biased = index + FirstChunkSize;
+#if defined(_MSC_VER)
+		unsigned long highest;
+		_BitScanReverse(&highest, biased);
+#else
+		const uint32_t highest = 31 - __builtin_clz(biased);
+#endif
+		offset = biased - (1u << highest);
+		return static_cast<uint32_t>(highest) - FIRST_SHIFT;
+	}
+
+	/** @brief Return the chunk, allocating it if no thread did yet */
+	T* acquireChunk(uint32_t chunk)
+	{
+		T* pChunk = m_pChunks[chunk].load(std::memory_order_acquire);
+		if (pChunk != nullptr)
+		{
+			return pChunk;
+		}
+		// only one thread allocates a chunk, late chunks are large and their size class has few blocks
+		std::lock_guard<std::mutex> lock(m_ChunkMutex);
+		pChunk = m_pChunks[chunk].load(std::memory_order_relaxed);
+		if (pChunk == nullptr)
+		{
+			m_hChunks[chunk] = Handle(sizeof(T) * (static_cast<size_t>(FirstChunkSize) << chunk), alignof(T), MemoryTag::Container);
+			pChunk = reinterpret_cast<T*>(m_hChunks[chunk].Raw());
+			assert(pChunk != nullptr && "StableVector chunk allocation failed");
+			m_pChunks[chunk].store(pChunk, std::memory_order_release);
+		}
+		return pChunk;
+	}
+
+	std::atomic<T*>			m_pChunks[CHUNK_NUM] = {};		// chunk k holds FirstChunkSize << k elements, never moved
+	Handle					m_hChunks[CHUNK_NUM];			// the memory of each installed chunk
+	std::mutex				m_ChunkMutex;					// taken to allocate a missing chunk
+	std::atomic<uint32_t>	m_iSize = { 0 };				// the number of claimed indices
+};
+
+} // namespace DE
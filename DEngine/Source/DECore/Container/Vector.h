@@ -2,10 +2,23 @@
 
 // Engine
 #include <DECore/Memory/Handle.h>
+// Cpp
+#include <assert.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
 
 namespace DE
 {
 
+/** @brief	Whether moving a T to another address is a plain byte copy, so MyArray can grow
+*		with memcpy and let the defragmenter move its elements. Defaults to trivially
+*		copyable; specialize to true for a type that only owns resources by pointer
+*		and never refers to its own address (e.g. a ComPtr wrapper)
+*/
+template <class T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
 /** @brief T is the class of the item to be stored
 *		This is the default contiguous array to be used in DEngine, it behaves
 *		in similar way as std::vector
@@ -33,12 +46,11 @@ public:
 		m_iCapacity = size;
 		if (size > 0)
 		{
-			m_hElements.Set(sizeof(T) * size);
+			m_hElements.Set(sizeof(T) * size, alignof(T), MemoryTag::Container);
 			m_pBegin = reinterpret_cast<T*>(m_hElements.Raw());
-			for (uint32_t i = 0; i < size; ++i)
-			{
-				new (&m_pBegin[i]) T();
-			}
+			assert(m_pBegin && "out of memory");
+			registerRelocation();
+			constructDefault(m_pBegin, size);
 		}
 	}
 
@@ -48,14 +60,7 @@ public:
 	*/
 	MyArray(MyArray&& other)
 	{
-		m_hElements = other.m_hElements;
-		other.m_hElements.m_counter = -1;
-		m_hElements.m_counter++;
-		m_iSize = other.m_iSize;
-		m_iCapacity = other.m_iCapacity;
-		m_pBegin = reinterpret_cast<T*>(m_hElements.Raw());
-		other.m_iCapacity = 0;
-		other.m_iSize = 0;
+		takeFrom(other);
 	}
 
 	/** @brief	Move the other handle from another array, and invalidate it
@@ -64,14 +69,12 @@ public:
 	*/
 	const MyArray& operator=(MyArray&& other)
 	{
-		m_hElements = other.m_hElements;
-		other.m_hElements.m_counter = -1;
-		m_hElements.m_counter++;
-		m_iSize = other.m_iSize;
-		m_iCapacity = other.m_iCapacity;
-		m_pBegin = reinterpret_cast<T*>(m_hElements.Raw());
-		other.m_iCapacity = 0;
-		other.m_iSize = 0;
+		if (this != &other)
+		{
+			clear();
+			release();
+			takeFrom(other);
+		}
 		return *this;
 	}
 
@@ -79,10 +82,7 @@ public:
 	~MyArray()
 	{
 		clear();
-		if (m_iCapacity > 0)
-		{
-			m_hElements.Free();
-		}
+		release();
 	}
 
 	/** @brief Return the current size
@@ -128,18 +128,18 @@ public:
 	template<class... Args>
 	T& emplace_back(Args&&... args)
 	{
-		if (m_iCapacity == 0)
-		{
-			reserve(1);
-		}
 		if (m_iSize >= m_iCapacity)
 		{
-			reserve(m_iCapacity * 2);
+			// args may refer to an element about to be relocated
+			T item(std::forward<Args>(args)...);
+			reserve(m_iCapacity == 0 ? 1 : m_iCapacity * 2);
+			T* pItem = new (&m_pBegin[m_iSize]) T(std::move(item));
+			m_iSize++;
+			return *pItem;
 		}
-		new (&m_pBegin[m_iSize]) T(std::forward<Args>(args)...);
+		T* pItem = new (&m_pBegin[m_iSize]) T(std::forward<Args>(args)...);
 		m_iSize++;
-
-		return m_pBegin[m_iSize];
+		return *pItem;
 	}
 
 	/** @brief Remove the last element, keep capacity unchanged */
@@ -149,52 +149,175 @@ public:
 		m_iSize--;
 	}
 
-	/** @brief Resize the array and construct all elements
+	/** @brief Resize the array, default constructing new elements in one pass or
+	*		destroying the ones beyond the new size
 	*
 	*	@param size the new size
 	*/
 	void resize(size_t size)
 	{
-		reserve(size);
-		for (auto i = m_iSize; i < size; ++i)
+		if (size > m_iSize)
+		{
+			reserve(size);
+			constructDefault(m_pBegin + m_iSize, size - m_iSize);
+		}
+		else
 		{
-			push_back(T());
+			destroy(m_pBegin + size, m_iSize - size);
 		}
 		m_iSize = size;
-	}	
-	
-	/** @brief Reserve the array's capavity
+	}
+
+	/** @brief Replace the content with count copies of value
 	*
-	*	@param capacity the new capacity
+	*	@param count the new size
+	*	@param value the value copied
 	*/
-	void reserve(std::size_t capacity)
+	void assign(size_t count, const T& value)
 	{
-		std::size_t oldCapacity = m_iCapacity;
-		if (capacity > oldCapacity)
+		clear();
+		reserve(count);
+		for (size_t i = 0; i < count; ++i)
 		{
-			m_iCapacity = capacity;
-			Handle hNewElements(sizeof(T) * capacity);
-			if (oldCapacity > 0)
+			new (&m_pBegin[i]) T(value);
+		}
+		m_iSize = count;
+	}
+
+	/** @brief Replace the content with a copy of a range, which must not be inside this array
+	*
+	*	@param first pointer to the first element
+	*	@param last pointer past the last element
+	*/
+	void assign(const T* first, const T* last)
+	{
+		assert(last < begin() || first >= end());
+		clear();
+		insert(begin(), first, last);
+	}
+
+	/** @brief Insert an element before pos
+	*
+	*	@param pos position in this array, end() to append
+	*	@param item the item to be inserted
+	*	@return the inserted element
+	*/
+	iterator insert(const_iterator pos, const T& item)
+	{
+		const size_t index = pos - m_pBegin;
+		if (index == m_iSize)
+		{
+			return &emplace_back(item);
+		}
+		T copy(item); // item may be an element of this array
+		openGap(index, 1);
+		new (&m_pBegin[index]) T(std::move(copy));
+		return m_pBegin + index;
+	}
+
+	/** @brief Construct an element in place before pos
+	*
+	*	@param pos position in this array, end() to append
+	*	@param args the parameter forward to T's constructor
+	*	@return the inserted element
+	*/
+	template<class... Args>
+	iterator emplace(const_iterator pos, Args&&... args)
+	{
+		const size_t index = pos - m_pBegin;
+		if (index == m_iSize)
+		{
+			return &emplace_back(std::forward<Args>(args)...);
+		}
+		T item(std::forward<Args>(args)...); // args may refer to an element of this array
+		openGap(index, 1);
+		new (&m_pBegin[index]) T(std::move(item));
+		return m_pBegin + index;
+	}
+
+	/** @brief Insert a copy of a range before pos, the range must not be inside this array
+	*
+	*	@param pos position in this array, end() to append
+	*	@param first pointer to the first element
+	*	@param last pointer past the last element
+	*	@return the first inserted element
+	*/
+	iterator insert(const_iterator pos, const T* first, const T* last)
+	{
+		const size_t index = pos - m_pBegin;
+		const size_t count = last - first;
+		if (count == 0)
+		{
+			return m_pBegin + index;
+		}
+		assert(last <= begin() || first >= end());
+		openGap(index, count);
+		if constexpr (std::is_trivially_copyable<T>::value)
+		{
+			memcpy(m_pBegin + index, first, sizeof(T) * count);
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
 			{
-				memcpy(hNewElements.Raw(), m_hElements.Raw(), sizeof(T) * m_iSize);
-				m_hElements.Free();
+				new (&m_pBegin[index + i]) T(first[i]);
 			}
-			m_hElements = hNewElements;
-			m_pBegin = reinterpret_cast<T*>(m_hElements.Raw());
 		}
+		return m_pBegin + index;
 	}
 
-	/** @brief Clear the items in this array, leaving the capacity and allocated memory unchanged */
-	void clear()
+	/** @brief Remove the element at pos, shifting the elements after it
+	*
+	*	@param pos position of the element in this array
+	*	@return the element following the removed one
+	*/
+	iterator erase(const_iterator pos)
+	{
+		const size_t index = pos - m_pBegin;
+		assert(index < m_iSize);
+		m_pBegin[index].~T();
+		relocate(m_pBegin + index + 1, m_pBegin + index, m_iSize - index - 1);
+		m_iSize--;
+		return m_pBegin + index;
+	}
+
+	/** @brief Reduce the capacity to the size, freeing the memory if empty */
+	void shrink_to_fit()
 	{
-		for (uint32_t i = 0; i < m_iSize; ++i)
+		if (m_iCapacity == m_iSize)
 		{
-			m_pBegin[i].~T();
+			return;
 		}
-		if (m_iCapacity > 0)
+		if (m_iSize == 0)
+		{
+			release();
+			return;
+		}
+		reallocate(m_iSize);
+	}
+	
+	/** @brief Reserve the array's capavity
+	*
+	*	@param capacity the new capacity
+	*/
+	void reserve(std::size_t capacity)
+	{
+		if (capacity > m_iCapacity)
 		{
-			memset(m_pBegin, NULL, sizeof(T) * m_iSize);
+			reallocate(capacity);
 		}
+	}
+
+	/** @brief Return the current capacity */
+	inline size_t capacity() const
+	{
+		return m_iCapacity;
+	}
+
+	/** @brief Destroy the items in this array, leaving the capacity and allocated memory unchanged */
+	void clear()
+	{
+		destroy(m_pBegin, m_iSize);
 		m_iSize = 0;
 	}
 
@@ -273,8 +396,161 @@ public:
 
 private:
 
+	/** @brief Default construct num elements in uninitialized memory, zero filled in one call for trivial types */
+	static void constructDefault(T* pBegin, size_t num)
+	{
+		if constexpr (std::is_trivially_default_constructible<T>::value)
+		{
+			if (num > 0)
+			{
+				memset(pBegin, 0, sizeof(T) * num); // value initialized, same as T()
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < num; ++i)
+			{
+				new (&pBegin[i]) T();
+			}
+		}
+	}
+
+	static void destroy(T* pBegin, size_t num)
+	{
+		if constexpr (!std::is_trivially_destructible<T>::value)
+		{
+			for (size_t i = 0; i < num; ++i)
+			{
+				pBegin[i].~T();
+			}
+		}
+	}
+
+	/** @brief Move num elements to uninitialized memory and end the lifetime of the source */
+	static void relocate(T* pFrom, T* pTo, size_t num)
+	{
+		if constexpr (IsTriviallyRelocatable<T>::value)
+		{
+			if (num > 0)
+			{
+				memmove(pTo, pFrom, sizeof(T) * num);
+			}
+		}
+		else if (pTo > pFrom)
+		{
+			// backward so an overlapping shift within the array never reads a moved element
+			for (size_t i = num; i-- > 0;)
+			{
+				new (&pTo[i]) T(std::move(pFrom[i]));
+				pFrom[i].~T();
+			}
+		}
+		else
+		{
+			// element may refer to its own address (e.g. a nested array registered for relocation)
+			for (size_t i = 0; i < num; ++i)
+			{
+				new (&pTo[i]) T(std::move(pFrom[i]));
+				pFrom[i].~T();
+			}
+		}
+	}
+
+	/** @brief Move the elements to a new allocation of the capacity, which must hold them */
+	void reallocate(size_t capacity)
+	{
+		Handle hNewElements(sizeof(T) * capacity, alignof(T), MemoryTag::Container);
+		T* pNewBegin = reinterpret_cast<T*>(hNewElements.Raw());
+		assert(pNewBegin && "out of memory");
+		relocate(m_pBegin, pNewBegin, m_iSize);
+		if (m_iCapacity > 0)
+		{
+			m_hElements.Free();
+		}
+		m_hElements = hNewElements;
+		m_pBegin = pNewBegin;
+		m_iCapacity = capacity;
+		registerRelocation();
+	}
+
+	/** @brief Make count uninitialized slots at index, shifting the elements after it */
+	void openGap(size_t index, size_t count)
+	{
+		const size_t size = m_iSize + count;
+		if (size > m_iCapacity)
+		{
+			const size_t grown = m_iCapacity * 2;
+			Handle hNewElements(sizeof(T) * (size > grown ? size : grown), alignof(T), MemoryTag::Container);
+			T* pNewBegin = reinterpret_cast<T*>(hNewElements.Raw());
+			assert(pNewBegin && "out of memory");
+			relocate(m_pBegin, pNewBegin, index);
+			relocate(m_pBegin + index, pNewBegin + index + count, m_iSize - index);
+			if (m_iCapacity > 0)
+			{
+				m_hElements.Free();
+			}
+			m_hElements = hNewElements;
+			m_pBegin = pNewBegin;
+			m_iCapacity = size > grown ? size : grown;
+			registerRelocation();
+		}
+		else
+		{
+			relocate(m_pBegin + index, m_pBegin + index + count, m_iSize - index);
+		}
+		m_iSize = size;
+	}
+
+	/** @brief Free the memory, the elements must be destroyed */
+	void release()
+	{
+		if (m_iCapacity > 0)
+		{
+			m_hElements.Free();
+		}
+		m_hElements = Handle();
+		m_pBegin = nullptr;
+		m_iCapacity = 0;
+	}
+
+	/** @brief Take the memory of other, this array must be empty without memory */
+	void takeFrom(MyArray& other)
+	{
+		m_hElements = other.m_hElements;
+		m_pBegin = other.m_pBegin;
+		m_iSize = other.m_iSize;
+		m_iCapacity = other.m_iCapacity;
+		other.m_hElements = Handle();
+		other.m_pBegin = nullptr;
+		other.m_iSize = 0;
+		other.m_iCapacity = 0;
+		registerRelocation();
+	}
+
+	/** @brief	Refresh the cached pointer after the defragmenter moved the elements
+	*
+	*	@param pOwner the array owning the moved memory
+	*	@param pNewAddress the new address of the first element
+	*/
+	static void onRelocate(void* pOwner, void* pNewAddress)
+	{
+		static_cast<MyArray*>(pOwner)->m_pBegin = static_cast<T*>(pNewAddress);
+	}
+
+	/** @brief	Let the defragmenter move the elements, only when a byte copy is a valid move of T */
+	void registerRelocation()
+	{
+		if constexpr (IsTriviallyRelocatable<T>::value)
+		{
+			if (m_iCapacity > 0)
+			{
+				m_hElements.SetRelocationListener(&onRelocate, this);
+			}
+		}
+	}
+
 	Handle					m_hElements;		// the handle array containing the exact data
-	T*						m_pBegin;			// the cached pointer to the first element
+	T*						m_pBegin = nullptr;	// the cached pointer to the first element
 	std::size_t				m_iSize = 0;		// the current size of array
 	std::size_t				m_iCapacity = 0;	// the current capacity
 };
@@ -4,6 +4,8 @@
 #include <DECore/DECore.h>
 #include <DECore/FileSystem/FileLoader.h>
 #include <DECore/Job/JobScheduler.h>
+#include <DECore/Container/SmallVector.h>
+#include <DECore/Memory/MemoryTag.h>
 // Cpp
 #include <fstream>
 #include <assert.h>
@@ -13,6 +15,7 @@ namespace DE
 
 void FileLoader::LoadSync(const char* path, Vector<char>& output)
 {
+	MemoryTagScope memoryScope(MemoryTag::Loader);
 	std::ifstream fs;
 	fs.open(path, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
 	assert(fs);
@@ -30,6 +33,7 @@ struct LoadFileData
 
 void LoadFile(void* data)
 {
+	MemoryTagScope memoryScope(MemoryTag::Loader);
 	LoadFileData* pData = reinterpret_cast<LoadFileData*>(data);
 	std::ifstream fs;
 	fs.open(pData->path, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
@@ -43,11 +47,10 @@ void LoadFile(void* data)
 JobFuture<Vector<char>> FileLoader::LoadAsync(const char* path)
 {
 	auto output = std::make_unique<Vector<char>>();
-	Vector<Job::Desc> jobDescs(1);
+	SmallVector<Job::Desc, 1> jobDescs;
 	LoadFileData* data = new LoadFileData{ path, output.get() };
-	Job::Desc desc(&LoadFile, data, nullptr);
-	jobDescs[0] = std::move(desc);
-	return JobFuture<Vector<char>>( JobScheduler::Instance()->Run(jobDescs), std::move(output) );
+	jobDescs.emplace_back(&LoadFile, data, nullptr);
+	return JobFuture<Vector<char>>( JobScheduler::Instance()->Run(jobDescs.data(), static_cast<uint32_t>(jobDescs.size())), std::move(output) );
 }
 
 }
\ No newline at end of file
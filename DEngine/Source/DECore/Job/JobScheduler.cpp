@@ -2,6 +2,8 @@
 #include "JobScheduler.h"
 #include "JobWorker.h"
 #include "Job.h"
+#include <DECore/Memory/MemoryTag.h>
+#include <DECore/Memory/MemoryResource.h>
 
 #include <assert.h>
 #include <thread>
@@ -16,6 +18,7 @@ void EmptyJob(void*) {}
 
 void JobScheduler::StartUp(uint8_t numThreads)
 {
+	MemoryTagScope memoryScope(MemoryTag::Job);
 	m_iNumWorker = numThreads;
 	m_Workers.reserve(m_iNumWorker);
 	for (uint8_t cnt = 0; cnt < m_iNumWorker; ++cnt)
@@ -37,18 +40,27 @@ void JobScheduler::ShutDown()
 		m_Workers[cnt]->End();
 	}
 	m_Workers.clear();
-	
+	ScratchMemoryResource::ReleaseThreadBuffer(); // main thread is worker 0
+
+	// Instance() makes a new scheduler after this one is gone
+	m_pInstance = nullptr;
 	delete this;
 }
 
 Job* JobScheduler::Run(Vector<Job::Desc>& jobDescs)
+{
+	return Run(jobDescs.data(), static_cast<uint32_t>(jobDescs.size()));
+}
+
+Job* JobScheduler::Run(Job::Desc* jobDescs, uint32_t num)
 {
 	Job::Desc parent(&EmptyJob, nullptr, nullptr);
-	parent.m_iUnfinished = static_cast<uint32_t>(jobDescs.size()) + 1;
+	parent.m_iUnfinished = num + 1;
 	Job* counter = m_Workers[0]->Push(parent);
 
-	for (auto& desc : jobDescs)
+	for (uint32_t i = 0; i < num; ++i)
 	{
+		Job::Desc& desc = jobDescs[i];
 		desc.m_iUnfinished++;
 		desc.m_pParent = counter;
 		m_Workers[0]->Push(desc); // push to main thread only for now
@@ -23,6 +23,12 @@ public:
 	*/
 	Job* Run(Vector<Job::Desc>& jobDescs);
 
+	/** @brief Put an array of jobs onto the scheduler and run it, e.g. from a SmallVector
+	*
+	*	@return a job as a counter to call WaitOnMainThread() on
+	*/
+	Job* Run(Job::Desc* jobDescs, uint32_t num);
+
 	/** @brief Get a job from the scheduler by stealing from other threads
 	*
 	*	@return a stolen job
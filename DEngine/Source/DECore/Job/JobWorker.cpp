@@ -2,6 +2,7 @@
 #include "JobWorker.h"
 #include "JobScheduler.h"
 #include "Job.h"
+#include <DECore/Memory/MemoryResource.h>
 
 #include <Windows.h>
 #include <thread>
@@ -134,6 +135,7 @@ void JobWorker::RunLoop()
 	}
 
 	// scheduler being shut down
+	ScratchMemoryResource::ReleaseThreadBuffer();
 }
 
 }
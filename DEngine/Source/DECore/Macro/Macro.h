@@ -1,9 +1,20 @@
 #pragma once
 
+#if defined(_WIN32)
 #include <windows.h> 
+#endif
 
 #if DLL_EXPORT
 #define DllExport __declspec(dllexport)
 #else
 #define DllExport
-#endif
\ No newline at end of file
+#endif
+
+// Memory debugging (poisoning, guard bands, handle generation check), on by default in debug build
+#ifndef DE_MEMORY_DEBUG
+#if defined(DEBUG)
+#define DE_MEMORY_DEBUG 1
+#else
+#define DE_MEMORY_DEBUG 0
+#endif
+#endif
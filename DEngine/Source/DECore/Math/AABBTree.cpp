@@ -0,0 +1,763 @@
+#include <DECore/DECore.h>
+#include "AABBTree.h"
+
+#include <DECore/Container/SmallVector.h>
+
+#include <algorithm>
+#include <assert.h>
+
+namespace DE
+{
+
+namespace
+{
+
+using SIMD::Float4;
+
+constexpr uint32_t BIN_NUM = 16;			// split candidates per axis of Rebuild()
+constexpr uint32_t STACK_INLINE = 64;		// nodes pending in a query before the stack allocates
+constexpr uint32_t INSIDE_BIT = 1u << 31;	// on a stacked node, every leaf below is inside the frustum
+
+inline float Area(const float* min, const float* max)
+{
+	const float x = max[0] - min[0];
+	const float y = max[1] - min[1];
+	const float z = max[2] - min[2];
+	return 2.0f * (x * y + y * z + z * x);
+}
+
+inline float MergedArea(const float* minA, const float* maxA, const float* minB, const float* maxB)
+{
+	float min[3], max[3];
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		min[i] = minA[i] < minB[i] ? minA[i] : minB[i];
+		max[i] = maxA[i] > maxB[i] ? maxA[i] : maxB[i];
+	}
+	return Area(min, max);
+}
+
+/** @brief Return the larger of the 4 lanes in every lane */
+inline Float4 HorizontalMax(Float4 a)
+{
+	a = SIMD::Max(a, SIMD::Shuffle<2, 3, 0, 1>(a));
+	return SIMD::Max(a, SIMD::Shuffle<1, 0, 3, 2>(a));
+}
+
+/** @brief Return the smaller of the 4 lanes in every lane */
+inline Float4 HorizontalMin(Float4 a)
+{
+	a = SIMD::Min(a, SIMD::Shuffle<2, 3, 0, 1>(a));
+	return SIMD::Min(a, SIMD::Shuffle<1, 0, 3, 2>(a));
+}
+
+/** @brief	The 6 planes of a frustum in two registers per component, left right bottom top
+*		in the first and near far near far in the second, a repeated plane changes nothing
+*/
+struct FrustumPlanes
+{
+	explicit FrustumPlanes(const Frustum& frustum)
+	{
+		const Plane* planes = frustum.GetPlanes();
+		const uint32_t order[8] = { 0, 1, 2, 3, 4, 5, 4, 5 };
+		alignas(16) float x[8], y[8], z[8], w[8];
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			const Vector3& normal = planes[order[i]].m_vNormal;
+			x[i] = normal.GetX();
+			y[i] = normal.GetY();
+			z[i] = normal.GetZ();
+			w[i] = normal.GetW();
+		}
+		for (uint32_t g = 0; g < 2; ++g)
+		{
+			nx[g] = SIMD::Load(x + g * 4);
+			ny[g] = SIMD::Load(y + g * 4);
+			nz[g] = SIMD::Load(z + g * 4);
+			d[g] = SIMD::Load(w + g * 4);
+			positiveX[g] = SIMD::CmpGT(nx[g], SIMD::Zero());
+			positiveY[g] = SIMD::CmpGT(ny[g], SIMD::Zero());
+			positiveZ[g] = SIMD::CmpGT(nz[g], SIMD::Zero());
+		}
+	}
+
+	Float4 nx[2], ny[2], nz[2], d[2];
+	Float4 positiveX[2], positiveY[2], positiveZ[2];	// all set where the normal points to +axis
+};
+
+enum class FrustumTest
+{
+	Outside,
+	Intersect,
+	Inside,
+};
+
+/** @brief	Test a box against all planes at once, the corner furthest along a plane normal
+*		decides whether the box is outside it, the nearest corner whether it is inside
+*/
+inline FrustumTest TestFrustum(const FrustumPlanes& planes, const float* boxMin, const float* boxMax)
+{
+	const Float4 min = SIMD::Load(boxMin);
+	const Float4 max = SIMD::Load(boxMax);
+	const Float4 minX = SIMD::Broadcast<0>(min), minY = SIMD::Broadcast<1>(min), minZ = SIMD::Broadcast<2>(min);
+	const Float4 maxX = SIMD::Broadcast<0>(max), maxY = SIMD::Broadcast<1>(max), maxZ = SIMD::Broadcast<2>(max);
+
+	uint32_t outside = 0;
+	uint32_t notInside = 0;
+	for (uint32_t g = 0; g < 2; ++g)
+	{
+		const Float4 farX = SIMD::Select(minX, maxX, planes.positiveX[g]);
+		const Float4 farY = SIMD::Select(minY, maxY, planes.positiveY[g]);
+		const Float4 farZ = SIMD::Select(minZ, maxZ, planes.positiveZ[g]);
+		const Float4 nearX = SIMD::Select(maxX, minX, planes.positiveX[g]);
+		const Float4 nearY = SIMD::Select(maxY, minY, planes.positiveY[g]);
+		const Float4 nearZ = SIMD::Select(maxZ, minZ, planes.positiveZ[g]);
+		const Float4 farDistance = SIMD::MulAdd(planes.nx[g], farX, SIMD::MulAdd(planes.ny[g], farY, SIMD::Mul(planes.nz[g], farZ)));
+		const Float4 nearDistance = SIMD::MulAdd(planes.nx[g], nearX, SIMD::MulAdd(planes.ny[g], nearY, SIMD::Mul(planes.nz[g], nearZ)));
+		outside |= SIMD::MoveMask(SIMD::CmpLT(farDistance, planes.d[g]));
+		notInside |= SIMD::MoveMask(SIMD::CmpLT(nearDistance, planes.d[g]));
+	}
+	return outside ? FrustumTest::Outside : (notInside ? FrustumTest::Intersect : FrustumTest::Inside);
+}
+
+} // namespace
+
+uint32_t AABBTree::allocateNode()
+{
+	if (m_iFreeList == NULL_NODE)
+	{
+		m_iFreeList = static_cast<uint32_t>(m_nodes.size());
+		Node& node = m_nodes.emplace_back();
+		node.m_iParent = NULL_NODE;
+		node.m_iHeight = -1;
+	}
+	const uint32_t index = m_iFreeList;
+	Node& node = m_nodes[index];
+	m_iFreeList = node.m_iParent;
+	node.m_iParent = NULL_NODE;
+	node.m_iChild1 = NULL_NODE;
+	node.m_iChild2 = NULL_NODE;
+	node.m_iHeight = 0;
+	return index;
+}
+
+void AABBTree::freeNode(uint32_t index)
+{
+	Node& node = m_nodes[index];
+	node.m_iParent = m_iFreeList;
+	node.m_iHeight = -1;
+	m_iFreeList = index;
+}
+
+void AABBTree::setFatBox(uint32_t leaf, const AABB& box)
+{
+	Node& node = m_nodes[leaf];
+	const Vector3& min = box.GetMin();
+	const Vector3& max = box.GetMax();
+	node.m_vMin[0] = min.GetX() - m_fMargin;
+	node.m_vMin[1] = min.GetY() - m_fMargin;
+	node.m_vMin[2] = min.GetZ() - m_fMargin;
+	node.m_vMin[3] = 0.0f;
+	node.m_vMax[0] = max.GetX() + m_fMargin;
+	node.m_vMax[1] = max.GetY() + m_fMargin;
+	node.m_vMax[2] = max.GetZ() + m_fMargin;
+	node.m_vMax[3] = 0.0f;
+}
+
+void AABBTree::fitToChildren(uint32_t index)
+{
+	Node& node = m_nodes[index];
+	const Node& child1 = m_nodes[node.m_iChild1];
+	const Node& child2 = m_nodes[node.m_iChild2];
+	SIMD::Store(node.m_vMin, SIMD::Min(SIMD::Load(child1.m_vMin), SIMD::Load(child2.m_vMin)));
+	SIMD::Store(node.m_vMax, SIMD::Max(SIMD::Load(child1.m_vMax), SIMD::Load(child2.m_vMax)));
+	node.m_iHeight = 1 + std::max(child1.m_iHeight, child2.m_iHeight);
+}
+
+uint32_t AABBTree::Insert(const AABB& box, uint32_t userData)
+{
+	assert(!box.IsEmpty());
+	const uint32_t leaf = allocateNode();
+	m_nodes[leaf].m_iChild2 = userData;
+	setFatBox(leaf, box);
+	insertLeaf(leaf);
+	++m_iLeafCount;
+	return leaf;
+}
+
+void AABBTree::Remove(uint32_t proxy)
+{
+	assert(proxy < m_nodes.size() && m_nodes[proxy].IsLeaf() && m_nodes[proxy].m_iHeight == 0);
+	removeLeaf(proxy);
+	freeNode(proxy);
+	--m_iLeafCount;
+}
+
+bool AABBTree::Update(uint32_t proxy, const AABB& box)
+{
+	assert(proxy < m_nodes.size() && m_nodes[proxy].IsLeaf() && m_nodes[proxy].m_iHeight == 0);
+	const Node& node = m_nodes[proxy];
+	const Vector3& min = box.GetMin();
+	const Vector3& max = box.GetMax();
+	if (min.GetX() >= node.m_vMin[0] && min.GetY() >= node.m_vMin[1] && min.GetZ() >= node.m_vMin[2]
+		&& max.GetX() <= node.m_vMax[0] && max.GetY() <= node.m_vMax[1] && max.GetZ() <= node.m_vMax[2])
+	{
+		return false;
+	}
+	removeLeaf(proxy);
+	setFatBox(proxy, box);
+	insertLeaf(proxy);
+	return true;
+}
+
+void AABBTree::Refit(uint32_t proxy, const AABB& box)
+{
+	assert(proxy < m_nodes.size() && m_nodes[proxy].IsLeaf() && m_nodes[proxy].m_iHeight == 0);
+	setFatBox(proxy, box);
+	for (uint32_t index = m_nodes[proxy].m_iParent; index != NULL_NODE; index = m_nodes[index].m_iParent)
+	{
+		fitToChildren(index);
+	}
+}
+
+void AABBTree::Clear()
+{
+	m_nodes.clear();
+	m_iRoot = NULL_NODE;
+	m_iFreeList = NULL_NODE;
+	m_iLeafCount = 0;
+}
+
+void AABBTree::insertLeaf(uint32_t leaf)
+{
+	if (m_iRoot == NULL_NODE)
+	{
+		m_iRoot = leaf;
+		m_nodes[leaf].m_iParent = NULL_NODE;
+		return;
+	}
+
+	// walk down to the sibling of least cost, the area of the new parent plus the area
+	// every ancestor grows by, stop when going further costs more than pairing here
+	const float* leafMin = m_nodes[leaf].m_vMin;
+	const float* leafMax = m_nodes[leaf].m_vMax;
+	uint32_t index = m_iRoot;
+	while (!m_nodes[index].IsLeaf())
+	{
+		const Node& node = m_nodes[index];
+		const float area = Area(node.m_vMin, node.m_vMax);
+		const float combinedArea = MergedArea(node.m_vMin, node.m_vMax, leafMin, leafMax);
+		const float cost = 2.0f * combinedArea;
+		const float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		const uint32_t children[2] = { node.m_iChild1, node.m_iChild2 };
+		for (uint32_t c = 0; c < 2; ++c)
+		{
+			const Node& child = m_nodes[children[c]];
+			const float mergedArea = MergedArea(child.m_vMin, child.m_vMax, leafMin, leafMax);
+			childCost[c] = (child.IsLeaf() ? mergedArea : mergedArea - Area(child.m_vMin, child.m_vMax)) + inheritanceCost;
+		}
+		if (cost < childCost[0] && cost < childCost[1])
+		{
+			break;
+		}
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+	const uint32_t sibling = index;
+
+	// a new parent takes the place of the sibling
+	const uint32_t oldParent = m_nodes[sibling].m_iParent;
+	const uint32_t newParent = allocateNode();
+	Node& parent = m_nodes[newParent];
+	parent.m_iParent = oldParent;
+	parent.m_iChild1 = sibling;
+	parent.m_iChild2 = leaf;
+	fitToChildren(newParent);
+	if (oldParent != NULL_NODE)
+	{
+		Node& grandParent = m_nodes[oldParent];
+		(grandParent.m_iChild1 == sibling ? grandParent.m_iChild1 : grandParent.m_iChild2) = newParent;
+	}
+	else
+	{
+		m_iRoot = newParent;
+	}
+	m_nodes[sibling].m_iParent = newParent;
+	m_nodes[leaf].m_iParent = newParent;
+
+	// refit and rebalance the ancestors
+	for (index = m_nodes[leaf].m_iParent; index != NULL_NODE; index = m_nodes[index].m_iParent)
+	{
+		index = balance(index);
+		fitToChildren(index);
+	}
+}
+
+void AABBTree::removeLeaf(uint32_t leaf)
+{
+	if (leaf == m_iRoot)
+	{
+		m_iRoot = NULL_NODE;
+		return;
+	}
+
+	// the sibling takes the place of the parent
+	const uint32_t parent = m_nodes[leaf].m_iParent;
+	const uint32_t grandParent = m_nodes[parent].m_iParent;
+	const uint32_t sibling = m_nodes[parent].m_iChild1 == leaf ? m_nodes[parent].m_iChild2 : m_nodes[parent].m_iChild1;
+	freeNode(parent);
+	m_nodes[sibling].m_iParent = grandParent;
+	if (grandParent == NULL_NODE)
+	{
+		m_iRoot = sibling;
+		return;
+	}
+	Node& node = m_nodes[grandParent];
+	(node.m_iChild1 == parent ? node.m_iChild1 : node.m_iChild2) = sibling;
+
+	for (uint32_t index = grandParent; index != NULL_NODE; index = m_nodes[index].m_iParent)
+	{
+		index = balance(index);
+		fitToChildren(index);
+	}
+}
+
+uint32_t AABBTree::balance(uint32_t iA)
+{
+	// rotate the higher child up when the heights of the children differ by more than 1
+	Node& A = m_nodes[iA];
+	if (A.IsLeaf() || A.m_iHeight < 2)
+	{
+		return iA;
+	}
+
+	const uint32_t iB = A.m_iChild1;
+	const uint32_t iC = A.m_iChild2;
+	Node& B = m_nodes[iB];
+	Node& C = m_nodes[iC];
+	const int32_t difference = C.m_iHeight - B.m_iHeight;
+	if (difference >= -1 && difference <= 1)
+	{
+		return iA;
+	}
+
+	// the higher child P with children F and G goes up, A keeps the lower child and the lower of F and G
+	const uint32_t iP = difference > 1 ? iC : iB;
+	Node& P = m_nodes[iP];
+	const uint32_t iF = P.m_iChild1;
+	const uint32_t iG = P.m_iChild2;
+	const bool bKeepF = m_nodes[iF].m_iHeight > m_nodes[iG].m_iHeight;
+	const uint32_t iUp = bKeepF ? iF : iG;			// stays under P
+	const uint32_t iDown = bKeepF ? iG : iF;		// moves under A
+
+	P.m_iChild1 = iA;
+	P.m_iChild2 = iUp;
+	P.m_iParent = A.m_iParent;
+	A.m_iParent = iP;
+	if (P.m_iParent != NULL_NODE)
+	{
+		Node& parent = m_nodes[P.m_iParent];
+		(parent.m_iChild1 == iA ? parent.m_iChild1 : parent.m_iChild2) = iP;
+	}
+	else
+	{
+		m_iRoot = iP;
+	}
+
+	(difference > 1 ? A.m_iChild2 : A.m_iChild1) = iDown;
+	m_nodes[iDown].m_iParent = iA;
+	fitToChildren(iA);
+	fitToChildren(iP);
+	return iP;
+}
+
+/** @brief A leaf while Rebuild() sorts it, the boxes are copied out of the nodes to be read in order */
+struct alignas(16) AABBTree::BuildLeaf
+{
+	float						m_vMin[4];		// w is 0
+	float						m_vMax[4];
+	uint32_t					m_iNode;
+	uint8_t						m_iBin[3];		// bin of the center on every axis, in the range being split
+};
+
+void AABBTree::Rebuild()
+{
+	if (m_iLeafCount < 3)
+	{
+		return;
+	}
+
+	// keep the leaves, free every internal node
+	Vector<BuildLeaf> leaves;
+	leaves.reserve(m_iLeafCount);
+	for (uint32_t i = 0; i < m_nodes.size(); ++i)
+	{
+		const Node& node = m_nodes[i];
+		if (node.m_iHeight == 0)
+		{
+			BuildLeaf& leaf = leaves.emplace_back();
+			SIMD::Store(leaf.m_vMin, SIMD::Load(node.m_vMin));
+			SIMD::Store(leaf.m_vMax, SIMD::Load(node.m_vMax));
+			leaf.m_iNode = i;
+		}
+		else if (node.m_iHeight > 0)
+		{
+			freeNode(i);
+		}
+	}
+	m_iRoot = buildSAH(leaves.data(), static_cast<uint32_t>(leaves.size()));
+	m_nodes[m_iRoot].m_iParent = NULL_NODE;
+}
+
+uint32_t AABBTree::buildSAH(BuildLeaf* leaves, uint32_t num)
+{
+	struct Task
+	{
+		uint32_t	m_iBegin;
+		uint32_t	m_iEnd;
+		uint32_t	m_iParent;
+		bool		m_bSecond;		// whether the node of this task is the second child of the parent
+	};
+
+	struct Bin
+	{
+		void Reset()
+		{
+			m_vMin = SIMD::Splat(INFINITY);
+			m_vMax = SIMD::Splat(-INFINITY);
+			m_iCount = 0;
+		}
+
+		// surface area times count, the cost of a side of a split
+		float Cost() const
+		{
+			alignas(16) float min[4], max[4];
+			SIMD::Store(min, m_vMin);
+			SIMD::Store(max, m_vMax);
+			return m_iCount ? m_iCount * Area(min, max) : INFINITY;
+		}
+
+		Float4		m_vMin;
+		Float4		m_vMax;
+		uint32_t	m_iCount;
+	};
+
+	uint32_t root = NULL_NODE;
+	Vector<uint32_t> internalNodes;			// parents before their children
+	internalNodes.reserve(num);
+	Vector<Task> tasks;
+	tasks.push_back(Task{ 0, num, NULL_NODE, false });
+	auto link = [&](const Task& task, uint32_t index) {
+		m_nodes[index].m_iParent = task.m_iParent;
+		if (task.m_iParent == NULL_NODE)
+		{
+			root = index;
+		}
+		else
+		{
+			(task.m_bSecond ? m_nodes[task.m_iParent].m_iChild2 : m_nodes[task.m_iParent].m_iChild1) = index;
+		}
+	};
+
+	while (!tasks.empty())
+	{
+		const Task task = tasks.back();
+		tasks.pop_back();
+		const uint32_t count = task.m_iEnd - task.m_iBegin;
+		BuildLeaf* range = leaves + task.m_iBegin;
+		if (count == 1)
+		{
+			link(task, range[0].m_iNode);
+			continue;
+		}
+
+		const uint32_t index = allocateNode();
+		link(task, index);
+		internalNodes.push_back(index);
+
+		if (count == 2)
+		{
+			tasks.push_back(Task{ task.m_iBegin + 1, task.m_iEnd, index, true });
+			tasks.push_back(Task{ task.m_iBegin, task.m_iBegin + 1, index, false });
+			continue;
+		}
+
+		// bounds of the centers, doubled to save the halving
+		Float4 centerMin = SIMD::Splat(INFINITY);
+		Float4 centerMax = SIMD::Splat(-INFINITY);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Float4 center = SIMD::Add(SIMD::Load(range[i].m_vMin), SIMD::Load(range[i].m_vMax));
+			centerMin = SIMD::Min(centerMin, center);
+			centerMax = SIMD::Max(centerMax, center);
+		}
+		alignas(16) float extent[4];
+		SIMD::Store(extent, SIMD::Sub(centerMax, centerMin));
+		// fewer bins for a few leaves, an axis where every center is the same is skipped
+		const uint32_t binNum = std::min(count, BIN_NUM);
+		const Float4 scale = SIMD::Set(
+			extent[0] > 0.0f ? binNum / extent[0] : 0.0f,
+			extent[1] > 0.0f ? binNum / extent[1] : 0.0f,
+			extent[2] > 0.0f ? binNum / extent[2] : 0.0f,
+			0.0f);
+
+		// bin the centers on the 3 axes in one pass
+		Bin bins[3][BIN_NUM];
+		for (uint32_t a = 0; a < 3; ++a)
+		{
+			for (uint32_t b = 0; b < binNum; ++b)
+			{
+				bins[a][b].Reset();
+			}
+		}
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			BuildLeaf& leaf = range[i];
+			const Float4 min = SIMD::Load(leaf.m_vMin);
+			const Float4 max = SIMD::Load(leaf.m_vMax);
+			alignas(16) float position[4];
+			SIMD::Store(position, SIMD::Mul(SIMD::Sub(SIMD::Add(min, max), centerMin), scale));
+			for (uint32_t a = 0; a < 3; ++a)
+			{
+				const uint32_t b = std::min(static_cast<uint32_t>(position[a]), binNum - 1);
+				leaf.m_iBin[a] = static_cast<uint8_t>(b);
+				Bin& bin = bins[a][b];
+				bin.m_vMin = SIMD::Min(bin.m_vMin, min);
+				bin.m_vMax = SIMD::Max(bin.m_vMax, max);
+				++bin.m_iCount;
+			}
+		}
+
+		// cost of a split is the area times the count of each side, the same for the parent is left out
+		uint32_t bestAxis = 3;
+		uint32_t bestSplit = 0;
+		float bestCost = INFINITY;
+		for (uint32_t a = 0; a < 3; ++a)
+		{
+			if (extent[a] <= 0.0f)
+			{
+				continue;
+			}
+			// sweep from the right for the right side of every split, then from the left
+			float rightCost[BIN_NUM];
+			Bin side;
+			side.Reset();
+			for (uint32_t b = binNum - 1; b > 0; --b)
+			{
+				side.m_vMin = SIMD::Min(side.m_vMin, bins[a][b].m_vMin);
+				side.m_vMax = SIMD::Max(side.m_vMax, bins[a][b].m_vMax);
+				side.m_iCount += bins[a][b].m_iCount;
+				rightCost[b] = side.Cost();
+			}
+			side.Reset();
+			for (uint32_t b = 0; b < binNum - 1; ++b)
+			{
+				side.m_vMin = SIMD::Min(side.m_vMin, bins[a][b].m_vMin);
+				side.m_vMax = SIMD::Max(side.m_vMax, bins[a][b].m_vMax);
+				side.m_iCount += bins[a][b].m_iCount;
+				// split between bin b and b + 1
+				const float cost = side.Cost() + rightCost[b + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = a;
+					bestSplit = b;
+				}
+			}
+		}
+
+		uint32_t middle;
+		if (bestAxis < 3)
+		{
+			const BuildLeaf* pEnd = std::partition(range, range + count, [bestAxis, bestSplit](const BuildLeaf& leaf) {
+				return leaf.m_iBin[bestAxis] <= bestSplit;
+			});
+			middle = static_cast<uint32_t>(pEnd - range);
+		}
+		else
+		{
+			// every center is at the same point, any halves cost the same
+			middle = count / 2;
+		}
+		assert(middle > 0 && middle < count);
+
+		tasks.push_back(Task{ task.m_iBegin + middle, task.m_iEnd, index, true });
+		tasks.push_back(Task{ task.m_iBegin, task.m_iBegin + middle, index, false });
+	}
+
+	// children were allocated after their parent, fit bottom up
+	for (uint32_t i = static_cast<uint32_t>(internalNodes.size()); i-- > 0;)
+	{
+		fitToChildren(internalNodes[i]);
+	}
+	return root;
+}
+
+float AABBTree::GetAreaRatio() const
+{
+	if (m_iRoot == NULL_NODE || m_nodes[m_iRoot].IsLeaf())
+	{
+		return 0.0f;
+	}
+	float area = 0.0f;
+	for (uint32_t i = 0; i < m_nodes.size(); ++i)
+	{
+		const Node& node = m_nodes[i];
+		if (node.m_iHeight > 0)
+		{
+			area += Area(node.m_vMin, node.m_vMax);
+		}
+	}
+	return area / Area(m_nodes[m_iRoot].m_vMin, m_nodes[m_iRoot].m_vMax);
+}
+
+void AABBTree::Query(const Frustum& frustum, Vector<uint32_t>& result) const
+{
+	if (m_iRoot == NULL_NODE)
+	{
+		return;
+	}
+	const FrustumPlanes planes(frustum);
+	SmallVector<uint32_t, STACK_INLINE> stack;
+	stack.push_back(m_iRoot);
+	while (!stack.empty())
+	{
+		const uint32_t entry = stack.back();
+		stack.pop_back();
+		const Node& node = m_nodes[entry & ~INSIDE_BIT];
+		FrustumTest test = FrustumTest::Inside;
+		if (!(entry & INSIDE_BIT))
+		{
+			test = TestFrustum(planes, node.m_vMin, node.m_vMax);
+			if (test == FrustumTest::Outside)
+			{
+				continue;
+			}
+		}
+		if (node.IsLeaf())
+		{
+			result.push_back(node.m_iChild2);
+		}
+		else
+		{
+			// below a node inside every plane nothing is tested again
+			const uint32_t inside = test == FrustumTest::Inside ? INSIDE_BIT : 0;
+			stack.push_back(node.m_iChild2 | inside);
+			stack.push_back(node.m_iChild1 | inside);
+		}
+	}
+}
+
+void AABBTree::Query(const Sphere& sphere, Vector<uint32_t>& result) const
+{
+	if (m_iRoot == NULL_NODE)
+	{
+		return;
+	}
+	const Vector3 center = sphere.GetCenter();
+	const Float4 c = SIMD::Set(center.GetX(), center.GetY(), center.GetZ(), 0.0f);
+	const float radiusSquared = sphere.GetRadius() * sphere.GetRadius();
+	SmallVector<uint32_t, STACK_INLINE> stack;
+	stack.push_back(m_iRoot);
+	while (!stack.empty())
+	{
+		const Node& node = m_nodes[stack.back()];
+		stack.pop_back();
+		// distance from the center to the nearest point of the box
+		const Float4 outside = SIMD::Max(SIMD::Max(SIMD::Sub(SIMD::Load(node.m_vMin), c), SIMD::Sub(c, SIMD::Load(node.m_vMax))), SIMD::Zero());
+		if (SIMD::Dot3(outside, outside) > radiusSquared)
+		{
+			continue;
+		}
+		if (node.IsLeaf())
+		{
+			result.push_back(node.m_iChild2);
+		}
+		else
+		{
+			stack.push_back(node.m_iChild2);
+			stack.push_back(node.m_iChild1);
+		}
+	}
+}
+
+void AABBTree::Query(const AABB& box, Vector<uint32_t>& result) const
+{
+	if (m_iRoot == NULL_NODE)
+	{
+		return;
+	}
+	const Vector3& min = box.GetMin();
+	const Vector3& max = box.GetMax();
+	const Float4 queryMin = SIMD::Set(min.GetX(), min.GetY(), min.GetZ(), 0.0f);
+	const Float4 queryMax = SIMD::Set(max.GetX(), max.GetY(), max.GetZ(), 0.0f);
+	SmallVector<uint32_t, STACK_INLINE> stack;
+	stack.push_back(m_iRoot);
+	while (!stack.empty())
+	{
+		const Node& node = m_nodes[stack.back()];
+		stack.pop_back();
+		const Float4 separated = SIMD::Or(SIMD::CmpGT(SIMD::Load(node.m_vMin), queryMax), SIMD::CmpGT(queryMin, SIMD::Load(node.m_vMax)));
+		if (SIMD::MoveMask(separated))
+		{
+			continue;
+		}
+		if (node.IsLeaf())
+		{
+			result.push_back(node.m_iChild2);
+		}
+		else
+		{
+			stack.push_back(node.m_iChild2);
+			stack.push_back(node.m_iChild1);
+		}
+	}
+}
+
+void AABBTree::RayCast(const Vector3& origin, const Vector3& direction, float fMaxDistance, Vector<uint32_t>& result) const
+{
+	if (m_iRoot == NULL_NODE)
+	{
+		return;
+	}
+	// a zero component becomes tiny, so the slab distances are huge instead of NaN
+	float inverse[3];
+	const float components[3] = { direction.GetX(), direction.GetY(), direction.GetZ() };
+	for (uint32_t a = 0; a < 3; ++a)
+	{
+		const float d = fabsf(components[a]) > 1e-20f ? components[a] : copysignf(1e-20f, components[a]);
+		inverse[a] = 1.0f / d;
+	}
+	const Float4 o = SIMD::Set(origin.GetX(), origin.GetY(), origin.GetZ(), 0.0f);
+	const Float4 inv = SIMD::Set(inverse[0], inverse[1], inverse[2], 0.0f);
+	// w of the slab distances is 0 for the entry, the segment starts at the origin, and fMaxDistance for the exit
+	const Float4 wMask = SIMD::CmpGT(SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f), SIMD::Zero());
+	const Float4 maxDistance = SIMD::Splat(fMaxDistance);
+	SmallVector<uint32_t, STACK_INLINE> stack;
+	stack.push_back(m_iRoot);
+	while (!stack.empty())
+	{
+		const Node& node = m_nodes[stack.back()];
+		stack.pop_back();
+		const Float4 t1 = SIMD::Mul(SIMD::Sub(SIMD::Load(node.m_vMin), o), inv);
+		const Float4 t2 = SIMD::Mul(SIMD::Sub(SIMD::Load(node.m_vMax), o), inv);
+		const Float4 entry = HorizontalMax(SIMD::Min(t1, t2));
+		const Float4 exit = HorizontalMin(SIMD::Select(SIMD::Max(t1, t2), maxDistance, wMask));
+		if (SIMD::MoveMask(SIMD::CmpGT(entry, exit)) & 1)
+		{
+			continue;
+		}
+		if (node.IsLeaf())
+		{
+			result.push_back(node.m_iChild2);
+		}
+		else
+		{
+			stack.push_back(node.m_iChild2);
+			stack.push_back(node.m_iChild1);
+		}
+	}
+}
+
+} // namespace DE
@@ -0,0 +1,147 @@
+// AABBTree.h: dynamic bounding volume hierarchy of axis aligned boxes, for visibility, overlap and ray queries over a scene
+#pragma once
+
+// Engine
+#include <DECore/Container/Vector.h>
+#include <DECore/Math/BoundingVolume.h>
+#include <DECore/Math/Frustum.h>
+// Cpp
+#include <stdint.h>
+
+namespace DE
+{
+
+/** @brief	Binary tree of boxes, every object is a leaf and every internal node bounds its two
+*		children. A leaf keeps a fat box, the box of the object grown by a margin, so an
+*		object moving a little does not touch the tree. Insert() walks down to the sibling
+*		of least surface area cost and Insert()/Remove() rotate the ancestors to keep the
+*		height logarithmic, Rebuild() builds the whole tree again with the surface area
+*		heuristic when the incremental changes made it loose. Queries walk the tree with
+*		an explicit stack and test a node in SIMD registers, they append the user data
+*		of the leaves whose fat box passes the test, so the result is conservative.
+*		The ids returned by Insert() stay valid until Remove(), Rebuild() included
+*/
+class AABBTree
+{
+public:
+
+	static constexpr uint32_t NULL_NODE = ~0u;
+
+	/** @brief	Construct an empty tree
+	*
+	*	@param fMargin: the fat boxes of the leaves are the object boxes grown by this on every side
+	*/
+	explicit AABBTree(float fMargin = 0.1f)
+		: m_fMargin(fMargin)
+	{}
+
+	AABBTree(AABBTree&&) = default;
+	AABBTree& operator=(AABBTree&&) = default;
+
+	/** @brief	Add an object
+	*
+	*	@param box: the box of the object, must not be empty
+	*	@param userData: returned by the queries that find the object
+	*	@return the id of the leaf, for Remove(), Update() and Refit()
+	*/
+	uint32_t Insert(const AABB& box, uint32_t userData);
+
+	/** @brief Remove the leaf of an id returned by Insert() */
+	void Remove(uint32_t proxy);
+
+	/** @brief	Move an object, the leaf is reinserted only when the box leaves its fat box
+	*
+	*	@return whether the leaf was reinserted
+	*/
+	bool Update(uint32_t proxy, const AABB& box);
+
+	/** @brief	Set the box of an object in place and refit the ancestors of its leaf, the tree
+	*		keeps its shape. Cheaper than Update() for objects moving every frame, but the
+	*		tree gets looser the further they move, call Rebuild() once in a while
+	*/
+	void Refit(uint32_t proxy, const AABB& box);
+
+	/** @brief	Build the internal nodes again top down, splitting at the plane of least
+	*		surface area cost among up to 16 bins of the box centers on every axis. Leaves keep their ids
+	*/
+	void Rebuild();
+
+	/** @brief Remove every leaf */
+	void Clear();
+
+	/** @brief Append the user data of the leaves intersecting the frustum, whose plane normals point inside */
+	void Query(const Frustum& frustum, Vector<uint32_t>& result) const;
+
+	/** @brief Append the user data of the leaves intersecting the sphere */
+	void Query(const Sphere& sphere, Vector<uint32_t>& result) const;
+
+	/** @brief Append the user data of the leaves intersecting the box */
+	void Query(const AABB& box, Vector<uint32_t>& result) const;
+
+	/** @brief	Append the user data of the leaves hit by the segment from origin to
+	*		origin + direction * fMaxDistance, direction does not need to be normalized
+	*/
+	void RayCast(const Vector3& origin, const Vector3& direction, float fMaxDistance, Vector<uint32_t>& result) const;
+
+	uint32_t GetUserData(uint32_t proxy) const
+	{
+		return m_nodes[proxy].m_iChild2;
+	}
+
+	/** @brief Return the fat box of a leaf */
+	AABB GetFatAABB(uint32_t proxy) const
+	{
+		const Node& node = m_nodes[proxy];
+		return AABB(Vector3(node.m_vMin[0], node.m_vMin[1], node.m_vMin[2]), Vector3(node.m_vMax[0], node.m_vMax[1], node.m_vMax[2]));
+	}
+
+	uint32_t GetLeafCount() const
+	{
+		return m_iLeafCount;
+	}
+
+	/** @brief Return the number of levels below the root, 0 for a tree of one leaf */
+	uint32_t GetHeight() const
+	{
+		return m_iRoot == NULL_NODE ? 0 : m_nodes[m_iRoot].m_iHeight;
+	}
+
+	/** @brief Return the total surface area of the internal nodes over the area of the root, lower is tighter */
+	float GetAreaRatio() const;
+
+private:
+
+	struct alignas(16) Node
+	{
+		bool IsLeaf() const
+		{
+			return m_iChild1 == NULL_NODE;
+		}
+
+		float						m_vMin[4];		// w is 0, the SIMD tests load the whole register
+		float						m_vMax[4];
+		uint32_t					m_iParent;		// or the next free node
+		uint32_t					m_iChild1;		// NULL_NODE for a leaf
+		uint32_t					m_iChild2;		// or the user data of a leaf
+		int32_t						m_iHeight;		// 0 for a leaf, -1 for a free node
+	};
+
+	struct BuildLeaf;
+
+	uint32_t allocateNode();
+	void freeNode(uint32_t index);
+	void insertLeaf(uint32_t leaf);
+	void removeLeaf(uint32_t leaf);
+	uint32_t balance(uint32_t index);
+	void setFatBox(uint32_t leaf, const AABB& box);
+	void fitToChildren(uint32_t index);
+	uint32_t buildSAH(BuildLeaf* leaves, uint32_t num);
+
+	Vector<Node>					m_nodes;
+	uint32_t						m_iRoot = NULL_NODE;
+	uint32_t						m_iFreeList = NULL_NODE;
+	uint32_t						m_iLeafCount = 0;
+	float							m_fMargin;
+};
+
+} // namespace DE
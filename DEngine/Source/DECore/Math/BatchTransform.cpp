@@ -0,0 +1,175 @@
+#include <DECore/DECore.h>
+#include "BatchTransform.h"
+#include "BatchTransformKernel.h"
+
+#include <assert.h>
+#if DE_SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#elif DE_SIMD_X86
+#include <cpuid.h>
+#endif
+
+namespace DE
+{
+
+static_assert(sizeof(Matrix4) == sizeof(float) * 16, "Matrix4 arrays are read as packed 16 floats");
+
+namespace
+{
+
+constexpr uint32_t MATRIX_STRIDE = 16;	// floats between two matrices of an array
+
+#if DE_SIMD_X86
+
+void CPUID(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+	__cpuidex(reinterpret_cast<int*>(regs), leaf, subleaf);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/** @brief Return XCR0, the register state the OS saves on context switch */
+uint64_t ReadXCR0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+SIMDLevel DetectSIMDLevel()
+{
+	uint32_t regs[4] = {};	// eax, ebx, ecx, edx
+	CPUID(0, 0, regs);
+	const uint32_t maxLeaf = regs[0];
+
+	CPUID(1, 0, regs);
+	assert((!DE_SIMD_SSE || (regs[2] & (1u << 19))) && "SSE4.1 is required by the math library");
+	const bool bFMA = (regs[2] & (1u << 12)) != 0;
+	const bool bPOPCNT = (regs[2] & (1u << 23)) != 0;
+	const bool bOSXSAVE = (regs[2] & (1u << 27)) != 0;
+	const bool bAVX = (regs[2] & (1u << 28)) != 0;
+	if (!bOSXSAVE || !bAVX || maxLeaf < 7)
+	{
+		return SIMDLevel::Baseline;
+	}
+	// XMM and YMM state
+	const uint64_t xcr0 = ReadXCR0();
+	if ((xcr0 & 0x6) != 0x6)
+	{
+		return SIMDLevel::Baseline;
+	}
+
+	CPUID(7, 0, regs);
+	const bool bAVX2 = (regs[1] & (1u << 5)) != 0;
+	const bool bAVX512F = (regs[1] & (1u << 16)) != 0;
+	// the frustum culling kernels count their visible lanes with POPCNT
+	if (!bAVX2 || !bFMA || !bPOPCNT)
+	{
+		return SIMDLevel::Baseline;
+	}
+	// opmask, upper ZMM0-15 and ZMM16-31 state
+	if (bAVX512F && (xcr0 & 0xE0) == 0xE0)
+	{
+		return SIMDLevel::AVX512;
+	}
+	return SIMDLevel::AVX2;
+}
+
+#else
+
+SIMDLevel DetectSIMDLevel()
+{
+	return SIMDLevel::Baseline;
+}
+
+#endif // DE_SIMD_X86
+
+const BatchTransformKernels& GetKernels(SIMDLevel level)
+{
+	switch (level)
+	{
+	case SIMDLevel::AVX512:
+		return GetAVX512BatchTransformKernels();
+	case SIMDLevel::AVX2:
+		return GetAVX2BatchTransformKernels();
+	default:
+		return GetBaselineBatchTransformKernels();
+	}
+}
+
+struct Dispatch
+{
+	Dispatch()
+	{
+		m_SupportedLevel = DetectSIMDLevel();
+		m_Level = m_SupportedLevel;
+		m_pKernels = &GetKernels(m_Level);
+	}
+
+	SIMDLevel						m_SupportedLevel;
+	SIMDLevel						m_Level;
+	const BatchTransformKernels*	m_pKernels;
+};
+
+Dispatch& GetDispatch()
+{
+	static Dispatch dispatch;
+	return dispatch;
+}
+
+} // namespace
+
+void BatchTransform::TransformPoints(const Matrix4& matrix, const Float3Stream& in, const Float3Stream& out, uint32_t num)
+{
+	GetDispatch().m_pKernels->TransformPoints(matrix.Raw(), in, out, num);
+}
+
+void BatchTransform::TransformNormals(const Matrix4& matrix, const Float3Stream& in, const Float3Stream& out, uint32_t num)
+{
+	GetDispatch().m_pKernels->TransformNormals(matrix.Raw(), in, out, num);
+}
+
+void BatchTransform::MultiplyMatrices(const Matrix4* local, const Matrix4& parent, Matrix4* out, uint32_t num)
+{
+	GetDispatch().m_pKernels->MultiplyMatrices(reinterpret_cast<const float*>(local), parent.Raw(), 0, reinterpret_cast<float*>(out), num);
+}
+
+void BatchTransform::MultiplyMatrices(const Matrix4* local, const Matrix4* parents, Matrix4* out, uint32_t num)
+{
+	GetDispatch().m_pKernels->MultiplyMatrices(reinterpret_cast<const float*>(local), reinterpret_cast<const float*>(parents), MATRIX_STRIDE, reinterpret_cast<float*>(out), num);
+}
+
+void BatchTransform::TransformAABBs(const Matrix4& matrix, const Float3Stream& inMin, const Float3Stream& inMax, const Float3Stream& outMin, const Float3Stream& outMax, uint32_t num)
+{
+	GetDispatch().m_pKernels->TransformAABBs(matrix.Raw(), 0, inMin, inMax, outMin, outMax, num);
+}
+
+void BatchTransform::TransformAABBs(const Matrix4* matrices, const Float3Stream& inMin, const Float3Stream& inMax, const Float3Stream& outMin, const Float3Stream& outMax, uint32_t num)
+{
+	GetDispatch().m_pKernels->TransformAABBs(reinterpret_cast<const float*>(matrices), MATRIX_STRIDE, inMin, inMax, outMin, outMax, num);
+}
+
+SIMDLevel BatchTransform::GetSIMDLevel()
+{
+	return GetDispatch().m_Level;
+}
+
+SIMDLevel BatchTransform::GetSupportedSIMDLevel()
+{
+	return GetDispatch().m_SupportedLevel;
+}
+
+void BatchTransform::SetSIMDLevel(SIMDLevel level)
+{
+	Dispatch& dispatch = GetDispatch();
+	dispatch.m_Level = level < dispatch.m_SupportedLevel ? level : dispatch.m_SupportedLevel;
+	dispatch.m_pKernels = &GetKernels(dispatch.m_Level);
+}
+
+} // namespace DE
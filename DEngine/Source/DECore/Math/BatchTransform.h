@@ -0,0 +1,112 @@
+// BatchTransform.h: transform many points, normals, matrices and bounding boxes per call, with baseline, AVX2 or AVX-512 kernels chosen by CPUID
+#pragma once
+
+// Engine
+#include <DECore/Math/simdmath.h>
+// Cpp
+#include <stdint.h>
+
+namespace DE
+{
+
+/** @brief	The x, y and z of N vectors in three separate arrays, structure of arrays.
+*		A kernel loads 4, 8 or 16 consecutive elements of an array at once, the
+*		arrays need no alignment
+*/
+struct Float3Stream
+{
+	float*		x;
+	float*		y;
+	float*		z;
+};
+
+/** @brief Instruction set of the batch kernels */
+enum class SIMDLevel : uint8_t
+{
+	Baseline,	// 4 lanes, the SIMD layer of the build: SSE4.1, NEON or scalar
+	AVX2,		// 8 lanes, AVX2, FMA3 and POPCNT
+	AVX512,		// 16 lanes, AVX-512F
+};
+
+/** @brief	Batch versions of Vector3::Transform and Matrix4::operator*. Vectors are row
+*		vectors multiplied on the left, p * M, the convention of Matrix4::Translation
+*		and of world = local * parent. The kernels broadcast the matrix once and run
+*		multiply add over whole lanes of the streams instead of one dot product per
+*		component. They are picked on first use from CPUID and the register state
+*		the OS saves. The output of a call may be its input, no other overlap is allowed
+*/
+class BatchTransform
+{
+public:
+
+	/** @brief	out[i] = (in[i], 1) * matrix, the last column of the matrix is ignored
+	*
+	*	@param matrix: an affine transform
+	*	@param in: the points
+	*	@param out: the transformed points
+	*	@param num: number of points
+	*/
+	static void TransformPoints(const Matrix4& matrix, const Float3Stream& in, const Float3Stream& out, uint32_t num);
+
+	/** @brief	out[i] = (in[i], 0) * matrix, the result is not normalized
+	*
+	*	@param matrix: the normal matrix, the inverse transpose of a transform that has non uniform scale
+	*	@param in: the directions
+	*	@param out: the transformed directions
+	*	@param num: number of directions
+	*/
+	static void TransformNormals(const Matrix4& matrix, const Float3Stream& in, const Float3Stream& out, uint32_t num);
+
+	/** @brief	out[i] = local[i] * parent, e.g. the world matrices of the children of one node
+	*
+	*	@param local: the matrices multiplied on the left
+	*	@param parent: the matrix multiplied on the right, must not be in out
+	*	@param out: the results
+	*	@param num: number of matrices
+	*/
+	static void MultiplyMatrices(const Matrix4* local, const Matrix4& parent, Matrix4* out, uint32_t num);
+
+	/** @brief	out[i] = local[i] * parents[i], e.g. one level of a hierarchy with the parent world matrices gathered
+	*
+	*	@param local: the matrices multiplied on the left
+	*	@param parents: the matrices multiplied on the right, must not overlap out
+	*	@param out: the results
+	*	@param num: number of matrices
+	*/
+	static void MultiplyMatrices(const Matrix4* local, const Matrix4* parents, Matrix4* out, uint32_t num);
+
+	/** @brief	Transform N axis aligned boxes by one matrix, each result is the tight box around the transformed box
+	*
+	*	@param matrix: an affine transform
+	*	@param inMin: the minimum corners
+	*	@param inMax: the maximum corners
+	*	@param outMin: the transformed minimum corners
+	*	@param outMax: the transformed maximum corners
+	*	@param num: number of boxes
+	*/
+	static void TransformAABBs(const Matrix4& matrix, const Float3Stream& inMin, const Float3Stream& inMax, const Float3Stream& outMin, const Float3Stream& outMax, uint32_t num);
+
+	/** @brief	Transform box i by matrices[i], e.g. the local bounds of every object to world space
+	*
+	*	@param matrices: one affine transform per box
+	*	@param inMin: the minimum corners
+	*	@param inMax: the maximum corners
+	*	@param outMin: the transformed minimum corners
+	*	@param outMax: the transformed maximum corners
+	*	@param num: number of boxes
+	*/
+	static void TransformAABBs(const Matrix4* matrices, const Float3Stream& inMin, const Float3Stream& inMax, const Float3Stream& outMin, const Float3Stream& outMax, uint32_t num);
+
+	/** @brief Return the instruction set of the kernels in use */
+	static SIMDLevel GetSIMDLevel();
+
+	/** @brief Return the highest instruction set the CPU and the OS support */
+	static SIMDLevel GetSupportedSIMDLevel();
+
+	/** @brief	Use the kernels of another instruction set, e.g. to compare them in a benchmark.
+	*		Clamped to the supported level, must not be called while a batch call runs
+	*/
+	static void SetSIMDLevel(SIMDLevel level);
+};
+
+} // namespace DE
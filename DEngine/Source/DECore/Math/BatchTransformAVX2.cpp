@@ -0,0 +1,173 @@
+// BatchTransformAVX2.cpp: premake builds this file with /arch:AVX2, it only runs after CPUID reported AVX2 and FMA3
+#include <DECore/DECore.h>
+#include "BatchTransformKernel.h"
+
+#if DE_SIMD_X86
+
+// only raw intrinsics below, an inline function of the math headers used here would be built for AVX2 and could be picked by the linker for every caller
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2,fma")
+#endif
+
+#include <immintrin.h>
+
+namespace DE
+{
+
+namespace
+{
+
+void TransformPoints(const float* m, const Float3Stream& in, const Float3Stream& out, uint32_t num)
+{
+	const __m256 m00 = _mm256_set1_ps(m[0]), m01 = _mm256_set1_ps(m[1]), m02 = _mm256_set1_ps(m[2]);
+	const __m256 m10 = _mm256_set1_ps(m[4]), m11 = _mm256_set1_ps(m[5]), m12 = _mm256_set1_ps(m[6]);
+	const __m256 m20 = _mm256_set1_ps(m[8]), m21 = _mm256_set1_ps(m[9]), m22 = _mm256_set1_ps(m[10]);
+	const __m256 m30 = _mm256_set1_ps(m[12]), m31 = _mm256_set1_ps(m[13]), m32 = _mm256_set1_ps(m[14]);
+
+	uint32_t i = 0;
+	for (; i + 8 <= num; i += 8)
+	{
+		const __m256 x = _mm256_loadu_ps(in.x + i);
+		const __m256 y = _mm256_loadu_ps(in.y + i);
+		const __m256 z = _mm256_loadu_ps(in.z + i);
+		_mm256_storeu_ps(out.x + i, _mm256_fmadd_ps(x, m00, _mm256_fmadd_ps(y, m10, _mm256_fmadd_ps(z, m20, m30))));
+		_mm256_storeu_ps(out.y + i, _mm256_fmadd_ps(x, m01, _mm256_fmadd_ps(y, m11, _mm256_fmadd_ps(z, m21, m31))));
+		_mm256_storeu_ps(out.z + i, _mm256_fmadd_ps(x, m02, _mm256_fmadd_ps(y, m12, _mm256_fmadd_ps(z, m22, m32))));
+	}
+	BatchTransformScalar::TransformPoints(m, in, out, i, num);
+}
+
+void TransformNormals(const float* m, const Float3Stream& in, const Float3Stream& out, uint32_t num)
+{
+	const __m256 m00 = _mm256_set1_ps(m[0]), m01 = _mm256_set1_ps(m[1]), m02 = _mm256_set1_ps(m[2]);
+	const __m256 m10 = _mm256_set1_ps(m[4]), m11 = _mm256_set1_ps(m[5]), m12 = _mm256_set1_ps(m[6]);
+	const __m256 m20 = _mm256_set1_ps(m[8]), m21 = _mm256_set1_ps(m[9]), m22 = _mm256_set1_ps(m[10]);
+
+	uint32_t i = 0;
+	for (; i + 8 <= num; i += 8)
+	{
+		const __m256 x = _mm256_loadu_ps(in.x + i);
+		const __m256 y = _mm256_loadu_ps(in.y + i);
+		const __m256 z = _mm256_loadu_ps(in.z + i);
+		_mm256_storeu_ps(out.x + i, _mm256_fmadd_ps(x, m00, _mm256_fmadd_ps(y, m10, _mm256_mul_ps(z, m20))));
+		_mm256_storeu_ps(out.y + i, _mm256_fmadd_ps(x, m01, _mm256_fmadd_ps(y, m11, _mm256_mul_ps(z, m21))));
+		_mm256_storeu_ps(out.z + i, _mm256_fmadd_ps(x, m02, _mm256_fmadd_ps(y, m12, _mm256_mul_ps(z, m22))));
+	}
+	BatchTransformScalar::TransformNormals(m, in, out, i, num);
+}
+
+/** @brief Two rows of local * parent, each 128 bit lane holds one row and the parent rows are in both lanes */
+inline __m256 MultiplyRows(__m256 rows, __m256 p0, __m256 p1, __m256 p2, __m256 p3)
+{
+	__m256 result = _mm256_mul_ps(_mm256_permute_ps(rows, _MM_SHUFFLE(0, 0, 0, 0)), p0);
+	result = _mm256_fmadd_ps(_mm256_permute_ps(rows, _MM_SHUFFLE(1, 1, 1, 1)), p1, result);
+	result = _mm256_fmadd_ps(_mm256_permute_ps(rows, _MM_SHUFFLE(2, 2, 2, 2)), p2, result);
+	return _mm256_fmadd_ps(_mm256_permute_ps(rows, _MM_SHUFFLE(3, 3, 3, 3)), p3, result);
+}
+
+void MultiplyMatrices(const float* local, const float* parent, uint32_t parentStride, float* out, uint32_t num)
+{
+	for (uint32_t i = 0; i < num; ++i, local += 16, parent += parentStride, out += 16)
+	{
+		const __m256 p0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent));
+		const __m256 p1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent + 4));
+		const __m256 p2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent + 8));
+		const __m256 p3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent + 12));
+		// Matrix4 is only 16 byte aligned, both halves are loaded before the first store as out may be local
+		const __m256 l01 = _mm256_loadu_ps(local);
+		const __m256 l23 = _mm256_loadu_ps(local + 8);
+		_mm256_storeu_ps(out, MultiplyRows(l01, p0, p1, p2, p3));
+		_mm256_storeu_ps(out + 8, MultiplyRows(l23, p0, p1, p2, p3));
+	}
+}
+
+/** @brief	Load row r of 8 matrices and transpose within the lanes, column c holds element (r, c)
+*		of matrices 0 to 3 in the low lane and of matrices 4 to 7 in the high lane
+*/
+inline void LoadRow(const float* m, uint32_t stride, uint32_t r, __m256& c0, __m256& c1, __m256& c2)
+{
+	const float* pRow = m + r * 4;
+	const __m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(pRow)), _mm_load_ps(pRow + stride * 4), 1);
+	const __m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(pRow + stride)), _mm_load_ps(pRow + stride * 5), 1);
+	const __m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(pRow + stride * 2)), _mm_load_ps(pRow + stride * 6), 1);
+	const __m256 d = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(pRow + stride * 3)), _mm_load_ps(pRow + stride * 7), 1);
+	const __m256 ab01 = _mm256_unpacklo_ps(a, b);
+	const __m256 ab23 = _mm256_unpackhi_ps(a, b);
+	const __m256 cd01 = _mm256_unpacklo_ps(c, d);
+	const __m256 cd23 = _mm256_unpackhi_ps(c, d);
+	c0 = _mm256_shuffle_ps(ab01, cd01, _MM_SHUFFLE(1, 0, 1, 0));
+	c1 = _mm256_shuffle_ps(ab01, cd01, _MM_SHUFFLE(3, 2, 3, 2));
+	c2 = _mm256_shuffle_ps(ab23, cd23, _MM_SHUFFLE(1, 0, 1, 0));
+}
+
+void TransformAABBs(const float* matrix, uint32_t matrixStride, const Float3Stream& inMin, const Float3Stream& inMax, const Float3Stream& outMin, const Float3Stream& outMax, uint32_t num)
+{
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	uint32_t i = 0;
+	for (; i + 8 <= num; i += 8)
+	{
+		const float* m = matrix + matrixStride * i;
+		__m256 m00, m01, m02, m10, m11, m12, m20, m21, m22, m30, m31, m32;
+		LoadRow(m, matrixStride, 0, m00, m01, m02);
+		LoadRow(m, matrixStride, 1, m10, m11, m12);
+		LoadRow(m, matrixStride, 2, m20, m21, m22);
+		LoadRow(m, matrixStride, 3, m30, m31, m32);
+
+		const __m256 minX = _mm256_loadu_ps(inMin.x + i), maxX = _mm256_loadu_ps(inMax.x + i);
+		const __m256 minY = _mm256_loadu_ps(inMin.y + i), maxY = _mm256_loadu_ps(inMax.y + i);
+		const __m256 minZ = _mm256_loadu_ps(inMin.z + i), maxZ = _mm256_loadu_ps(inMax.z + i);
+		const __m256 cx = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half);
+		const __m256 cy = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half);
+		const __m256 cz = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half);
+		const __m256 ex = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+		const __m256 ey = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+		const __m256 ez = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+
+		const __m256 tcx = _mm256_fmadd_ps(cx, m00, _mm256_fmadd_ps(cy, m10, _mm256_fmadd_ps(cz, m20, m30)));
+		const __m256 tcy = _mm256_fmadd_ps(cx, m01, _mm256_fmadd_ps(cy, m11, _mm256_fmadd_ps(cz, m21, m31)));
+		const __m256 tcz = _mm256_fmadd_ps(cx, m02, _mm256_fmadd_ps(cy, m12, _mm256_fmadd_ps(cz, m22, m32)));
+		const __m256 tex = _mm256_fmadd_ps(ex, _mm256_andnot_ps(signMask, m00), _mm256_fmadd_ps(ey, _mm256_andnot_ps(signMask, m10), _mm256_mul_ps(ez, _mm256_andnot_ps(signMask, m20))));
+		const __m256 tey = _mm256_fmadd_ps(ex, _mm256_andnot_ps(signMask, m01), _mm256_fmadd_ps(ey, _mm256_andnot_ps(signMask, m11), _mm256_mul_ps(ez, _mm256_andnot_ps(signMask, m21))));
+		const __m256 tez = _mm256_fmadd_ps(ex, _mm256_andnot_ps(signMask, m02), _mm256_fmadd_ps(ey, _mm256_andnot_ps(signMask, m12), _mm256_mul_ps(ez, _mm256_andnot_ps(signMask, m22))));
+
+		_mm256_storeu_ps(outMin.x + i, _mm256_sub_ps(tcx, tex));
+		_mm256_storeu_ps(outMin.y + i, _mm256_sub_ps(tcy, tey));
+		_mm256_storeu_ps(outMin.z + i, _mm256_sub_ps(tcz, tez));
+		_mm256_storeu_ps(outMax.x + i, _mm256_add_ps(tcx, tex));
+		_mm256_storeu_ps(outMax.y + i, _mm256_add_ps(tcy, tey));
+		_mm256_storeu_ps(outMax.z + i, _mm256_add_ps(tcz, tez));
+	}
+	BatchTransformScalar::TransformAABBs(matrix, matrixStride, inMin, inMax, outMin, outMax, i, num);
+}
+
+} // namespace
+
+const BatchTransformKernels& GetAVX2BatchTransformKernels()
+{
+	static const BatchTransformKernels kernels = { &TransformPoints, &TransformNormals, &MultiplyMatrices, &TransformAABBs };
+	return kernels;
+}
+
+} // namespace DE
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#else
+
+namespace DE
+{
+
+const BatchTransformKernels& GetAVX2BatchTransformKernels()
+{
+	return GetBaselineBatchTransformKernels();
+}
+
+} // namespace DE
+
+#endif // DE_SIMD_X86
@@ -0,0 +1,179 @@
+// BatchTransformAVX512.cpp: premake builds this file with /arch:AVX512, it only runs after CPUID reported AVX-512F
+#include <DECore/DECore.h>
+#include "BatchTransformKernel.h"
+
+#if DE_SIMD_X86
+
+// only raw intrinsics below, an inline function of the math headers used here would be built for AVX-512 and could be picked by the linker for every caller
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx512f")
+#endif
+
+#include <immintrin.h>
+
+namespace DE
+{
+
+namespace
+{
+
+/** @brief Mask of the first num lanes */
+inline __mmask16 TailMask(uint32_t num)
+{
+	return static_cast<__mmask16>((1u << num) - 1);
+}
+
+void TransformPoints(const float* m, const Float3Stream& in, const Float3Stream& out, uint32_t num)
+{
+	const __m512 m00 = _mm512_set1_ps(m[0]), m01 = _mm512_set1_ps(m[1]), m02 = _mm512_set1_ps(m[2]);
+	const __m512 m10 = _mm512_set1_ps(m[4]), m11 = _mm512_set1_ps(m[5]), m12 = _mm512_set1_ps(m[6]);
+	const __m512 m20 = _mm512_set1_ps(m[8]), m21 = _mm512_set1_ps(m[9]), m22 = _mm512_set1_ps(m[10]);
+	const __m512 m30 = _mm512_set1_ps(m[12]), m31 = _mm512_set1_ps(m[13]), m32 = _mm512_set1_ps(m[14]);
+
+	// the last iteration masks off the lanes past num
+	for (uint32_t i = 0; i < num; i += 16)
+	{
+		const __mmask16 mask = num - i >= 16 ? 0xFFFF : TailMask(num - i);
+		const __m512 x = _mm512_maskz_loadu_ps(mask, in.x + i);
+		const __m512 y = _mm512_maskz_loadu_ps(mask, in.y + i);
+		const __m512 z = _mm512_maskz_loadu_ps(mask, in.z + i);
+		_mm512_mask_storeu_ps(out.x + i, mask, _mm512_fmadd_ps(x, m00, _mm512_fmadd_ps(y, m10, _mm512_fmadd_ps(z, m20, m30))));
+		_mm512_mask_storeu_ps(out.y + i, mask, _mm512_fmadd_ps(x, m01, _mm512_fmadd_ps(y, m11, _mm512_fmadd_ps(z, m21, m31))));
+		_mm512_mask_storeu_ps(out.z + i, mask, _mm512_fmadd_ps(x, m02, _mm512_fmadd_ps(y, m12, _mm512_fmadd_ps(z, m22, m32))));
+	}
+}
+
+void TransformNormals(const float* m, const Float3Stream& in, const Float3Stream& out, uint32_t num)
+{
+	const __m512 m00 = _mm512_set1_ps(m[0]), m01 = _mm512_set1_ps(m[1]), m02 = _mm512_set1_ps(m[2]);
+	const __m512 m10 = _mm512_set1_ps(m[4]), m11 = _mm512_set1_ps(m[5]), m12 = _mm512_set1_ps(m[6]);
+	const __m512 m20 = _mm512_set1_ps(m[8]), m21 = _mm512_set1_ps(m[9]), m22 = _mm512_set1_ps(m[10]);
+
+	for (uint32_t i = 0; i < num; i += 16)
+	{
+		const __mmask16 mask = num - i >= 16 ? 0xFFFF : TailMask(num - i);
+		const __m512 x = _mm512_maskz_loadu_ps(mask, in.x + i);
+		const __m512 y = _mm512_maskz_loadu_ps(mask, in.y + i);
+		const __m512 z = _mm512_maskz_loadu_ps(mask, in.z + i);
+		_mm512_mask_storeu_ps(out.x + i, mask, _mm512_fmadd_ps(x, m00, _mm512_fmadd_ps(y, m10, _mm512_mul_ps(z, m20))));
+		_mm512_mask_storeu_ps(out.y + i, mask, _mm512_fmadd_ps(x, m01, _mm512_fmadd_ps(y, m11, _mm512_mul_ps(z, m21))));
+		_mm512_mask_storeu_ps(out.z + i, mask, _mm512_fmadd_ps(x, m02, _mm512_fmadd_ps(y, m12, _mm512_mul_ps(z, m22))));
+	}
+}
+
+void MultiplyMatrices(const float* local, const float* parent, uint32_t parentStride, float* out, uint32_t num)
+{
+	// one register holds a whole matrix, a row per 128 bit lane, and the parent rows are in every lane
+	for (uint32_t i = 0; i < num; ++i, local += 16, parent += parentStride, out += 16)
+	{
+		const __m512 p0 = _mm512_broadcast_f32x4(_mm_load_ps(parent));
+		const __m512 p1 = _mm512_broadcast_f32x4(_mm_load_ps(parent + 4));
+		const __m512 p2 = _mm512_broadcast_f32x4(_mm_load_ps(parent + 8));
+		const __m512 p3 = _mm512_broadcast_f32x4(_mm_load_ps(parent + 12));
+		const __m512 l = _mm512_loadu_ps(local);
+		__m512 result = _mm512_mul_ps(_mm512_permute_ps(l, _MM_SHUFFLE(0, 0, 0, 0)), p0);
+		result = _mm512_fmadd_ps(_mm512_permute_ps(l, _MM_SHUFFLE(1, 1, 1, 1)), p1, result);
+		result = _mm512_fmadd_ps(_mm512_permute_ps(l, _MM_SHUFFLE(2, 2, 2, 2)), p2, result);
+		result = _mm512_fmadd_ps(_mm512_permute_ps(l, _MM_SHUFFLE(3, 3, 3, 3)), p3, result);
+		_mm512_storeu_ps(out, result);
+	}
+}
+
+/** @brief	Load row r of 16 matrices and transpose within the lanes, column c holds element (r, c)
+*		of matrices 4 * lane to 4 * lane + 3 in every 128 bit lane
+*/
+inline __m512 LoadRowLanes(const float* pRow, uint32_t stride)
+{
+	__m512 result = _mm512_castps128_ps512(_mm_load_ps(pRow));
+	result = _mm512_insertf32x4(result, _mm_load_ps(pRow + stride * 4), 1);
+	result = _mm512_insertf32x4(result, _mm_load_ps(pRow + stride * 8), 2);
+	return _mm512_insertf32x4(result, _mm_load_ps(pRow + stride * 12), 3);
+}
+
+inline void LoadRow(const float* m, uint32_t stride, uint32_t r, __m512& c0, __m512& c1, __m512& c2)
+{
+	const float* pRow = m + r * 4;
+	const __m512 a = LoadRowLanes(pRow, stride);
+	const __m512 b = LoadRowLanes(pRow + stride, stride);
+	const __m512 c = LoadRowLanes(pRow + stride * 2, stride);
+	const __m512 d = LoadRowLanes(pRow + stride * 3, stride);
+	const __m512 ab01 = _mm512_unpacklo_ps(a, b);
+	const __m512 ab23 = _mm512_unpackhi_ps(a, b);
+	const __m512 cd01 = _mm512_unpacklo_ps(c, d);
+	const __m512 cd23 = _mm512_unpackhi_ps(c, d);
+	c0 = _mm512_shuffle_ps(ab01, cd01, _MM_SHUFFLE(1, 0, 1, 0));
+	c1 = _mm512_shuffle_ps(ab01, cd01, _MM_SHUFFLE(3, 2, 3, 2));
+	c2 = _mm512_shuffle_ps(ab23, cd23, _MM_SHUFFLE(1, 0, 1, 0));
+}
+
+void TransformAABBs(const float* matrix, uint32_t matrixStride, const Float3Stream& inMin, const Float3Stream& inMax, const Float3Stream& outMin, const Float3Stream& outMax, uint32_t num)
+{
+	const __m512 half = _mm512_set1_ps(0.5f);
+
+	uint32_t i = 0;
+	for (; i + 16 <= num; i += 16)
+	{
+		const float* m = matrix + matrixStride * i;
+		__m512 m00, m01, m02, m10, m11, m12, m20, m21, m22, m30, m31, m32;
+		LoadRow(m, matrixStride, 0, m00, m01, m02);
+		LoadRow(m, matrixStride, 1, m10, m11, m12);
+		LoadRow(m, matrixStride, 2, m20, m21, m22);
+		LoadRow(m, matrixStride, 3, m30, m31, m32);
+
+		const __m512 minX = _mm512_loadu_ps(inMin.x + i), maxX = _mm512_loadu_ps(inMax.x + i);
+		const __m512 minY = _mm512_loadu_ps(inMin.y + i), maxY = _mm512_loadu_ps(inMax.y + i);
+		const __m512 minZ = _mm512_loadu_ps(inMin.z + i), maxZ = _mm512_loadu_ps(inMax.z + i);
+		const __m512 cx = _mm512_mul_ps(_mm512_add_ps(minX, maxX), half);
+		const __m512 cy = _mm512_mul_ps(_mm512_add_ps(minY, maxY), half);
+		const __m512 cz = _mm512_mul_ps(_mm512_add_ps(minZ, maxZ), half);
+		const __m512 ex = _mm512_mul_ps(_mm512_sub_ps(maxX, minX), half);
+		const __m512 ey = _mm512_mul_ps(_mm512_sub_ps(maxY, minY), half);
+		const __m512 ez = _mm512_mul_ps(_mm512_sub_ps(maxZ, minZ), half);
+
+		const __m512 tcx = _mm512_fmadd_ps(cx, m00, _mm512_fmadd_ps(cy, m10, _mm512_fmadd_ps(cz, m20, m30)));
+		const __m512 tcy = _mm512_fmadd_ps(cx, m01, _mm512_fmadd_ps(cy, m11, _mm512_fmadd_ps(cz, m21, m31)));
+		const __m512 tcz = _mm512_fmadd_ps(cx, m02, _mm512_fmadd_ps(cy, m12, _mm512_fmadd_ps(cz, m22, m32)));
+		const __m512 tex = _mm512_fmadd_ps(ex, _mm512_abs_ps(m00), _mm512_fmadd_ps(ey, _mm512_abs_ps(m10), _mm512_mul_ps(ez, _mm512_abs_ps(m20))));
+		const __m512 tey = _mm512_fmadd_ps(ex, _mm512_abs_ps(m01), _mm512_fmadd_ps(ey, _mm512_abs_ps(m11), _mm512_mul_ps(ez, _mm512_abs_ps(m21))));
+		const __m512 tez = _mm512_fmadd_ps(ex, _mm512_abs_ps(m02), _mm512_fmadd_ps(ey, _mm512_abs_ps(m12), _mm512_mul_ps(ez, _mm512_abs_ps(m22))));
+
+		_mm512_storeu_ps(outMin.x + i, _mm512_sub_ps(tcx, tex));
+		_mm512_storeu_ps(outMin.y + i, _mm512_sub_ps(tcy, tey));
+		_mm512_storeu_ps(outMin.z + i, _mm512_sub_ps(tcz, tez));
+		_mm512_storeu_ps(outMax.x + i, _mm512_add_ps(tcx, tex));
+		_mm512_storeu_ps(outMax.y + i, _mm512_add_ps(tcy, tey));
+		_mm512_storeu_ps(outMax.z + i, _mm512_add_ps(tcz, tez));
+	}
+	// the matrices past num must not be read, so the tail is not masked
+	BatchTransformScalar::TransformAABBs(matrix, matrixStride, inMin, inMax, outMin, outMax, i, num);
+}
+
+} // namespace
+
+const BatchTransformKernels& GetAVX512BatchTransformKernels()
+{
+	static const BatchTransformKernels kernels = { &TransformPoints, &TransformNormals, &MultiplyMatrices, &TransformAABBs };
+	return kernels;
+}
+
+} // namespace DE
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#else
+
+namespace DE
+{
+
+const BatchTransformKernels& GetAVX512BatchTransformKernels()
+{
+	return GetBaselineBatchTransformKernels();
+}
+
+} // namespace DE
+
+#endif // DE_SIMD_X86
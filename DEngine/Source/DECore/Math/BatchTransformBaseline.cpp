@@ -0,0 +1,145 @@
+// BatchTransformBaseline.cpp: 4 lane kernels on the SIMD layer, SSE4.1, NEON or scalar as the build selects
+#include <DECore/DECore.h>
+#include "BatchTransformKernel.h"
+
+namespace DE
+{
+
+namespace
+{
+
+using SIMD::Float4;
+
+void TransformPoints(const float* m, const Float3Stream& in, const Float3Stream& out, uint32_t num)
+{
+	const Float4 m00 = SIMD::Splat(m[0]), m01 = SIMD::Splat(m[1]), m02 = SIMD::Splat(m[2]);
+	const Float4 m10 = SIMD::Splat(m[4]), m11 = SIMD::Splat(m[5]), m12 = SIMD::Splat(m[6]);
+	const Float4 m20 = SIMD::Splat(m[8]), m21 = SIMD::Splat(m[9]), m22 = SIMD::Splat(m[10]);
+	const Float4 m30 = SIMD::Splat(m[12]), m31 = SIMD::Splat(m[13]), m32 = SIMD::Splat(m[14]);
+
+	uint32_t i = 0;
+	for (; i + 4 <= num; i += 4)
+	{
+		const Float4 x = SIMD::LoadU(in.x + i);
+		const Float4 y = SIMD::LoadU(in.y + i);
+		const Float4 z = SIMD::LoadU(in.z + i);
+		const Float4 rx = SIMD::Add(SIMD::MulAdd(y, m10, SIMD::Mul(x, m00)), SIMD::MulAdd(z, m20, m30));
+		const Float4 ry = SIMD::Add(SIMD::MulAdd(y, m11, SIMD::Mul(x, m01)), SIMD::MulAdd(z, m21, m31));
+		const Float4 rz = SIMD::Add(SIMD::MulAdd(y, m12, SIMD::Mul(x, m02)), SIMD::MulAdd(z, m22, m32));
+		SIMD::StoreU(out.x + i, rx);
+		SIMD::StoreU(out.y + i, ry);
+		SIMD::StoreU(out.z + i, rz);
+	}
+	BatchTransformScalar::TransformPoints(m, in, out, i, num);
+}
+
+void TransformNormals(const float* m, const Float3Stream& in, const Float3Stream& out, uint32_t num)
+{
+	const Float4 m00 = SIMD::Splat(m[0]), m01 = SIMD::Splat(m[1]), m02 = SIMD::Splat(m[2]);
+	const Float4 m10 = SIMD::Splat(m[4]), m11 = SIMD::Splat(m[5]), m12 = SIMD::Splat(m[6]);
+	const Float4 m20 = SIMD::Splat(m[8]), m21 = SIMD::Splat(m[9]), m22 = SIMD::Splat(m[10]);
+
+	uint32_t i = 0;
+	for (; i + 4 <= num; i += 4)
+	{
+		const Float4 x = SIMD::LoadU(in.x + i);
+		const Float4 y = SIMD::LoadU(in.y + i);
+		const Float4 z = SIMD::LoadU(in.z + i);
+		const Float4 rx = SIMD::MulAdd(z, m20, SIMD::MulAdd(y, m10, SIMD::Mul(x, m00)));
+		const Float4 ry = SIMD::MulAdd(z, m21, SIMD::MulAdd(y, m11, SIMD::Mul(x, m01)));
+		const Float4 rz = SIMD::MulAdd(z, m22, SIMD::MulAdd(y, m12, SIMD::Mul(x, m02)));
+		SIMD::StoreU(out.x + i, rx);
+		SIMD::StoreU(out.y + i, ry);
+		SIMD::StoreU(out.z + i, rz);
+	}
+	BatchTransformScalar::TransformNormals(m, in, out, i, num);
+}
+
+/** @brief Row r of local * parent, the sum of the parent rows scaled by the elements of local row r */
+inline Float4 MultiplyRow(Float4 row, Float4 p0, Float4 p1, Float4 p2, Float4 p3)
+{
+	const Float4 r01 = SIMD::MulAdd(SIMD::Broadcast<1>(row), p1, SIMD::Mul(SIMD::Broadcast<0>(row), p0));
+	const Float4 r23 = SIMD::MulAdd(SIMD::Broadcast<3>(row), p3, SIMD::Mul(SIMD::Broadcast<2>(row), p2));
+	return SIMD::Add(r01, r23);
+}
+
+void MultiplyMatrices(const float* local, const float* parent, uint32_t parentStride, float* out, uint32_t num)
+{
+	for (uint32_t i = 0; i < num; ++i, local += 16, parent += parentStride, out += 16)
+	{
+		const Float4 p0 = SIMD::Load(parent);
+		const Float4 p1 = SIMD::Load(parent + 4);
+		const Float4 p2 = SIMD::Load(parent + 8);
+		const Float4 p3 = SIMD::Load(parent + 12);
+		// every row is loaded before the first store, out may be local
+		const Float4 l0 = SIMD::Load(local);
+		const Float4 l1 = SIMD::Load(local + 4);
+		const Float4 l2 = SIMD::Load(local + 8);
+		const Float4 l3 = SIMD::Load(local + 12);
+		SIMD::Store(out, MultiplyRow(l0, p0, p1, p2, p3));
+		SIMD::Store(out + 4, MultiplyRow(l1, p0, p1, p2, p3));
+		SIMD::Store(out + 8, MultiplyRow(l2, p0, p1, p2, p3));
+		SIMD::Store(out + 12, MultiplyRow(l3, p0, p1, p2, p3));
+	}
+}
+
+/** @brief Load row r of 4 matrices and transpose, column c holds element (r, c) of each matrix */
+inline void LoadRow(const float* m, uint32_t stride, uint32_t r, Float4& c0, Float4& c1, Float4& c2, Float4& c3)
+{
+	c0 = SIMD::Load(m + r * 4);
+	c1 = SIMD::Load(m + stride + r * 4);
+	c2 = SIMD::Load(m + stride * 2 + r * 4);
+	c3 = SIMD::Load(m + stride * 3 + r * 4);
+	SIMD::Transpose(c0, c1, c2, c3);
+}
+
+void TransformAABBs(const float* matrix, uint32_t matrixStride, const Float3Stream& inMin, const Float3Stream& inMax, const Float3Stream& outMin, const Float3Stream& outMax, uint32_t num)
+{
+	const Float4 half = SIMD::Splat(0.5f);
+
+	uint32_t i = 0;
+	for (; i + 4 <= num; i += 4)
+	{
+		const float* m = matrix + matrixStride * i;
+		Float4 m00, m01, m02, m10, m11, m12, m20, m21, m22, m30, m31, m32, unused;
+		LoadRow(m, matrixStride, 0, m00, m01, m02, unused);
+		LoadRow(m, matrixStride, 1, m10, m11, m12, unused);
+		LoadRow(m, matrixStride, 2, m20, m21, m22, unused);
+		LoadRow(m, matrixStride, 3, m30, m31, m32, unused);
+
+		const Float4 minX = SIMD::LoadU(inMin.x + i), maxX = SIMD::LoadU(inMax.x + i);
+		const Float4 minY = SIMD::LoadU(inMin.y + i), maxY = SIMD::LoadU(inMax.y + i);
+		const Float4 minZ = SIMD::LoadU(inMin.z + i), maxZ = SIMD::LoadU(inMax.z + i);
+		const Float4 cx = SIMD::Mul(SIMD::Add(minX, maxX), half);
+		const Float4 cy = SIMD::Mul(SIMD::Add(minY, maxY), half);
+		const Float4 cz = SIMD::Mul(SIMD::Add(minZ, maxZ), half);
+		const Float4 ex = SIMD::Mul(SIMD::Sub(maxX, minX), half);
+		const Float4 ey = SIMD::Mul(SIMD::Sub(maxY, minY), half);
+		const Float4 ez = SIMD::Mul(SIMD::Sub(maxZ, minZ), half);
+
+		const Float4 tcx = SIMD::Add(SIMD::MulAdd(cy, m10, SIMD::Mul(cx, m00)), SIMD::MulAdd(cz, m20, m30));
+		const Float4 tcy = SIMD::Add(SIMD::MulAdd(cy, m11, SIMD::Mul(cx, m01)), SIMD::MulAdd(cz, m21, m31));
+		const Float4 tcz = SIMD::Add(SIMD::MulAdd(cy, m12, SIMD::Mul(cx, m02)), SIMD::MulAdd(cz, m22, m32));
+		const Float4 tex = SIMD::MulAdd(ez, SIMD::Abs(m20), SIMD::MulAdd(ey, SIMD::Abs(m10), SIMD::Mul(ex, SIMD::Abs(m00))));
+		const Float4 tey = SIMD::MulAdd(ez, SIMD::Abs(m21), SIMD::MulAdd(ey, SIMD::Abs(m11), SIMD::Mul(ex, SIMD::Abs(m01))));
+		const Float4 tez = SIMD::MulAdd(ez, SIMD::Abs(m22), SIMD::MulAdd(ey, SIMD::Abs(m12), SIMD::Mul(ex, SIMD::Abs(m02))));
+
+		SIMD::StoreU(outMin.x + i, SIMD::Sub(tcx, tex));
+		SIMD::StoreU(outMin.y + i, SIMD::Sub(tcy, tey));
+		SIMD::StoreU(outMin.z + i, SIMD::Sub(tcz, tez));
+		SIMD::StoreU(outMax.x + i, SIMD::Add(tcx, tex));
+		SIMD::StoreU(outMax.y + i, SIMD::Add(tcy, tey));
+		SIMD::StoreU(outMax.z + i, SIMD::Add(tcz, tez));
+	}
+	BatchTransformScalar::TransformAABBs(matrix, matrixStride, inMin, inMax, outMin, outMax, i, num);
+}
+
+} // namespace
+
+const BatchTransformKernels& GetBaselineBatchTransformKernels()
+{
+	static const BatchTransformKernels kernels = { &TransformPoints, &TransformNormals, &MultiplyMatrices, &TransformAABBs };
+	return kernels;
+}
+
+} // namespace DE
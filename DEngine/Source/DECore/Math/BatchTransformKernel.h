@@ -0,0 +1,93 @@
+// BatchTransformKernel.h: kernel table shared by BatchTransform.cpp and the per instruction set kernel files
+#pragma once
+
+// Engine
+#include <DECore/Math/BatchTransform.h>
+// Cpp
+#include <math.h>
+#include <stdint.h>
+
+namespace DE
+{
+
+/** @brief	Matrices are passed as 16 floats in row major order. A stride of 0 floats
+*		reuses one matrix for every element, a stride of 16 walks an array
+*/
+struct BatchTransformKernels
+{
+	void (*TransformPoints)(const float* matrix, const Float3Stream& in, const Float3Stream& out, uint32_t num);
+	void (*TransformNormals)(const float* matrix, const Float3Stream& in, const Float3Stream& out, uint32_t num);
+	void (*MultiplyMatrices)(const float* local, const float* parent, uint32_t parentStride, float* out, uint32_t num);
+	void (*TransformAABBs)(const float* matrix, uint32_t matrixStride, const Float3Stream& inMin, const Float3Stream& inMax, const Float3Stream& outMin, const Float3Stream& outMax, uint32_t num);
+};
+
+const BatchTransformKernels& GetBaselineBatchTransformKernels();
+// x86 only, the baseline kernels elsewhere
+const BatchTransformKernels& GetAVX2BatchTransformKernels();
+const BatchTransformKernels& GetAVX512BatchTransformKernels();
+
+// internal linkage, each kernel file compiled for its own instruction set keeps its own copy,
+// the linker must not pick an AVX-512 one for the baseline kernels
+namespace
+{
+
+/** @brief Scalar kernels for the elements left after the last full register, over [begin, end) */
+struct BatchTransformScalar
+{
+	static void TransformPoints(const float* m, const Float3Stream& in, const Float3Stream& out, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const float x = in.x[i];
+			const float y = in.y[i];
+			const float z = in.z[i];
+			out.x[i] = x * m[0] + y * m[4] + z * m[8] + m[12];
+			out.y[i] = x * m[1] + y * m[5] + z * m[9] + m[13];
+			out.z[i] = x * m[2] + y * m[6] + z * m[10] + m[14];
+		}
+	}
+
+	static void TransformNormals(const float* m, const Float3Stream& in, const Float3Stream& out, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const float x = in.x[i];
+			const float y = in.y[i];
+			const float z = in.z[i];
+			out.x[i] = x * m[0] + y * m[4] + z * m[8];
+			out.y[i] = x * m[1] + y * m[5] + z * m[9];
+			out.z[i] = x * m[2] + y * m[6] + z * m[10];
+		}
+	}
+
+	static void TransformAABBs(const float* matrix, uint32_t matrixStride, const Float3Stream& inMin, const Float3Stream& inMax, const Float3Stream& outMin, const Float3Stream& outMax, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const float* m = matrix + matrixStride * i;
+			// transform the center, the half extent goes through the absolute of the 3x3
+			const float cx = (inMin.x[i] + inMax.x[i]) * 0.5f;
+			const float cy = (inMin.y[i] + inMax.y[i]) * 0.5f;
+			const float cz = (inMin.z[i] + inMax.z[i]) * 0.5f;
+			const float ex = (inMax.x[i] - inMin.x[i]) * 0.5f;
+			const float ey = (inMax.y[i] - inMin.y[i]) * 0.5f;
+			const float ez = (inMax.z[i] - inMin.z[i]) * 0.5f;
+			const float tcx = cx * m[0] + cy * m[4] + cz * m[8] + m[12];
+			const float tcy = cx * m[1] + cy * m[5] + cz * m[9] + m[13];
+			const float tcz = cx * m[2] + cy * m[6] + cz * m[10] + m[14];
+			const float tex = ex * fabsf(m[0]) + ey * fabsf(m[4]) + ez * fabsf(m[8]);
+			const float tey = ex * fabsf(m[1]) + ey * fabsf(m[5]) + ez * fabsf(m[9]);
+			const float tez = ex * fabsf(m[2]) + ey * fabsf(m[6]) + ez * fabsf(m[10]);
+			outMin.x[i] = tcx - tex;
+			outMin.y[i] = tcy - tey;
+			outMin.z[i] = tcz - tez;
+			outMax.x[i] = tcx + tex;
+			outMax.y[i] = tcy + tey;
+			outMax.z[i] = tcz + tez;
+		}
+	}
+};
+
+} // namespace
+
+} // namespace DE
@@ -0,0 +1,324 @@
+#include <DECore/DECore.h>
+#include "BoundingVolume.h"
+
+#include <assert.h>
+
+namespace DE
+{
+
+namespace
+{
+
+using SIMD::Float4;
+
+constexpr uint32_t DIRECTION_NUM = 7;		// EPOS-14, the axes and the 4 diagonals of a cube
+constexpr float MAX_EXACT_INDEX = 16777216.0f;	// 2^24, the point indices are kept in float lanes
+
+/** @brief Deinterleave 4 points packed as x, y, z into one register per component */
+inline void LoadPoints(const float* p, Float4& x, Float4& y, Float4& z)
+{
+	const Float4 a = SIMD::LoadU(p);		// x0 y0 z0 x1
+	const Float4 b = SIMD::LoadU(p + 4);	// y1 z1 x2 y2
+	const Float4 c = SIMD::LoadU(p + 8);	// z2 x3 y3 z3
+	x = SIMD::Shuffle<0, 3, 1, 2>(a, SIMD::Shuffle<2, 2, 1, 1>(b, c));
+	y = SIMD::Shuffle<1, 2, 1, 2>(SIMD::Shuffle<1, 1, 0, 0>(a, b), SIMD::Shuffle<3, 3, 2, 2>(b, c));
+	z = SIMD::Shuffle<1, 2, 1, 2>(SIMD::Shuffle<2, 2, 1, 1>(a, b), SIMD::Shuffle<0, 0, 3, 3>(c, c));
+}
+
+/** @brief The projections of 4 points on the EPOS-14 directions, not normalized */
+inline void Project(Float4 x, Float4 y, Float4 z, Float4 projections[DIRECTION_NUM])
+{
+	const Float4 xyPlus = SIMD::Add(x, y);
+	const Float4 xyMinus = SIMD::Sub(x, y);
+	projections[0] = x;
+	projections[1] = y;
+	projections[2] = z;
+	projections[3] = SIMD::Add(xyPlus, z);
+	projections[4] = SIMD::Sub(xyPlus, z);
+	projections[5] = SIMD::Add(xyMinus, z);
+	projections[6] = SIMD::Sub(xyMinus, z);
+}
+
+inline void Project(float x, float y, float z, float projections[DIRECTION_NUM])
+{
+	projections[0] = x;
+	projections[1] = y;
+	projections[2] = z;
+	projections[3] = x + y + z;
+	projections[4] = x + y - z;
+	projections[5] = x - y + z;
+	projections[6] = x - y - z;
+}
+
+/** @brief Find the points with the smallest and the largest projection on each direction */
+void FindExtremePoints(const float* positions, uint32_t num, uint32_t minIndex[DIRECTION_NUM], uint32_t maxIndex[DIRECTION_NUM])
+{
+	float minValue[DIRECTION_NUM];
+	float maxValue[DIRECTION_NUM];
+	for (uint32_t d = 0; d < DIRECTION_NUM; ++d)
+	{
+		minValue[d] = INFINITY;
+		maxValue[d] = -INFINITY;
+		minIndex[d] = 0;
+		maxIndex[d] = 0;
+	}
+
+	uint32_t i = 0;
+	if (num >= 4)
+	{
+		// every lane keeps its own extremes and their indices, reduced after the loop
+		Float4 minLaneValue[DIRECTION_NUM], maxLaneValue[DIRECTION_NUM], minLaneIndex[DIRECTION_NUM], maxLaneIndex[DIRECTION_NUM];
+		for (uint32_t d = 0; d < DIRECTION_NUM; ++d)
+		{
+			minLaneValue[d] = SIMD::Splat(INFINITY);
+			maxLaneValue[d] = SIMD::Splat(-INFINITY);
+			minLaneIndex[d] = SIMD::Zero();
+			maxLaneIndex[d] = SIMD::Zero();
+		}
+		const Float4 step = SIMD::Splat(4.0f);
+		Float4 index = SIMD::Set(0.0f, 1.0f, 2.0f, 3.0f);
+		for (; i + 4 <= num; i += 4, index = SIMD::Add(index, step))
+		{
+			Float4 x, y, z;
+			LoadPoints(positions + i * 3, x, y, z);
+			Float4 projections[DIRECTION_NUM];
+			Project(x, y, z, projections);
+			for (uint32_t d = 0; d < DIRECTION_NUM; ++d)
+			{
+				const Float4 less = SIMD::CmpLT(projections[d], minLaneValue[d]);
+				const Float4 greater = SIMD::CmpGT(projections[d], maxLaneValue[d]);
+				minLaneValue[d] = SIMD::Select(minLaneValue[d], projections[d], less);
+				minLaneIndex[d] = SIMD::Select(minLaneIndex[d], index, less);
+				maxLaneValue[d] = SIMD::Select(maxLaneValue[d], projections[d], greater);
+				maxLaneIndex[d] = SIMD::Select(maxLaneIndex[d], index, greater);
+			}
+		}
+
+		for (uint32_t d = 0; d < DIRECTION_NUM; ++d)
+		{
+			alignas(16) float laneMin[4], laneMax[4], laneMinIndex[4], laneMaxIndex[4];
+			SIMD::Store(laneMin, minLaneValue[d]);
+			SIMD::Store(laneMax, maxLaneValue[d]);
+			SIMD::Store(laneMinIndex, minLaneIndex[d]);
+			SIMD::Store(laneMaxIndex, maxLaneIndex[d]);
+			for (uint32_t l = 0; l < 4; ++l)
+			{
+				if (laneMin[l] < minValue[d])
+				{
+					minValue[d] = laneMin[l];
+					minIndex[d] = static_cast<uint32_t>(laneMinIndex[l]);
+				}
+				if (laneMax[l] > maxValue[d])
+				{
+					maxValue[d] = laneMax[l];
+					maxIndex[d] = static_cast<uint32_t>(laneMaxIndex[l]);
+				}
+			}
+		}
+	}
+
+	for (; i < num; ++i)
+	{
+		const float* p = positions + i * 3;
+		float projections[DIRECTION_NUM];
+		Project(p[0], p[1], p[2], projections);
+		for (uint32_t d = 0; d < DIRECTION_NUM; ++d)
+		{
+			if (projections[d] < minValue[d])
+			{
+				minValue[d] = projections[d];
+				minIndex[d] = i;
+			}
+			if (projections[d] > maxValue[d])
+			{
+				maxValue[d] = projections[d];
+				maxIndex[d] = i;
+			}
+		}
+	}
+}
+
+inline Vector3 GetPoint(const float* positions, uint32_t index)
+{
+	const float* p = positions + index * 3;
+	return Vector3(p[0], p[1], p[2]);
+}
+
+} // namespace
+
+AABB AABB::FromPoints(const float* positions, uint32_t num)
+{
+	float min[3] = { INFINITY, INFINITY, INFINITY };
+	float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+	uint32_t i = 0;
+	if (num >= 4)
+	{
+		// 4 points are the registers (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3), no shuffle is
+		// needed for a component wise reduction as long as each register keeps its own result
+		Float4 min0 = SIMD::Splat(INFINITY), min1 = min0, min2 = min0;
+		Float4 max0 = SIMD::Splat(-INFINITY), max1 = max0, max2 = max0;
+		for (; i + 4 <= num; i += 4)
+		{
+			const float* p = positions + i * 3;
+			const Float4 a = SIMD::LoadU(p);
+			const Float4 b = SIMD::LoadU(p + 4);
+			const Float4 c = SIMD::LoadU(p + 8);
+			min0 = SIMD::Min(min0, a);
+			min1 = SIMD::Min(min1, b);
+			min2 = SIMD::Min(min2, c);
+			max0 = SIMD::Max(max0, a);
+			max1 = SIMD::Max(max1, b);
+			max2 = SIMD::Max(max2, c);
+		}
+
+		// lane k of the three registers in order holds component k % 3
+		float laneMin[12], laneMax[12];
+		SIMD::StoreU(laneMin, min0);
+		SIMD::StoreU(laneMin + 4, min1);
+		SIMD::StoreU(laneMin + 8, min2);
+		SIMD::StoreU(laneMax, max0);
+		SIMD::StoreU(laneMax + 4, max1);
+		SIMD::StoreU(laneMax + 8, max2);
+		for (uint32_t k = 0; k < 12; ++k)
+		{
+			min[k % 3] = laneMin[k] < min[k % 3] ? laneMin[k] : min[k % 3];
+			max[k % 3] = laneMax[k] > max[k % 3] ? laneMax[k] : max[k % 3];
+		}
+	}
+
+	for (; i < num; ++i)
+	{
+		const float* p = positions + i * 3;
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			min[k] = p[k] < min[k] ? p[k] : min[k];
+			max[k] = p[k] > max[k] ? p[k] : max[k];
+		}
+	}
+	return AABB(Vector3(min[0], min[1], min[2]), Vector3(max[0], max[1], max[2]));
+}
+
+AABB AABB::Transformed(const Matrix4& transform) const
+{
+	// transform the center, the half extent goes through the absolute of the 3x3
+	const float* m = transform.Raw();
+	const Vector3 center = GetCenter();
+	const Vector3 extent = GetExtent();
+	float newCenter[3], newExtent[3];
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		newCenter[c] = center.GetX() * m[c] + center.GetY() * m[4 + c] + center.GetZ() * m[8 + c] + m[12 + c];
+		newExtent[c] = extent.GetX() * fabsf(m[c]) + extent.GetY() * fabsf(m[4 + c]) + extent.GetZ() * fabsf(m[8 + c]);
+	}
+	return AABB(Vector3(newCenter[0] - newExtent[0], newCenter[1] - newExtent[1], newCenter[2] - newExtent[2]),
+		Vector3(newCenter[0] + newExtent[0], newCenter[1] + newExtent[1], newCenter[2] + newExtent[2]));
+}
+
+Sphere Sphere::FromPoints(const float* positions, uint32_t num)
+{
+	assert(num > 0);
+	assert(num <= MAX_EXACT_INDEX && "point indices are tracked in float lanes");
+
+	uint32_t minIndex[DIRECTION_NUM];
+	uint32_t maxIndex[DIRECTION_NUM];
+	FindExtremePoints(positions, num, minIndex, maxIndex);
+
+	// the farthest pair of extreme points is the first diameter
+	uint32_t bestDirection = 0;
+	float bestDistance = -1.0f;
+	for (uint32_t d = 0; d < DIRECTION_NUM; ++d)
+	{
+		const float distance = (GetPoint(positions, maxIndex[d]) - GetPoint(positions, minIndex[d])).LengthSquared();
+		if (distance > bestDistance)
+		{
+			bestDistance = distance;
+			bestDirection = d;
+		}
+	}
+	const Vector3 pMin = GetPoint(positions, minIndex[bestDirection]);
+	const Vector3 pMax = GetPoint(positions, maxIndex[bestDirection]);
+	Sphere sphere((pMin + pMax) * 0.5f, sqrtf(bestDistance) * 0.5f);
+
+	// the other extreme points are the likeliest to be outside, merge them before the pass
+	for (uint32_t d = 0; d < DIRECTION_NUM; ++d)
+	{
+		sphere.Merge(GetPoint(positions, minIndex[d]));
+		sphere.Merge(GetPoint(positions, maxIndex[d]));
+	}
+
+	// Ritter's pass, 4 points are tested at once and only the points outside are merged
+	uint32_t i = 0;
+	if (num >= 4)
+	{
+		Float4 cx = SIMD::Splat(sphere.m_vCenter.GetX());
+		Float4 cy = SIMD::Splat(sphere.m_vCenter.GetY());
+		Float4 cz = SIMD::Splat(sphere.m_vCenter.GetZ());
+		Float4 radiusSquared = SIMD::Splat(sphere.GetRadius() * sphere.GetRadius());
+		for (; i + 4 <= num; i += 4)
+		{
+			Float4 x, y, z;
+			LoadPoints(positions + i * 3, x, y, z);
+			const Float4 dx = SIMD::Sub(x, cx);
+			const Float4 dy = SIMD::Sub(y, cy);
+			const Float4 dz = SIMD::Sub(z, cz);
+			const Float4 distanceSquared = SIMD::MulAdd(dz, dz, SIMD::MulAdd(dy, dy, SIMD::Mul(dx, dx)));
+			const uint32_t outside = SIMD::MoveMask(SIMD::CmpGT(distanceSquared, radiusSquared));
+			if (outside)
+			{
+				for (uint32_t l = 0; l < 4; ++l)
+				{
+					if (outside & (1u << l))
+					{
+						sphere.Merge(GetPoint(positions, i + l));
+					}
+				}
+				cx = SIMD::Splat(sphere.m_vCenter.GetX());
+				cy = SIMD::Splat(sphere.m_vCenter.GetY());
+				cz = SIMD::Splat(sphere.m_vCenter.GetZ());
+				radiusSquared = SIMD::Splat(sphere.GetRadius() * sphere.GetRadius());
+			}
+		}
+	}
+	for (; i < num; ++i)
+	{
+		sphere.Merge(GetPoint(positions, i));
+	}
+
+	// a merge moves the center, rounding can leave an earlier point a few ulps outside
+	sphere.m_vCenter.SetW(sphere.GetRadius() * (1.0f + 1e-5f));
+	return sphere;
+}
+
+void Sphere::Merge(const Vector3& point)
+{
+	const Vector3 center = GetCenter();
+	const Vector3 offset = point - center;
+	const float distanceSquared = offset.LengthSquared();
+	const float radius = GetRadius();
+	if (distanceSquared > radius * radius)
+	{
+		// the new sphere touches the point and the far side of the old sphere
+		const float distance = sqrtf(distanceSquared);
+		const float newRadius = (radius + distance) * 0.5f;
+		Vector3 newCenter = center + Vector3(offset) * ((newRadius - radius) / distance);
+		m_vCenter = Vector3(newCenter.GetX(), newCenter.GetY(), newCenter.GetZ(), newRadius);
+	}
+}
+
+Sphere Sphere::Transformed(const Matrix4& transform) const
+{
+	const float* m = transform.Raw();
+	const float x = m_vCenter.GetX(), y = m_vCenter.GetY(), z = m_vCenter.GetZ();
+	const Vector3 center(x * m[0] + y * m[4] + z * m[8] + m[12], x * m[1] + y * m[5] + z * m[9] + m[13], x * m[2] + y * m[6] + z * m[10] + m[14]);
+	// the rows of the 3x3 are the transformed axes, the longest one scales the radius most
+	float scaleSquared = 0.0f;
+	for (uint32_t r = 0; r < 3; ++r)
+	{
+		const float lengthSquared = m[r * 4] * m[r * 4] + m[r * 4 + 1] * m[r * 4 + 1] + m[r * 4 + 2] * m[r * 4 + 2];
+		scaleSquared = lengthSquared > scaleSquared ? lengthSquared : scaleSquared;
+	}
+	return Sphere(center, GetRadius() * sqrtf(scaleSquared));
+}
+
+} // namespace DE
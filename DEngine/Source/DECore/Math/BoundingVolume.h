@@ -0,0 +1,154 @@
+// BoundingVolume.h: axis aligned box and sphere around a set of points, e.g. the vertices of a mesh
+#pragma once
+
+// Engine
+#include <DECore/Math/simdmath.h>
+// Cpp
+#include <math.h>
+#include <stdint.h>
+
+namespace DE
+{
+
+/** @brief	Axis aligned bounding box. A default constructed box is empty, min is +inf and
+*		max is -inf, so merging a point into it gives the box of that point
+*/
+class AABB
+{
+public:
+
+	AABB()
+		: m_vMin(INFINITY, INFINITY, INFINITY)
+		, m_vMax(-INFINITY, -INFINITY, -INFINITY)
+	{}
+
+	AABB(const Vector3& vMin, const Vector3& vMax)
+		: m_vMin(vMin)
+		, m_vMax(vMax)
+	{}
+
+	/** @brief	The box of num points packed as x, y, z floats, e.g. a vertex buffer.
+	*		Reduces 4 points per iteration in three registers
+	*/
+	static AABB FromPoints(const float* positions, uint32_t num);
+
+	const Vector3& GetMin() const
+	{
+		return m_vMin;
+	}
+
+	const Vector3& GetMax() const
+	{
+		return m_vMax;
+	}
+
+	Vector3 GetCenter() const
+	{
+		return (m_vMin + m_vMax) * 0.5f;
+	}
+
+	/** @brief Return the half size on each axis */
+	Vector3 GetExtent() const
+	{
+		return (m_vMax - m_vMin) * 0.5f;
+	}
+
+	/** @brief Return if no point was merged into the box */
+	bool IsEmpty() const
+	{
+		return m_vMin.GetX() > m_vMax.GetX();
+	}
+
+	bool Contains(const Vector3& point) const
+	{
+		return point.GetX() >= m_vMin.GetX() && point.GetY() >= m_vMin.GetY() && point.GetZ() >= m_vMin.GetZ()
+			&& point.GetX() <= m_vMax.GetX() && point.GetY() <= m_vMax.GetY() && point.GetZ() <= m_vMax.GetZ();
+	}
+
+	bool Intersects(const AABB& other) const
+	{
+		return m_vMin.GetX() <= other.m_vMax.GetX() && m_vMin.GetY() <= other.m_vMax.GetY() && m_vMin.GetZ() <= other.m_vMax.GetZ()
+			&& other.m_vMin.GetX() <= m_vMax.GetX() && other.m_vMin.GetY() <= m_vMax.GetY() && other.m_vMin.GetZ() <= m_vMax.GetZ();
+	}
+
+	void Merge(const Vector3& point)
+	{
+		m_vMin = Vector3(SIMD::Min(m_vMin._data, point._data));
+		m_vMax = Vector3(SIMD::Max(m_vMax._data, point._data));
+	}
+
+	void Merge(const AABB& other)
+	{
+		m_vMin = Vector3(SIMD::Min(m_vMin._data, other.m_vMin._data));
+		m_vMax = Vector3(SIMD::Max(m_vMax._data, other.m_vMax._data));
+	}
+
+	/** @brief Return the tight box around this box transformed by an affine matrix, p * transform */
+	AABB Transformed(const Matrix4& transform) const;
+
+private:
+
+	Vector3						m_vMin;
+	Vector3						m_vMax;
+};
+
+/** @brief Bounding sphere, the radius is kept in the w component of the center */
+class Sphere
+{
+public:
+
+	Sphere()
+		: m_vCenter(0.0f, 0.0f, 0.0f, 0.0f)
+	{}
+
+	Sphere(const Vector3& vCenter, float fRadius)
+		: m_vCenter(vCenter.GetX(), vCenter.GetY(), vCenter.GetZ(), fRadius)
+	{}
+
+	/** @brief	A sphere around num points packed as x, y, z floats, e.g. a vertex buffer.
+	*		EPOS-14: the farthest pair of the extreme points along 7 directions gives the
+	*		first sphere, then one Ritter pass grows it over every point. Usually within
+	*		a few percent of the minimum sphere, linear in the number of points
+	*/
+	static Sphere FromPoints(const float* positions, uint32_t num);
+
+	/** @brief The sphere through the corners of a box */
+	static Sphere FromAABB(const AABB& box)
+	{
+		return Sphere(box.GetCenter(), box.GetExtent().Length());
+	}
+
+	Vector3 GetCenter() const
+	{
+		return Vector3(m_vCenter.GetX(), m_vCenter.GetY(), m_vCenter.GetZ());
+	}
+
+	float GetRadius() const
+	{
+		return m_vCenter.GetW();
+	}
+
+	bool Contains(const Vector3& point) const
+	{
+		return (point - GetCenter()).LengthSquared() <= GetRadius() * GetRadius();
+	}
+
+	bool Intersects(const Sphere& other) const
+	{
+		const float radius = GetRadius() + other.GetRadius();
+		return (other.GetCenter() - GetCenter()).LengthSquared() <= radius * radius;
+	}
+
+	/** @brief Grow to the smallest sphere around this sphere and the point, Ritter's update */
+	void Merge(const Vector3& point);
+
+	/** @brief Return the sphere transformed by an affine matrix, the radius is scaled by the largest axis scale */
+	Sphere Transformed(const Matrix4& transform) const;
+
+private:
+
+	// Stores radius to w component
+	Vector3						m_vCenter;
+};
+
+} // namespace DE
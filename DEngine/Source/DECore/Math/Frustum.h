@@ -3,6 +3,7 @@
 
 #include "simdmath.h"
 #include "Plane.h"
+#include "BoundingVolume.h"
 
 namespace DE
 {
@@ -18,46 +19,75 @@ public:
 		Reconstruct(fFov, fRatio, fZNear, fZFar);
 	}
 
-	// Bounding sphere culling
-	//bool Cull(Sphere sphere)
-	//{
-	//	for (int i = 0; i < 6; ++i)
-	//	{
-	//		if (!m_planes[i].IsInside(sphere))
-	//		{
-	//			return false;
-	//		}
-	//	}
-	//	return true;
-	//}
-
-	//// Bounding box culling
-	//bool Cull(AABB box)
-	//{
-	//	for (int i = 0; i < 6; ++i)
-	//	{
-	//		Vector3 planeNormal = m_planes[i].GetNormal();
-	//		Vector3 max = box.getMax();
-	//		Vector3 min = box.getMin();
-	//		Vector3 testPoint
-	//			(
-	//				(planeNormal.GetX() > 0 ? max.GetX() : min.GetX()),
-	//				(planeNormal.GetY() > 0 ? max.GetY() : min.GetY()),
-	//				(planeNormal.GetZ() > 0 ? max.GetZ() : min.GetZ())
-	//			);
-	//		if (!m_planes[i].IsInside(testPoint))
-	//		{
-	//			return false;
-	//		}
-	//	}
-	//	return true;
-	//}
+	// Bounding sphere culling, false if the sphere is completely outside one plane.
+	// The plane normals point inside, as FromViewProjection builds them
+	bool Cull(const Sphere& sphere) const
+	{
+		const Vector3 center = sphere.GetCenter();
+		for (int i = 0; i < 6; ++i)
+		{
+			if (m_planes[i].Distance(center) < -sphere.GetRadius())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Bounding box culling, tests the corner furthest along each plane normal
+	bool Cull(const AABB& box) const
+	{
+		const Vector3& max = box.GetMax();
+		const Vector3& min = box.GetMin();
+		for (int i = 0; i < 6; ++i)
+		{
+			const Vector3& planeNormal = m_planes[i].m_vNormal;
+			const Vector3 testPoint
+				(
+					(planeNormal.GetX() > 0 ? max.GetX() : min.GetX()),
+					(planeNormal.GetY() > 0 ? max.GetY() : min.GetY()),
+					(planeNormal.GetZ() > 0 ? max.GetZ() : min.GetZ())
+				);
+			if (m_planes[i].Distance(testPoint) < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Extract the planes of a view projection matrix, points are p * viewProjection in D3D clip space.
+	// The normals point inside, left, right, bottom, top, near, far
+	static Frustum FromViewProjection(const Matrix4& viewProjection)
+	{
+		// clip = (x, y, z, w), inside is -w <= x <= w, -w <= y <= w and 0 <= z <= w.
+		// Column c of the matrix gives clip component c
+		const float* m = viewProjection.Raw();
+		auto column = [m](int c, int r) { return m[r * 4 + c]; };
+		auto plane = [&column](int c, float sign) {
+			return Plane(column(3, 0) + sign * column(c, 0), column(3, 1) + sign * column(c, 1), column(3, 2) + sign * column(c, 2), column(3, 3) + sign * column(c, 3));
+		};
+
+		Frustum frustum;
+		frustum.m_planes[0] = plane(0, 1.0f);
+		frustum.m_planes[1] = plane(0, -1.0f);
+		frustum.m_planes[2] = plane(1, 1.0f);
+		frustum.m_planes[3] = plane(1, -1.0f);
+		frustum.m_planes[4] = Plane(column(2, 0), column(2, 1), column(2, 2), column(2, 3));
+		frustum.m_planes[5] = plane(2, -1.0f);
+		return frustum;
+	}
 
 	Plane* GetPlanes()
 	{
 		return m_planes;
 	}
 
+	const Plane* GetPlanes() const
+	{
+		return m_planes;
+	}
+
 private:
 
 	void Reconstruct(const float fFov, const float fRatio, const float fZNear, const float fZFar)
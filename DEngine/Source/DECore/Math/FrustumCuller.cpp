@@ -0,0 +1,139 @@
+#include <DECore/DECore.h>
+#include "FrustumCuller.h"
+#include "FrustumCullerKernel.h"
+
+#include <DECore/Container/Vector.h>
+#include <DECore/Job/JobScheduler.h>
+
+#include <string.h>
+
+namespace DE
+{
+
+namespace
+{
+
+constexpr uint32_t CHUNK_ALIGNMENT = 16;	// a chunk starts at a full register of every kernel
+constexpr uint32_t MAX_CHUNKS = 256;		// well below the job queue of a worker
+
+const FrustumCullKernels& GetKernels()
+{
+	switch (BatchTransform::GetSIMDLevel())
+	{
+	case SIMDLevel::AVX512:
+		return GetAVX512FrustumCullKernels();
+	case SIMDLevel::AVX2:
+		return GetAVX2FrustumCullKernels();
+	default:
+		return GetBaselineFrustumCullKernels();
+	}
+}
+
+/** @brief	The objects [begin, end) of one job, the visible indices go to visible + begin.
+*		Allocated per job, the job system deletes it when the job finishes
+*/
+struct CullChunk
+{
+	const FrustumCullKernels*	m_pKernels;
+	const CullPlanes*			m_pPlanes;
+	const Float3Stream*			m_pFirst;	// centers or minimum corners
+	const Float3Stream*			m_pSecond;	// maximum corners, null for spheres
+	const float*				m_pRadii;
+	uint32_t*					m_pVisible;
+	uint32_t*					m_pNumVisible;
+	uint32_t					m_iBegin;
+	uint32_t					m_iEnd;
+};
+
+void CullChunkJob(void* data)
+{
+	CullChunk* pChunk = reinterpret_cast<CullChunk*>(data);
+	uint32_t* pVisible = pChunk->m_pVisible + pChunk->m_iBegin;
+	if (pChunk->m_pSecond)
+	{
+		*pChunk->m_pNumVisible = pChunk->m_pKernels->CullAABBs(*pChunk->m_pPlanes, *pChunk->m_pFirst, *pChunk->m_pSecond, pChunk->m_iBegin, pChunk->m_iEnd, pVisible);
+	}
+	else
+	{
+		*pChunk->m_pNumVisible = pChunk->m_pKernels->CullSpheres(*pChunk->m_pPlanes, *pChunk->m_pFirst, pChunk->m_pRadii, pChunk->m_iBegin, pChunk->m_iEnd, pVisible);
+	}
+}
+
+uint32_t CullParallel(const CullPlanes& planes, const Float3Stream& first, const Float3Stream* pSecond, const float* radii, uint32_t num, uint32_t* visible, uint32_t chunkSize)
+{
+	chunkSize = (chunkSize + CHUNK_ALIGNMENT - 1) / CHUNK_ALIGNMENT * CHUNK_ALIGNMENT;
+	if (chunkSize == 0)
+	{
+		chunkSize = CHUNK_ALIGNMENT;
+	}
+	if ((num + chunkSize - 1) / chunkSize > MAX_CHUNKS)
+	{
+		chunkSize = ((num + MAX_CHUNKS - 1) / MAX_CHUNKS + CHUNK_ALIGNMENT - 1) / CHUNK_ALIGNMENT * CHUNK_ALIGNMENT;
+	}
+	const uint32_t numChunks = (num + chunkSize - 1) / chunkSize;
+
+	const FrustumCullKernels& kernels = GetKernels();
+	if (numChunks <= 1)
+	{
+		return pSecond ? kernels.CullAABBs(planes, first, *pSecond, 0, num, visible) : kernels.CullSpheres(planes, first, radii, 0, num, visible);
+	}
+
+	Vector<uint32_t> numVisibles(numChunks);
+	Vector<Job::Desc> jobDescs(numChunks);
+	for (uint32_t i = 0; i < numChunks; ++i)
+	{
+		const uint32_t begin = i * chunkSize;
+		const uint32_t end = num - begin > chunkSize ? begin + chunkSize : num;
+		CullChunk* data = new CullChunk{ &kernels, &planes, &first, pSecond, radii, visible, &numVisibles[i], begin, end };
+		jobDescs[i] = Job::Desc(&CullChunkJob, data, nullptr);
+	}
+	Job* counter = JobScheduler::Instance()->Run(jobDescs);
+	JobScheduler::Instance()->WaitOnMainThread(counter);
+
+	// every chunk wrote to its own range, move them together in order
+	uint32_t numVisible = numVisibles[0];
+	for (uint32_t i = 1; i < numChunks; ++i)
+	{
+		memmove(visible + numVisible, visible + i * chunkSize, numVisibles[i] * sizeof(uint32_t));
+		numVisible += numVisibles[i];
+	}
+	return numVisible;
+}
+
+} // namespace
+
+void FrustumCuller::SetFrustum(const Frustum& frustum)
+{
+	// Plane keeps n . p = w, the kernels test n . p + d >= 0
+	const Plane* planes = frustum.GetPlanes();
+	for (uint32_t p = 0; p < 6; ++p)
+	{
+		const Vector3& normal = planes[p].m_vNormal;
+		m_planes.nx[p] = normal.GetX();
+		m_planes.ny[p] = normal.GetY();
+		m_planes.nz[p] = normal.GetZ();
+		m_planes.d[p] = -normal.GetW();
+	}
+}
+
+uint32_t FrustumCuller::CullSpheres(const Float3Stream& centers, const float* radii, uint32_t num, uint32_t* visible) const
+{
+	return GetKernels().CullSpheres(m_planes, centers, radii, 0, num, visible);
+}
+
+uint32_t FrustumCuller::CullAABBs(const Float3Stream& min, const Float3Stream& max, uint32_t num, uint32_t* visible) const
+{
+	return GetKernels().CullAABBs(m_planes, min, max, 0, num, visible);
+}
+
+uint32_t FrustumCuller::CullSpheresParallel(const Float3Stream& centers, const float* radii, uint32_t num, uint32_t* visible, uint32_t chunkSize) const
+{
+	return CullParallel(m_planes, centers, nullptr, radii, num, visible, chunkSize);
+}
+
+uint32_t FrustumCuller::CullAABBsParallel(const Float3Stream& min, const Float3Stream& max, uint32_t num, uint32_t* visible, uint32_t chunkSize) const
+{
+	return CullParallel(m_planes, min, &max, nullptr, num, visible, chunkSize);
+}
+
+} // namespace DE
@@ -0,0 +1,93 @@
+// FrustumCuller.h: test many bounding spheres or boxes against the 6 planes of a camera per call, 4, 8 or 16 objects per instruction
+#pragma once
+
+// Engine
+#include <DECore/Math/BatchTransform.h>
+#include <DECore/Math/Frustum.h>
+// Cpp
+#include <stdint.h>
+
+namespace DE
+{
+
+/** @brief	The 6 planes of a frustum in structure of arrays, a point p is inside
+*		plane i when nx[i] * p.x + ny[i] * p.y + nz[i] * p.z + d[i] >= 0
+*/
+struct CullPlanes
+{
+	float		nx[6];
+	float		ny[6];
+	float		nz[6];
+	float		d[6];
+};
+
+/** @brief	Frustum culling over bounds in structure of arrays, e.g. the columns of a
+*		SoAVector. An object is culled when it is completely outside one plane, so a
+*		large object near a corner of the frustum may stay visible. The result is a
+*		compact list of the indices of the visible objects in increasing order.
+*		The kernels follow the instruction set of BatchTransform::SetSIMDLevel
+*/
+class FrustumCuller
+{
+public:
+
+	// objects per job of the parallel calls, rounded up to a multiple of 16
+	static constexpr uint32_t DEFAULT_CHUNK_SIZE = 4096;
+
+	FrustumCuller() = default;
+
+	explicit FrustumCuller(const Frustum& frustum)
+	{
+		SetFrustum(frustum);
+	}
+
+	/** @brief Cull against the frustum of a camera, e.g. Camera::GetCameraToScreen() */
+	explicit FrustumCuller(const Matrix4& viewProjection)
+	{
+		SetFrustum(Frustum::FromViewProjection(viewProjection));
+	}
+
+	/** @brief Use the planes of a frustum, their normals must point inside */
+	void SetFrustum(const Frustum& frustum);
+
+	/** @brief	Find the spheres that intersect the frustum
+	*
+	*	@param centers: the sphere centers
+	*	@param radii: the sphere radii
+	*	@param num: number of spheres
+	*	@param visible: receives the indices of the visible spheres, must hold num indices
+	*	@return number of visible spheres
+	*/
+	uint32_t CullSpheres(const Float3Stream& centers, const float* radii, uint32_t num, uint32_t* visible) const;
+
+	/** @brief	Find the axis aligned boxes that intersect the frustum
+	*
+	*	@param min: the minimum corners
+	*	@param max: the maximum corners
+	*	@param num: number of boxes
+	*	@param visible: receives the indices of the visible boxes, must hold num indices
+	*	@return number of visible boxes
+	*/
+	uint32_t CullAABBs(const Float3Stream& min, const Float3Stream& max, uint32_t num, uint32_t* visible) const;
+
+	/** @brief	CullSpheres() split in chunks over the job system, the result is the same.
+	*		JobScheduler must be started, blocks on WaitOnMainThread()
+	*/
+	uint32_t CullSpheresParallel(const Float3Stream& centers, const float* radii, uint32_t num, uint32_t* visible, uint32_t chunkSize = DEFAULT_CHUNK_SIZE) const;
+
+	/** @brief	CullAABBs() split in chunks over the job system, the result is the same.
+	*		JobScheduler must be started, blocks on WaitOnMainThread()
+	*/
+	uint32_t CullAABBsParallel(const Float3Stream& min, const Float3Stream& max, uint32_t num, uint32_t* visible, uint32_t chunkSize = DEFAULT_CHUNK_SIZE) const;
+
+	const CullPlanes& GetPlanes() const
+	{
+		return m_planes;
+	}
+
+private:
+
+	CullPlanes					m_planes = {};
+};
+
+} // namespace DE
@@ -0,0 +1,161 @@
+// FrustumCullerAVX2.cpp: premake builds this file with /arch:AVX2, it only runs after CPUID reported AVX2, FMA3 and POPCNT
+#include <DECore/DECore.h>
+#include "FrustumCullerKernel.h"
+
+#if DE_SIMD_X86
+
+// only raw intrinsics below, an inline function of the math headers used here would be built for AVX2 and could be picked by the linker for every caller
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma,popcnt"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2,fma,popcnt")
+#endif
+
+#include <immintrin.h>
+
+namespace DE
+{
+
+namespace
+{
+
+/** @brief For each 8 bit mask, the lanes of its set bits packed to the low bytes */
+struct CompactTable
+{
+	constexpr CompactTable()
+		: m_lanes()
+	{
+		for (uint32_t mask = 0; mask < 256; ++mask)
+		{
+			uint64_t lanes = 0;
+			uint32_t num = 0;
+			for (uint32_t l = 0; l < 8; ++l)
+			{
+				if (mask & (1u << l))
+				{
+					lanes |= static_cast<uint64_t>(l) << (num++ * 8);
+				}
+			}
+			m_lanes[mask] = lanes;
+		}
+	}
+
+	uint64_t	m_lanes[256];
+};
+
+constexpr CompactTable COMPACT_TABLE;
+
+/** @brief Append the indices of the set bits of mask with one permute and one store of 8 lanes */
+inline uint32_t Compact(uint32_t mask, __m256i index, uint32_t* visible, uint32_t num)
+{
+	const __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&COMPACT_TABLE.m_lanes[mask])));
+	// the lanes past the set bits are overwritten by the next store or are inside the end - begin indices
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(visible + num), _mm256_permutevar8x32_epi32(index, lanes));
+	return num + _mm_popcnt_u32(mask);
+}
+
+uint32_t CullSpheres(const CullPlanes& planes, const Float3Stream& centers, const float* radii, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	__m256 nx[6], ny[6], nz[6], d[6];
+	for (uint32_t p = 0; p < 6; ++p)
+	{
+		nx[p] = _mm256_set1_ps(planes.nx[p]);
+		ny[p] = _mm256_set1_ps(planes.ny[p]);
+		nz[p] = _mm256_set1_ps(planes.nz[p]);
+		d[p] = _mm256_set1_ps(planes.d[p]);
+	}
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256i step = _mm256_set1_epi32(8);
+	__m256i index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(begin)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+	uint32_t num = 0;
+	uint32_t i = begin;
+	for (; i + 8 <= end; i += 8, index = _mm256_add_epi32(index, step))
+	{
+		const __m256 x = _mm256_loadu_ps(centers.x + i);
+		const __m256 y = _mm256_loadu_ps(centers.y + i);
+		const __m256 z = _mm256_loadu_ps(centers.z + i);
+		const __m256 r = _mm256_loadu_ps(radii + i);
+		__m256 distance = _mm256_fmadd_ps(z, nz[0], _mm256_fmadd_ps(y, ny[0], _mm256_fmadd_ps(x, nx[0], d[0])));
+		for (uint32_t p = 1; p < 6; ++p)
+		{
+			distance = _mm256_min_ps(distance, _mm256_fmadd_ps(z, nz[p], _mm256_fmadd_ps(y, ny[p], _mm256_fmadd_ps(x, nx[p], d[p]))));
+		}
+		const uint32_t inside = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(distance, r), zero, _CMP_NLT_UQ)));
+		num = Compact(inside, index, visible, num);
+	}
+	return FrustumCullScalar::CullSpheres(planes, centers, radii, i, end, visible, num);
+}
+
+uint32_t CullAABBs(const CullPlanes& planes, const Float3Stream& min, const Float3Stream& max, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	__m256 nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+	for (uint32_t p = 0; p < 6; ++p)
+	{
+		nx[p] = _mm256_set1_ps(planes.nx[p]);
+		ny[p] = _mm256_set1_ps(planes.ny[p]);
+		nz[p] = _mm256_set1_ps(planes.nz[p]);
+		d[p] = _mm256_set1_ps(planes.d[p]);
+		ax[p] = _mm256_andnot_ps(sign, nx[p]);
+		ay[p] = _mm256_andnot_ps(sign, ny[p]);
+		az[p] = _mm256_andnot_ps(sign, nz[p]);
+	}
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256i step = _mm256_set1_epi32(8);
+	__m256i index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(begin)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+	uint32_t num = 0;
+	uint32_t i = begin;
+	for (; i + 8 <= end; i += 8, index = _mm256_add_epi32(index, step))
+	{
+		const __m256 minX = _mm256_loadu_ps(min.x + i), maxX = _mm256_loadu_ps(max.x + i);
+		const __m256 minY = _mm256_loadu_ps(min.y + i), maxY = _mm256_loadu_ps(max.y + i);
+		const __m256 minZ = _mm256_loadu_ps(min.z + i), maxZ = _mm256_loadu_ps(max.z + i);
+		const __m256 cx = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half);
+		const __m256 cy = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half);
+		const __m256 cz = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half);
+		const __m256 ex = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+		const __m256 ey = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+		const __m256 ez = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+		__m256 distance = _mm256_set1_ps(INFINITY);
+		for (uint32_t p = 0; p < 6; ++p)
+		{
+			const __m256 center = _mm256_fmadd_ps(cz, nz[p], _mm256_fmadd_ps(cy, ny[p], _mm256_fmadd_ps(cx, nx[p], d[p])));
+			const __m256 extent = _mm256_fmadd_ps(ez, az[p], _mm256_fmadd_ps(ey, ay[p], _mm256_mul_ps(ex, ax[p])));
+			distance = _mm256_min_ps(distance, _mm256_add_ps(center, extent));
+		}
+		const uint32_t inside = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(distance, zero, _CMP_NLT_UQ)));
+		num = Compact(inside, index, visible, num);
+	}
+	return FrustumCullScalar::CullAABBs(planes, min, max, i, end, visible, num);
+}
+
+} // namespace
+
+const FrustumCullKernels& GetAVX2FrustumCullKernels()
+{
+	static const FrustumCullKernels kernels = { &CullSpheres, &CullAABBs };
+	return kernels;
+}
+
+} // namespace DE
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#else
+
+namespace DE
+{
+
+const FrustumCullKernels& GetAVX2FrustumCullKernels()
+{
+	return GetBaselineFrustumCullKernels();
+}
+
+} // namespace DE
+
+#endif // DE_SIMD_X86
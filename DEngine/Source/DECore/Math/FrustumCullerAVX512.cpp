@@ -0,0 +1,137 @@
+// FrustumCullerAVX512.cpp: premake builds this file with /arch:AVX512, it only runs after CPUID reported AVX-512F and POPCNT
+#include <DECore/DECore.h>
+#include "FrustumCullerKernel.h"
+
+#if DE_SIMD_X86
+
+// only raw intrinsics below, an inline function of the math headers used here would be built for AVX-512 and could be picked by the linker for every caller
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,popcnt"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx512f,popcnt")
+#endif
+
+#include <immintrin.h>
+
+namespace DE
+{
+
+namespace
+{
+
+/** @brief Mask of the first num lanes */
+inline __mmask16 TailMask(uint32_t num)
+{
+	return static_cast<__mmask16>((1u << num) - 1);
+}
+
+/** @brief Append the lanes of index selected by mask, compress store writes only those */
+inline uint32_t Compact(__mmask16 mask, __m512i index, uint32_t* visible, uint32_t num)
+{
+	_mm512_mask_compressstoreu_epi32(visible + num, mask, index);
+	return num + _mm_popcnt_u32(mask);
+}
+
+uint32_t CullSpheres(const CullPlanes& planes, const Float3Stream& centers, const float* radii, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	__m512 nx[6], ny[6], nz[6], d[6];
+	for (uint32_t p = 0; p < 6; ++p)
+	{
+		nx[p] = _mm512_set1_ps(planes.nx[p]);
+		ny[p] = _mm512_set1_ps(planes.ny[p]);
+		nz[p] = _mm512_set1_ps(planes.nz[p]);
+		d[p] = _mm512_set1_ps(planes.d[p]);
+	}
+	const __m512 zero = _mm512_setzero_ps();
+	const __m512i step = _mm512_set1_epi32(16);
+	__m512i index = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(begin)), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+	uint32_t num = 0;
+	// the last iteration masks off the objects past end
+	for (uint32_t i = begin; i < end; i += 16, index = _mm512_add_epi32(index, step))
+	{
+		const __mmask16 mask = end - i >= 16 ? 0xFFFF : TailMask(end - i);
+		const __m512 x = _mm512_maskz_loadu_ps(mask, centers.x + i);
+		const __m512 y = _mm512_maskz_loadu_ps(mask, centers.y + i);
+		const __m512 z = _mm512_maskz_loadu_ps(mask, centers.z + i);
+		const __m512 r = _mm512_maskz_loadu_ps(mask, radii + i);
+		__m512 distance = _mm512_fmadd_ps(z, nz[0], _mm512_fmadd_ps(y, ny[0], _mm512_fmadd_ps(x, nx[0], d[0])));
+		for (uint32_t p = 1; p < 6; ++p)
+		{
+			distance = _mm512_min_ps(distance, _mm512_fmadd_ps(z, nz[p], _mm512_fmadd_ps(y, ny[p], _mm512_fmadd_ps(x, nx[p], d[p]))));
+		}
+		num = Compact(_mm512_mask_cmp_ps_mask(mask, _mm512_add_ps(distance, r), zero, _CMP_NLT_UQ), index, visible, num);
+	}
+	return num;
+}
+
+uint32_t CullAABBs(const CullPlanes& planes, const Float3Stream& min, const Float3Stream& max, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	__m512 nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+	for (uint32_t p = 0; p < 6; ++p)
+	{
+		nx[p] = _mm512_set1_ps(planes.nx[p]);
+		ny[p] = _mm512_set1_ps(planes.ny[p]);
+		nz[p] = _mm512_set1_ps(planes.nz[p]);
+		d[p] = _mm512_set1_ps(planes.d[p]);
+		ax[p] = _mm512_abs_ps(nx[p]);
+		ay[p] = _mm512_abs_ps(ny[p]);
+		az[p] = _mm512_abs_ps(nz[p]);
+	}
+	const __m512 zero = _mm512_setzero_ps();
+	const __m512 half = _mm512_set1_ps(0.5f);
+	const __m512i step = _mm512_set1_epi32(16);
+	__m512i index = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(begin)), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+
+	uint32_t num = 0;
+	for (uint32_t i = begin; i < end; i += 16, index = _mm512_add_epi32(index, step))
+	{
+		const __mmask16 mask = end - i >= 16 ? 0xFFFF : TailMask(end - i);
+		const __m512 minX = _mm512_maskz_loadu_ps(mask, min.x + i), maxX = _mm512_maskz_loadu_ps(mask, max.x + i);
+		const __m512 minY = _mm512_maskz_loadu_ps(mask, min.y + i), maxY = _mm512_maskz_loadu_ps(mask, max.y + i);
+		const __m512 minZ = _mm512_maskz_loadu_ps(mask, min.z + i), maxZ = _mm512_maskz_loadu_ps(mask, max.z + i);
+		const __m512 cx = _mm512_mul_ps(_mm512_add_ps(minX, maxX), half);
+		const __m512 cy = _mm512_mul_ps(_mm512_add_ps(minY, maxY), half);
+		const __m512 cz = _mm512_mul_ps(_mm512_add_ps(minZ, maxZ), half);
+		const __m512 ex = _mm512_mul_ps(_mm512_sub_ps(maxX, minX), half);
+		const __m512 ey = _mm512_mul_ps(_mm512_sub_ps(maxY, minY), half);
+		const __m512 ez = _mm512_mul_ps(_mm512_sub_ps(maxZ, minZ), half);
+		__m512 distance = _mm512_set1_ps(INFINITY);
+		for (uint32_t p = 0; p < 6; ++p)
+		{
+			const __m512 center = _mm512_fmadd_ps(cz, nz[p], _mm512_fmadd_ps(cy, ny[p], _mm512_fmadd_ps(cx, nx[p], d[p])));
+			const __m512 extent = _mm512_fmadd_ps(ez, az[p], _mm512_fmadd_ps(ey, ay[p], _mm512_mul_ps(ex, ax[p])));
+			distance = _mm512_min_ps(distance, _mm512_add_ps(center, extent));
+		}
+		num = Compact(_mm512_mask_cmp_ps_mask(mask, distance, zero, _CMP_NLT_UQ), index, visible, num);
+	}
+	return num;
+}
+
+} // namespace
+
+const FrustumCullKernels& GetAVX512FrustumCullKernels()
+{
+	static const FrustumCullKernels kernels = { &CullSpheres, &CullAABBs };
+	return kernels;
+}
+
+} // namespace DE
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#else
+
+namespace DE
+{
+
+const FrustumCullKernels& GetAVX512FrustumCullKernels()
+{
+	return GetBaselineFrustumCullKernels();
+}
+
+} // namespace DE
+
+#endif // DE_SIMD_X86
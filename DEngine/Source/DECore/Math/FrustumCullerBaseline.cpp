@@ -0,0 +1,114 @@
+// FrustumCullerBaseline.cpp: 4 lane kernels on the SIMD layer, SSE4.1, NEON or scalar as the build selects
+#include <DECore/DECore.h>
+#include "FrustumCullerKernel.h"
+
+namespace DE
+{
+
+namespace
+{
+
+using SIMD::Float4;
+
+/** @brief The planes splatted once per call, the absolute normals are for the box extents */
+struct SplatPlanes
+{
+	explicit SplatPlanes(const CullPlanes& planes)
+	{
+		for (uint32_t p = 0; p < 6; ++p)
+		{
+			nx[p] = SIMD::Splat(planes.nx[p]);
+			ny[p] = SIMD::Splat(planes.ny[p]);
+			nz[p] = SIMD::Splat(planes.nz[p]);
+			d[p] = SIMD::Splat(planes.d[p]);
+			ax[p] = SIMD::Abs(nx[p]);
+			ay[p] = SIMD::Abs(ny[p]);
+			az[p] = SIMD::Abs(nz[p]);
+		}
+	}
+
+	Float4		nx[6], ny[6], nz[6], d[6];
+	Float4		ax[6], ay[6], az[6];
+};
+
+/** @brief	Append the indices of the set bits of mask, without a branch per lane. Objects
+*		with NaN bounds compare as not outside and stay visible, as in every kernel
+*/
+inline uint32_t Compact(uint32_t mask, uint32_t index, uint32_t* visible, uint32_t num)
+{
+	for (uint32_t l = 0; l < 4; ++l)
+	{
+		visible[num] = index + l;
+		num += (mask >> l) & 1;
+	}
+	return num;
+}
+
+uint32_t CullSpheres(const CullPlanes& planes, const Float3Stream& centers, const float* radii, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	const SplatPlanes s(planes);
+	const Float4 zero = SIMD::Zero();
+
+	uint32_t num = 0;
+	uint32_t i = begin;
+	for (; i + 4 <= end; i += 4)
+	{
+		const Float4 x = SIMD::LoadU(centers.x + i);
+		const Float4 y = SIMD::LoadU(centers.y + i);
+		const Float4 z = SIMD::LoadU(centers.z + i);
+		const Float4 r = SIMD::LoadU(radii + i);
+		// the nearest signed distance of the sphere surface to any plane
+		Float4 distance = SIMD::MulAdd(z, s.nz[0], SIMD::MulAdd(y, s.ny[0], SIMD::MulAdd(x, s.nx[0], s.d[0])));
+		for (uint32_t p = 1; p < 6; ++p)
+		{
+			distance = SIMD::Min(distance, SIMD::MulAdd(z, s.nz[p], SIMD::MulAdd(y, s.ny[p], SIMD::MulAdd(x, s.nx[p], s.d[p]))));
+		}
+		const uint32_t outside = SIMD::MoveMask(SIMD::CmpLT(SIMD::Add(distance, r), zero));
+		num = Compact(~outside, i, visible, num);
+	}
+	return FrustumCullScalar::CullSpheres(planes, centers, radii, i, end, visible, num);
+}
+
+uint32_t CullAABBs(const CullPlanes& planes, const Float3Stream& min, const Float3Stream& max, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	const SplatPlanes s(planes);
+	const Float4 zero = SIMD::Zero();
+	const Float4 half = SIMD::Splat(0.5f);
+	const Float4 infinity = SIMD::Splat(INFINITY);
+
+	uint32_t num = 0;
+	uint32_t i = begin;
+	for (; i + 4 <= end; i += 4)
+	{
+		const Float4 minX = SIMD::LoadU(min.x + i), maxX = SIMD::LoadU(max.x + i);
+		const Float4 minY = SIMD::LoadU(min.y + i), maxY = SIMD::LoadU(max.y + i);
+		const Float4 minZ = SIMD::LoadU(min.z + i), maxZ = SIMD::LoadU(max.z + i);
+		const Float4 cx = SIMD::Mul(SIMD::Add(minX, maxX), half);
+		const Float4 cy = SIMD::Mul(SIMD::Add(minY, maxY), half);
+		const Float4 cz = SIMD::Mul(SIMD::Add(minZ, maxZ), half);
+		const Float4 ex = SIMD::Mul(SIMD::Sub(maxX, minX), half);
+		const Float4 ey = SIMD::Mul(SIMD::Sub(maxY, minY), half);
+		const Float4 ez = SIMD::Mul(SIMD::Sub(maxZ, minZ), half);
+		// the distance of the corner furthest along the normal, center + |n| . extent
+		Float4 distance = infinity;
+		for (uint32_t p = 0; p < 6; ++p)
+		{
+			const Float4 center = SIMD::MulAdd(cz, s.nz[p], SIMD::MulAdd(cy, s.ny[p], SIMD::MulAdd(cx, s.nx[p], s.d[p])));
+			const Float4 extent = SIMD::MulAdd(ez, s.az[p], SIMD::MulAdd(ey, s.ay[p], SIMD::Mul(ex, s.ax[p])));
+			distance = SIMD::Min(distance, SIMD::Add(center, extent));
+		}
+		const uint32_t outside = SIMD::MoveMask(SIMD::CmpLT(distance, zero));
+		num = Compact(~outside, i, visible, num);
+	}
+	return FrustumCullScalar::CullAABBs(planes, min, max, i, end, visible, num);
+}
+
+} // namespace
+
+const FrustumCullKernels& GetBaselineFrustumCullKernels()
+{
+	static const FrustumCullKernels kernels = { &CullSpheres, &CullAABBs };
+	return kernels;
+}
+
+} // namespace DE
@@ -0,0 +1,81 @@
+// FrustumCullerKernel.h: kernel table shared by FrustumCuller.cpp and the per instruction set kernel files
+#pragma once
+
+// Engine
+#include <DECore/Math/FrustumCuller.h>
+// Cpp
+#include <math.h>
+#include <stdint.h>
+
+namespace DE
+{
+
+/** @brief	Test the objects [begin, end) against all planes. The index of every object that
+*		is not completely outside one plane is written to visible[0], visible[1], ... in
+*		increasing order, the number of them is returned. visible must hold end - begin indices
+*/
+struct FrustumCullKernels
+{
+	uint32_t (*CullSpheres)(const CullPlanes& planes, const Float3Stream& centers, const float* radii, uint32_t begin, uint32_t end, uint32_t* visible);
+	uint32_t (*CullAABBs)(const CullPlanes& planes, const Float3Stream& min, const Float3Stream& max, uint32_t begin, uint32_t end, uint32_t* visible);
+};
+
+const FrustumCullKernels& GetBaselineFrustumCullKernels();
+// x86 only, the baseline kernels elsewhere
+const FrustumCullKernels& GetAVX2FrustumCullKernels();
+const FrustumCullKernels& GetAVX512FrustumCullKernels();
+
+// internal linkage, each kernel file compiled for its own instruction set keeps its own copy,
+// the linker must not pick an AVX2 one for the baseline kernels
+namespace
+{
+
+/** @brief Scalar kernels for the objects left after the last full register, appends to visible[num] */
+struct FrustumCullScalar
+{
+	static uint32_t CullSpheres(const CullPlanes& planes, const Float3Stream& centers, const float* radii, uint32_t begin, uint32_t end, uint32_t* visible, uint32_t num)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			// the nearest signed distance of the center to any plane, in the order of the vector kernels
+			float distance = INFINITY;
+			for (uint32_t p = 0; p < 6; ++p)
+			{
+				const float d = centers.z[i] * planes.nz[p] + (centers.y[i] * planes.ny[p] + (centers.x[i] * planes.nx[p] + planes.d[p]));
+				distance = d < distance ? d : distance;
+			}
+			visible[num] = i;
+			num += !(distance + radii[i] < 0.0f);
+		}
+		return num;
+	}
+
+	static uint32_t CullAABBs(const CullPlanes& planes, const Float3Stream& min, const Float3Stream& max, uint32_t begin, uint32_t end, uint32_t* visible, uint32_t num)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			// center and half extent, the corner furthest along the normal is center + |n| . extent
+			const float cx = (min.x[i] + max.x[i]) * 0.5f;
+			const float cy = (min.y[i] + max.y[i]) * 0.5f;
+			const float cz = (min.z[i] + max.z[i]) * 0.5f;
+			const float ex = (max.x[i] - min.x[i]) * 0.5f;
+			const float ey = (max.y[i] - min.y[i]) * 0.5f;
+			const float ez = (max.z[i] - min.z[i]) * 0.5f;
+			float distance = INFINITY;
+			for (uint32_t p = 0; p < 6; ++p)
+			{
+				const float center = cz * planes.nz[p] + (cy * planes.ny[p] + (cx * planes.nx[p] + planes.d[p]));
+				const float extent = ez * fabsf(planes.nz[p]) + (ey * fabsf(planes.ny[p]) + ex * fabsf(planes.nx[p]));
+				const float d = center + extent;
+				distance = d < distance ? d : distance;
+			}
+			visible[num] = i;
+			num += !(distance < 0.0f);
+		}
+		return num;
+	}
+};
+
+} // namespace
+
+} // namespace DE
@@ -20,11 +20,24 @@ public:
 		m_vNormal.SetW(a.Dot(m_vNormal));
 	}
 
+	// Construct plane a * x + b * y + c * z + d = 0, the normal (a, b, c) points to the positive side
+	Plane(float a, float b, float c, float d)
+	{
+		const float invLength = 1.0f / sqrtf(a * a + b * b + c * c);
+		m_vNormal = Vector3(a * invLength, b * invLength, c * invLength, -d * invLength);
+	}
+
+	// Signed distance from the plane, positive on the side the normal points to
+	float Distance(const Vector3& point) const
+	{
+		return m_vNormal.Dot(point) - m_vNormal.GetW();
+	}
+
 	void Transform(Matrix4 transform)
 	{
 		Vector3 newPoint = m_vNormal * m_vNormal.GetW();
 		newPoint.Transform(transform);
-		m_vNormal.TransformAsVector(transform.Inverse().Transpose());
+		m_vNormal.TransformAsVector(transform.NormalMatrix());
 		m_vNormal.Normalize();
 		m_vNormal.SetW(newPoint.Dot(m_vNormal));
 	}
@@ -0,0 +1,559 @@
+// SIMD.h: thin vector layer over SSE4.1, AVX2, NEON or scalar code, the math library is written on top of it
+#pragma once
+
+// Cpp
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// Backend, chosen at compile time. Define DE_SIMD_FORCE_SCALAR to build the scalar fallback on any target.
+// The NEON branches have not been through a compiler yet, ARM64 builds the scalar fallback unless
+// DE_SIMD_ENABLE_NEON is defined. Turn it on by default once clang --target=aarch64-linux-gnu -fsyntax-only
+// passes over simdmath.cpp, BatchTransformBaseline.cpp and FrustumCullerBaseline.cpp
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DE_SIMD_X86 1
+#else
+#define DE_SIMD_X86 0
+#endif
+
+#if defined(DE_SIMD_FORCE_SCALAR)
+#define DE_SIMD_SSE 0
+#define DE_SIMD_NEON 0
+#elif DE_SIMD_X86 && (defined(_MSC_VER) || defined(__SSE4_1__))
+#define DE_SIMD_SSE 1
+#define DE_SIMD_NEON 0
+#elif (defined(__aarch64__) || defined(_M_ARM64)) && defined(DE_SIMD_ENABLE_NEON)
+#define DE_SIMD_SSE 0
+#define DE_SIMD_NEON 1
+#else
+#define DE_SIMD_SSE 0
+#define DE_SIMD_NEON 0
+#endif
+#define DE_SIMD_SCALAR (!DE_SIMD_SSE && !DE_SIMD_NEON)
+
+// FloatN is 8 lanes when the build targets AVX2 and FMA, MSVC /arch:AVX2 implies both
+#if DE_SIMD_SSE && defined(__AVX2__) && (defined(_MSC_VER) || defined(__FMA__))
+#define DE_SIMD_AVX2 1
+#else
+#define DE_SIMD_AVX2 0
+#endif
+
+#if DE_SIMD_SSE
+#include <smmintrin.h>
+#if DE_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#elif DE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace DE
+{
+
+/** @brief	Free functions over Float4, four floats in one register, and FloatN, the widest
+*		register of the build for loops over arrays. Lane 0 is x. Shuffle indices are
+*		given in result order, Shuffle<1, 2, 0, 3>(a) is (a.y, a.z, a.x, a.w)
+*/
+namespace SIMD
+{
+
+#if DE_SIMD_SSE
+using Float4 = __m128;
+#elif DE_SIMD_NEON
+using Float4 = float32x4_t;
+#else
+struct alignas(16) Float4
+{
+	float f[4];
+};
+#endif
+
+//-----------------------------------------------------------------------------
+// Float4
+//-----------------------------------------------------------------------------
+
+inline Float4 Set(float x, float y, float z, float w)
+{
+#if DE_SIMD_SSE
+	return _mm_setr_ps(x, y, z, w);
+#elif DE_SIMD_NEON
+	const float data[4] = { x, y, z, w };
+	return vld1q_f32(data);
+#else
+	return Float4{ { x, y, z, w } };
+#endif
+}
+
+inline Float4 Splat(float value)
+{
+#if DE_SIMD_SSE
+	return _mm_set1_ps(value);
+#elif DE_SIMD_NEON
+	return vdupq_n_f32(value);
+#else
+	return Float4{ { value, value, value, value } };
+#endif
+}
+
+inline Float4 Zero()
+{
+#if DE_SIMD_SSE
+	return _mm_setzero_ps();
+#elif DE_SIMD_NEON
+	return vdupq_n_f32(0.0f);
+#else
+	return Float4{ { 0.0f, 0.0f, 0.0f, 0.0f } };
+#endif
+}
+
+/** @brief Load 4 floats from a 16 byte aligned address */
+inline Float4 Load(const float* p)
+{
+#if DE_SIMD_SSE
+	return _mm_load_ps(p);
+#elif DE_SIMD_NEON
+	return vld1q_f32(p);
+#else
+	return Float4{ { p[0], p[1], p[2], p[3] } };
+#endif
+}
+
+/** @brief Load 4 floats from any address */
+inline Float4 LoadU(const float* p)
+{
+#if DE_SIMD_SSE
+	return _mm_loadu_ps(p);
+#elif DE_SIMD_NEON
+	return vld1q_f32(p);
+#else
+	return Float4{ { p[0], p[1], p[2], p[3] } };
+#endif
+}
+
+/** @brief Store 4 floats to a 16 byte aligned address */
+inline void Store(float* p, Float4 a)
+{
+#if DE_SIMD_SSE
+	_mm_store_ps(p, a);
+#elif DE_SIMD_NEON
+	vst1q_f32(p, a);
+#else
+	p[0] = a.f[0]; p[1] = a.f[1]; p[2] = a.f[2]; p[3] = a.f[3];
+#endif
+}
+
+/** @brief Store 4 floats to any address */
+inline void StoreU(float* p, Float4 a)
+{
+#if DE_SIMD_SSE
+	_mm_storeu_ps(p, a);
+#elif DE_SIMD_NEON
+	vst1q_f32(p, a);
+#else
+	p[0] = a.f[0]; p[1] = a.f[1]; p[2] = a.f[2]; p[3] = a.f[3];
+#endif
+}
+
+/** @brief Return lane i */
+template <int i>
+inline float Get(Float4 a)
+{
+#if DE_SIMD_SSE
+	return _mm_cvtss_f32(_mm_shuffle_ps(a, a, _MM_SHUFFLE(i, i, i, i)));
+#elif DE_SIMD_NEON
+	return vgetq_lane_f32(a, i);
+#else
+	return a.f[i];
+#endif
+}
+
+/** @brief Return a with lane i replaced by value */
+template <int i>
+inline Float4 Insert(Float4 a, float value)
+{
+#if DE_SIMD_SSE
+	return _mm_insert_ps(a, _mm_set_ss(value), i << 4);
+#elif DE_SIMD_NEON
+	return vsetq_lane_f32(value, a, i);
+#else
+	a.f[i] = value;
+	return a;
+#endif
+}
+
+/** @brief (a[X], a[Y], a[Z], a[W]) */
+template <int X, int Y, int Z, int W>
+inline Float4 Shuffle(Float4 a)
+{
+#if DE_SIMD_SSE
+	return _mm_shuffle_ps(a, a, _MM_SHUFFLE(W, Z, Y, X));
+#elif DE_SIMD_NEON && defined(__clang__)
+	return __builtin_shufflevector(a, a, X, Y, Z, W);
+#elif DE_SIMD_NEON && defined(__GNUC__)
+	return __builtin_shuffle(a, uint32x4_t{ X, Y, Z, W });
+#elif DE_SIMD_NEON
+	float32x4_t result = vdupq_n_f32(vgetq_lane_f32(a, X));
+	result = vsetq_lane_f32(vgetq_lane_f32(a, Y), result, 1);
+	result = vsetq_lane_f32(vgetq_lane_f32(a, Z), result, 2);
+	return vsetq_lane_f32(vgetq_lane_f32(a, W), result, 3);
+#else
+	return Float4{ { a.f[X], a.f[Y], a.f[Z], a.f[W] } };
+#endif
+}
+
+/** @brief (a[X], a[Y], b[Z], b[W]), as _mm_shuffle_ps */
+template <int X, int Y, int Z, int W>
+inline Float4 Shuffle(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+#elif DE_SIMD_NEON && defined(__clang__)
+	return __builtin_shufflevector(a, b, X, Y, Z + 4, W + 4);
+#elif DE_SIMD_NEON && defined(__GNUC__)
+	return __builtin_shuffle(a, b, uint32x4_t{ X, Y, Z + 4, W + 4 });
+#elif DE_SIMD_NEON
+	float32x4_t result = vdupq_n_f32(vgetq_lane_f32(a, X));
+	result = vsetq_lane_f32(vgetq_lane_f32(a, Y), result, 1);
+	result = vsetq_lane_f32(vgetq_lane_f32(b, Z), result, 2);
+	return vsetq_lane_f32(vgetq_lane_f32(b, W), result, 3);
+#else
+	return Float4{ { a.f[X], a.f[Y], b.f[Z], b.f[W] } };
+#endif
+}
+
+/** @brief Lane i in every lane */
+template <int i>
+inline Float4 Broadcast(Float4 a)
+{
+#if DE_SIMD_NEON
+	return vdupq_laneq_f32(a, i);
+#else
+	return Shuffle<i, i, i, i>(a);
+#endif
+}
+
+inline Float4 Add(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_add_ps(a, b);
+#elif DE_SIMD_NEON
+	return vaddq_f32(a, b);
+#else
+	return Float4{ { a.f[0] + b.f[0], a.f[1] + b.f[1], a.f[2] + b.f[2], a.f[3] + b.f[3] } };
+#endif
+}
+
+inline Float4 Sub(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_sub_ps(a, b);
+#elif DE_SIMD_NEON
+	return vsubq_f32(a, b);
+#else
+	return Float4{ { a.f[0] - b.f[0], a.f[1] - b.f[1], a.f[2] - b.f[2], a.f[3] - b.f[3] } };
+#endif
+}
+
+inline Float4 Mul(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_mul_ps(a, b);
+#elif DE_SIMD_NEON
+	return vmulq_f32(a, b);
+#else
+	return Float4{ { a.f[0] * b.f[0], a.f[1] * b.f[1], a.f[2] * b.f[2], a.f[3] * b.f[3] } };
+#endif
+}
+
+inline Float4 Div(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_div_ps(a, b);
+#elif DE_SIMD_NEON
+	return vdivq_f32(a, b);
+#else
+	return Float4{ { a.f[0] / b.f[0], a.f[1] / b.f[1], a.f[2] / b.f[2], a.f[3] / b.f[3] } };
+#endif
+}
+
+/** @brief a * b + c, fused when the target has FMA */
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c)
+{
+#if DE_SIMD_AVX2
+	return _mm_fmadd_ps(a, b, c);
+#elif DE_SIMD_SSE
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+#elif DE_SIMD_NEON
+	return vfmaq_f32(c, a, b);
+#else
+	return Add(Mul(a, b), c);
+#endif
+}
+
+inline Float4 Neg(Float4 a)
+{
+#if DE_SIMD_SSE
+	return _mm_xor_ps(a, _mm_set1_ps(-0.0f));
+#elif DE_SIMD_NEON
+	return vnegq_f32(a);
+#else
+	return Float4{ { -a.f[0], -a.f[1], -a.f[2], -a.f[3] } };
+#endif
+}
+
+inline Float4 Abs(Float4 a)
+{
+#if DE_SIMD_SSE
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+#elif DE_SIMD_NEON
+	return vabsq_f32(a);
+#else
+	return Float4{ { fabsf(a.f[0]), fabsf(a.f[1]), fabsf(a.f[2]), fabsf(a.f[3]) } };
+#endif
+}
+
+inline Float4 Min(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_min_ps(a, b);
+#elif DE_SIMD_NEON
+	return vminq_f32(a, b);
+#else
+	return Float4{ { fminf(a.f[0], b.f[0]), fminf(a.f[1], b.f[1]), fminf(a.f[2], b.f[2]), fminf(a.f[3], b.f[3]) } };
+#endif
+}
+
+inline Float4 Max(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_max_ps(a, b);
+#elif DE_SIMD_NEON
+	return vmaxq_f32(a, b);
+#else
+	return Float4{ { fmaxf(a.f[0], b.f[0]), fmaxf(a.f[1], b.f[1]), fmaxf(a.f[2], b.f[2]), fmaxf(a.f[3], b.f[3]) } };
+#endif
+}
+
+inline Float4 Sqrt(Float4 a)
+{
+#if DE_SIMD_SSE
+	return _mm_sqrt_ps(a);
+#elif DE_SIMD_NEON
+	return vsqrtq_f32(a);
+#else
+	return Float4{ { sqrtf(a.f[0]), sqrtf(a.f[1]), sqrtf(a.f[2]), sqrtf(a.f[3]) } };
+#endif
+}
+
+/** @brief Sum of the four lanes */
+inline float HorizontalAdd(Float4 a)
+{
+#if DE_SIMD_SSE
+	const __m128 pairs = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+#elif DE_SIMD_NEON
+	return vaddvq_f32(a);
+#else
+	return (a.f[0] + a.f[1]) + (a.f[2] + a.f[3]);
+#endif
+}
+
+/** @brief Dot product of the xyz in every lane */
+inline Float4 Dot3Splat(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_dp_ps(a, b, 0x7F);
+#else
+	return Splat(HorizontalAdd(Insert<3>(Mul(a, b), 0.0f)));
+#endif
+}
+
+/** @brief Dot product of all four lanes in every lane */
+inline Float4 Dot4Splat(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_dp_ps(a, b, 0xFF);
+#else
+	return Splat(HorizontalAdd(Mul(a, b)));
+#endif
+}
+
+inline float Dot3(Float4 a, Float4 b)
+{
+	return Get<0>(Dot3Splat(a, b));
+}
+
+inline float Dot4(Float4 a, Float4 b)
+{
+	return Get<0>(Dot4Splat(a, b));
+}
+
+/** @brief Cross product of the xyz, w is 0 */
+inline Float4 Cross3(Float4 a, Float4 b)
+{
+	const Float4 c = Sub(Mul(a, Shuffle<1, 2, 0, 3>(b)), Mul(Shuffle<1, 2, 0, 3>(a), b));
+	return Insert<3>(Shuffle<1, 2, 0, 3>(c), 0.0f);
+}
+
+/** @brief Transpose the 4x4 matrix held in four rows */
+inline void Transpose(Float4& r0, Float4& r1, Float4& r2, Float4& r3)
+{
+#if DE_SIMD_SSE
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+#else
+	const Float4 t0 = Shuffle<0, 1, 0, 1>(r0, r1);
+	const Float4 t1 = Shuffle<2, 3, 2, 3>(r0, r1);
+	const Float4 t2 = Shuffle<0, 1, 0, 1>(r2, r3);
+	const Float4 t3 = Shuffle<2, 3, 2, 3>(r2, r3);
+	r0 = Shuffle<0, 2, 0, 2>(t0, t2);
+	r1 = Shuffle<1, 3, 1, 3>(t0, t2);
+	r2 = Shuffle<0, 2, 0, 2>(t1, t3);
+	r3 = Shuffle<1, 3, 1, 3>(t1, t3);
+#endif
+}
+
+/** @brief All bits set in the lanes where a < b */
+inline Float4 CmpLT(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_cmplt_ps(a, b);
+#elif DE_SIMD_NEON
+	return vreinterpretq_f32_u32(vcltq_f32(a, b));
+#else
+	Float4 result;
+	for (int i = 0; i < 4; ++i)
+	{
+		const uint32_t bits = a.f[i] < b.f[i] ? 0xFFFFFFFFu : 0u;
+		memcpy(&result.f[i], &bits, sizeof(float));
+	}
+	return result;
+#endif
+}
+
+/** @brief All bits set in the lanes where a > b */
+inline Float4 CmpGT(Float4 a, Float4 b)
+{
+	return CmpLT(b, a);
+}
+
+inline Float4 And(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_and_ps(a, b);
+#elif DE_SIMD_NEON
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#else
+	Float4 result;
+	for (int i = 0; i < 4; ++i)
+	{
+		uint32_t bitsA, bitsB;
+		memcpy(&bitsA, &a.f[i], sizeof(float));
+		memcpy(&bitsB, &b.f[i], sizeof(float));
+		bitsA &= bitsB;
+		memcpy(&result.f[i], &bitsA, sizeof(float));
+	}
+	return result;
+#endif
+}
+
+inline Float4 Or(Float4 a, Float4 b)
+{
+#if DE_SIMD_SSE
+	return _mm_or_ps(a, b);
+#elif DE_SIMD_NEON
+	return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#else
+	Float4 result;
+	for (int i = 0; i < 4; ++i)
+	{
+		uint32_t bitsA, bitsB;
+		memcpy(&bitsA, &a.f[i], sizeof(float));
+		memcpy(&bitsB, &b.f[i], sizeof(float));
+		bitsA |= bitsB;
+		memcpy(&result.f[i], &bitsA, sizeof(float));
+	}
+	return result;
+#endif
+}
+
+/** @brief Lane by lane, b where mask is set and a elsewhere. Mask lanes are all or no bits */
+inline Float4 Select(Float4 a, Float4 b, Float4 mask)
+{
+#if DE_SIMD_SSE
+	return _mm_blendv_ps(a, b, mask);
+#elif DE_SIMD_NEON
+	return vbslq_f32(vreinterpretq_u32_f32(mask), b, a);
+#else
+	Float4 result;
+	for (int i = 0; i < 4; ++i)
+	{
+		uint32_t bits;
+		memcpy(&bits, &mask.f[i], sizeof(float));
+		result.f[i] = bits ? b.f[i] : a.f[i];
+	}
+	return result;
+#endif
+}
+
+/** @brief Bit i is the sign bit of lane i */
+inline uint32_t MoveMask(Float4 a)
+{
+#if DE_SIMD_SSE
+	return static_cast<uint32_t>(_mm_movemask_ps(a));
+#elif DE_SIMD_NEON
+	static const int32_t shifts[4] = { 0, 1, 2, 3 };
+	const uint32x4_t signs = vshrq_n_u32(vreinterpretq_u32_f32(a), 31);
+	return vaddvq_u32(vshlq_u32(signs, vld1q_s32(shifts)));
+#else
+	uint32_t result = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		result |= signbit(a.f[i]) ? 1u << i : 0u;
+	}
+	return result;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// FloatN, the widest register of the build. Loops over arrays step by SIMD_WIDTH
+// and use the Float4 operations above, which are overloaded for the 8 lane type
+//-----------------------------------------------------------------------------
+
+#if DE_SIMD_AVX2
+using FloatN = __m256;
+constexpr uint32_t SIMD_WIDTH = 8;
+#else
+using FloatN = Float4;
+constexpr uint32_t SIMD_WIDTH = 4;
+#endif
+
+#if DE_SIMD_AVX2
+inline FloatN SplatN(float value) { return _mm256_set1_ps(value); }
+inline FloatN LoadN(const float* p) { return _mm256_loadu_ps(p); }
+inline void StoreN(float* p, FloatN a) { _mm256_storeu_ps(p, a); }
+
+inline FloatN Add(FloatN a, FloatN b) { return _mm256_add_ps(a, b); }
+inline FloatN Sub(FloatN a, FloatN b) { return _mm256_sub_ps(a, b); }
+inline FloatN Mul(FloatN a, FloatN b) { return _mm256_mul_ps(a, b); }
+inline FloatN Div(FloatN a, FloatN b) { return _mm256_div_ps(a, b); }
+inline FloatN MulAdd(FloatN a, FloatN b, FloatN c) { return _mm256_fmadd_ps(a, b, c); }
+inline FloatN Neg(FloatN a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+inline FloatN Abs(FloatN a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+inline FloatN Min(FloatN a, FloatN b) { return _mm256_min_ps(a, b); }
+inline FloatN Max(FloatN a, FloatN b) { return _mm256_max_ps(a, b); }
+inline FloatN Sqrt(FloatN a) { return _mm256_sqrt_ps(a); }
+inline FloatN CmpLT(FloatN a, FloatN b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline FloatN CmpGT(FloatN a, FloatN b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline FloatN And(FloatN a, FloatN b) { return _mm256_and_ps(a, b); }
+inline FloatN Or(FloatN a, FloatN b) { return _mm256_or_ps(a, b); }
+inline FloatN Select(FloatN a, FloatN b, FloatN mask) { return _mm256_blendv_ps(a, b, mask); }
+inline uint32_t MoveMask(FloatN a) { return static_cast<uint32_t>(_mm256_movemask_ps(a)); }
+#else
+inline FloatN SplatN(float value) { return Splat(value); }
+inline FloatN LoadN(const float* p) { return LoadU(p); }
+inline void StoreN(float* p, FloatN a) { StoreU(p, a); }
+#endif
+
+} // namespace SIMD
+
+} // namespace DE
@@ -6,7 +6,7 @@
 namespace DE
 {
 
-__declspec(align(16)) class SQT
+class alignas(16) SQT
 {
 public:
 	SQT() {};
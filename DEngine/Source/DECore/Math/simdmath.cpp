@@ -26,10 +26,10 @@ const SIMDVector3 SIMDVector3::NegativeUnitZ(0.0f, 0.0f, -1.0f);
 // Matrix4 methods
 void SIMDMatrix4::CreateTranslation(const SIMDVector3& translation)
 {
-	_rows[0] = _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
-	_rows[1] = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
-	_rows[2] = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
-	_rows[3] = _mm_setr_ps(translation.GetX(), translation.GetY(), translation.GetZ(), 1.0f);
+	_rows[0] = SIMD::Set(1.0f, 0.0f, 0.0f, 0.0f);
+	_rows[1] = SIMD::Set(0.0f, 1.0f, 0.0f, 0.0f);
+	_rows[2] = SIMD::Set(0.0f, 0.0f, 1.0f, 0.0f);
+	_rows[3] = SIMD::Set(translation.GetX(), translation.GetY(), translation.GetZ(), 1.0f);
 }
 SIMDMatrix4 SIMDMatrix4::Translation(const SIMDVector3 & translation)
 {
@@ -40,27 +40,27 @@ SIMDMatrix4 SIMDMatrix4::Translation(const SIMDVector3 & translation)
 
 void SIMDMatrix4::SetPosition(const SIMDVector3 & translation)
 {
-	_rows[3] = _mm_setr_ps(translation.GetX(), translation.GetY(), translation.GetZ(), 1.0f);
+	_rows[3] = SIMD::Set(translation.GetX(), translation.GetY(), translation.GetZ(), 1.0f);
 }
 
 SIMDVector3 SIMDMatrix4::GetPosition() const
 {
-	return SIMDVector3(_rows[3].m128_f32[0], _rows[3].m128_f32[1], _rows[3].m128_f32[2]);
+	return SIMDVector3(SIMD::Get<0>(_rows[3]), SIMD::Get<1>(_rows[3]), SIMD::Get<2>(_rows[3]));
 }
 
 SIMDVector3 SIMDMatrix4::GetRight() const
 {
-	return SIMDVector3(_rows[0].m128_f32[0], _rows[0].m128_f32[1], _rows[0].m128_f32[2]);
+	return SIMDVector3(SIMD::Get<0>(_rows[0]), SIMD::Get<1>(_rows[0]), SIMD::Get<2>(_rows[0]));
 }
 
 SIMDVector3 SIMDMatrix4::GetUp() const
 {
-	return SIMDVector3(_rows[1].m128_f32[0], _rows[1].m128_f32[1], _rows[1].m128_f32[2]);
+	return SIMDVector3(SIMD::Get<0>(_rows[1]), SIMD::Get<1>(_rows[1]), SIMD::Get<2>(_rows[1]));
 }
 
 SIMDVector3 SIMDMatrix4::GetForward() const
 {
-	return SIMDVector3(_rows[2].m128_f32[0], _rows[2].m128_f32[1], _rows[2].m128_f32[2]);
+	return SIMDVector3(SIMD::Get<0>(_rows[2]), SIMD::Get<1>(_rows[2]), SIMD::Get<2>(_rows[2]));
 }
 
 void SIMDMatrix4::CreateLookAt(const SIMDVector3& vEye, const SIMDVector3& vAt, const SIMDVector3& vUp)
@@ -69,10 +69,10 @@ void SIMDMatrix4::CreateLookAt(const SIMDVector3& vEye, const SIMDVector3& vAt,
 	SIMDVector3 xAxis = Cross(vUp, zAxis).Normalize();
 	SIMDVector3 yAxis = Cross(zAxis, xAxis);
 
-	_rows[0] = _mm_setr_ps(xAxis.GetX(), yAxis.GetX(), zAxis.GetX(), 0.0f);
-	_rows[1] = _mm_setr_ps(xAxis.GetY(), yAxis.GetY(), zAxis.GetY(), 0.0f);
-	_rows[2] = _mm_setr_ps(xAxis.GetZ(), yAxis.GetZ(), zAxis.GetZ(), 0.0f);
-	_rows[3] = _mm_setr_ps(-xAxis.Dot(vEye), -yAxis.Dot(vEye), -zAxis.Dot(vEye), 1.0f);
+	_rows[0] = SIMD::Set(xAxis.GetX(), yAxis.GetX(), zAxis.GetX(), 0.0f);
+	_rows[1] = SIMD::Set(xAxis.GetY(), yAxis.GetY(), zAxis.GetY(), 0.0f);
+	_rows[2] = SIMD::Set(xAxis.GetZ(), yAxis.GetZ(), zAxis.GetZ(), 0.0f);
+	_rows[3] = SIMD::Set(-xAxis.Dot(vEye), -yAxis.Dot(vEye), -zAxis.Dot(vEye), 1.0f);
 }
 
 SIMDMatrix4 SIMDMatrix4::LookAtMatrix(const SIMDVector3 & vEye, const SIMDVector3 & vAt, const SIMDVector3 & vUp)
@@ -87,10 +87,10 @@ void SIMDMatrix4::CreatePerspectiveFOV(float fFOVy, float fAspectRatio, float fN
 	float fYScale = tanf(PI / 2.0f - (fFOVy / 2)); // cot(x) is the same as tan(pi/2 - x)
 	float fXScale = fYScale / fAspectRatio;
 
-	_rows[0] = _mm_setr_ps(fXScale, 0.0f, 0.0f, 0.0f);
-	_rows[1] = _mm_setr_ps(0.0f, fYScale, 0.0f, 0.0f);
-	_rows[2] = _mm_setr_ps(0.0f, 0.0f, fFar / (fFar - fNear), 1.0f);
-	_rows[3] = _mm_setr_ps(0.0f, 0.0f, -fNear * fFar / (fFar - fNear), 0.0f);
+	_rows[0] = SIMD::Set(fXScale, 0.0f, 0.0f, 0.0f);
+	_rows[1] = SIMD::Set(0.0f, fYScale, 0.0f, 0.0f);
+	_rows[2] = SIMD::Set(0.0f, 0.0f, fFar / (fFar - fNear), 1.0f);
+	_rows[3] = SIMD::Set(0.0f, 0.0f, -fNear * fFar / (fFar - fNear), 0.0f);
 
 }
 
@@ -103,10 +103,10 @@ SIMDMatrix4 SIMDMatrix4::PerspectiveProjection(float fFOVy, float fAspectRatio,
 
 void SIMDMatrix4::CreateOrthographicProj(int32_t width, int32_t height, float zNear, float zFar)
 {
-	_rows[0] = _mm_setr_ps(2.0f / width, 0.0f, 0.0f, 0.0f);
-	_rows[1] = _mm_setr_ps(0.0f, 2.0f / height, 0.0f, 0.0f);
-	_rows[2] = _mm_setr_ps(0.0f, 0.0f, 1.0f / (zFar - zNear), 0.0f);
-	_rows[3] = _mm_setr_ps(0.0f, 0.0f, -zNear / (zFar - zNear), 1.0f);
+	_rows[0] = SIMD::Set(2.0f / width, 0.0f, 0.0f, 0.0f);
+	_rows[1] = SIMD::Set(0.0f, 2.0f / height, 0.0f, 0.0f);
+	_rows[2] = SIMD::Set(0.0f, 0.0f, 1.0f / (zFar - zNear), 0.0f);
+	_rows[3] = SIMD::Set(0.0f, 0.0f, -zNear / (zFar - zNear), 1.0f);
 }
 
 SIMDMatrix4 SIMDMatrix4::OrthographicProjection(int32_t width, int32_t height, float zNear, float zFar)
@@ -118,80 +118,79 @@ SIMDMatrix4 SIMDMatrix4::OrthographicProjection(int32_t width, int32_t height, f
 
 void SIMDMatrix4::Invert()
 {
-	__m128 minor0, minor1, minor2, minor3;
-	__m128 row0, row1, row2, row3;
-	__m128 det, tmp1;
+	SIMD::Float4 minor0, minor1, minor2, minor3;
+	SIMD::Float4 row0, row1, row2, row3;
+	SIMD::Float4 det, tmp1;
 
 	// tranpose and arrange as
-	row0 = _mm_setr_ps(_rows[0].m128_f32[0], _rows[1].m128_f32[0], _rows[2].m128_f32[0], _rows[3].m128_f32[0]); // 1 2 3 4
-	row1 = _mm_setr_ps(_rows[2].m128_f32[1], _rows[3].m128_f32[1], _rows[0].m128_f32[1], _rows[1].m128_f32[1]); // 7 8 5 6
-	row2 = _mm_setr_ps(_rows[0].m128_f32[2], _rows[1].m128_f32[2], _rows[2].m128_f32[2], _rows[3].m128_f32[2]); // 9 10 11 12
-	row3 = _mm_setr_ps(_rows[2].m128_f32[3], _rows[3].m128_f32[3], _rows[0].m128_f32[3], _rows[1].m128_f32[3]); // 15 16 13 14
+	row0 = _rows[0];
+	row1 = _rows[1];
+	row2 = _rows[2];
+	row3 = _rows[3];
+	SIMD::Transpose(row0, row1, row2, row3); // 1 2 3 4, 5 6 7 8, 9 10 11 12, 13 14 15 16
+	row1 = SIMD::Shuffle<2, 3, 0, 1>(row1); // 7 8 5 6
+	row3 = SIMD::Shuffle<2, 3, 0, 1>(row3); // 15 16 13 14
 
 	// calculate cofactor
-	tmp1 = _mm_mul_ps(row2, row3);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
-	minor0 = _mm_mul_ps(row1, tmp1); // add
-	minor1 = _mm_mul_ps(row0, tmp1);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
-	minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp1), minor0); // minus
-	minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor1);
-	minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+	tmp1 = SIMD::Mul(row2, row3);
+	tmp1 = SIMD::Shuffle<1, 0, 3, 2>(tmp1);
+	minor0 = SIMD::Mul(row1, tmp1); // add
+	minor1 = SIMD::Mul(row0, tmp1);
+	tmp1 = SIMD::Shuffle<2, 3, 0, 1>(tmp1);
+	minor0 = SIMD::Sub(SIMD::Mul(row1, tmp1), minor0); // minus
+	minor1 = SIMD::Sub(SIMD::Mul(row0, tmp1), minor1);
+	minor1 = SIMD::Shuffle<2, 3, 0, 1>(minor1);
 	
-	tmp1 = _mm_mul_ps(row1, row2);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
-	minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor0); // add
-	minor3 = _mm_mul_ps(row0, tmp1);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
-	minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp1)); // minus
-	minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor3);
-	minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+	tmp1 = SIMD::Mul(row1, row2);
+	tmp1 = SIMD::Shuffle<1, 0, 3, 2>(tmp1);
+	minor0 = SIMD::Add(SIMD::Mul(row3, tmp1), minor0); // add
+	minor3 = SIMD::Mul(row0, tmp1);
+	tmp1 = SIMD::Shuffle<2, 3, 0, 1>(tmp1);
+	minor0 = SIMD::Sub(minor0, SIMD::Mul(row3, tmp1)); // minus
+	minor3 = SIMD::Sub(SIMD::Mul(row0, tmp1), minor3);
+	minor3 = SIMD::Shuffle<2, 3, 0, 1>(minor3);
 	
-	tmp1 = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
-	row2 = _mm_shuffle_ps(row2, row2, 0x4E);
-	minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor0); // add
-	minor2 = _mm_mul_ps(row0, tmp1);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
-	minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp1)); // minus
-	minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor2);
-	minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+	tmp1 = SIMD::Mul(SIMD::Shuffle<2, 3, 0, 1>(row1), row3);
+	tmp1 = SIMD::Shuffle<1, 0, 3, 2>(tmp1);
+	row2 = SIMD::Shuffle<2, 3, 0, 1>(row2);
+	minor0 = SIMD::Add(SIMD::Mul(row2, tmp1), minor0); // add
+	minor2 = SIMD::Mul(row0, tmp1);
+	tmp1 = SIMD::Shuffle<2, 3, 0, 1>(tmp1);
+	minor0 = SIMD::Sub(minor0, SIMD::Mul(row2, tmp1)); // minus
+	minor2 = SIMD::Sub(SIMD::Mul(row0, tmp1), minor2);
+	minor2 = SIMD::Shuffle<2, 3, 0, 1>(minor2);
 	
-	tmp1 = _mm_mul_ps(row0, row1);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
-	minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor2);
-	minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp1), minor3);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
-	minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp1), minor2);
-	minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp1));
+	tmp1 = SIMD::Mul(row0, row1);
+	tmp1 = SIMD::Shuffle<1, 0, 3, 2>(tmp1);
+	minor2 = SIMD::Add(SIMD::Mul(row3, tmp1), minor2);
+	minor3 = SIMD::Sub(SIMD::Mul(row2, tmp1), minor3);
+	tmp1 = SIMD::Shuffle<2, 3, 0, 1>(tmp1);
+	minor2 = SIMD::Sub(SIMD::Mul(row3, tmp1), minor2);
+	minor3 = SIMD::Sub(minor3, SIMD::Mul(row2, tmp1));
 	
-	tmp1 = _mm_mul_ps(row0, row3);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
-	minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp1));
-	minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor2);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
-	minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor1);
-	minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp1));
+	tmp1 = SIMD::Mul(row0, row3);
+	tmp1 = SIMD::Shuffle<1, 0, 3, 2>(tmp1);
+	minor1 = SIMD::Sub(minor1, SIMD::Mul(row2, tmp1));
+	minor2 = SIMD::Add(SIMD::Mul(row1, tmp1), minor2);
+	tmp1 = SIMD::Shuffle<2, 3, 0, 1>(tmp1);
+	minor1 = SIMD::Add(SIMD::Mul(row2, tmp1), minor1);
+	minor2 = SIMD::Sub(minor2, SIMD::Mul(row1, tmp1));
 	
-	tmp1 = _mm_mul_ps(row0, row2);
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
-	minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor1);
-	minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp1));
-	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E); 
-	minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp1));
-	minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor3);
-
-	det = _mm_mul_ps(row0, minor0);
-	det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
-	det = _mm_add_ss(_mm_shuffle_ps(det, det, 0xB1), det);
-	tmp1 = _mm_rcp_ss(det);
-	det = _mm_sub_ss(_mm_add_ss(tmp1, tmp1), _mm_mul_ss(det, _mm_mul_ss(tmp1, tmp1)));
-	det = _mm_shuffle_ps(det, det, 0x00);
-
-	_rows[0] = _mm_mul_ps(det, minor0);
-	_rows[1] = _mm_mul_ps(det, minor1);
-	_rows[2] = _mm_mul_ps(det, minor2);
-	_rows[3] = _mm_mul_ps(det, minor3);
+	tmp1 = SIMD::Mul(row0, row2);
+	tmp1 = SIMD::Shuffle<1, 0, 3, 2>(tmp1);
+	minor1 = SIMD::Add(SIMD::Mul(row3, tmp1), minor1);
+	minor3 = SIMD::Sub(minor3, SIMD::Mul(row1, tmp1));
+	tmp1 = SIMD::Shuffle<2, 3, 0, 1>(tmp1); 
+	minor1 = SIMD::Sub(minor1, SIMD::Mul(row3, tmp1));
+	minor3 = SIMD::Add(SIMD::Mul(row1, tmp1), minor3);
+
+	// 1 / det in every lane
+	det = SIMD::Div(SIMD::Splat(1.0f), SIMD::Dot4Splat(row0, minor0));
+
+	_rows[0] = SIMD::Mul(det, minor0);
+	_rows[1] = SIMD::Mul(det, minor1);
+	_rows[2] = SIMD::Mul(det, minor2);
+	_rows[3] = SIMD::Mul(det, minor3);
 }
 
 SIMDMatrix4 SIMDMatrix4::Inverse() const
@@ -201,10 +200,62 @@ SIMDMatrix4 SIMDMatrix4::Inverse() const
 	return result;
 }
 
+// Inverse transpose of the upper 3x3 with rows a, b, c: (b x c, c x a, a x b) / det, w are 0
+static inline void InverseTranspose3x3(const SIMD::Float4 rows[4], SIMD::Float4 result[3])
+{
+	const SIMD::Float4 bc = SIMD::Cross3(rows[1], rows[2]);
+	const SIMD::Float4 ca = SIMD::Cross3(rows[2], rows[0]);
+	const SIMD::Float4 ab = SIMD::Cross3(rows[0], rows[1]);
+	const SIMD::Float4 invDet = SIMD::Div(SIMD::Splat(1.0f), SIMD::Dot3Splat(rows[0], bc));
+	result[0] = SIMD::Mul(bc, invDet);
+	result[1] = SIMD::Mul(ca, invDet);
+	result[2] = SIMD::Mul(ab, invDet);
+}
+
+// Translation row of the inverse given the inverse of the upper 3x3: (-t * inverse3x3, 1)
+static inline SIMD::Float4 InverseTranslation(SIMD::Float4 translation, const SIMD::Float4 inverse[3])
+{
+	SIMD::Float4 result = SIMD::Mul(SIMD::Broadcast<0>(translation), inverse[0]);
+	result = SIMD::MulAdd(SIMD::Broadcast<1>(translation), inverse[1], result);
+	result = SIMD::MulAdd(SIMD::Broadcast<2>(translation), inverse[2], result);
+	return SIMD::Insert<3>(SIMD::Neg(result), 1.0f);
+}
+
+SIMDMatrix4 SIMDMatrix4::InverseAffine() const
+{
+	SIMD::Float4 resultRows[4];
+	InverseTranspose3x3(_rows, resultRows);
+	resultRows[3] = SIMD::Zero();
+	SIMD::Transpose(resultRows[0], resultRows[1], resultRows[2], resultRows[3]);
+	resultRows[3] = InverseTranslation(_rows[3], resultRows);
+	return SIMDMatrix4(resultRows);
+}
+
+SIMDMatrix4 SIMDMatrix4::InverseRigid() const
+{
+	// the inverse of a rotation is its transpose
+	SIMD::Float4 resultRows[4];
+	resultRows[0] = SIMD::Insert<3>(_rows[0], 0.0f);
+	resultRows[1] = SIMD::Insert<3>(_rows[1], 0.0f);
+	resultRows[2] = SIMD::Insert<3>(_rows[2], 0.0f);
+	resultRows[3] = SIMD::Zero();
+	SIMD::Transpose(resultRows[0], resultRows[1], resultRows[2], resultRows[3]);
+	resultRows[3] = InverseTranslation(_rows[3], resultRows);
+	return SIMDMatrix4(resultRows);
+}
+
+SIMDMatrix4 SIMDMatrix4::NormalMatrix() const
+{
+	SIMD::Float4 resultRows[4];
+	InverseTranspose3x3(_rows, resultRows);
+	resultRows[3] = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
+	return SIMDMatrix4(resultRows);
+}
+
 SIMDMatrix4 SIMDMatrix4::Transpose()
 {
 	SIMDMatrix4 result = *this;
-	_MM_TRANSPOSE4_PS(result._rows[0], result._rows[1], result._rows[2], result._rows[3]);
+	SIMD::Transpose(result._rows[0], result._rows[1], result._rows[2], result._rows[3]);
 	return result;
 }
 
@@ -1,8 +1,7 @@
-// simdmath.h: Maths Libraray, defining vector, matrix and quaternion, with Intel SSE4.1 extensions and MSVC++
+// simdmath.h: Maths Libraray, defining vector, matrix and quaternion, on the SIMD layer of SIMD.h
 #pragma once
 
-#include <xmmintrin.h> // intrinics
-#include <smmintrin.h> // intrinics
+#include "SIMD.h" // SSE4.1, AVX2, NEON or scalar
 #include <math.h> // sin cos
 #include <limits>
 #include <stdint.h>
@@ -11,6 +10,9 @@ namespace DE
 {
 
 class SQT;
+class SIMDVector3;
+class AABB;
+class Sphere;
 
 constexpr float PI { 3.1415926535f };
 
@@ -18,7 +20,46 @@ constexpr float PI { 3.1415926535f };
 class alignas(16) SIMDMatrix4
 {
 private:
-	__m128 _rows[4];
+	SIMD::Float4 _rows[4];
+
+	// result = lhs * rhs, every result row is the rows of rhs weighted by the elements of one lhs row.
+	// result may be lhs or rhs
+	static inline void Multiply(const SIMD::Float4 lhs[4], const SIMD::Float4 rhs[4], SIMD::Float4 result[4])
+	{
+		const SIMD::Float4 rhs0 = rhs[0];
+		const SIMD::Float4 rhs1 = rhs[1];
+		const SIMD::Float4 rhs2 = rhs[2];
+		const SIMD::Float4 rhs3 = rhs[3];
+#if DE_SIMD_AVX2
+		// two rows per instruction, one in each 128 bit lane
+		const __m256 r0 = _mm256_set_m128(rhs0, rhs0);
+		const __m256 r1 = _mm256_set_m128(rhs1, rhs1);
+		const __m256 r2 = _mm256_set_m128(rhs2, rhs2);
+		const __m256 r3 = _mm256_set_m128(rhs3, rhs3);
+		const __m256 l01 = _mm256_set_m128(lhs[1], lhs[0]);
+		const __m256 l23 = _mm256_set_m128(lhs[3], lhs[2]);
+		__m256 result01 = _mm256_mul_ps(_mm256_permute_ps(l01, 0x00), r0);
+		__m256 result23 = _mm256_mul_ps(_mm256_permute_ps(l23, 0x00), r0);
+		result01 = _mm256_fmadd_ps(_mm256_permute_ps(l01, 0x55), r1, result01);
+		result23 = _mm256_fmadd_ps(_mm256_permute_ps(l23, 0x55), r1, result23);
+		result01 = _mm256_fmadd_ps(_mm256_permute_ps(l01, 0xAA), r2, result01);
+		result23 = _mm256_fmadd_ps(_mm256_permute_ps(l23, 0xAA), r2, result23);
+		result01 = _mm256_fmadd_ps(_mm256_permute_ps(l01, 0xFF), r3, result01);
+		result23 = _mm256_fmadd_ps(_mm256_permute_ps(l23, 0xFF), r3, result23);
+		result[0] = _mm256_castps256_ps128(result01);
+		result[1] = _mm256_extractf128_ps(result01, 1);
+		result[2] = _mm256_castps256_ps128(result23);
+		result[3] = _mm256_extractf128_ps(result23, 1);
+#else
+		for (int i = 0; i < 4; ++i)
+		{
+			const SIMD::Float4 row = lhs[i];
+			const SIMD::Float4 xy = SIMD::MulAdd(SIMD::Broadcast<1>(row), rhs1, SIMD::Mul(SIMD::Broadcast<0>(row), rhs0));
+			const SIMD::Float4 zw = SIMD::MulAdd(SIMD::Broadcast<3>(row), rhs3, SIMD::Mul(SIMD::Broadcast<2>(row), rhs2));
+			result[i] = SIMD::Add(xy, zw);
+		}
+#endif
+	}
 
 public:
 	friend class SIMDVector3;
@@ -35,23 +76,23 @@ public:
 	// Construct with given value
 	inline SIMDMatrix4(const float other[4][4])
 	{
-		_rows[0] = _mm_setr_ps(other[0][0], other[0][1], other[0][2], other[0][3]);
-		_rows[1] = _mm_setr_ps(other[1][0], other[1][1], other[1][2], other[1][3]);
-		_rows[2] = _mm_setr_ps(other[2][0], other[2][1], other[2][2], other[2][3]);
-		_rows[3] = _mm_setr_ps(other[3][0], other[3][1], other[3][2], other[3][3]);
+		_rows[0] = SIMD::Set(other[0][0], other[0][1], other[0][2], other[0][3]);
+		_rows[1] = SIMD::Set(other[1][0], other[1][1], other[1][2], other[1][3]);
+		_rows[2] = SIMD::Set(other[2][0], other[2][1], other[2][2], other[2][3]);
+		_rows[3] = SIMD::Set(other[3][0], other[3][1], other[3][2], other[3][3]);
 	}
 
 	// Construct with given value, assume input is row major matrix
 	inline SIMDMatrix4(const float other[16])
 	{
-		_rows[0] = _mm_setr_ps(other[0], other[4], other[8], other[12]);
-		_rows[1] = _mm_setr_ps(other[1], other[5], other[9], other[13]);
-		_rows[2] = _mm_setr_ps(other[2], other[6], other[10], other[14]);
-		_rows[3] = _mm_setr_ps(other[3], other[7], other[11], other[15]);
+		_rows[0] = SIMD::Set(other[0], other[4], other[8], other[12]);
+		_rows[1] = SIMD::Set(other[1], other[5], other[9], other[13]);
+		_rows[2] = SIMD::Set(other[2], other[6], other[10], other[14]);
+		_rows[3] = SIMD::Set(other[3], other[7], other[11], other[15]);
 	}
 
-	// Construct with given m128 data
-	inline SIMDMatrix4(const __m128 data[4])
+	// Construct with given rows
+	inline SIMDMatrix4(const SIMD::Float4 data[4])
 	{
 		_rows[0] = data[0];
 		_rows[1] = data[1];
@@ -81,29 +122,41 @@ public:
 	// Set data values
 	inline void Set(float other[4][4])
 	{
-		_rows[0] = _mm_setr_ps(other[0][0], other[0][1], other[0][2], other[0][3]);
-		_rows[1] = _mm_setr_ps(other[1][0], other[1][1], other[1][2], other[1][3]);
-		_rows[2] = _mm_setr_ps(other[2][0], other[2][1], other[2][2], other[2][3]);
-		_rows[3] = _mm_setr_ps(other[3][0], other[3][1], other[3][2], other[3][3]);
+		_rows[0] = SIMD::Set(other[0][0], other[0][1], other[0][2], other[0][3]);
+		_rows[1] = SIMD::Set(other[1][0], other[1][1], other[1][2], other[1][3]);
+		_rows[2] = SIMD::Set(other[2][0], other[2][1], other[2][2], other[2][3]);
+		_rows[3] = SIMD::Set(other[3][0], other[3][1], other[3][2], other[3][3]);
+	}
+
+	// Return raw float array, 16 floats in row major order
+	inline const float* Raw() const
+	{
+		return reinterpret_cast<const float*>(_rows);
+	}
+
+	// Return raw float array, 16 floats in row major order
+	inline float* Raw()
+	{
+		return reinterpret_cast<float*>(_rows);
 	}
 
 	// Add another matrix to the matrix, store the result back to this
 	inline void Add(SIMDMatrix4& other)
 	{
-		_rows[0] = _mm_add_ps(_rows[0], other._rows[0]);
-		_rows[1] = _mm_add_ps(_rows[1], other._rows[1]);
-		_rows[2] = _mm_add_ps(_rows[2], other._rows[2]);
-		_rows[3] = _mm_add_ps(_rows[3], other._rows[3]);
+		_rows[0] = SIMD::Add(_rows[0], other._rows[0]);
+		_rows[1] = SIMD::Add(_rows[1], other._rows[1]);
+		_rows[2] = SIMD::Add(_rows[2], other._rows[2]);
+		_rows[3] = SIMD::Add(_rows[3], other._rows[3]);
 	}
 
 	// Overload + operator
 	inline SIMDMatrix4 operator+(SIMDMatrix4& other)
 	{
 		SIMDMatrix4 result;
-		result._rows[0] = _mm_add_ps(_rows[0], other._rows[0]);
-		result._rows[1] = _mm_add_ps(_rows[1], other._rows[1]);
-		result._rows[2] = _mm_add_ps(_rows[2], other._rows[2]);
-		result._rows[3] = _mm_add_ps(_rows[3], other._rows[3]);
+		result._rows[0] = SIMD::Add(_rows[0], other._rows[0]);
+		result._rows[1] = SIMD::Add(_rows[1], other._rows[1]);
+		result._rows[2] = SIMD::Add(_rows[2], other._rows[2]);
+		result._rows[3] = SIMD::Add(_rows[3], other._rows[3]);
 
 		return result;
 	}
@@ -111,29 +164,29 @@ public:
 	// Overload += operator
 	inline void operator+=(SIMDMatrix4& other)
 	{
-		_rows[0] = _mm_add_ps(_rows[0], other._rows[0]);
-		_rows[1] = _mm_add_ps(_rows[1], other._rows[1]);
-		_rows[2] = _mm_add_ps(_rows[2], other._rows[2]);
-		_rows[3] = _mm_add_ps(_rows[3], other._rows[3]);
+		_rows[0] = SIMD::Add(_rows[0], other._rows[0]);
+		_rows[1] = SIMD::Add(_rows[1], other._rows[1]);
+		_rows[2] = SIMD::Add(_rows[2], other._rows[2]);
+		_rows[3] = SIMD::Add(_rows[3], other._rows[3]);
 	}
 
 	// Subtract the matrix by another matrix, store the result back to this
 	inline void Sub(SIMDMatrix4& other)
 	{
-		_rows[0] = _mm_sub_ps(_rows[0], other._rows[0]);
-		_rows[1] = _mm_sub_ps(_rows[1], other._rows[1]);
-		_rows[2] = _mm_sub_ps(_rows[2], other._rows[2]);
-		_rows[3] = _mm_sub_ps(_rows[3], other._rows[3]);
+		_rows[0] = SIMD::Sub(_rows[0], other._rows[0]);
+		_rows[1] = SIMD::Sub(_rows[1], other._rows[1]);
+		_rows[2] = SIMD::Sub(_rows[2], other._rows[2]);
+		_rows[3] = SIMD::Sub(_rows[3], other._rows[3]);
 	}
 
 	// Overload - operator
 	inline SIMDMatrix4 operator-(SIMDMatrix4& other)
 	{
 		SIMDMatrix4 result;
-		result._rows[0] = _mm_sub_ps(_rows[0], other._rows[0]);
-		result._rows[1] = _mm_sub_ps(_rows[1], other._rows[1]);
-		result._rows[2] = _mm_sub_ps(_rows[2], other._rows[2]);
-		result._rows[3] = _mm_sub_ps(_rows[3], other._rows[3]);
+		result._rows[0] = SIMD::Sub(_rows[0], other._rows[0]);
+		result._rows[1] = SIMD::Sub(_rows[1], other._rows[1]);
+		result._rows[2] = SIMD::Sub(_rows[2], other._rows[2]);
+		result._rows[3] = SIMD::Sub(_rows[3], other._rows[3]);
 
 		return result;
 	}
@@ -141,68 +194,33 @@ public:
 	// Overload -= operator
 	inline void operator-=(SIMDMatrix4& other)
 	{
-		_rows[0] = _mm_sub_ps(_rows[0], other._rows[0]);
-		_rows[1] = _mm_sub_ps(_rows[1], other._rows[1]);
-		_rows[2] = _mm_sub_ps(_rows[2], other._rows[2]);
-		_rows[3] = _mm_sub_ps(_rows[3], other._rows[3]);
+		_rows[0] = SIMD::Sub(_rows[0], other._rows[0]);
+		_rows[1] = SIMD::Sub(_rows[1], other._rows[1]);
+		_rows[2] = SIMD::Sub(_rows[2], other._rows[2]);
+		_rows[3] = SIMD::Sub(_rows[3], other._rows[3]);
 	}
 
 	// Overload * operator
 	inline SIMDMatrix4 operator*(const SIMDMatrix4& other) const
 	{
-		__m128 mat_rows0 = other._rows[0];
-		__m128 mat_rows1 = other._rows[1];
-		__m128 mat_rows2 = other._rows[2];
-		__m128 mat_rows3 = other._rows[3];
-		_MM_TRANSPOSE4_PS(mat_rows0, mat_rows1, mat_rows2, mat_rows3);
-
-		SIMDMatrix4 result;
-		for (int i = 0; i < 4; ++i)
-		{
-			__m128 x = _mm_dp_ps(mat_rows0, _rows[i], 0xF1);
-			__m128 y = _mm_dp_ps(mat_rows1, _rows[i], 0xF2);
-			__m128 z = _mm_dp_ps(mat_rows2, _rows[i], 0xF4);
-			__m128 w = _mm_dp_ps(mat_rows3, _rows[i], 0xF8);
-
-			result._rows[i] = _mm_add_ps(x, y);
-			result._rows[i] = _mm_add_ps(result._rows[i], z);
-			result._rows[i] = _mm_add_ps(result._rows[i], w);
-		}
-		return result;
+		SIMD::Float4 resultRows[4];
+		Multiply(_rows, other._rows, resultRows);
+		return SIMDMatrix4(resultRows);
 	}
 
 	// Overload *= operator
 	inline void operator*=(const SIMDMatrix4& other)
 	{
-		__m128 mat_rows0 = other._rows[0];
-		__m128 mat_rows1 = other._rows[1];
-		__m128 mat_rows2 = other._rows[2];
-		__m128 mat_rows3 = other._rows[3];
-		_MM_TRANSPOSE4_PS(mat_rows0, mat_rows1, mat_rows2, mat_rows3);
-
-		for (int i = 0; i < 4; ++i)
-		{
-			__m128 x = _mm_dp_ps(_rows[i], mat_rows0, 0xF1);
-			__m128 y = _mm_dp_ps(_rows[i], mat_rows1, 0xF2);
-			__m128 z = _mm_dp_ps(_rows[i], mat_rows2, 0xF4);
-			__m128 w = _mm_dp_ps(_rows[i], mat_rows3, 0xF8);
-
-			_rows[i] = _mm_add_ps(x, y);
-			_rows[i] = _mm_add_ps(_rows[i], z);
-			_rows[i] = _mm_add_ps(_rows[i], w);
-		}
+		Multiply(_rows, other._rows, _rows);
 	}
 
 	// Set a scale transformation given a uniform scale
 	inline void CreateScale(float scalar)
 	{
-		__m128 scale = _mm_set_ps1(scalar);
-
-		_rows[0] = _mm_insert_ps(_rows[0], scale, 0x0E);
-		_rows[1] = _mm_insert_ps(_rows[1], scale, 0x5D);
-		_rows[2] = _mm_insert_ps(_rows[2], scale, 0xAB);
-		_rows[3] = _mm_set_ps1(1.0f);
-		_rows[3] = _mm_insert_ps(_rows[3], _rows[3], 0x07);
+		_rows[0] = SIMD::Set(scalar, 0.0f, 0.0f, 0.0f);
+		_rows[1] = SIMD::Set(0.0f, scalar, 0.0f, 0.0f);
+		_rows[2] = SIMD::Set(0.0f, 0.0f, scalar, 0.0f);
+		_rows[3] = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
 	}
 	static SIMDMatrix4 Scale(float scalar)
 	{
@@ -213,45 +231,36 @@ public:
 
 	inline void CreateScaleX(float scalar)
 	{
-		__m128 scale = _mm_set_ps1(scalar);
-		__m128 identity = _mm_set_ps1(1.0f);
-
-		_rows[0] = _mm_insert_ps(_rows[0], scale, 0x0E);
-		_rows[1] = _mm_insert_ps(_rows[1], identity, 0x5D);
-		_rows[2] = _mm_insert_ps(_rows[2], identity, 0xAB);
-		_rows[3] = _mm_insert_ps(identity, identity, 0x07);
+		_rows[0] = SIMD::Set(scalar, 0.0f, 0.0f, 0.0f);
+		_rows[1] = SIMD::Set(0.0f, 1.0f, 0.0f, 0.0f);
+		_rows[2] = SIMD::Set(0.0f, 0.0f, 1.0f, 0.0f);
+		_rows[3] = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
 	}
 
 	inline void CreateScaleY(float scalar)
 	{
-		__m128 scale = _mm_set_ps1(scalar);
-		__m128 identity = _mm_set_ps1(1.0f);
-
-		_rows[0] = _mm_insert_ps(_rows[0], identity, 0x0E);
-		_rows[1] = _mm_insert_ps(_rows[1], scale, 0x5D);
-		_rows[2] = _mm_insert_ps(_rows[2], identity, 0xAB);
-		_rows[3] = _mm_insert_ps(_rows[3], identity, 0x07);
+		_rows[0] = SIMD::Set(1.0f, 0.0f, 0.0f, 0.0f);
+		_rows[1] = SIMD::Set(0.0f, scalar, 0.0f, 0.0f);
+		_rows[2] = SIMD::Set(0.0f, 0.0f, 1.0f, 0.0f);
+		_rows[3] = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
 	}
 
 	inline void CreateScaleZ(float scalar)
 	{
-		__m128 scale = _mm_set_ps1(scalar);
-		__m128 identity = _mm_set_ps1(1.0f);
-
-		_rows[0] = _mm_insert_ps(_rows[0], identity, 0x0E);
-		_rows[1] = _mm_insert_ps(_rows[1], identity, 0x5D);
-		_rows[2] = _mm_insert_ps(_rows[2], scale, 0xAB);
-		_rows[3] = _mm_insert_ps(_rows[3], identity, 0x07);
+		_rows[0] = SIMD::Set(1.0f, 0.0f, 0.0f, 0.0f);
+		_rows[1] = SIMD::Set(0.0f, 1.0f, 0.0f, 0.0f);
+		_rows[2] = SIMD::Set(0.0f, 0.0f, scalar, 0.0f);
+		_rows[3] = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
 	}
 
 	inline void ScaleXYZ(float scalar)
 	{
-		__m128 scaleX = _mm_setr_ps(scalar, 1.0f, 1.0f, 1.0f);
-		__m128 scaleY = _mm_setr_ps(1.0f, scalar, 1.0f, 1.0f);
-		__m128 scaleZ = _mm_setr_ps(1.0f, 1.0f, scalar, 1.0f);
-		_rows[0] = _mm_mul_ps(_rows[0], scaleX);
-		_rows[1] = _mm_mul_ps(_rows[1], scaleY);
-		_rows[2] = _mm_mul_ps(_rows[2], scaleZ);
+		SIMD::Float4 scaleX = SIMD::Set(scalar, 1.0f, 1.0f, 1.0f);
+		SIMD::Float4 scaleY = SIMD::Set(1.0f, scalar, 1.0f, 1.0f);
+		SIMD::Float4 scaleZ = SIMD::Set(1.0f, 1.0f, scalar, 1.0f);
+		_rows[0] = SIMD::Mul(_rows[0], scaleX);
+		_rows[1] = SIMD::Mul(_rows[1], scaleY);
+		_rows[2] = SIMD::Mul(_rows[2], scaleZ);
 	}
 
 	// Set a rotation transformation about the X axis given an angle in radian
@@ -260,12 +269,10 @@ public:
 		float cosTheta = cosf(radian);
 		float sinTheta = sinf(radian);
 
-		_rows[0] = _mm_set_ps1(1.0f);
-		_rows[0] = _mm_insert_ps(_rows[0], _rows[0], 0x0E);
-		_rows[1] = _mm_setr_ps(0.0f, cosTheta, sinTheta, 0.0f);
-		_rows[2] = _mm_setr_ps(0.0f, -sinTheta, cosTheta, 0.0f);
-		_rows[3] = _mm_set_ps1(1.0f);
-		_rows[3] = _mm_insert_ps(_rows[3], _rows[3], 0x07);
+		_rows[0] = SIMD::Set(1.0f, 0.0f, 0.0f, 0.0f);
+		_rows[1] = SIMD::Set(0.0f, cosTheta, sinTheta, 0.0f);
+		_rows[2] = SIMD::Set(0.0f, -sinTheta, cosTheta, 0.0f);
+		_rows[3] = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
 	}
 	static SIMDMatrix4 RotationX(float radian)
 	{
@@ -280,12 +287,10 @@ public:
 		float cosTheta = cosf(radian);
 		float sinTheta = sinf(radian);
 
-		_rows[0] = _mm_setr_ps(cosTheta, 0.0f, -sinTheta, 0.0f);
-		_rows[1] = _mm_set_ps1(1.0f);
-		_rows[1] = _mm_insert_ps(_rows[1], _rows[1], 0x0D);
-		_rows[2] = _mm_setr_ps(sinTheta, 0.0f, cosTheta, 0.0f);
-		_rows[3] = _mm_set_ps1(1.0f);
-		_rows[3] = _mm_insert_ps(_rows[3], _rows[3], 0x07);
+		_rows[0] = SIMD::Set(cosTheta, 0.0f, -sinTheta, 0.0f);
+		_rows[1] = SIMD::Set(0.0f, 1.0f, 0.0f, 0.0f);
+		_rows[2] = SIMD::Set(sinTheta, 0.0f, cosTheta, 0.0f);
+		_rows[3] = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
 	}
 	static SIMDMatrix4 RotationY(float radian)
 	{
@@ -300,30 +305,28 @@ public:
 		float cosTheta = cosf(radian);
 		float sinTheta = sinf(radian);
 
-		_rows[0] = _mm_setr_ps(cosTheta, sinTheta, 0.0f, 0.0f);
-		_rows[1] = _mm_setr_ps(-sinTheta, cosTheta, 0.0f, 0.0f);
-		_rows[2] = _mm_set_ps1(1.0f);
-		_rows[2] = _mm_insert_ps(_rows[2], _rows[2], 0x0B);
-		_rows[3] = _mm_set_ps1(1.0f);
-		_rows[3] = _mm_insert_ps(_rows[3], _rows[3], 0x07);
+		_rows[0] = SIMD::Set(cosTheta, sinTheta, 0.0f, 0.0f);
+		_rows[1] = SIMD::Set(-sinTheta, cosTheta, 0.0f, 0.0f);
+		_rows[2] = SIMD::Set(0.0f, 0.0f, 1.0f, 0.0f);
+		_rows[3] = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
 	}
 
 	// Interpolate between two matrices with float t, return the resultant matrix
 	// i.e. result = a * (1 - t) + b * t
 	inline friend SIMDMatrix4 Lerp(const SIMDMatrix4& a, const SIMDMatrix4& b, float t)
 	{
-		__m128 resultRows[4];
-		__m128 oneMinusT = _mm_set_ps1(1.0f - t);
-		__m128 oneT = _mm_set_ps1(t);
+		SIMD::Float4 resultRows[4];
+		SIMD::Float4 oneMinusT = SIMD::Splat(1.0f - t);
+		SIMD::Float4 oneT = SIMD::Splat(t);
 
-		resultRows[0] = _mm_mul_ps(a._rows[0], oneMinusT);
-		resultRows[0] = _mm_add_ps(resultRows[0], _mm_mul_ps(b._rows[0], oneT));
-		resultRows[1] = _mm_mul_ps(a._rows[1], oneMinusT);
-		resultRows[1] = _mm_add_ps(resultRows[1], _mm_mul_ps(b._rows[1], oneT));
-		resultRows[2] = _mm_mul_ps(a._rows[2], oneMinusT);
-		resultRows[2] = _mm_add_ps(resultRows[2], _mm_mul_ps(b._rows[2], oneT));
-		resultRows[3] = _mm_mul_ps(a._rows[3], oneMinusT);
-		resultRows[3] = _mm_add_ps(resultRows[3], _mm_mul_ps(b._rows[3], oneT));
+		resultRows[0] = SIMD::Mul(a._rows[0], oneMinusT);
+		resultRows[0] = SIMD::Add(resultRows[0], SIMD::Mul(b._rows[0], oneT));
+		resultRows[1] = SIMD::Mul(a._rows[1], oneMinusT);
+		resultRows[1] = SIMD::Add(resultRows[1], SIMD::Mul(b._rows[1], oneT));
+		resultRows[2] = SIMD::Mul(a._rows[2], oneMinusT);
+		resultRows[2] = SIMD::Add(resultRows[2], SIMD::Mul(b._rows[2], oneT));
+		resultRows[3] = SIMD::Mul(a._rows[3], oneMinusT);
+		resultRows[3] = SIMD::Add(resultRows[3], SIMD::Mul(b._rows[3], oneT));
 
 		return SIMDMatrix4(resultRows);
 	}
@@ -360,6 +363,15 @@ public:
 	void Invert();
 	SIMDMatrix4 Inverse() const;
 
+	// Return the inverse of an affine matrix, the last column must be (0, 0, 0, 1)
+	SIMDMatrix4 InverseAffine() const;
+
+	// Return the inverse of a rotation and translation without scale, transposes the rotation
+	SIMDMatrix4 InverseRigid() const;
+
+	// Return the inverse transpose of the upper 3x3, the matrix transforming normals under this one
+	SIMDMatrix4 NormalMatrix() const;
+
 	// Transpose the matrix
 	SIMDMatrix4 Transpose();
 };
@@ -368,16 +380,18 @@ public:
 class alignas(16) SIMDVector3
 {
 private:
-	__m128 _data;
-	// _data.m128_f32[0] = x
-	// _data.m128_f32[1] = y
-	// _data.m128_f32[2] = z
-	// _data.m128_f32[3] = w
+	SIMD::Float4 _data;
+	// lane 0 = x
+	// lane 1 = y
+	// lane 2 = z
+	// lane 3 = w
 	// right side at multiplication
 public:
 	friend class SIMDMatrix4;
 	friend class SIMDQuaternion;
 	friend class SQT;
+	friend class AABB;
+	friend class Sphere;
 
 	static const SIMDVector3 Zero;
 	static const SIMDVector3 UnitX;
@@ -390,17 +404,17 @@ public:
 	// Default Constructor
 	inline SIMDVector3() 
 	{
-		_data = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+		_data = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
 	};
 
 	// Construct with given float values
 	inline SIMDVector3(float x, float y, float z, float w = 1.0f)
 	{
-		_data = _mm_setr_ps(x, y, z, w);
+		_data = SIMD::Set(x, y, z, w);
 	};
 
-	// Construct with given m128 data
-	inline SIMDVector3(__m128 value)
+	// Construct with given SIMD data
+	inline SIMDVector3(SIMD::Float4 value)
 	{
 		_data = value;
 	}
@@ -421,137 +435,130 @@ public:
 	// Return raw float array
 	inline const float* Raw() const
 	{
-		return _data.m128_f32;
+		return reinterpret_cast<const float*>(&_data);
 	}
 
 	// Set data values
 	inline void Set(float x, float y, float z)
 	{
-		_data = _mm_setr_ps(x, y, z, 1.0f);
+		_data = SIMD::Set(x, y, z, 1.0f);
 	}
 
 	inline void SetX(float x)
 	{
-		__m128 temp = _mm_set_ss(x);
-		_data = _mm_insert_ps(_data, temp, 0x00);
+		_data = SIMD::Insert<0>(_data, x);
 	}
 
 	inline void SetY(float y)
 	{
-		__m128 temp = _mm_set_ss(y);
-		_data = _mm_insert_ps(_data, temp, 0x10);
+		_data = SIMD::Insert<1>(_data, y);
 	}
 
 	inline void SetZ(float z)
 	{
-		__m128 temp = _mm_set_ss(z);
-		_data = _mm_insert_ps(_data, temp, 0x20);
+		_data = SIMD::Insert<2>(_data, z);
 	}
 
 	inline void SetW(float w)
 	{
-		__m128 temp = _mm_set_ss(w);
-		_data = _mm_insert_ps(_data, temp, 0x30);
+		_data = SIMD::Insert<3>(_data, w);
 	}
 
 	inline float GetX() const
 	{
-		return _data.m128_f32[0];
+		return SIMD::Get<0>(_data);
 	}
 
 	inline float GetY() const
 	{
-		return _data.m128_f32[1];
+		return SIMD::Get<1>(_data);
 	}
 
 	inline float GetZ() const
 	{
-		return _data.m128_f32[2];
+		return SIMD::Get<2>(_data);
 	}
 
 	inline float GetW() const
 	{
-		return _data.m128_f32[3];
+		return SIMD::Get<3>(_data);
 	}
 
 	// Dot product, return a float
 	inline float Dot(const SIMDVector3& other) const
 	{
-		__m128 temp = _mm_dp_ps(_data, other._data, 0x78);
-		return temp.m128_f32[3];
+		return SIMD::Dot3(_data, other._data);
 	}
 
 	// Add two vector, store result back to this
 	inline void Add(const SIMDVector3& other)
 	{
-		_data = _mm_add_ps(_data, other._data);
+		_data = SIMD::Add(_data, other._data);
 	}
 
 	// Overload + operator
 	inline SIMDVector3 operator+(const SIMDVector3& other) const
 	{
 		SIMDVector3 result;
-		result._data = _mm_add_ps(_data, other._data);
+		result._data = SIMD::Add(_data, other._data);
 		return result;
 	}
 
 	// Overload += operator
 	inline void operator+=(const SIMDVector3& other)
 	{
-		_data = _mm_add_ps(_data, other._data);
+		_data = SIMD::Add(_data, other._data);
 	}
 
 	// Substract the other vector from this, store result back to this
 	inline void Substract(const SIMDVector3& other)
 	{
-		_data = _mm_sub_ps(_data, other._data);
+		_data = SIMD::Sub(_data, other._data);
 	}
 
 	// Overload - operator
 	inline SIMDVector3 operator-(const SIMDVector3& other) const
 	{
 		SIMDVector3 result;
-		result._data = _mm_sub_ps(_data, other._data);
+		result._data = SIMD::Sub(_data, other._data);
 		return result;
 	}
 
 	// Overload -= operator
 	inline void operator-=(const SIMDVector3& other)
 	{
-		_data = _mm_sub_ps(_data, other._data);
+		_data = SIMD::Sub(_data, other._data);
 	}
 
 	// Return negative
 	inline SIMDVector3 operator-()
 	{
 		SIMDVector3 result;
-		__m128 zero = _mm_set_ss(0.0f);
-		result._data = _mm_sub_ps(zero, _data);
+		result._data = SIMD::Neg(_data);
 		return result;
 	}
 
 	// Multiple the vector by a scalar, stire result back to this
 	inline void Multiply(float scalar)
 	{
-		__m128 temp = _mm_set_ps1(scalar);
-		_data = _mm_mul_ps(_data, temp);
+		_data = SIMD::Mul(_data, SIMD::Splat(scalar));
 	}
 
 	// Overload * operator
 	inline SIMDVector3 operator*(float scalar)
 	{
 		SIMDVector3 result;
-		__m128 slr = _mm_set_ps1(scalar);
-		result._data = _mm_mul_ps(_data, slr);
+		result._data = SIMD::Mul(_data, SIMD::Splat(scalar));
 		return result;
 	}
 
 	// Normalize the vector, store result back to this
 	inline SIMDVector3& Normalize()
 	{
-		__m128 length = _mm_dp_ps(_data, _data, 0x77);
-		length = _mm_div_ps(_mm_set_ps1(1.0f), _mm_sqrt_ps(length)); // more accurate than _mm_rsqrt_ps
-		_data = _mm_mul_ps(_data, length);
+		// w is kept
+		SIMD::Float4 length = SIMD::Dot3Splat(_data, _data);
+		length = SIMD::Div(SIMD::Splat(1.0f), SIMD::Sqrt(length)); // more accurate than a reciprocal square root estimate
+		_data = SIMD::Mul(_data, SIMD::Insert<3>(length, 1.0f));
 		return *this;
 	}
 
@@ -559,32 +566,30 @@ public:
 	inline SIMDVector3 Normal()
 	{
 		SIMDVector3 result;
-		__m128 length = _mm_dp_ps(_data, _data, 0x77);
-		length = _mm_div_ps(_mm_set_ps1(1.0f), _mm_sqrt_ps(length)); // more accurate than _mm_rsqrt_ps
-		result._data = _mm_mul_ps(_data, length);
+		SIMD::Float4 length = SIMD::Dot3Splat(_data, _data);
+		length = SIMD::Div(SIMD::Splat(1.0f), SIMD::Sqrt(length)); // more accurate than a reciprocal square root estimate
+		result._data = SIMD::Mul(_data, SIMD::Insert<3>(length, 1.0f));
 		return result;
 	}
 
 	inline SIMDVector3& NormalizeAll()
 	{
-		__m128 length = _mm_dp_ps(_data, _data, 0xFF);
-		length = _mm_div_ps(_mm_set_ps1(1.0f), _mm_sqrt_ps(length));
-		_data = _mm_mul_ps(_data, length);
+		SIMD::Float4 length = SIMD::Dot4Splat(_data, _data);
+		length = SIMD::Div(SIMD::Splat(1.0f), SIMD::Sqrt(length));
+		_data = SIMD::Mul(_data, length);
 		return *this;
 	}
 
 	// Return the square of the length of vector
 	inline float LengthSquared() const
 	{
-		__m128 length = _mm_dp_ps(_data, _data, 0x78);
-		return length.m128_f32[3];
+		return SIMD::Dot3(_data, _data);
 	}
 
 	// Return the length of vector
 	inline float Length() const
 	{
-		__m128 length = _mm_dp_ps(_data, _data, 0x78);
-		return sqrtf(length.m128_f32[3]);
+		return sqrtf(SIMD::Dot3(_data, _data));
 	}
 
 	inline bool iszero() const
@@ -603,22 +608,18 @@ public:
 	// Return the cross product as SIMDVector3 of two vectors
 	inline friend SIMDVector3 Cross(const SIMDVector3& a, const SIMDVector3& b)
 	{
-		SIMDVector3 result;
-		result._data = _mm_mul_ps(_mm_shuffle_ps(a._data, a._data, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(b._data, b._data, _MM_SHUFFLE(3, 1, 0, 2)));
-		__m128 temp = _mm_mul_ps(_mm_shuffle_ps(a._data, a._data, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(b._data, b._data, _MM_SHUFFLE(3, 0, 2, 1)));
-		result._data = _mm_sub_ps(result._data, temp);
-		return result;
+		return SIMDVector3(SIMD::Cross3(a._data, b._data));
 	}
 
 	// Interpolate between two vectors with float t, return the resultant vector
 	// i.e. result = a * (1 - t) + b * t
 	inline static SIMDVector3 Lerp(const SIMDVector3& a, const SIMDVector3& b, float t)
 	{
-		__m128 tempA = _mm_set_ps1(1.0f - t);
-		tempA = _mm_mul_ps(a._data, tempA);
-		__m128 tempB = _mm_set_ps1(t);
-		tempB = _mm_mul_ps(b._data, tempB);
-		__m128 result = _mm_add_ps(tempA, tempB);
+		SIMD::Float4 tempA = SIMD::Splat(1.0f - t);
+		tempA = SIMD::Mul(a._data, tempA);
+		SIMD::Float4 tempB = SIMD::Splat(t);
+		tempB = SIMD::Mul(b._data, tempB);
+		SIMD::Float4 result = SIMD::Add(tempA, tempB);
 		return SIMDVector3(result);
 	}
 
@@ -626,18 +627,18 @@ public:
 	// i.e. result = a * t1 + b * t2 + c * t3 + d * (1 - t1 -t2 - t3)
 	inline friend SIMDVector3 Blend(const SIMDVector3& a, const SIMDVector3& b, const SIMDVector3& c, const SIMDVector3& d, float t1, float t2, float t3)
 	{
-		__m128 tempA = _mm_set_ps1(t1);
-		tempA = _mm_mul_ps(a._data, tempA);
-		__m128 tempB = _mm_set_ps1(t2);
-		tempB = _mm_mul_ps(b._data, tempB);
-		__m128 tempC = _mm_set_ps1(t3);
-		tempC = _mm_mul_ps(c._data, tempC);
-		__m128 tempD = _mm_set_ps1(1.0f - t1 - t2 - t3);
-		tempD = _mm_mul_ps(d._data, tempD);
-
-		__m128 result = _mm_add_ps(tempA, tempB);
-		result = _mm_add_ps(result, tempC);
-		result = _mm_add_ps(result, tempD);
+		SIMD::Float4 tempA = SIMD::Splat(t1);
+		tempA = SIMD::Mul(a._data, tempA);
+		SIMD::Float4 tempB = SIMD::Splat(t2);
+		tempB = SIMD::Mul(b._data, tempB);
+		SIMD::Float4 tempC = SIMD::Splat(t3);
+		tempC = SIMD::Mul(c._data, tempC);
+		SIMD::Float4 tempD = SIMD::Splat(1.0f - t1 - t2 - t3);
+		tempD = SIMD::Mul(d._data, tempD);
+
+		SIMD::Float4 result = SIMD::Add(tempA, tempB);
+		result = SIMD::Add(result, tempC);
+		result = SIMD::Add(result, tempD);
 		return SIMDVector3(result);
 	}
 
@@ -645,42 +646,26 @@ public:
 	inline void Transform(const SIMDMatrix4& mat)
 	{
 		// set w to 1.0f
+		const SIMD::Float4 point = SIMD::Insert<3>(_data, 1.0f);
 
-		__m128 one = _mm_set_ss(1.0f);
-		_data = _mm_insert_ps(_data, one, 0x30);
+		// lane i is the dot product with row i, the weighted sum of the columns
+		SIMD::Float4 mat_cols0 = mat._rows[0];
+		SIMD::Float4 mat_cols1 = mat._rows[1];
+		SIMD::Float4 mat_cols2 = mat._rows[2];
+		SIMD::Float4 mat_cols3 = mat._rows[3];
+		SIMD::Transpose(mat_cols0, mat_cols1, mat_cols2, mat_cols3);
 
-		__m128 x = _mm_dp_ps(_data, mat._rows[0], 0xF1);
-		__m128 y = _mm_dp_ps(_data, mat._rows[1], 0xF2);
-		__m128 z = _mm_dp_ps(_data, mat._rows[2], 0xF4);
-		__m128 w = _mm_dp_ps(_data, mat._rows[3], 0xF8);
-
-		_data = _mm_insert_ps(_data, x, 0x00);
-		_data = _mm_insert_ps(_data, y, 0x50);
-		_data = _mm_insert_ps(_data, z, 0xA0);
-		_data = _mm_insert_ps(_data, w, 0xF0);
+		const SIMD::Float4 xy = SIMD::MulAdd(SIMD::Broadcast<1>(point), mat_cols1, SIMD::Mul(SIMD::Broadcast<0>(point), mat_cols0));
+		const SIMD::Float4 zw = SIMD::Add(SIMD::Mul(SIMD::Broadcast<2>(point), mat_cols2), mat_cols3);
+		_data = SIMD::Add(xy, zw);
 	}
 
 	// Transform the vector by a 4x4 Matrix, store result back to this
 	inline void TransformAsVector(const SIMDMatrix4& mat)
 	{
-		__m128 mat_rows0 = mat._rows[0];
-		__m128 mat_rows1 = mat._rows[1];
-		__m128 mat_rows2 = mat._rows[2];
-		__m128 mat_rows3 = mat._rows[3];
-		_MM_TRANSPOSE4_PS(mat_rows0, mat_rows1, mat_rows2, mat_rows3);
-
-		// Set w to 0.0f
-		_data = _mm_insert_ps(_data, _data, 0x08);
-
-		__m128 x = _mm_dp_ps(_data, mat_rows0, 0xF1);
-		__m128 y = _mm_dp_ps(_data, mat_rows1, 0xF2);
-		__m128 z = _mm_dp_ps(_data, mat_rows2, 0xF4);
-		__m128 w = _mm_dp_ps(_data, mat_rows3, 0xF8);
-
-		_data = _mm_insert_ps(_data, x, 0x00);
-		_data = _mm_insert_ps(_data, y, 0x50);
-		_data = _mm_insert_ps(_data, z, 0xA0);
-		_data = _mm_insert_ps(_data, w, 0xF0);
+		// w is 0.0f, the weighted sum of the first three rows
+		const SIMD::Float4 xy = SIMD::MulAdd(SIMD::Broadcast<1>(_data), mat._rows[1], SIMD::Mul(SIMD::Broadcast<0>(_data), mat._rows[0]));
+		_data = SIMD::MulAdd(SIMD::Broadcast<2>(_data), mat._rows[2], xy);
 	}
 
 	static float AngleBetween(const SIMDVector3& lhs, const SIMDVector3& rhs)
@@ -692,11 +677,11 @@ public:
 class alignas(16) SIMDQuaternion
 {
 private:
-	__m128 _data;
-	// _data.m128_f32[0] = x
-	// _data.m128_f32[1] = y
-	// _data.m128_f32[2] = z
-	// _data.m128_f32[3] = w
+	SIMD::Float4 _data;
+	// lane 0 = x
+	// lane 1 = y
+	// lane 2 = z
+	// lane 3 = w
 public:
 	friend class SIMDMatrix4;
 	friend class SIMDVector3;
@@ -709,17 +694,17 @@ public:
 	// Construct with given axis and angle in radian
 	SIMDQuaternion(SIMDVector3& axis, float radian)
 	{
-		__m128 sinTheta = _mm_set_ps1(sinf(radian / 2.0f));
-		__m128 cosTheta = _mm_set_ps1(cosf(radian / 2.0f));
+		SIMD::Float4 sinTheta = SIMD::Splat(sinf(radian / 2.0f));
+		float cosTheta = cosf(radian / 2.0f);
 		axis.Normalize();
-		_data = _mm_mul_ps(axis._data, sinTheta);
-		_data = _mm_insert_ps(_data, cosTheta, 0xF0);
+		_data = SIMD::Mul(axis._data, sinTheta);
+		_data = SIMD::Insert<3>(_data, cosTheta);
 	}
 
 	// Construct with direct data
 	SIMDQuaternion(float data[4])
 	{
-		_data = _mm_setr_ps(data[0], data[1], data[2], data[3]);
+		_data = SIMD::Set(data[0], data[1], data[2], data[3]);
 	}
 
 	// Copy constructor
@@ -737,85 +722,74 @@ public:
 
 	inline float GetX() const
 	{
-		return _data.m128_f32[0];
+		return SIMD::Get<0>(_data);
 	}
 
 	inline float GetY() const
 	{
-		return _data.m128_f32[1];
+		return SIMD::Get<1>(_data);
 	}
 
 	inline float GetZ() const
 	{
-		return _data.m128_f32[2];
+		return SIMD::Get<2>(_data);
 	}
 
 	inline float GetW() const
 	{
-		return _data.m128_f32[3];
+		return SIMD::Get<3>(_data);
 	}
 
 	// Return negative
 	inline SIMDQuaternion operator-() const
 	{
 		SIMDQuaternion result;
-		__m128 zero = _mm_set_ss(0.0f);
-		result._data = _mm_sub_ps(zero, _data);
+		result._data = SIMD::Neg(_data);
 		return result;
 	}
 
 	// Multiply this quaternion with another quaternion, store result back to this
+	// i.e. this = this * other
 	inline void Multiply(const SIMDQuaternion& other)
 	{
-		__m128 result;
-		__m128 q2X = _mm_shuffle_ps(other._data, other._data, _MM_SHUFFLE(0, 0, 0, 0));
-		__m128 q2Y = _mm_shuffle_ps(other._data, other._data, _MM_SHUFFLE(1, 1, 1, 1));
-		__m128 q2Z = _mm_shuffle_ps(other._data, other._data, _MM_SHUFFLE(2, 2, 2, 2));
-		__m128 q2W = _mm_shuffle_ps(other._data, other._data, _MM_SHUFFLE(3, 3, 3, 3));
-
-		q2X = _mm_mul_ps(q2X, _mm_shuffle_ps(_data, _data, _MM_SHUFFLE(0, 1, 2, 3)));
-		q2Y = _mm_mul_ps(q2X, _mm_shuffle_ps(_data, _data, _MM_SHUFFLE(1, 0, 3, 2)));
-		q2Z = _mm_mul_ps(q2X, _mm_shuffle_ps(_data, _data, _MM_SHUFFLE(2, 3, 0, 1)));
-		q2W = _mm_mul_ps(q2W, _data);
-
-		result = _mm_addsub_ps(_mm_shuffle_ps(q2W, q2W, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(q2X, q2X, _MM_SHUFFLE(2, 3, 0, 1)));
-		result = _mm_addsub_ps(_mm_shuffle_ps(result, result, _MM_SHUFFLE(2, 0, 3, 1)), _mm_shuffle_ps(q2Y, q2Y, _MM_SHUFFLE(3, 1, 2, 0)));
-		result = _mm_addsub_ps(_mm_shuffle_ps(result, result, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(q2Z, q2Z, _MM_SHUFFLE(2, 3, 1, 0)));
-		result = _mm_shuffle_ps(result, result, _MM_SHUFFLE(3, 2, 0, 1));
+		const SIMD::Float4 q2 = other._data;
+		SIMD::Float4 result = SIMD::Mul(SIMD::Broadcast<3>(_data), q2);
+		result = SIMD::MulAdd(SIMD::Broadcast<0>(_data), SIMD::Mul(SIMD::Shuffle<3, 2, 1, 0>(q2), SIMD::Set(1.0f, -1.0f, 1.0f, -1.0f)), result);
+		result = SIMD::MulAdd(SIMD::Broadcast<1>(_data), SIMD::Mul(SIMD::Shuffle<2, 3, 0, 1>(q2), SIMD::Set(1.0f, 1.0f, -1.0f, -1.0f)), result);
+		result = SIMD::MulAdd(SIMD::Broadcast<2>(_data), SIMD::Mul(SIMD::Shuffle<1, 0, 3, 2>(q2), SIMD::Set(-1.0f, 1.0f, 1.0f, -1.0f)), result);
 		_data = result;
 	}
 
 	/*SIMDQuaternion operator+(const SIMDQuaternion& other)
 	{
 		SIMDQuaternion result;
-		result._data = _mm_add_ps(_data, other._data);
+		result._data = SIMD::Add(_data, other._data);
 		return result;
 	}
 
 	void operator+=(const SIMDQuaternion& other)
 	{
-		_data = _mm_add_ps(_data, other._data);
+		_data = SIMD::Add(_data, other._data);
 	}*/
 
 	inline void Multiply(float scalar)
 	{
-		__m128 temp = _mm_set_ps1(scalar);
-		_data = _mm_mul_ps(_data, temp);
+		_data = SIMD::Mul(_data, SIMD::Splat(scalar));
 	}
 
 	SIMDMatrix4 GetRotationMatrix()
 	{
 		float x, y, z, w;
-		x = _data.m128_f32[0];
-		y = _data.m128_f32[1];
-		z = _data.m128_f32[2];
-		w = _data.m128_f32[3];
+		x = SIMD::Get<0>(_data);
+		y = SIMD::Get<1>(_data);
+		z = SIMD::Get<2>(_data);
+		w = SIMD::Get<3>(_data);
 
-		__m128 rows[4];
-		rows[0] = _mm_setr_ps(1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y), 0.0f);
-		rows[1] = _mm_setr_ps(2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x), 0.0f);
-		rows[2] = _mm_setr_ps(2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y), 0.0f);
-		rows[3] = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+		SIMD::Float4 rows[4];
+		rows[0] = SIMD::Set(1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y), 0.0f);
+		rows[1] = SIMD::Set(2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x), 0.0f);
+		rows[2] = SIMD::Set(2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y), 0.0f);
+		rows[3] = SIMD::Set(0.0f, 0.0f, 0.0f, 1.0f);
 
 		return SIMDMatrix4(rows);
 	}
@@ -823,26 +797,25 @@ public:
 	// Normalize the quaternion, store the result to this
 	inline void Normalize()
 	{
-		__m128 length = _mm_dp_ps(_data, _data, 0xFF);
-		length = _mm_div_ps(_mm_set_ps1(1.0f), _mm_sqrt_ps(length));
-		_data = _mm_mul_ps(_data, length);
+		SIMD::Float4 length = SIMD::Dot4Splat(_data, _data);
+		length = SIMD::Div(SIMD::Splat(1.0f), SIMD::Sqrt(length));
+		_data = SIMD::Mul(_data, length);
 	}
 
 	// Dot product, return a float
 	inline float Dot(const SIMDQuaternion& other) const
 	{
-		__m128 temp = _mm_dp_ps(_data, other._data, 0xFF);
-		return temp.m128_f32[3];
+		return SIMD::Dot4(_data, other._data);
 	}
 
 	// TODO: switch to utility function in namespace
 	static SIMDQuaternion Lerp(SIMDQuaternion a, SIMDQuaternion b, float t)
 	{
 		SIMDQuaternion result;
-		__m128 aFactor = _mm_set_ps1(1.0f - t);
-		__m128 bFactor = _mm_set_ps1(t);
-		result._data = _mm_mul_ps(aFactor, a._data);
-		result._data = _mm_add_ps(result._data, _mm_mul_ps(bFactor, b._data));
+		SIMD::Float4 aFactor = SIMD::Splat(1.0f - t);
+		SIMD::Float4 bFactor = SIMD::Splat(t);
+		result._data = SIMD::Mul(aFactor, a._data);
+		result._data = SIMD::Add(result._data, SIMD::Mul(bFactor, b._data));
 		return result;
 	}
 
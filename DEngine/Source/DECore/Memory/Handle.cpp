@@ -4,17 +4,30 @@
 namespace DE
 {
 
-Handle::Handle(size_t size)
+Handle::Handle(size_t size, MemoryTag tag)
     : m_counter(1)
 {
-    *this = MemoryManager::GetInstance()->Allocate(size);
+    *this = MemoryManager::GetInstance()->Allocate(size, tag);
 };
 
-void Handle::Set(size_t size)
+Handle::Handle(size_t size, size_t alignment, MemoryTag tag)
+    : m_counter(1)
+{
+    *this = MemoryManager::GetInstance()->Allocate(size, alignment, tag);
+};
+
+void Handle::Set(size_t size, MemoryTag tag)
+{
+    assert(m_counter == 0);
+    m_counter++;
+    *this = MemoryManager::GetInstance()->Allocate(size, tag);
+}
+
+void Handle::Set(size_t size, size_t alignment, MemoryTag tag)
 {
     assert(m_counter == 0);
     m_counter++;
-    *this = MemoryManager::GetInstance()->Allocate(size);
+    *this = MemoryManager::GetInstance()->Allocate(size, alignment, tag);
 }
 
 void* Handle::Raw() const
@@ -22,6 +35,11 @@ void* Handle::Raw() const
     return MemoryManager::GetInstance()->GetMemoryAddressFromHandle(*this);
 }
 
+void Handle::SetRelocationListener(RelocationCallback callback, void* pOwner) const
+{
+    MemoryManager::GetInstance()->SetRelocationListener(*this, callback, pOwner);
+}
+
 void Handle::Free()
 {
     if (m_counter == 1)
@@ -2,18 +2,24 @@
 #pragma once
 
 // Cpp
+#include <stddef.h>
 #include <stdint.h>
 // Engine
 #include <DECore/Macro/Macro.h>
+#include <DECore/Memory/MemoryTag.h>
 
 namespace DE
 {
 
+using RelocationCallback = void(*)(void* pOwner, void* pNewAddress);	// notified when the defragmenter moved a block
+
 /*
 *	STRUCT: Handle
 *	The 4 byte Handle replaces dynamically allocated memory by storing
 *	the pool index and block index, so by getting raw pointer
-*	of the Handle user can get the memory of the block
+*	of the Handle user can get the memory of the block. With
+*	DE_MEMORY_DEBUG the Handle is 8 bytes, it also keeps the
+*	generation of the block to catch use after free
 */
 struct DllExport Handle
 {
@@ -28,19 +34,35 @@ struct DllExport Handle
 	*	@ void
 	********************************************************************************/
 	Handle() 
-		: m_counter(0)
+		: m_poolIndex(0)
+		, m_blockIndex(0)
+		, m_counter(0)
 	{};
 
 	/********************************************************************************
 	*	--- Constructor:
-	*	Handle(size_t)
+	*	Handle(size_t, MemoryTag)
 	*	This constructor will construct an Handle referring to the memory of or
 	*	larger than the given size, typically use with sizeof(class)
 	*
 	*	--- Parameters:
 	*	@ size: size of the memory needed
+	*	@ tag: subsystem the memory is attributed to
+	********************************************************************************/
+	Handle(size_t size, MemoryTag tag = MemoryTag::General);
+
+	/********************************************************************************
+	*	--- Constructor:
+	*	Handle(size_t, size_t, MemoryTag)
+	*	This constructor will construct an Handle referring to aligned memory of or
+	*	larger than the given size, e.g. Handle(sizeof(T), alignof(T), tag)
+	*
+	*	--- Parameters:
+	*	@ size: size of the memory needed
+	*	@ alignment: power of two, up to MEMORY_PAGE_SIZE
+	*	@ tag: subsystem the memory is attributed to
 	********************************************************************************/
-	Handle(size_t size);
+	Handle(size_t size, size_t alignment, MemoryTag tag);
 
 	/********************************************************************************
 	*	--- Constructor:
@@ -60,17 +82,34 @@ struct DllExport Handle
 
 	/********************************************************************************
 	*	--- Function:
-	*	Set(size_t)
+	*	Set(size_t, MemoryTag)
 	*	This function will allocate memory of given size to this Handle, should only
 	*	be called from an invalid Handle (i.e. constructed with empty constructor)
 	*
 	*	--- Parameters:
 	*	@ size: size of the memory needed
+	*	@ tag: subsystem the memory is attributed to
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void Set(size_t size, MemoryTag tag = MemoryTag::General);
+
+	/********************************************************************************
+	*	--- Function:
+	*	Set(size_t, size_t, MemoryTag)
+	*	This function will allocate aligned memory of given size to this Handle,
+	*	should only be called from an invalid Handle
+	*
+	*	--- Parameters:
+	*	@ size: size of the memory needed
+	*	@ alignment: power of two, up to MEMORY_PAGE_SIZE
+	*	@ tag: subsystem the memory is attributed to
 	*
 	*	--- Return:
 	*	@ void
 	********************************************************************************/
-	void Set(size_t size);
+	void Set(size_t size, size_t alignment, MemoryTag tag = MemoryTag::General);
 
 	/********************************************************************************
 	*	--- Function:
@@ -117,9 +156,34 @@ struct DllExport Handle
 	********************************************************************************/
 	void Free();
 
+	/********************************************************************************
+	*	--- Function:
+	*	SetRelocationListener(RelocationCallback, void*)
+	*	This function will allow the defragmenter to move the memory of this Handle,
+	*	the callback is invoked with the new address so that cached raw pointer can
+	*	be refreshed. Memory without a listener is never moved
+	*
+	*	--- Parameters:
+	*	@ callback: function to be called after the memory is moved, nullptr to pin
+	*	@ pOwner: first argument passed to the callback
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void SetRelocationListener(RelocationCallback callback, void* pOwner) const;
+
 	uint32_t							m_poolIndex : 5;		// pool index occupying 5 bits
 	uint32_t							m_blockIndex : 16;		// block index occupying 16 bits
 	uint32_t							m_counter : 11;		// counter occupying 11 bits
+#if DE_MEMORY_DEBUG
+	uint32_t							m_generation = 0;	// generation of the block when allocated, checked against MemoryManager to catch stale use
+#endif
 };
 
+#if DE_MEMORY_DEBUG
+static_assert(sizeof(Handle) == 8, "Handle is 8 bytes with DE_MEMORY_DEBUG");
+#else
+static_assert(sizeof(Handle) == 4, "Handle is 4 bytes");
+#endif
+
 };
\ No newline at end of file
@@ -0,0 +1,220 @@
+// LargeObjectAllocator.cpp
+
+#include <DECore/DECore.h>
+#include "LargeObjectAllocator.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace DE
+{
+
+namespace
+{
+
+#if defined(_WIN32)
+// Large page allocation requires SeLockMemoryPrivilege to be enabled on the process token
+bool EnableLockMemoryPrivilege()
+{
+	HANDLE token;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+	{
+		return false;
+	}
+
+	TOKEN_PRIVILEGES privileges = {};
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+	bool result = LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+		&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL)
+		&& GetLastError() == ERROR_SUCCESS; // AdjustTokenPrivileges succeeds even if the privilege is not held
+	CloseHandle(token);
+	return result;
+}
+#endif
+
+}
+
+void LargeObjectAllocator::Init()
+{
+#if defined(_WIN32)
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	m_iPageSize = sysInfo.dwAllocationGranularity;
+	m_iHugePageSize = EnableLockMemoryPrivilege() ? GetLargePageMinimum() : 0;
+#else
+	m_iPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	m_iHugePageSize = 2 * 1024 * 1024; // explicit huge page is tried first, otherwise transparent huge page is advised
+#endif
+
+	for (uint32_t i = 0; i < LARGE_OBJECT_MAX_NUM; ++i)
+	{
+		m_Slots[i] = {};
+		m_pFreeSlots[i] = LARGE_OBJECT_MAX_NUM - 1 - i;
+	}
+	m_iFreeSlotNum = LARGE_OBJECT_MAX_NUM;
+	m_iCacheNum = 0;
+	m_iCacheSize = 0;
+}
+
+void LargeObjectAllocator::Destruct()
+{
+	for (uint32_t i = 0; i < LARGE_OBJECT_MAX_NUM; ++i)
+	{
+		if (m_Slots[i].pAddress)
+		{
+			Unmap(m_Slots[i]);
+			m_Slots[i] = {};
+		}
+	}
+	for (uint32_t i = 0; i < m_iCacheNum; ++i)
+	{
+		Unmap(m_Cache[i]);
+	}
+	m_iCacheNum = 0;
+	m_iCacheSize = 0;
+}
+
+uint32_t LargeObjectAllocator::Allocate(size_t size)
+{
+	if (m_iFreeSlotNum == 0)
+	{
+		assert(false && "no large object slot left");
+		return LARGE_OBJECT_MAX_NUM;
+	}
+
+	const size_t mappedSize = GetMappedSize(size);
+
+	// best fit from cache, but do not hand out region more than twice the size needed
+	uint32_t best = LARGE_OBJECT_CACHE_NUM;
+	for (uint32_t i = 0; i < m_iCacheNum; ++i)
+	{
+		if (m_Cache[i].iSize >= mappedSize && m_Cache[i].iSize <= mappedSize * 2
+			&& (best == LARGE_OBJECT_CACHE_NUM || m_Cache[i].iSize < m_Cache[best].iSize))
+		{
+			best = i;
+		}
+	}
+
+	Region region = {};
+	if (best != LARGE_OBJECT_CACHE_NUM)
+	{
+		region = m_Cache[best];
+		m_iCacheSize -= region.iSize;
+		for (uint32_t i = best + 1; i < m_iCacheNum; ++i)
+		{
+			m_Cache[i - 1] = m_Cache[i];
+		}
+		m_iCacheNum--;
+	}
+	else
+	{
+		region = Map(mappedSize);
+		if (!region.pAddress && m_iCacheNum > 0)
+		{
+			// give the cached region back to the OS and retry
+			for (uint32_t i = 0; i < m_iCacheNum; ++i)
+			{
+				Unmap(m_Cache[i]);
+			}
+			m_iCacheNum = 0;
+			m_iCacheSize = 0;
+			region = Map(mappedSize);
+		}
+	}
+
+	if (!region.pAddress)
+	{
+		assert(false && "large object mapping failed");
+		return LARGE_OBJECT_MAX_NUM;
+	}
+
+	uint32_t index = m_pFreeSlots[--m_iFreeSlotNum];
+	m_Slots[index] = region;
+	return index;
+}
+
+void LargeObjectAllocator::Free(uint32_t index)
+{
+	assert(index < LARGE_OBJECT_MAX_NUM && m_Slots[index].pAddress);
+
+	Region region = m_Slots[index];
+	m_Slots[index] = {};
+	m_pFreeSlots[m_iFreeSlotNum++] = index;
+
+	if (region.iSize > LARGE_OBJECT_CACHE_MAX_SIZE)
+	{
+		Unmap(region);
+		return;
+	}
+
+	// evict the oldest until the new region fits
+	while (m_iCacheNum == LARGE_OBJECT_CACHE_NUM || m_iCacheSize + region.iSize > LARGE_OBJECT_CACHE_MAX_SIZE)
+	{
+		Unmap(m_Cache[0]);
+		m_iCacheSize -= m_Cache[0].iSize;
+		for (uint32_t i = 1; i < m_iCacheNum; ++i)
+		{
+			m_Cache[i - 1] = m_Cache[i];
+		}
+		m_iCacheNum--;
+	}
+	m_Cache[m_iCacheNum++] = region;
+	m_iCacheSize += region.iSize;
+}
+
+LargeObjectAllocator::Region LargeObjectAllocator::Map(size_t size) const
+{
+	Region region = {};
+	region.iSize = size;
+	const bool tryHugePage = m_iHugePageSize != 0 && size % m_iHugePageSize == 0;
+
+#if defined(_WIN32)
+	if (tryHugePage)
+	{
+		region.pAddress = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		region.bHugePage = region.pAddress != nullptr;
+	}
+	if (!region.pAddress)
+	{
+		region.pAddress = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+#else
+	void* ptr = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+	if (tryHugePage)
+	{
+		ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		region.bHugePage = ptr != MAP_FAILED;
+	}
+#endif
+	if (ptr == MAP_FAILED)
+	{
+		ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if defined(MADV_HUGEPAGE)
+		if (ptr != MAP_FAILED && tryHugePage)
+		{
+			madvise(ptr, size, MADV_HUGEPAGE);
+		}
+#endif
+	}
+	region.pAddress = ptr == MAP_FAILED ? nullptr : ptr;
+#endif
+
+	return region;
+}
+
+void LargeObjectAllocator::Unmap(const Region& region) const
+{
+#if defined(_WIN32)
+	VirtualFree(region.pAddress, 0, MEM_RELEASE);
+#else
+	munmap(region.pAddress, region.iSize);
+#endif
+}
+
+};
@@ -0,0 +1,204 @@
+// LargeObjectAllocator.h: OS mapped allocation for memory larger than the biggest pool block
+#pragma once
+
+// C++ include
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace DE
+{
+
+constexpr uint32_t LARGE_OBJECT_MAX_NUM = 1024;							// maximum number of live large object
+constexpr uint32_t LARGE_OBJECT_CACHE_NUM = 4;							// maximum number of freed region kept for reuse
+constexpr size_t LARGE_OBJECT_CACHE_MAX_SIZE = 512ull * 1024 * 1024;	// maximum total size of freed region kept for reuse
+
+/*
+*	class: LargeObjectAllocator
+*	LargeObjectAllocator maps memory directly from the OS for
+*	request that does not fit in any memory pool. Huge/large pages
+*	are used when the system allows, and a small FIFO cache of
+*	recently freed region avoids remapping when similar size is
+*	requested again (e.g. staging buffer reloaded every level)
+*/
+class LargeObjectAllocator
+{
+public:
+
+	/********************************************************************************
+	*	--- Function:
+	*	Init()
+	*	This function will query the page size and try to enable huge page support
+	*
+	*	--- Parameters:
+	*	@ void
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void Init();
+
+	/********************************************************************************
+	*	--- Function:
+	*	Destruct()
+	*	This function will unmap all live and cached region
+	*
+	*	--- Parameters:
+	*	@ void
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void Destruct();
+
+	/********************************************************************************
+	*	--- Function:
+	*	Allocate(size_t)
+	*	This function will map a region of at least the given size, reusing a cached
+	*	region when one fits, and return the slot index referring to it
+	*
+	*	--- Parameters:
+	*	@ size: size of the memory requested
+	*
+	*	--- Return:
+	*	@ uint32_t: slot index, to be stored as block index in a Handle
+	********************************************************************************/
+	uint32_t Allocate(size_t size);
+
+	/********************************************************************************
+	*	--- Function:
+	*	GetMappedSize(size_t)
+	*	This function will return the size Allocate() maps for the given size, a
+	*	region reused from the cache may be larger
+	*
+	*	--- Parameters:
+	*	@ size: size of the memory requested
+	*
+	*	--- Return:
+	*	@ size_t: size rounded up to the page size in use
+	********************************************************************************/
+	size_t GetMappedSize(size_t size) const
+	{
+		const size_t granularity = (m_iHugePageSize != 0 && size >= m_iHugePageSize) ? m_iHugePageSize : m_iPageSize;
+		return (size + granularity - 1) / granularity * granularity;
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	Free(uint32_t)
+	*	This function will return the region to the cache, unmapping the oldest
+	*	cached region if the cache is full
+	*
+	*	--- Parameters:
+	*	@ index: slot index returned by Allocate()
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void Free(uint32_t index);
+
+	/********************************************************************************
+	*	--- Function:
+	*	GetAddress(uint32_t)
+	*	This function will return the start address of the region in given slot
+	*
+	*	--- Parameters:
+	*	@ index: slot index returned by Allocate()
+	*
+	*	--- Return:
+	*	@ void*: start address of the region
+	********************************************************************************/
+	void* GetAddress(uint32_t index) const
+	{
+		assert(index < LARGE_OBJECT_MAX_NUM && m_Slots[index].pAddress);
+		return m_Slots[index].pAddress;
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	GetSize(uint32_t)
+	*	This function will return the mapped size of the region in given slot
+	*
+	*	--- Parameters:
+	*	@ index: slot index returned by Allocate()
+	*
+	*	--- Return:
+	*	@ size_t: mapped size, always a multiple of the page size in use
+	********************************************************************************/
+	size_t GetSize(uint32_t index) const
+	{
+		assert(index < LARGE_OBJECT_MAX_NUM && m_Slots[index].pAddress);
+		return m_Slots[index].iSize;
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	Find(const void*)
+	*	This function will return the slot of the live region containing the address
+	*
+	*	--- Parameters:
+	*	@ address: address inside a region
+	*
+	*	--- Return:
+	*	@ uint32_t: slot index, LARGE_OBJECT_MAX_NUM if not found
+	********************************************************************************/
+	uint32_t Find(const void* address) const
+	{
+		for (uint32_t i = 0; i < LARGE_OBJECT_MAX_NUM; ++i)
+		{
+			const char* start = static_cast<const char*>(m_Slots[i].pAddress);
+			if (start && address >= start && address < start + m_Slots[i].iSize)
+			{
+				return i;
+			}
+		}
+		return LARGE_OBJECT_MAX_NUM;
+	}
+
+private:
+
+	struct Region
+	{
+		void*							pAddress;		// start of the mapped region
+		size_t							iSize;			// mapped size
+		bool							bHugePage;		// whether the region is backed by huge page
+	};
+
+	/********************************************************************************
+	*	--- Function:
+	*	Map(size_t)
+	*	This function will map a region from the OS, try huge page first and fall
+	*	back to normal page
+	*
+	*	--- Parameters:
+	*	@ size: size already rounded to page granularity
+	*
+	*	--- Return:
+	*	@ Region: the mapped region, with null address if failed
+	********************************************************************************/
+	Region Map(size_t size) const;
+
+	/********************************************************************************
+	*	--- Function:
+	*	Unmap(const Region&)
+	*	This function will return a region to the OS
+	*
+	*	--- Parameters:
+	*	@ region: the region returned by Map()
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void Unmap(const Region& region) const;
+
+	Region								m_Slots[LARGE_OBJECT_MAX_NUM];		// live region, indexed by slot
+	uint32_t							m_pFreeSlots[LARGE_OBJECT_MAX_NUM];	// free slot indices used as stack
+	uint32_t							m_iFreeSlotNum = 0;					// number of free slot
+	Region								m_Cache[LARGE_OBJECT_CACHE_NUM];	// freed region, oldest first
+	uint32_t							m_iCacheNum = 0;					// number of cached region
+	size_t								m_iCacheSize = 0;					// total size of cached region
+	size_t								m_iPageSize = 0;					// normal page granularity
+	size_t								m_iHugePageSize = 0;				// huge page size, 0 if not usable
+};
+
+};
@@ -3,70 +3,206 @@
 #include <DECore/DECore.h>
 #include "MemoryManager.h"
 
+// Cpp
+#include <fstream>
+#include <string>
+
 namespace DE
 {
 
 MemoryManager* MemoryManager::m_pInstance;
 
+namespace
+{
+thread_local MemoryTag s_CurrentTag = MemoryTag::General;
+thread_local bool s_bEvicting = false;	// eviction callback running on this thread
+thread_local uint32_t s_iTraceThread = UINT32_MAX;	// index of this thread in the trace, assigned on first event
+}
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag)
+	: m_PreviousTag(s_CurrentTag)
+{
+	s_CurrentTag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+	s_CurrentTag = m_PreviousTag;
+}
+
+MemoryTag MemoryTagScope::Current()
+{
+	return s_CurrentTag;
+}
+
 void MemoryManager::ConstructDefaultPool()
 {
-	uint32_t heapSize = 0;
+	size_t heapSize = MEMORY_PAGE_SIZE;
 
 	for (uint32_t i = 0; i < MEMORY_POOL_NUM; ++i)
 	{
-		heapSize += MEMORY_POOL_CONFIG[i][0] * MEMORY_POOL_CONFIG[i][1] + sizeof(uint32_t) * 4 + sizeof(uint32_t) * MEMORY_POOL_CONFIG[i][1];
+		heapSize += static_cast<size_t>(MEMORY_POOL_CONFIG[i][0]) * MEMORY_POOL_CONFIG[i][1] + MemoryPool::GetHeaderSize(MEMORY_POOL_CONFIG[i][1]);
 	}
 	m_pRawHeapStart = std::malloc(heapSize);
-	void* heapStart = alignedAddress(m_pRawHeapStart); // align the start of memory pool
+	void* heapStart = alignedAddress(m_pRawHeapStart, MEMORY_PAGE_SIZE); // page align the start of memory pool
 
 	for (uint32_t i = 0; i < MEMORY_POOL_NUM; ++i)
 	{
 		m_pPool[i] = MemoryPool::Construct(MEMORY_POOL_CONFIG[i][0], MEMORY_POOL_CONFIG[i][1], heapStart);
+		m_pRecords[i] = static_cast<AllocationRecord*>(std::malloc(sizeof(AllocationRecord) * MEMORY_POOL_CONFIG[i][1]));
+#if DE_MEMORY_DEBUG
+		for (uint32_t j = 0; j < MEMORY_POOL_CONFIG[i][1]; ++j)
+		{
+			m_pRecords[i][j].iGeneration = 0;
+			m_pRecords[i][j].bLive = false;
+		}
+#endif
+		m_PoolStatistics[i] = {};
+		m_PoolStatistics[i].iBlockSize = MEMORY_POOL_CONFIG[i][0];
+		m_PoolStatistics[i].iBlockNum = MEMORY_POOL_CONFIG[i][1];
+	}
+
+	m_LargeObjectAllocator.Init();
+	m_PoolStatistics[MEMORY_POOL_NUM] = {};
+	m_PoolStatistics[MEMORY_POOL_NUM].iBlockNum = LARGE_OBJECT_MAX_NUM;
+#if DE_MEMORY_DEBUG
+	for (auto& record : m_LargeObjectRecords)
+	{
+		record.iGeneration = 0;
+		record.bLive = false;
 	}
+#endif
+	for (auto& tagStatistics : m_TagStatistics)
+	{
+		tagStatistics = {};
+	}
+	m_StartTime = std::chrono::steady_clock::now();
 }
 
 void MemoryManager::Destruct()
 {
+	m_LargeObjectAllocator.Destruct();
+	for (uint32_t i = 0; i < MEMORY_POOL_NUM; ++i)
+	{
+		std::free(m_pRecords[i]);
+	}
 	std::free(m_pRawHeapStart);
 	*m_pPool = nullptr;
 	delete this;
 }
 
-Handle MemoryManager::Allocate(size_t size)
+Handle MemoryManager::Allocate(size_t size, MemoryTag tag)
 {
-	std::lock_guard<std::mutex> lock(m_mutex);
+	return Allocate(size, MEMORY_ALIGNMENT, tag);
+}
+
+Handle MemoryManager::Allocate(size_t size, size_t alignment, MemoryTag tag)
+{
+	return allocate(size, alignment, tag, false);
+}
 
+Handle MemoryManager::TryAllocate(size_t size, size_t alignment, MemoryTag tag)
+{
+	return allocate(size, alignment, tag, true);
+}
+
+Handle MemoryManager::allocate(size_t size, size_t alignment, MemoryTag tag, bool bMayDeny)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && alignment <= MEMORY_PAGE_SIZE);
+	alignment = alignment < MEMORY_ALIGNMENT ? MEMORY_ALIGNMENT : alignment;
+
+	const MemoryTag scopeTag = MemoryTagScope::Current();
+	if (scopeTag != MemoryTag::General)
+	{
+		tag = scopeTag;
+	}
+
+	// block is aligned to its size up to page size, front guard band is widened to keep the alignment
+	const size_t payloadOffset = MEMORY_GUARD_BAND_SIZE == 0 ? 0 : (alignment > MEMORY_GUARD_BAND_SIZE ? alignment : MEMORY_GUARD_BAND_SIZE);
+	const size_t blockNeeded = payloadOffset + size + MEMORY_GUARD_BAND_SIZE;
+	uint32_t poolIndex = MEMORY_POOL_NUM;
 	for (uint32_t i = 0; i < MEMORY_POOL_NUM; ++i)
 	{
-		if (size <= MEMORY_POOL_CONFIG[i][0])
+		if (blockNeeded <= MEMORY_POOL_CONFIG[i][0] && alignment <= MEMORY_POOL_CONFIG[i][0])
 		{
-			if (m_pPool[i]->m_iFreeBlockNum == 0)
-			{
-				assert(false && "no block left");
-			}
-			int index = m_pPool[i]->m_pFreeList[m_pPool[i]->m_iFreeBlockIndex];
-			m_pPool[i]->m_iFreeBlockNum--;
-			m_pPool[i]->m_iFreeBlockIndex++;
-			return Handle(i, index);
+			poolIndex = i;
+			break;
 		}
 	}
 
-	assert(false && "no block fits");
-	return NULL;
+	// the budget is checked in the bytes the tag is charged, the size class rather than the size requested
+	std::unique_lock<std::mutex> lock(m_mutex);
+	const size_t blockSize = poolIndex < MEMORY_POOL_NUM ? m_pPool[poolIndex]->m_iBlockSize : m_LargeObjectAllocator.GetMappedSize(blockNeeded);
+	if (!reserveBudget(tag, blockSize, lock, bMayDeny))
+	{
+		return Handle();
+	}
+
+	if (poolIndex < MEMORY_POOL_NUM)
+	{
+		if (m_pPool[poolIndex]->m_iFreeBlockNum == 0)
+		{
+			m_PoolStatistics[poolIndex].iFailedNum++;
+			assert(false && "no block left");
+			return Handle();
+		}
+		uint32_t index = m_pPool[poolIndex]->Allocate();
+		recordAllocation(poolIndex, m_pRecords[poolIndex][index], blockSize, size, tag);
+		Handle hle(poolIndex, index);
+#if DE_MEMORY_DEBUG
+		debugAllocate(hle, m_pRecords[poolIndex][index], static_cast<uint32_t>(payloadOffset));
+#endif
+		if (m_bTracing)
+		{
+			traceEvent(MemoryTraceOp::Allocate, hle, size, alignment, tag);
+		}
+		return hle;
+	}
+
+	uint32_t index = m_LargeObjectAllocator.Allocate(blockNeeded);
+	if (index == LARGE_OBJECT_MAX_NUM)
+	{
+		m_PoolStatistics[MEMORY_POOL_NUM].iFailedNum++;
+		return Handle();
+	}
+	recordAllocation(MEMORY_POOL_NUM, m_LargeObjectRecords[index], blockSize, size, tag);
+	Handle hle(LARGE_OBJECT_POOL_INDEX, index);
+#if DE_MEMORY_DEBUG
+	debugAllocate(hle, m_LargeObjectRecords[index], static_cast<uint32_t>(payloadOffset));
+#endif
+	if (m_bTracing)
+	{
+		traceEvent(MemoryTraceOp::Allocate, hle, size, alignment, tag);
+	}
+	return hle;
 }
 
 void MemoryManager::Free(Handle hle)
 {
-	memset(hle.Raw(), 0, m_pPool[hle.m_poolIndex]->m_iBlockSize);
-	int index = m_pPool[hle.m_poolIndex]->m_iFreeBlockIndex - 1;
-	m_pPool[hle.m_poolIndex]->m_iFreeBlockIndex--;
-	if (index == -1)
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_bTracing)
 	{
-		m_pPool[hle.m_poolIndex]->m_iFreeBlockIndex = MEMORY_POOL_CONFIG[hle.m_poolIndex][1] - 1;
-		index = MEMORY_POOL_CONFIG[hle.m_poolIndex][1] - 1;
+		const AllocationRecord& record = hle.m_poolIndex == LARGE_OBJECT_POOL_INDEX ? m_LargeObjectRecords[hle.m_blockIndex] : m_pRecords[hle.m_poolIndex][hle.m_blockIndex];
+		traceEvent(MemoryTraceOp::Free, hle, 0, 0, record.tag);
 	}
-	m_pPool[hle.m_poolIndex]->m_pFreeList[index] = hle.m_blockIndex;
-	m_pPool[hle.m_poolIndex]->m_iFreeBlockNum++;
+
+	if (hle.m_poolIndex == LARGE_OBJECT_POOL_INDEX)
+	{
+#if DE_MEMORY_DEBUG
+		debugFree(hle, m_LargeObjectRecords[hle.m_blockIndex], m_LargeObjectAllocator.GetSize(hle.m_blockIndex));
+#endif
+		recordFree(MEMORY_POOL_NUM, m_LargeObjectRecords[hle.m_blockIndex]);
+		m_LargeObjectAllocator.Free(hle.m_blockIndex);
+		return;
+	}
+
+	// the block is not cleared, memory from Allocate() is uninitialized just like malloc
+#if DE_MEMORY_DEBUG
+	debugFree(hle, m_pRecords[hle.m_poolIndex][hle.m_blockIndex], m_pPool[hle.m_poolIndex]->m_iBlockSize);
+#endif
+	recordFree(hle.m_poolIndex, m_pRecords[hle.m_poolIndex][hle.m_blockIndex]);
+	m_pPool[hle.m_poolIndex]->Free(hle.m_blockIndex);
 }
 
 void * MemoryManager::GetMemoryAddressFromHandle(Handle hle) const
@@ -75,18 +211,430 @@ void * MemoryManager::GetMemoryAddressFromHandle(Handle hle) const
 	{
 		return nullptr;
 	}
-	assert((((uint64_t)m_pPool[hle.m_poolIndex] + sizeof(uint32_t) * 4 + sizeof(uint32_t) * MEMORY_POOL_CONFIG[hle.m_poolIndex][1] + m_pPool[hle.m_poolIndex]->m_iBlockSize * hle.m_blockIndex)) % 16 == 0); // temp check
-	return (void*)((uint64_t)m_pPool[hle.m_poolIndex] + sizeof(uint32_t) * 4 + sizeof(uint32_t) * MEMORY_POOL_CONFIG[hle.m_poolIndex][1] + m_pPool[hle.m_poolIndex]->m_iBlockSize * hle.m_blockIndex);
+#if DE_MEMORY_DEBUG
+	const AllocationRecord& record = hle.m_poolIndex == LARGE_OBJECT_POOL_INDEX ? m_LargeObjectRecords[hle.m_blockIndex] : m_pRecords[hle.m_poolIndex][hle.m_blockIndex];
+	assert(record.bLive && "use after free");
+	assert(record.iGeneration == hle.m_generation && "stale handle, the block is freed and reused");
+	return reinterpret_cast<char*>(blockAddress(hle.m_poolIndex, hle.m_blockIndex)) + record.iPayloadOffset;
+#else
+	return blockAddress(hle.m_poolIndex, hle.m_blockIndex);
+#endif
+}
+
+bool MemoryManager::reserveBudget(MemoryTag tag, size_t size, std::unique_lock<std::mutex>& lock, bool bMayDeny)
+{
+	const uint32_t tagIndex = static_cast<uint32_t>(tag);
+	const uint64_t projected = m_TagStatistics[tagIndex].iCurrentBytes + size;
+	if (m_TagBudgets[tagIndex].iBudgetBytes == 0 || projected <= m_TagBudgets[tagIndex].iWarningBytes)
+	{
+		return true;
+	}
+
+	EvictionListener listeners[MEMORY_EVICTION_CALLBACK_MAX_NUM];
+	uint32_t listenerNum = 0;
+	if (!s_bEvicting)
+	{
+		for (const auto& listener : m_EvictionListeners)
+		{
+			if (listener.pfnEvict && listener.tag == tag)
+			{
+				listeners[listenerNum++] = listener;
+			}
+		}
+	}
+
+	if (listenerNum > 0)
+	{
+		// callbacks run unlocked so that they can free
+		const uint64_t bytesToFree = projected - m_TagBudgets[tagIndex].iWarningBytes;
+		lock.unlock();
+		s_bEvicting = true;
+		for (uint32_t i = 0; i < listenerNum; ++i)
+		{
+			listeners[i].pfnEvict(tag, bytesToFree, listeners[i].pUserData);
+		}
+		s_bEvicting = false;
+		lock.lock();
+	}
+
+	if (m_TagStatistics[tagIndex].iCurrentBytes + size <= m_TagBudgets[tagIndex].iBudgetBytes)
+	{
+		return true;
+	}
+	if (!bMayDeny)
+	{
+		// the caller has no way to do without the memory, let it go above the budget
+		m_TagStatistics[tagIndex].iOverBudgetNum++;
+		return true;
+	}
+	m_TagStatistics[tagIndex].iDeniedNum++;
+	return false;
+}
+
+void* MemoryManager::blockAddress(uint32_t poolIndex, uint32_t blockIndex) const
+{
+	if (poolIndex == LARGE_OBJECT_POOL_INDEX)
+	{
+		return m_LargeObjectAllocator.GetAddress(blockIndex);
+	}
+	return m_pPool[poolIndex]->GetBlock(blockIndex);
+}
+
+Handle MemoryManager::GetHandleFromMemoryAddress(const void* ptr)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Handle hle;
+	for (uint32_t i = 0; i < MEMORY_POOL_NUM; ++i)
+	{
+		const uint32_t physical = m_pPool[i]->GetPhysicalIndex(ptr);
+		if (physical != m_pPool[i]->m_iBlockNum)
+		{
+			assert(m_pPool[i]->IsUsed(physical) && "address is not allocated");
+			hle = Handle(i, m_pPool[i]->GetLogicalIndex(physical));
+			break;
+		}
+	}
+	if (hle.m_counter == 0)
+	{
+		const uint32_t index = m_LargeObjectAllocator.Find(ptr);
+		if (index == LARGE_OBJECT_MAX_NUM)
+		{
+			return hle;
+		}
+		hle = Handle(LARGE_OBJECT_POOL_INDEX, index);
+	}
+
+#if DE_MEMORY_DEBUG
+	const AllocationRecord& record = hle.m_poolIndex == LARGE_OBJECT_POOL_INDEX ? m_LargeObjectRecords[hle.m_blockIndex] : m_pRecords[hle.m_poolIndex][hle.m_blockIndex];
+	hle.m_generation = record.iGeneration;
+	assert(ptr == reinterpret_cast<char*>(blockAddress(hle.m_poolIndex, hle.m_blockIndex)) + record.iPayloadOffset && "address is not the start of an allocation");
+#else
+	assert(ptr == blockAddress(hle.m_poolIndex, hle.m_blockIndex) && "address is not the start of an allocation");
+#endif
+	return hle;
+}
+
+void MemoryManager::SetRelocationListener(Handle hle, RelocationCallback callback, void* pOwner)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	AllocationRecord& record = hle.m_poolIndex == LARGE_OBJECT_POOL_INDEX ? m_LargeObjectRecords[hle.m_blockIndex] : m_pRecords[hle.m_poolIndex][hle.m_blockIndex];
+	record.pfnRelocate = callback;
+	record.pOwner = pOwner;
+}
+
+uint32_t MemoryManager::Defragment(float budgetMs)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<float, std::milli>(budgetMs);
+	uint32_t movedNum = 0;
+
+	for (uint32_t n = 0; n < MEMORY_POOL_NUM; ++n, m_iDefragPool = (m_iDefragPool + 1) % MEMORY_POOL_NUM)
+	{
+		MemoryPool* pool = m_pPool[m_iDefragPool];
+		uint32_t lowestFree = pool->GetLowestFree();
+		uint32_t physical = pool->GetHighestUsed();
+		if (physical == pool->m_iBlockNum)
+		{
+			continue;
+		}
+
+		// walk used blocks from the back, pinned block is skipped and stays where it is
+		for (; physical > lowestFree; --physical)
+		{
+			if (!pool->IsUsed(physical))
+			{
+				continue;
+			}
+			AllocationRecord& record = m_pRecords[m_iDefragPool][pool->GetLogicalIndex(physical)];
+			if (!record.pfnRelocate)
+			{
+				continue;
+			}
+
+			pool->Move(physical, lowestFree);
+#if DE_MEMORY_DEBUG
+			if (m_DebugConfig.bPoisonOnFree)
+			{
+				memset(pool->GetPhysicalBlock(physical), m_DebugConfig.iFreePattern, pool->m_iBlockSize < m_DebugConfig.iMaxPoisonSize ? pool->m_iBlockSize : m_DebugConfig.iMaxPoisonSize);
+			}
+#endif
+#if DE_MEMORY_DEBUG
+			record.pfnRelocate(record.pOwner, reinterpret_cast<char*>(pool->GetPhysicalBlock(lowestFree)) + record.iPayloadOffset);
+#else
+			record.pfnRelocate(record.pOwner, pool->GetPhysicalBlock(lowestFree));
+#endif
+			m_PoolStatistics[m_iDefragPool].iRelocatedNum++;
+			movedNum++;
+
+			if (std::chrono::steady_clock::now() >= deadline)
+			{
+				return movedNum; // resume this pool next time
+			}
+			lowestFree = pool->GetLowestFree();
+		}
+	}
+
+	return movedNum;
+}
+
+void MemoryManager::SetBudget(MemoryTag tag, uint64_t budgetBytes, float warningRatio)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	TagBudget& budget = m_TagBudgets[static_cast<uint32_t>(tag)];
+	budget.iBudgetBytes = budgetBytes;
+	budget.iWarningBytes = static_cast<uint64_t>(budgetBytes * static_cast<double>(warningRatio));
+}
+
+BudgetStatus MemoryManager::GetBudgetStatus(MemoryTag tag)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const TagBudget& budget = m_TagBudgets[static_cast<uint32_t>(tag)];
+	const TagStatistics& stat = m_TagStatistics[static_cast<uint32_t>(tag)];
+	BudgetStatus status;
+	status.iBudgetBytes = budget.iBudgetBytes;
+	status.iWarningBytes = budget.iWarningBytes;
+	status.iCurrentBytes = stat.iCurrentBytes;
+	status.iDeniedNum = stat.iDeniedNum;
+	status.iOverBudgetNum = stat.iOverBudgetNum;
+	status.fUsage = budget.iBudgetBytes > 0 ? static_cast<float>(static_cast<double>(stat.iCurrentBytes) / budget.iBudgetBytes) : 0.0f;
+	status.bWarning = budget.iBudgetBytes > 0 && stat.iCurrentBytes > budget.iWarningBytes;
+	return status;
+}
+
+uint32_t MemoryManager::RegisterEvictionCallback(MemoryTag tag, EvictionCallback callback, void* pUserData)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (uint32_t i = 0; i < MEMORY_EVICTION_CALLBACK_MAX_NUM; ++i)
+	{
+		if (!m_EvictionListeners[i].pfnEvict)
+		{
+			m_EvictionListeners[i] = { callback, pUserData, tag };
+			return i;
+		}
+	}
+	assert(false && "no eviction callback slot left");
+	return MEMORY_EVICTION_CALLBACK_MAX_NUM;
+}
+
+void MemoryManager::UnregisterEvictionCallback(uint32_t id)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	assert(id < MEMORY_EVICTION_CALLBACK_MAX_NUM);
+	m_EvictionListeners[id] = {};
+}
+
+bool MemoryManager::DumpStatistics(const char* path)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::ofstream fout(path, std::ofstream::out);
+	if (!fout)
+	{
+		return false;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count();
+	fout << "{\n";
+	fout << "\t\"uptimeSeconds\": " << seconds << ",\n";
+	fout << "\t\"pools\": [\n";
+	for (uint32_t i = 0; i <= MEMORY_POOL_NUM; ++i)
+	{
+		const PoolStatistics& stat = m_PoolStatistics[i];
+		const uint64_t heldBytes = stat.iRequestedBytes + stat.iWastedBytes;
+		fout << "\t\t{ ";
+		fout << "\"blockSize\": " << (i == MEMORY_POOL_NUM ? "\"large\"" : std::to_string(stat.iBlockSize)) << ", ";
+		fout << "\"blockNum\": " << stat.iBlockNum << ", ";
+		fout << "\"used\": " << stat.iUsedBlockNum << ", ";
+		fout << "\"peak\": " << stat.iPeakUsedBlockNum << ", ";
+		fout << "\"allocations\": " << stat.iAllocationNum << ", ";
+		fout << "\"frees\": " << stat.iFreeNum << ", ";
+		fout << "\"failed\": " << stat.iFailedNum << ", ";
+		fout << "\"relocated\": " << stat.iRelocatedNum << ", ";
+		fout << "\"allocationsPerSecond\": " << (seconds > 0.0 ? stat.iAllocationNum / seconds : 0.0) << ", ";
+		fout << "\"requestedBytes\": " << stat.iRequestedBytes << ", ";
+		fout << "\"wastedBytes\": " << stat.iWastedBytes << ", ";
+		fout << "\"peakWastedBytes\": " << stat.iPeakWastedBytes << ", ";
+		fout << "\"utilization\": " << (heldBytes > 0 ? static_cast<double>(stat.iRequestedBytes) / heldBytes : 1.0);
+		fout << (i == MEMORY_POOL_NUM ? " }\n" : " },\n");
+	}
+	fout << "\t],\n";
+	fout << "\t\"tags\": {\n";
+	for (uint32_t i = 0; i < static_cast<uint32_t>(MemoryTag::Count); ++i)
+	{
+		const TagStatistics& stat = m_TagStatistics[i];
+		fout << "\t\t\"" << MEMORY_TAG_NAMES[i] << "\": { ";
+		fout << "\"currentBytes\": " << stat.iCurrentBytes << ", ";
+		fout << "\"peakBytes\": " << stat.iPeakBytes << ", ";
+		fout << "\"allocations\": " << stat.iAllocationNum << ", ";
+		fout << "\"liveAllocations\": " << stat.iLiveAllocationNum << ", ";
+		fout << "\"budgetBytes\": " << m_TagBudgets[i].iBudgetBytes << ", ";
+		fout << "\"denied\": " << stat.iDeniedNum << ", ";
+		fout << "\"overBudget\": " << stat.iOverBudgetNum;
+		fout << (i + 1 == static_cast<uint32_t>(MemoryTag::Count) ? " }\n" : " },\n");
+	}
+	fout << "\t}\n";
+	fout << "}\n";
+
+	return true;
+}
+
+void MemoryManager::BeginTrace()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_iTraceEventNum = 0;
+	m_TraceStartTime = std::chrono::steady_clock::now();
+	m_bTracing = true;
+}
+
+bool MemoryManager::EndTrace(const char* path)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_bTracing = false;
+	std::ofstream fout(path, std::ofstream::out | std::ofstream::binary);
+	if (fout)
+	{
+		MemoryTraceHeader header = { MEMORY_TRACE_MAGIC, MEMORY_TRACE_VERSION, m_iTraceEventNum };
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fout.write(reinterpret_cast<const char*>(m_pTraceEvents), sizeof(MemoryTraceEvent) * m_iTraceEventNum);
+	}
+
+	std::free(m_pTraceEvents);
+	m_pTraceEvents = nullptr;
+	m_iTraceEventNum = 0;
+	m_iTraceEventCapacity = 0;
+	return fout.good();
+}
+
+void MemoryManager::recordAllocation(uint32_t statIndex, AllocationRecord& record, size_t blockSize, size_t size, MemoryTag tag)
+{
+	record.iRequestedSize = size;
+	record.iBlockSize = blockSize;
+	record.tag = tag;
+	record.pfnRelocate = nullptr;
+	record.pOwner = nullptr;
+
+	PoolStatistics& poolStat = m_PoolStatistics[statIndex];
+	poolStat.iUsedBlockNum++;
+	poolStat.iPeakUsedBlockNum = poolStat.iUsedBlockNum > poolStat.iPeakUsedBlockNum ? poolStat.iUsedBlockNum : poolStat.iPeakUsedBlockNum;
+	poolStat.iAllocationNum++;
+	poolStat.iRequestedBytes += size;
+	poolStat.iWastedBytes += blockSize - size;
+	poolStat.iPeakWastedBytes = poolStat.iWastedBytes > poolStat.iPeakWastedBytes ? poolStat.iWastedBytes : poolStat.iPeakWastedBytes;
+
+	TagStatistics& tagStat = m_TagStatistics[static_cast<uint32_t>(tag)];
+	tagStat.iCurrentBytes += blockSize;
+	tagStat.iPeakBytes = tagStat.iCurrentBytes > tagStat.iPeakBytes ? tagStat.iCurrentBytes : tagStat.iPeakBytes;
+	tagStat.iAllocationNum++;
+	tagStat.iLiveAllocationNum++;
+}
+
+void MemoryManager::recordFree(uint32_t statIndex, const AllocationRecord& record)
+{
+	const size_t blockSize = record.iBlockSize;
+	PoolStatistics& poolStat = m_PoolStatistics[statIndex];
+	poolStat.iUsedBlockNum--;
+	poolStat.iFreeNum++;
+	poolStat.iRequestedBytes -= record.iRequestedSize;
+	poolStat.iWastedBytes -= blockSize - record.iRequestedSize;
+
+	TagStatistics& tagStat = m_TagStatistics[static_cast<uint32_t>(record.tag)];
+	tagStat.iCurrentBytes -= blockSize;
+	tagStat.iLiveAllocationNum--;
+}
+
+void MemoryManager::traceEvent(MemoryTraceOp op, Handle hle, size_t size, size_t alignment, MemoryTag tag)
+{
+	if (m_iTraceEventNum == m_iTraceEventCapacity)
+	{
+		const uint64_t capacity = m_iTraceEventCapacity == 0 ? 4096 : m_iTraceEventCapacity * 2;
+		MemoryTraceEvent* pEvents = static_cast<MemoryTraceEvent*>(std::realloc(m_pTraceEvents, sizeof(MemoryTraceEvent) * capacity));
+		if (!pEvents)
+		{
+			return; // drop the event rather than fail the allocation being traced
+		}
+		m_pTraceEvents = pEvents;
+		m_iTraceEventCapacity = capacity;
+	}
+	if (s_iTraceThread == UINT32_MAX)
+	{
+		s_iTraceThread = m_iTraceThreadNum++;
+	}
+
+	MemoryTraceEvent& event = m_pTraceEvents[m_iTraceEventNum++];
+	event.iTimeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_TraceStartTime).count());
+	event.iSize = size;
+	event.iId = static_cast<uint32_t>(hle.m_poolIndex) << 16 | hle.m_blockIndex;
+	event.iThread = s_iTraceThread;
+	event.iAlignment = static_cast<uint16_t>(alignment);
+	event.op = op;
+	event.tag = tag;
+	event.iPadding = 0;
+}
+
+#if DE_MEMORY_DEBUG
+void MemoryManager::debugAllocate(Handle& hle, AllocationRecord& record, uint32_t payloadOffset)
+{
+	assert(!record.bLive && "block handed out twice");
+	record.bLive = true;
+	record.iPayloadOffset = payloadOffset;
+	hle.m_generation = record.iGeneration;
+
+	char* block = reinterpret_cast<char*>(blockAddress(hle.m_poolIndex, hle.m_blockIndex));
+	char* payload = block + payloadOffset;
+	memset(block, MEMORY_GUARD_BAND_PATTERN, payloadOffset);
+	memset(payload + record.iRequestedSize, MEMORY_GUARD_BAND_PATTERN, MEMORY_GUARD_BAND_SIZE);
+	if (m_DebugConfig.bPoisonOnAllocate)
+	{
+		const size_t poisonSize = record.iRequestedSize < m_DebugConfig.iMaxPoisonSize ? record.iRequestedSize : m_DebugConfig.iMaxPoisonSize;
+		memset(payload, m_DebugConfig.iAllocatePattern, poisonSize);
+	}
+}
+
+void MemoryManager::debugFree(Handle hle, AllocationRecord& record, size_t blockSize)
+{
+	assert(record.bLive && "double free");
+	assert(record.iGeneration == hle.m_generation && "free through stale handle, the block is freed and reused");
+
+	char* block = reinterpret_cast<char*>(blockAddress(hle.m_poolIndex, hle.m_blockIndex));
+	if (m_DebugConfig.bCheckGuardBand)
+	{
+		const char* back = block + record.iPayloadOffset + record.iRequestedSize;
+		for (uint32_t i = 0; i < record.iPayloadOffset; ++i)
+		{
+			assert(static_cast<uint8_t>(block[i]) == MEMORY_GUARD_BAND_PATTERN && "buffer underrun, guard band before the block is overwritten");
+		}
+		for (uint32_t i = 0; i < MEMORY_GUARD_BAND_SIZE; ++i)
+		{
+			assert(static_cast<uint8_t>(back[i]) == MEMORY_GUARD_BAND_PATTERN && "buffer overrun, guard band after the block is overwritten");
+		}
+	}
+	if (m_DebugConfig.bPoisonOnFree)
+	{
+		memset(block, m_DebugConfig.iFreePattern, blockSize < m_DebugConfig.iMaxPoisonSize ? blockSize : m_DebugConfig.iMaxPoisonSize);
+	}
+
+	record.bLive = false;
+	record.iGeneration++;
 }
+#endif
 
 // Return a aligned address according to the alignment
-void* MemoryManager::alignedAddress(void* ptr)
+void* MemoryManager::alignedAddress(void* ptr, size_t alignment)
 {
 	uintptr_t ptr_ = reinterpret_cast<uintptr_t>(ptr);
-	uint32_t adjustment = static_cast<uint32_t>(ptr_ % MEMORY_ALIGNMENT);
+	uint32_t adjustment = static_cast<uint32_t>(ptr_ % alignment);
 	if (adjustment)
 	{
-		return reinterpret_cast<void*>(ptr_ + MEMORY_ALIGNMENT - adjustment);
+		return reinterpret_cast<void*>(ptr_ + alignment - adjustment);
 	}
 	else
 	{
@@ -5,8 +5,13 @@
 // Cpp
 #include <iostream>
 #include <mutex>
+#include <chrono>
 // Engine
 #include "MemoryPool.h"
+#include "LargeObjectAllocator.h"
+#include "MemoryStatistics.h"
+#include "MemoryTag.h"
+#include "MemoryTrace.h"
 #include "Handle.h"
 
 namespace DE
@@ -33,6 +38,29 @@ const uint32_t MEMORY_POOL_CONFIG[][2] =	// memory pool configuration: block siz
 	{ 16777216, 4 }  // 2048 * 2048 * 4
 };
 constexpr uint32_t MEMORY_POOL_NUM = sizeof(MEMORY_POOL_CONFIG) / sizeof(uint32_t) / 2;
+constexpr uint32_t LARGE_OBJECT_POOL_INDEX = 31;	// reserved pool index of Handle referring to a large object
+static_assert(MEMORY_POOL_NUM <= LARGE_OBJECT_POOL_INDEX, "pool index is stored in 5 bits with the last one reserved");
+constexpr uint32_t MEMORY_GUARD_BAND_SIZE = DE_MEMORY_DEBUG ? 16 : 0;	// guard band after every allocation, the one before is widened to the alignment
+constexpr uint8_t MEMORY_GUARD_BAND_PATTERN = 0xFD;	// byte pattern filled in guard band
+
+constexpr uint32_t MEMORY_EVICTION_CALLBACK_MAX_NUM = 32;	// maximum number of registered eviction callback
+using EvictionCallback = void(*)(MemoryTag tag, uint64_t bytesToFree, void* pUserData);	// asked to free memory of the tag
+
+/*
+*	STRUCT: MemoryDebugConfig
+*	Runtime switches of the memory debugging, only honoured when
+*	DE_MEMORY_DEBUG is on. Release build never touches the memory
+*	on allocate or free
+*/
+struct MemoryDebugConfig
+{
+	bool								bPoisonOnAllocate = true;		// fill new allocation with iAllocatePattern
+	bool								bPoisonOnFree = true;			// fill freed block with iFreePattern
+	bool								bCheckGuardBand = true;			// verify guard band on free
+	uint8_t								iAllocatePattern = 0xCD;		// pattern of uninitialized memory
+	uint8_t								iFreePattern = 0xDD;			// pattern of freed memory
+	size_t								iMaxPoisonSize = 1024 * 1024;	// bytes poisoned at most per allocation, bounds the cost on big block
+};
 
 class MemoryManager
 {
@@ -70,15 +98,53 @@ public:
 	*	--- Function:
 	*	Allocate(size_t)
 	*	This function will return a handle with appropriate pool and block index,
-	*	and update the book keeping record in memory pool
+	*	and update the book keeping record in memory pool. Size larger than the
+	*	biggest pool block is mapped directly from the OS by the large object allocator
 	*
 	*	--- Parameters:
 	*	@ size: size of the memory requested, typically pass by sizeof(class)
+	*	@ tag: subsystem the memory is attributed to, overridden by MemoryTagScope
 	*
 	*	--- Return:
-	*	@ void
+	*	@ Handle: handle to the memory, invalid if allocation failed
 	********************************************************************************/
-	Handle Allocate(size_t size);
+	Handle Allocate(size_t size, MemoryTag tag = MemoryTag::General);
+
+	/********************************************************************************
+	*	--- Function:
+	*	Allocate(size_t, size_t, MemoryTag)
+	*	This function will allocate as Allocate(size_t, MemoryTag) with the address
+	*	aligned. Pool blocks are aligned to their size, so an over aligned request
+	*	is served from a size class no smaller than the alignment, and the common
+	*	16-byte case costs nothing extra
+	*
+	*	--- Parameters:
+	*	@ size: size of the memory requested
+	*	@ alignment: power of two, up to MEMORY_PAGE_SIZE
+	*	@ tag: subsystem the memory is attributed to, overridden by MemoryTagScope
+	*
+	*	--- Return:
+	*	@ Handle: handle to the memory, invalid if allocation failed
+	********************************************************************************/
+	Handle Allocate(size_t size, size_t alignment, MemoryTag tag = MemoryTag::General);
+
+	/********************************************************************************
+	*	--- Function:
+	*	TryAllocate(size_t, size_t, MemoryTag)
+	*	This function will allocate as Allocate(size_t, size_t, MemoryTag) unless
+	*	the tag would still be above its budget after eviction, then it returns an
+	*	invalid Handle. Only for caller that can do without the memory (e.g. a
+	*	streaming staging copy), Allocate() never fails on the budget
+	*
+	*	--- Parameters:
+	*	@ size: size of the memory requested
+	*	@ alignment: power of two, up to MEMORY_PAGE_SIZE
+	*	@ tag: subsystem the memory is attributed to, overridden by MemoryTagScope
+	*
+	*	--- Return:
+	*	@ Handle: handle to the memory, invalid if denied or allocation failed
+	********************************************************************************/
+	Handle TryAllocate(size_t size, size_t alignment, MemoryTag tag);
 
 	/********************************************************************************
 	*	--- Function:
@@ -108,6 +174,231 @@ public:
 	// Get the raw address stored with reference to handle
 	void* GetMemoryAddressFromHandle(Handle hle) const;
 
+	/********************************************************************************
+	*	--- Function:
+	*	GetHandleFromMemoryAddress(const void*)
+	*	This function will return the handle of a live allocation from the address
+	*	returned by GetMemoryAddressFromHandle(), for API that only keeps the raw
+	*	pointer (e.g. std::pmr::memory_resource)
+	*
+	*	--- Parameters:
+	*	@ ptr: raw address of an allocation
+	*
+	*	--- Return:
+	*	@ Handle: handle to the memory, invalid if the address is not allocated here
+	********************************************************************************/
+	Handle GetHandleFromMemoryAddress(const void* ptr);
+
+	/********************************************************************************
+	*	--- Function:
+	*	SetRelocationListener(Handle, RelocationCallback, void*)
+	*	This function will mark the memory of the handle as movable by the
+	*	defragmenter, the callback is invoked with the mutex locked and must not
+	*	allocate or free
+	*
+	*	--- Parameters:
+	*	@ hle: a handle
+	*	@ callback: function to be called after the memory is moved, nullptr to pin
+	*	@ pOwner: first argument passed to the callback
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void SetRelocationListener(Handle hle, RelocationCallback callback, void* pOwner);
+
+	/********************************************************************************
+	*	--- Function:
+	*	Defragment(float)
+	*	This function will move movable blocks toward the front of each pool until
+	*	the pools are compact or the time budget is used up, continuing from where
+	*	the last call stopped. Large objects are never moved. Blocks are copied and
+	*	their listeners called on the calling thread, so call it between frames on
+	*	the main thread, once the jobs of the frame are waited and the GPU is idle,
+	*	when no other thread can read or allocate memory of movable blocks
+	*
+	*	--- Parameters:
+	*	@ budgetMs: time slice in millisecond
+	*
+	*	--- Return:
+	*	@ uint32_t: number of block moved
+	********************************************************************************/
+	uint32_t Defragment(float budgetMs);
+
+	/********************************************************************************
+	*	--- Function:
+	*	GetPoolStatistics(uint32_t)
+	*	This function will return the counters of a size class, index equals to
+	*	MEMORY_POOL_NUM refers to the large object allocator
+	*
+	*	--- Parameters:
+	*	@ poolIndex: index to MEMORY_POOL_CONFIG, or MEMORY_POOL_NUM
+	*
+	*	--- Return:
+	*	@ const PoolStatistics&: counters of the size class
+	********************************************************************************/
+	const PoolStatistics& GetPoolStatistics(uint32_t poolIndex) const
+	{
+		return m_PoolStatistics[poolIndex];
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	GetTagStatistics(MemoryTag)
+	*	This function will return the counters of all allocation with given tag
+	*
+	*	--- Parameters:
+	*	@ tag: the memory tag
+	*
+	*	--- Return:
+	*	@ const TagStatistics&: counters of the tag
+	********************************************************************************/
+	const TagStatistics& GetTagStatistics(MemoryTag tag) const
+	{
+		return m_TagStatistics[static_cast<uint32_t>(tag)];
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	SetBudget(MemoryTag, uint64_t, float)
+	*	This function will limit the block bytes held by a tag. Allocation going
+	*	above the warning level fires the eviction callbacks of the tag first.
+	*	TryAllocate() still going above the budget afterward returns an invalid
+	*	Handle, Allocate() goes through and is counted as over budget. The budget
+	*	is soft under contention, concurrent allocation of the same tag may
+	*	overshoot by a few blocks
+	*
+	*	--- Parameters:
+	*	@ tag: the memory tag
+	*	@ budgetBytes: hard limit in bytes, 0 to remove the budget
+	*	@ warningRatio: fraction of the budget above which eviction is requested
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void SetBudget(MemoryTag tag, uint64_t budgetBytes, float warningRatio = 0.9f);
+
+	/********************************************************************************
+	*	--- Function:
+	*	GetBudgetStatus(MemoryTag)
+	*	This function will return the current usage against the budget of a tag
+	*
+	*	--- Parameters:
+	*	@ tag: the memory tag
+	*
+	*	--- Return:
+	*	@ BudgetStatus: snapshot of the budget
+	********************************************************************************/
+	BudgetStatus GetBudgetStatus(MemoryTag tag);
+
+	/********************************************************************************
+	*	--- Function:
+	*	RegisterEvictionCallback(MemoryTag, EvictionCallback, void*)
+	*	This function will register a callback asked to free memory of the tag when
+	*	it is close to the budget. The callback runs on the allocating thread
+	*	without the mutex locked so it can free, its own allocation never fires
+	*	eviction again
+	*
+	*	--- Parameters:
+	*	@ tag: the memory tag
+	*	@ callback: function called with the number of bytes wanted back
+	*	@ pUserData: last argument passed to the callback
+	*
+	*	--- Return:
+	*	@ uint32_t: id to unregister, MEMORY_EVICTION_CALLBACK_MAX_NUM if full
+	********************************************************************************/
+	uint32_t RegisterEvictionCallback(MemoryTag tag, EvictionCallback callback, void* pUserData);
+
+	/********************************************************************************
+	*	--- Function:
+	*	UnregisterEvictionCallback(uint32_t)
+	*	This function will remove a callback, must not race with allocation of
+	*	the tag as the callback may be running
+	*
+	*	--- Parameters:
+	*	@ id: id returned by RegisterEvictionCallback()
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void UnregisterEvictionCallback(uint32_t id);
+
+	/********************************************************************************
+	*	--- Function:
+	*	DumpStatistics(const char*)
+	*	This function will write per size class watermarks, allocation rate, wasted
+	*	bytes and per tag usage to a JSON file
+	*
+	*	--- Parameters:
+	*	@ path: output file path
+	*
+	*	--- Return:
+	*	@ bool: True if the file is written
+	********************************************************************************/
+	bool DumpStatistics(const char* path);
+
+	/********************************************************************************
+	*	--- Function:
+	*	BeginTrace()
+	*	This function will start recording every Allocate() and Free() in memory,
+	*	discarding the events of the previous trace. The events are kept in system
+	*	heap so recording never allocates from the pools
+	*
+	*	--- Parameters:
+	*	@ void
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void BeginTrace();
+
+	/********************************************************************************
+	*	--- Function:
+	*	EndTrace(const char*)
+	*	This function will stop recording and write the events to a binary file
+	*	laid out as in MemoryTrace.h, for replay by DBenchmark
+	*
+	*	--- Parameters:
+	*	@ path: output file path
+	*
+	*	--- Return:
+	*	@ bool: True if the file is written
+	********************************************************************************/
+	bool EndTrace(const char* path);
+
+	/********************************************************************************
+	*	--- Function:
+	*	SetDebugConfig(const MemoryDebugConfig&)
+	*	This function will set the poisoning and guard band options, which take
+	*	effect only when DE_MEMORY_DEBUG is on
+	*
+	*	--- Parameters:
+	*	@ config: the debug options
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void SetDebugConfig(const MemoryDebugConfig& config)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_DebugConfig = config;
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	GetDebugConfig()
+	*	This function will return the current poisoning and guard band options
+	*
+	*	--- Parameters:
+	*	@ void
+	*
+	*	--- Return:
+	*	@ const MemoryDebugConfig&: the debug options
+	********************************************************************************/
+	const MemoryDebugConfig& GetDebugConfig() const
+	{
+		return m_DebugConfig;
+	}
+
 	/********************************************************************************
 	*	--- Static Function:
 	*	GetInstance()
@@ -142,21 +433,187 @@ private:
 
 	/********************************************************************************
 	*	--- Function:
-	*	alignedAddress(void*);
+	*	alignedAddress(void*, size_t);
 	*	This function will return an aligned address of the given address according
-	*	to the predefined memory alignement requirement
+	*	to the given alignement requirement
 	*
 	*	--- Parameters:
 	*	@ ptr: memory address
+	*	@ alignment: alignment in bytes
 	*
 	*	--- Return:
 	*	@ void*: aligned address
 	********************************************************************************/
-	void* alignedAddress(void* ptr);
+	void* alignedAddress(void* ptr, size_t alignment);
+
+	/********************************************************************************
+	*	--- Function:
+	*	allocate(size_t, size_t, MemoryTag, bool)
+	*	This function will implement Allocate() and TryAllocate()
+	*
+	*	--- Parameters:
+	*	@ size: size of the memory requested
+	*	@ alignment: power of two, up to MEMORY_PAGE_SIZE
+	*	@ tag: subsystem the memory is attributed to, overridden by MemoryTagScope
+	*	@ bMayDeny: whether going above the budget returns an invalid Handle
+	*
+	*	--- Return:
+	*	@ Handle: handle to the memory, invalid if denied or allocation failed
+	********************************************************************************/
+	Handle allocate(size_t size, size_t alignment, MemoryTag tag, bool bMayDeny);
 	
 	static MemoryManager*					m_pInstance;	// singleton instance
 	void*									m_pRawHeapStart;	// Raw heap start address
+	/********************************************************************************
+	*	--- Function:
+	*	recordAllocation(uint32_t, AllocationRecord&, size_t, size_t, MemoryTag)
+	*	This function will fill the book keeping record of a block and update the
+	*	statistics, must be called with the mutex locked
+	*
+	*	--- Parameters:
+	*	@ statIndex: index to m_PoolStatistics
+	*	@ record: record of the allocated block
+	*	@ blockSize: bytes charged to the tag, the size class or the mapped size of a large object
+	*	@ size: requested size
+	*	@ tag: resolved tag
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void recordAllocation(uint32_t statIndex, AllocationRecord& record, size_t blockSize, size_t size, MemoryTag tag);
+
+	/********************************************************************************
+	*	--- Function:
+	*	recordFree(uint32_t, const AllocationRecord&)
+	*	This function will undo the statistics of a block being freed, must be called
+	*	with the mutex locked
+	*
+	*	--- Parameters:
+	*	@ statIndex: index to m_PoolStatistics
+	*	@ record: record of the freed block
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void recordFree(uint32_t statIndex, const AllocationRecord& record);
+
+	/********************************************************************************
+	*	--- Function:
+	*	reserveBudget(MemoryTag, size_t, std::unique_lock<std::mutex>&)
+	*	This function will check the allocation against the tag budget, when it is
+	*	close the mutex is released while the eviction callbacks run, then checked
+	*	again. Going above the budget is counted as denied or over budget
+	*
+	*	--- Parameters:
+	*	@ tag: resolved tag
+	*	@ size: bytes the block charges to the tag, see AllocationRecord::iBlockSize
+	*	@ lock: the locked mutex
+	*	@ bMayDeny: whether going above the budget denies the allocation
+	*
+	*	--- Return:
+	*	@ bool: True if the allocation may proceed
+	********************************************************************************/
+	bool reserveBudget(MemoryTag tag, size_t size, std::unique_lock<std::mutex>& lock, bool bMayDeny);
+
+	/********************************************************************************
+	*	--- Function:
+	*	traceEvent(MemoryTraceOp, Handle, size_t, size_t, MemoryTag)
+	*	This function will append an event to the trace being recorded, must be
+	*	called with the mutex locked
+	*
+	*	--- Parameters:
+	*	@ op: allocate or free
+	*	@ hle: handle being allocated or freed
+	*	@ size: requested size, 0 for free
+	*	@ alignment: requested alignment, 0 for free
+	*	@ tag: resolved tag
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void traceEvent(MemoryTraceOp op, Handle hle, size_t size, size_t alignment, MemoryTag tag);
+
+	/********************************************************************************
+	*	--- Function:
+	*	blockAddress(uint32_t, uint32_t)
+	*	This function will return the start address of a block, including the
+	*	guard band in front
+	*
+	*	--- Parameters:
+	*	@ poolIndex: index to m_pPool, or LARGE_OBJECT_POOL_INDEX
+	*	@ blockIndex: block index in the pool
+	*
+	*	--- Return:
+	*	@ void*: start address of the block
+	********************************************************************************/
+	void* blockAddress(uint32_t poolIndex, uint32_t blockIndex) const;
+
+#if DE_MEMORY_DEBUG
+	/********************************************************************************
+	*	--- Function:
+	*	debugAllocate(Handle&, AllocationRecord&, uint32_t)
+	*	This function will stamp the handle with the block generation, write the
+	*	guard bands and poison the memory, must be called with the mutex locked
+	*
+	*	--- Parameters:
+	*	@ hle: handle being returned from Allocate()
+	*	@ record: record of the allocated block, with requested size filled
+	*	@ payloadOffset: size of the front guard band
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void debugAllocate(Handle& hle, AllocationRecord& record, uint32_t payloadOffset);
+
+	/********************************************************************************
+	*	--- Function:
+	*	debugFree(Handle, AllocationRecord&, size_t)
+	*	This function will assert on double free or stale handle, verify the guard
+	*	bands, poison the block and bump its generation, must be called with the
+	*	mutex locked
+	*
+	*	--- Parameters:
+	*	@ hle: handle being freed
+	*	@ record: record of the block
+	*	@ blockSize: actual size of the block
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void debugFree(Handle hle, AllocationRecord& record, size_t blockSize);
+#endif
+
 	MemoryPool*								m_pPool[MEMORY_POOL_NUM];	// All memory blocks' pools
+	LargeObjectAllocator					m_LargeObjectAllocator;	// Allocations larger than any pool block
+
+	AllocationRecord*						m_pRecords[MEMORY_POOL_NUM];	// Record of each block, indexed by block index
+	AllocationRecord						m_LargeObjectRecords[LARGE_OBJECT_MAX_NUM];	// Record of each large object
+	PoolStatistics							m_PoolStatistics[MEMORY_POOL_NUM + 1];	// Counters per size class, last one is large object
+	TagStatistics							m_TagStatistics[static_cast<uint32_t>(MemoryTag::Count)];	// Counters per tag
+	std::chrono::steady_clock::time_point	m_StartTime;	// Time the pools are constructed, for allocation rate
+	MemoryDebugConfig						m_DebugConfig;	// Poisoning and guard band options in debug build
+	uint32_t								m_iDefragPool = 0;	// Pool the defragmenter resumes from
+
+	struct TagBudget
+	{
+		uint64_t							iBudgetBytes;		// hard limit, 0 if none
+		uint64_t							iWarningBytes;		// eviction level
+	};
+	struct EvictionListener
+	{
+		EvictionCallback					pfnEvict;			// null if the slot is free
+		void*								pUserData;			// argument passed to pfnEvict
+		MemoryTag							tag;				// tag listened to
+	};
+	TagBudget								m_TagBudgets[static_cast<uint32_t>(MemoryTag::Count)] = {};	// Budget per tag
+	EvictionListener						m_EvictionListeners[MEMORY_EVICTION_CALLBACK_MAX_NUM] = {};	// Registered eviction callbacks
+
+	bool									m_bTracing = false;	// whether Allocate() and Free() are recorded
+	MemoryTraceEvent*						m_pTraceEvents = nullptr;	// Recorded events, grown with realloc
+	uint64_t								m_iTraceEventNum = 0;	// number of recorded event
+	uint64_t								m_iTraceEventCapacity = 0;	// number of event m_pTraceEvents can hold
+	uint32_t								m_iTraceThreadNum = 0;	// number of thread seen by the trace
+	std::chrono::steady_clock::time_point	m_TraceStartTime;	// Time the trace began
 
 	std::mutex								m_mutex;
 };
@@ -1,57 +1,253 @@
+#pragma once
+
 // C++ include
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
 #include <memory>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
-const uint32_t MEMORY_ALIGNMENT = 16;	// memory alignment requirement
+const uint32_t MEMORY_ALIGNMENT = 16;	// default memory alignment
+const uint32_t MEMORY_PAGE_SIZE = 4096;	// block area of every pool starts at page boundary, also the maximum alignment
 
 /*
 *	class: MemoryPool
 *	MemoryPool keep track of the memory pool and block
 *	status, and is responsible to return appropriate
-*	block of memory when Handle or other system requests
+*	block of memory when Handle or other system requests.
+*	Handle stores a logical block index which is mapped to
+*	the physical block, so that a live block can be moved
+*	toward the front of the pool without invalidating the
+*	Handle. Free physical blocks are tracked by a bitmap and
+*	the lowest one is always handed out first. The block area
+*	starts at a page boundary and block size is a power of two,
+*	so every block is aligned to min(block size, page size)
+*
+*	Memory layout:
+*	| MemoryPool | occupancy bitmap | logical to physical | physical to logical | blocks |
 */
 class MemoryPool
 {
 public:
 
+	/********************************************************************************
+	*	--- Static Function:
+	*	GetHeaderSize(uint32_t)
+	*	This function will return the size of the book keeping in front of the blocks
+	*
+	*	--- Parameters:
+	*	@ num: number of memory block
+	*
+	*	--- Return:
+	*	@ size_t: size in bytes, a multiple of MEMORY_PAGE_SIZE
+	********************************************************************************/
+	static size_t GetHeaderSize(uint32_t num)
+	{
+		const size_t size = sizeof(MemoryPool) + sizeof(uint64_t) * GetWordNum(num) + sizeof(uint32_t) * num * 2;
+		return (size + MEMORY_PAGE_SIZE - 1) / MEMORY_PAGE_SIZE * MEMORY_PAGE_SIZE;
+	}
+
 	/********************************************************************************
 	*	--- Static Function:
 	*	Construct(size_t, uint32_t, void*&)
 	*	This function will construct a memory pool with alignment at the beginning
 	*
 	*	--- Parameters:
-	*	@ size: size of the each memory block
+	*	@ size: size of the each memory block, a power of two
 	*	@ num: number of memory block
-	*	@ heapStart: the address of the start of the heap after the last memory pool
+	*	@ heapStart: page aligned address of the start of the heap after the last memory pool
 	*
 	*	--- Return:
 	*	@ MemoryPool*: pointer to the aligned address of start of memory pool
 	********************************************************************************/
 	static MemoryPool* Construct(size_t size, uint32_t num, void* &heapStart)
 	{
-		assert(size % MEMORY_ALIGNMENT == 0); // Make sure the block size does not need alignment
+		assert(size % MEMORY_ALIGNMENT == 0 && (size & (size - 1)) == 0); // block alignment relies on power of two size
+		assert((uint64_t) heapStart % MEMORY_PAGE_SIZE == 0);
+		assert(num <= (1 << 16)); // block index is stored in 16 bits in Handle
 
 		MemoryPool* ptr = (MemoryPool*) heapStart;
 		ptr->m_iBlockSize = static_cast<uint32_t>(size);
+		ptr->m_iBlockNum = num;
 		ptr->m_iFreeBlockNum = num;
-		ptr->m_iFreeBlockIndex = 0;
-
-		heapStart = (void*) ((uint64_t) heapStart + sizeof(uint32_t) * 4);
+		ptr->m_iLowestFreeWord = 0;
 
+		memset(ptr->occupancy(), 0, sizeof(uint64_t) * GetWordNum(num));
 		for (uint32_t i = 0; i < num; ++i)
 		{
-			ptr->m_pFreeList[i] = i;
+			ptr->logicalToPhysical()[i] = i;
+			ptr->physicalToLogical()[i] = i;
 		}
 
-		heapStart = (void*)((uint64_t) heapStart + (size * num) + (sizeof(uint32_t) * num));
+		heapStart = (void*)((uint64_t) heapStart + GetHeaderSize(num) + size * num);
 		return ptr;
 	}
 
+	/********************************************************************************
+	*	--- Function:
+	*	Allocate()
+	*	This function will mark the lowest free physical block as used, the pool
+	*	must have at least one free block
+	*
+	*	--- Parameters:
+	*	@ void
+	*
+	*	--- Return:
+	*	@ uint32_t: logical index of the block, to be stored in Handle
+	********************************************************************************/
+	uint32_t Allocate()
+	{
+		assert(m_iFreeBlockNum > 0);
+		const uint32_t physical = GetLowestFree();
+		occupancy()[physical / 64] |= 1ull << (physical % 64);
+		m_iFreeBlockNum--;
+		return physicalToLogical()[physical];
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	Free(uint32_t)
+	*	This function will mark the block as free
+	*
+	*	--- Parameters:
+	*	@ logicalIndex: logical index of the block
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void Free(uint32_t logicalIndex)
+	{
+		const uint32_t physical = logicalToPhysical()[logicalIndex];
+		assert(IsUsed(physical));
+		occupancy()[physical / 64] &= ~(1ull << (physical % 64));
+		m_iLowestFreeWord = physical / 64 < m_iLowestFreeWord ? physical / 64 : m_iLowestFreeWord;
+		m_iFreeBlockNum++;
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	Move(uint32_t, uint32_t)
+	*	This function will copy a used block to a free physical block and remap its
+	*	logical index, the source block becomes free
+	*
+	*	--- Parameters:
+	*	@ fromPhysical: physical index of a used block
+	*	@ toPhysical: physical index of a free block
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	void Move(uint32_t fromPhysical, uint32_t toPhysical)
+	{
+		assert(IsUsed(fromPhysical) && !IsUsed(toPhysical));
+		memcpy(GetPhysicalBlock(toPhysical), GetPhysicalBlock(fromPhysical), m_iBlockSize);
+
+		const uint32_t movedLogical = physicalToLogical()[fromPhysical];
+		const uint32_t freeLogical = physicalToLogical()[toPhysical];
+		physicalToLogical()[toPhysical] = movedLogical;
+		physicalToLogical()[fromPhysical] = freeLogical;
+		logicalToPhysical()[movedLogical] = toPhysical;
+		logicalToPhysical()[freeLogical] = fromPhysical;
+
+		occupancy()[toPhysical / 64] |= 1ull << (toPhysical % 64);
+		occupancy()[fromPhysical / 64] &= ~(1ull << (fromPhysical % 64));
+		m_iLowestFreeWord = fromPhysical / 64 < m_iLowestFreeWord ? fromPhysical / 64 : m_iLowestFreeWord;
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	GetLowestFree()
+	*	This function will return the lowest free physical block
+	*
+	*	--- Parameters:
+	*	@ void
+	*
+	*	--- Return:
+	*	@ uint32_t: physical index, m_iBlockNum if the pool is full
+	********************************************************************************/
+	uint32_t GetLowestFree()
+	{
+		const uint64_t* words = occupancy();
+		const uint32_t wordNum = GetWordNum(m_iBlockNum);
+		for (uint32_t i = m_iLowestFreeWord; i < wordNum; ++i)
+		{
+			if (~words[i] != 0)
+			{
+				m_iLowestFreeWord = i;
+				const uint32_t physical = i * 64 + LowestSetBit(~words[i]);
+				return physical < m_iBlockNum ? physical : m_iBlockNum;
+			}
+		}
+		m_iLowestFreeWord = wordNum;
+		return m_iBlockNum;
+	}
+
+	/********************************************************************************
+	*	--- Function:
+	*	GetHighestUsed()
+	*	This function will return the highest used physical block
+	*
+	*	--- Parameters:
+	*	@ void
+	*
+	*	--- Return:
+	*	@ uint32_t: physical index, m_iBlockNum if the pool is empty
+	********************************************************************************/
+	uint32_t GetHighestUsed() const
+	{
+		const uint64_t* words = occupancy();
+		for (uint32_t i = GetWordNum(m_iBlockNum); i-- > 0;)
+		{
+			if (words[i] != 0)
+			{
+				return i * 64 + HighestSetBit(words[i]);
+			}
+		}
+		return m_iBlockNum;
+	}
+
+	/** @brief Return whether the physical block is in use */
+	bool IsUsed(uint32_t physicalIndex) const
+	{
+		return (occupancy()[physicalIndex / 64] >> (physicalIndex % 64)) & 1;
+	}
+
+	/** @brief Return the logical index currently mapped to the physical block */
+	uint32_t GetLogicalIndex(uint32_t physicalIndex) const
+	{
+		return physicalToLogical()[physicalIndex];
+	}
+
+	/** @brief Return the address of the block referred by a logical index */
+	void* GetBlock(uint32_t logicalIndex) const
+	{
+		return GetPhysicalBlock(logicalToPhysical()[logicalIndex]);
+	}
+
+	/** @brief Return the physical block containing the address, m_iBlockNum if the address is outside the pool */
+	uint32_t GetPhysicalIndex(const void* address) const
+	{
+		const uint64_t first = (uint64_t) GetPhysicalBlock(0);
+		const uint64_t ptr = (uint64_t) address;
+		if (ptr < first || ptr >= first + (uint64_t) m_iBlockSize * m_iBlockNum)
+		{
+			return m_iBlockNum;
+		}
+		return static_cast<uint32_t>((ptr - first) / m_iBlockSize);
+	}
+
+	/** @brief Return the address of a physical block */
+	void* GetPhysicalBlock(uint32_t physicalIndex) const
+	{
+		return (void*)((uint64_t) this + GetHeaderSize(m_iBlockNum) + (uint64_t) m_iBlockSize * physicalIndex);
+	}
+
 	uint32_t							m_iBlockSize;			// block size of this memory pool
+	uint32_t							m_iBlockNum;			// number of memory block
 	uint32_t							m_iFreeBlockNum;		// number of free memory block
-	uint32_t							m_iFreeBlockIndex;		// the index of next free memory block in the free list
-	uint32_t							m_pFreeList[63356];		// free memory block indices 
+	uint32_t							m_iLowestFreeWord;		// no free block in the bitmap words before this
 
 private:
 
@@ -64,4 +260,46 @@ private:
 	*	@ void
 	********************************************************************************/
 	MemoryPool(){}
+
+	static uint32_t GetWordNum(uint32_t num)
+	{
+		return (num + 63) / 64;
+	}
+
+	static uint32_t LowestSetBit(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+#else
+		return __builtin_ctzll(value);
+#endif
+	}
+
+	static uint32_t HighestSetBit(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+
+	uint64_t* occupancy() const
+	{
+		return (uint64_t*)((uint64_t) this + sizeof(MemoryPool));
+	}
+
+	uint32_t* logicalToPhysical() const
+	{
+		return (uint32_t*)(occupancy() + GetWordNum(m_iBlockNum));
+	}
+
+	uint32_t* physicalToLogical() const
+	{
+		return logicalToPhysical() + m_iBlockNum;
+	}
 };
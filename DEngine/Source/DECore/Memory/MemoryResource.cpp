@@ -0,0 +1,135 @@
+// MemoryResource.cpp
+
+#include <DECore/DECore.h>
+#include "MemoryResource.h"
+#include "MemoryManager.h"
+
+// Cpp
+#include <new>
+#include <string.h>
+
+namespace DE
+{
+
+namespace
+{
+struct ThreadScratch
+{
+	Handle hBuffer;
+	void* pBuffer = nullptr;	// allocated on first claim, kept until the thread releases it
+	bool bInUse = false;
+};
+thread_local ThreadScratch s_Scratch;
+
+bool ClaimScratch()
+{
+	if (s_Scratch.bInUse)
+	{
+		return false;
+	}
+	if (!s_Scratch.pBuffer)
+	{
+		// held for the thread lifetime, not charged to the scope that happens to use it first
+		MemoryTagScope memoryScope(MemoryTag::General);
+		s_Scratch.hBuffer = MemoryManager::GetInstance()->Allocate(SCRATCH_BUFFER_SIZE, MemoryTag::General);
+		s_Scratch.pBuffer = s_Scratch.hBuffer.Raw();
+	}
+	s_Scratch.bInUse = s_Scratch.pBuffer != nullptr;
+	return s_Scratch.bInUse;
+}
+
+// the Handle of a PoolMemoryResource block is kept in front of the returned address, padded to keep the alignment
+size_t HandleHeaderSize(size_t alignment)
+{
+	const size_t align = alignment > alignof(Handle) ? alignment : alignof(Handle);
+	return (sizeof(Handle) + align - 1) & ~(align - 1);
+}
+}
+
+PoolMemoryResource* PoolMemoryResource::Instance(MemoryTag tag)
+{
+	static PoolMemoryResource s_Instances[] =
+	{
+		PoolMemoryResource(MemoryTag::General),
+		PoolMemoryResource(MemoryTag::Container),
+		PoolMemoryResource(MemoryTag::Loader),
+		PoolMemoryResource(MemoryTag::Renderer),
+		PoolMemoryResource(MemoryTag::Job),
+		PoolMemoryResource(MemoryTag::Texture),
+		PoolMemoryResource(MemoryTag::Mesh),
+		PoolMemoryResource(MemoryTag::FrameData),
+	};
+	static_assert(sizeof(s_Instances) / sizeof(s_Instances[0]) == static_cast<uint32_t>(MemoryTag::Count), "missing tag resource");
+	return &s_Instances[static_cast<uint32_t>(tag)];
+}
+
+void* PoolMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	const size_t headerSize = HandleHeaderSize(alignment);
+	Handle hle = MemoryManager::GetInstance()->Allocate(headerSize + bytes, alignment > alignof(Handle) ? alignment : alignof(Handle), m_Tag);
+	uint8_t* pBlock = static_cast<uint8_t*>(hle.Raw());
+	if (!pBlock)
+	{
+		throw std::bad_alloc(); // memory_resource must not return null
+	}
+	// no relocation listener, the block never moves so the header stays valid
+	memcpy(pBlock + headerSize - sizeof(Handle), &hle, sizeof(Handle));
+	return pBlock + headerSize;
+}
+
+void PoolMemoryResource::do_deallocate(void* ptr, size_t /*bytes*/, size_t /*alignment*/)
+{
+	Handle hle;
+	memcpy(&hle, static_cast<uint8_t*>(ptr) - sizeof(Handle), sizeof(Handle));
+	assert(hle.m_counter != 0 && "address is not allocated by PoolMemoryResource");
+	MemoryManager::GetInstance()->Free(hle);
+}
+
+bool PoolMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	// all instances share the same pools, only the tag differs
+	return dynamic_cast<const PoolMemoryResource*>(&other) != nullptr;
+}
+
+ScratchMemoryResource::ScratchMemoryResource(std::pmr::memory_resource* pUpstream)
+	: m_bOwnScratch(ClaimScratch())
+	, m_Monotonic(m_bOwnScratch ? s_Scratch.pBuffer : nullptr, m_bOwnScratch ? SCRATCH_BUFFER_SIZE : 0, pUpstream)
+{
+}
+
+ScratchMemoryResource::~ScratchMemoryResource()
+{
+	m_Monotonic.release();
+	if (m_bOwnScratch)
+	{
+		s_Scratch.bInUse = false;
+	}
+}
+
+void ScratchMemoryResource::ReleaseThreadBuffer()
+{
+	assert(!s_Scratch.bInUse && "scratch buffer released while in use");
+	if (s_Scratch.pBuffer)
+	{
+		MemoryManager::GetInstance()->Free(s_Scratch.hBuffer);
+		s_Scratch.hBuffer = Handle();
+		s_Scratch.pBuffer = nullptr;
+	}
+}
+
+void* ScratchMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	return m_Monotonic.allocate(bytes, alignment);
+}
+
+void ScratchMemoryResource::do_deallocate(void* /*ptr*/, size_t /*bytes*/, size_t /*alignment*/)
+{
+	// monotonic, released on destruction
+}
+
+bool ScratchMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+}
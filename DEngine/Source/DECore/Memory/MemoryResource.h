@@ -0,0 +1,121 @@
+// MemoryResource.h: std::pmr::memory_resource adapters over MemoryManager
+#pragma once
+
+// Cpp
+#include <memory_resource>
+// Engine
+#include "Handle.h"
+#include "MemoryTag.h"
+
+namespace DE
+{
+
+constexpr size_t SCRATCH_BUFFER_SIZE = 256 * 1024 - 32;	// per thread scratch buffer of ScratchMemoryResource, leaves room for debug guard bands in the 256KB size class
+
+/*
+*	class: PoolMemoryResource
+*	PoolMemoryResource lets standard containers (std::pmr::string,
+*	std::pmr::vector, ...) allocate from the MemoryManager size
+*	classes instead of the global heap, attributed to a MemoryTag.
+*	The blocks are never moved by the defragmenter. A block keeps
+*	its Handle just before the returned address so deallocation
+*	does not search the pools
+*/
+class PoolMemoryResource : public std::pmr::memory_resource
+{
+public:
+
+	/********************************************************************************
+	*	--- Constructor:
+	*	PoolMemoryResource(MemoryTag)
+	*	This constructor will construct a resource attributing allocation to the tag
+	*
+	*	--- Parameters:
+	*	@ tag: subsystem the memory is attributed to
+	********************************************************************************/
+	explicit PoolMemoryResource(MemoryTag tag = MemoryTag::General)
+		: m_Tag(tag)
+	{}
+
+	/********************************************************************************
+	*	--- Static Function:
+	*	Instance(MemoryTag)
+	*	This function will return the shared resource of the tag
+	*
+	*	--- Parameters:
+	*	@ tag: subsystem the memory is attributed to
+	*
+	*	--- Return:
+	*	@ PoolMemoryResource*: the shared resource
+	********************************************************************************/
+	static PoolMemoryResource* Instance(MemoryTag tag = MemoryTag::General);
+
+private:
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	MemoryTag							m_Tag;			// tag of every allocation
+};
+
+/*
+*	class: ScratchMemoryResource
+*	ScratchMemoryResource is a monotonic resource for short lived
+*	temporary, e.g. strings parsed by a loader. The outermost
+*	scratch resource on a thread bump allocates from the thread's
+*	scratch buffer, nested ones and overflow go to the upstream
+*	resource. Deallocation is a no-op, everything is released when
+*	the resource is destroyed. Must be used on the thread creating it.
+*	The scratch buffer is allocated on first use and kept until the
+*	thread calls ReleaseThreadBuffer()
+*/
+class ScratchMemoryResource : public std::pmr::memory_resource
+{
+public:
+
+	/********************************************************************************
+	*	--- Constructor:
+	*	ScratchMemoryResource(std::pmr::memory_resource*)
+	*	This constructor will claim the thread scratch buffer if it is not in use
+	*
+	*	--- Parameters:
+	*	@ pUpstream: resource used when the scratch buffer is in use or exhausted
+	********************************************************************************/
+	explicit ScratchMemoryResource(std::pmr::memory_resource* pUpstream = PoolMemoryResource::Instance());
+
+	/********************************************************************************
+	*	--- Destructor:
+	*	~ScratchMemoryResource()
+	*	This destructor will release all memory and give back the scratch buffer
+	********************************************************************************/
+	~ScratchMemoryResource();
+
+	/********************************************************************************
+	*	--- Static Function:
+	*	ReleaseThreadBuffer()
+	*	This function will free the scratch buffer of the calling thread, called by
+	*	a thread about to exit (e.g. a JobWorker) while no scratch resource is alive
+	*
+	*	--- Parameters:
+	*	@ void
+	*
+	*	--- Return:
+	*	@ void
+	********************************************************************************/
+	static void ReleaseThreadBuffer();
+
+	ScratchMemoryResource(const ScratchMemoryResource&) = delete;
+	ScratchMemoryResource& operator=(const ScratchMemoryResource&) = delete;
+
+private:
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	bool								m_bOwnScratch;	// whether this resource claimed the thread scratch buffer
+	std::pmr::monotonic_buffer_resource	m_Monotonic;	// bump allocator over the scratch buffer, then upstream
+};
+
+}
@@ -0,0 +1,85 @@
+// MemoryStatistics.h: counters kept by MemoryManager for sizing the memory pools
+#pragma once
+
+// Cpp
+#include <stdint.h>
+#include <stddef.h>
+// Engine
+#include <DECore/Macro/Macro.h>
+#include "MemoryTag.h"
+#include "Handle.h"
+
+namespace DE
+{
+
+/*
+*	STRUCT: PoolStatistics
+*	Counters of one size class, the large object allocator is
+*	reported as an extra size class with block size of 0
+*/
+struct PoolStatistics
+{
+	uint32_t							iBlockSize = 0;			// block size of this size class
+	uint32_t							iBlockNum = 0;			// number of block configured
+	uint32_t							iUsedBlockNum = 0;		// number of block currently in use
+	uint32_t							iPeakUsedBlockNum = 0;	// high watermark of block in use
+	uint64_t							iAllocationNum = 0;		// total number of allocation
+	uint64_t							iFreeNum = 0;			// total number of free
+	uint64_t							iFailedNum = 0;			// number of allocation failed as no block left
+	uint64_t							iRelocatedNum = 0;		// number of block moved by the defragmenter
+	uint64_t							iRequestedBytes = 0;	// bytes requested by live allocation
+	uint64_t							iWastedBytes = 0;		// block bytes not requested by live allocation
+	uint64_t							iPeakWastedBytes = 0;	// high watermark of wasted bytes
+};
+
+/*
+*	STRUCT: TagStatistics
+*	Counters of all allocation attributed to one MemoryTag
+*/
+struct TagStatistics
+{
+	uint64_t							iCurrentBytes = 0;		// block bytes held by live allocation
+	uint64_t							iPeakBytes = 0;			// high watermark of held bytes
+	uint64_t							iAllocationNum = 0;		// total number of allocation
+	uint64_t							iLiveAllocationNum = 0;	// number of live allocation
+	uint64_t							iDeniedNum = 0;			// number of TryAllocate() denied by the budget
+	uint64_t							iOverBudgetNum = 0;		// number of Allocate() let through above the budget
+};
+
+/*
+*	STRUCT: BudgetStatus
+*	Snapshot of the budget of one MemoryTag, cheap enough to query
+*	every frame to throttle streaming
+*/
+struct BudgetStatus
+{
+	uint64_t							iBudgetBytes = 0;		// hard limit, 0 if the tag has no budget
+	uint64_t							iWarningBytes = 0;		// eviction callbacks fire above this
+	uint64_t							iCurrentBytes = 0;		// block bytes held by live allocation
+	uint64_t							iDeniedNum = 0;			// number of TryAllocate() denied by the budget
+	uint64_t							iOverBudgetNum = 0;		// number of Allocate() let through above the budget
+	float								fUsage = 0.0f;			// current bytes over budget bytes, 0 if no budget
+	bool								bWarning = false;		// whether current bytes is above the warning level
+};
+
+/*
+*	STRUCT: AllocationRecord
+*	Book keeping of one live block, so that Free() can undo the
+*	statistics without the caller passing size or tag again,
+*	indexed by the logical block index stored in Handle
+*/
+struct AllocationRecord
+{
+	size_t								iRequestedSize;			// size passed to Allocate()
+	size_t								iBlockSize;				// bytes charged to the tag, the size class or the mapped size of a large object
+	MemoryTag							tag;					// resolved tag of the allocation
+	RelocationCallback					pfnRelocate;			// listener of the block being moved, block is pinned if null
+	void*								pOwner;					// argument passed to pfnRelocate
+#if DE_MEMORY_DEBUG
+	uint32_t							iPayloadOffset;			// size of the front guard band, at least the alignment requested
+	uint32_t							iGeneration;			// bumped on every free, a Handle carrying an older value is stale
+	bool								bLive;					// whether the block is currently allocated
+#endif
+};
+
+}
@@ -0,0 +1,56 @@
+// MemoryTag.h: subsystem tag attached to every allocation for memory statistics
+#pragma once
+
+// Cpp
+#include <stdint.h>
+
+namespace DE
+{
+
+enum class MemoryTag : uint8_t
+{
+	General = 0,
+	Container,
+	Loader,
+	Renderer,
+	Job,
+	Texture,
+	Mesh,
+	FrameData,
+	Count
+};
+
+constexpr const char* MEMORY_TAG_NAMES[] =
+{
+	"General",
+	"Container",
+	"Loader",
+	"Renderer",
+	"Job",
+	"Texture",
+	"Mesh",
+	"FrameData",
+};
+static_assert(sizeof(MEMORY_TAG_NAMES) / sizeof(MEMORY_TAG_NAMES[0]) == static_cast<uint32_t>(MemoryTag::Count), "missing tag name");
+
+/** @brief	RAII scope attributing every allocation made on this thread to a tag,
+*			the scope tag overrides the tag passed to MemoryManager::Allocate so
+*			e.g. a Vector grown inside a loader job counts as Loader instead of
+*			Container. Scopes can be nested, the innermost one wins
+*/
+class MemoryTagScope
+{
+public:
+	explicit MemoryTagScope(MemoryTag tag);
+	~MemoryTagScope();
+	MemoryTagScope(const MemoryTagScope&) = delete;
+	MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+	/** @brief Return the tag of the innermost scope on this thread, General if none */
+	static MemoryTag Current();
+
+private:
+	MemoryTag					m_PreviousTag;
+};
+
+}
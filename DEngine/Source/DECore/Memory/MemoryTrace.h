@@ -0,0 +1,51 @@
+// MemoryTrace.h: file layout of the allocation trace recorded by MemoryManager
+#pragma once
+
+// Cpp
+#include <stdint.h>
+// Engine
+#include "MemoryTag.h"
+
+namespace DE
+{
+
+constexpr uint32_t MEMORY_TRACE_MAGIC = 0x544D4544;	// "DEMT" in little endian
+constexpr uint32_t MEMORY_TRACE_VERSION = 1;		// bumped on every change of MemoryTraceEvent
+
+enum class MemoryTraceOp : uint8_t
+{
+	Allocate = 0,
+	Free
+};
+
+/*
+*	STRUCT: MemoryTraceHeader
+*	Start of a trace file, followed by iEventNum MemoryTraceEvent
+*/
+struct MemoryTraceHeader
+{
+	uint32_t							iMagic;			// MEMORY_TRACE_MAGIC
+	uint32_t							iVersion;		// MEMORY_TRACE_VERSION
+	uint64_t							iEventNum;		// number of event after the header
+};
+
+/*
+*	STRUCT: MemoryTraceEvent
+*	One Allocate() or Free() in the order they took the mutex. The id
+*	is the pool and block index of the Handle, unique among the live
+*	allocations, so a replay can pair a free with its allocation
+*/
+struct MemoryTraceEvent
+{
+	uint64_t							iTimeNs;		// nanoseconds since the trace began
+	uint64_t							iSize;			// requested size, 0 for free
+	uint32_t							iId;			// pool index << 16 | block index of the Handle
+	uint32_t							iThread;		// small index of the calling thread, in order of first event
+	uint16_t							iAlignment;		// requested alignment, 0 for free
+	MemoryTraceOp						op;				// allocate or free
+	MemoryTag							tag;			// resolved tag of the allocation
+	uint32_t							iPadding;		// keeps the file layout free of implicit padding
+};
+static_assert(sizeof(MemoryTraceEvent) == 32, "trace file layout changed, bump MEMORY_TRACE_VERSION");
+
+}
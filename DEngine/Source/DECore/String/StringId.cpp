@@ -0,0 +1,60 @@
+// StringId.cpp
+
+#include <DECore/DECore.h>
+#include "StringId.h"
+
+// Cpp
+#include <assert.h>
+#if DE_STRINGID_DEBUG
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#endif
+
+namespace DE
+{
+
+#if DE_STRINGID_DEBUG
+namespace
+{
+// system heap on purpose, the table outlives MemoryManager::Destruct() as a static
+struct InternTable
+{
+	std::mutex mutex;
+	std::unordered_map<uint64_t, std::string> strings;
+};
+
+InternTable& GetInternTable()
+{
+	static InternTable s_Table;
+	return s_Table;
+}
+}
+#endif
+
+StringId StringId::Intern(std::string_view str)
+{
+	const StringId id(str);
+#if DE_STRINGID_DEBUG
+	InternTable& table = GetInternTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+	auto result = table.strings.emplace(id.m_iHash, std::string(str));
+	assert((result.second || result.first->second == str) && "StringId hash collision");
+#endif
+	return id;
+}
+
+const char* StringId::GetString() const
+{
+#if DE_STRINGID_DEBUG
+	InternTable& table = GetInternTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+	auto it = table.strings.find(m_iHash);
+	// elements of unordered_map are never moved, the pointer stays valid
+	return it == table.strings.end() ? "<unknown>" : it->second.c_str();
+#else
+	return "";
+#endif
+}
+
+}
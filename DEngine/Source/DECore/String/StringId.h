@@ -0,0 +1,104 @@
+// StringId.h: 8 byte hashed string identifier
+#pragma once
+
+// Engine
+#include <DECore/Macro/Macro.h>
+// Cpp
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string_view>
+
+// Reverse lookup of StringId to the original string, on by default in debug build
+#ifndef DE_STRINGID_DEBUG
+#if defined(DEBUG)
+#define DE_STRINGID_DEBUG 1
+#else
+#define DE_STRINGID_DEBUG 0
+#endif
+#endif
+
+namespace DE
+{
+
+/** @brief 64-bit FNV-1a hash of a string, usable at compile time */
+constexpr uint64_t HashString(std::string_view str)
+{
+	uint64_t hashed = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		hashed = (hashed ^ static_cast<uint8_t>(str[i])) * 0x100000001b3ull;
+	}
+	return hashed;
+}
+
+/** @brief	Identifier of a string by its 64-bit FNV-1a hash, so keys are compared as
+*		integers and stored in 8 bytes. Literals are hashed at compile time, e.g.
+*		constexpr StringId ALBEDO("albedo") or "albedo"_sid. Strings known only at
+*		runtime go through Intern(), which in debug build records the string for
+*		GetString() and asserts on hash collision; release build keeps no string
+*/
+class StringId
+{
+public:
+
+	/** @brief Construct an invalid id */
+	constexpr StringId() = default;
+
+	/** @brief	Construct the id of a string without interning, GetString() of it
+	*		returns the string only if the same string was interned
+	*
+	*	@param str: the string
+	*/
+	constexpr explicit StringId(std::string_view str)
+		: m_iHash(HashString(str))
+	{}
+
+	/** @brief	Return the id of a string, recording the string for reverse lookup in
+	*		debug build. Thread safe
+	*
+	*	@param str: the string
+	*	@return StringId: id of the string
+	*/
+	static StringId Intern(std::string_view str);
+
+	/** @brief	Return the interned string of this id, always "" in release build
+	*
+	*	@return const char*: the string, "<unknown>" if never interned
+	*/
+	const char* GetString() const;
+
+	/** @brief Return the hash value */
+	constexpr uint64_t Value() const { return m_iHash; }
+
+	/** @brief Return whether the id is constructed from a string */
+	constexpr bool IsValid() const { return m_iHash != 0; }
+
+	constexpr bool operator==(StringId other) const { return m_iHash == other.m_iHash; }
+	constexpr bool operator!=(StringId other) const { return m_iHash != other.m_iHash; }
+	constexpr bool operator<(StringId other) const { return m_iHash < other.m_iHash; }
+
+private:
+
+	uint64_t						m_iHash = 0;		// FNV-1a of the string, 0 if invalid
+};
+
+/** @brief Compile time StringId of a literal, e.g. "albedo"_sid */
+constexpr StringId operator""_sid(const char* str, size_t len)
+{
+	return StringId(std::string_view(str, len));
+}
+
+}
+
+namespace std
+{
+template <>
+struct hash<DE::StringId>
+{
+	size_t operator()(DE::StringId id) const
+	{
+		return static_cast<size_t>(id.Value());
+	}
+};
+}
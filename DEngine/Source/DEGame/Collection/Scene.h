@@ -1,20 +1,68 @@
 #pragma once
 
 #include <DEGame/DEGame.h>
+#include <DECore/Container/HashMap.h>
 #include <DECore/Container/Vector.h>
+#include <DECore/Math/AABBTree.h>
 #include <DERendering/DataType/LightType.h>
 #include <DERendering/DataType/GraphicsDataType.h>
 #include <functional>
 
-namespace DE 
+namespace DE
 {
 
+/** @brief	World space box of an object for the trees of Scene, false when the object
+*		has no bounds, e.g. a mesh loaded without vertices, so queries always return it
+*/
+template <typename T>
+bool GetWorldBounds(const T& /*obj*/, AABB& /*box*/)
+{
+	return false;
+}
+
+inline bool GetWorldBounds(const Mesh& mesh, AABB& box)
+{
+	if (mesh.m_AABB.IsEmpty())
+	{
+		return false;
+	}
+	// the model space box through the scale and translate of the mesh, a negative scale swaps the corners
+	const Vector3 translate(mesh.translate.x, mesh.translate.y, mesh.translate.z);
+	Vector3 min = mesh.m_AABB.GetMin();
+	Vector3 max = mesh.m_AABB.GetMax();
+	const Vector3 a = min * mesh.scale + translate;
+	const Vector3 b = max * mesh.scale + translate;
+	box = AABB(a, a);
+	box.Merge(b);
+	return true;
+}
+
+inline bool GetWorldBounds(const PointLight& light, AABB& box)
+{
+	const Vector3 position(light.position.x, light.position.y, light.position.z);
+	const Vector3 radius(light.falloffRadius, light.falloffRadius, light.falloffRadius);
+	box = AABB(position - radius, position + radius);
+	return true;
+}
+
+inline bool GetWorldBounds(const QuadLight& light, AABB& box)
+{
+	// the quad is centered at the position on the xy plane, lit up to the falloff radius
+	const Vector3 position(light.position.x, light.position.y, light.position.z);
+	const Vector3 radius(light.falloffRadius, light.falloffRadius, light.falloffRadius);
+	const Vector3 halfSize(light.width * 0.5f, light.height * 0.5f, 0.0f);
+	box = AABB(position - radius, position + radius);
+	box.Merge(AABB(position - halfSize, position + halfSize));
+	return true;
+}
+
 class Scene
 {
 public:
 	Scene()
 	{
 		m_objects.resize(64);
+		m_trees.resize(64);
 	}
 	Scene(const Scene&) = delete;
 	Scene& operator=(const Scene&) = delete;
@@ -23,18 +71,159 @@ public:
 	void Add(const T& obj)
 	{
 		m_objects[T::ObjectId()].push_back(obj.Index());
+		ObjectTree& objectTree = m_trees[T::ObjectId()];
+		AABB box;
+		if (GetWorldBounds(obj, box))
+		{
+			objectTree.proxies.Add(obj.Index(), objectTree.tree.Insert(box, obj.Index()));
+		}
+		else
+		{
+			objectTree.unbounded.push_back(obj.Index());
+		}
+	}
+
+	/** @brief Call after changing the position or the size of an object, so the queries find it */
+	template <typename T>
+	void Move(const T& obj)
+	{
+		ObjectTree& objectTree = m_trees[T::ObjectId()];
+		AABB box;
+		const bool bBounded = GetWorldBounds(obj, box);
+		if (uint32_t* pProxy = objectTree.proxies.Find(obj.Index()))
+		{
+			if (bBounded)
+			{
+				objectTree.tree.Update(*pProxy, box);
+				return;
+			}
+			objectTree.tree.Remove(*pProxy);
+			objectTree.proxies.Remove(obj.Index());
+			objectTree.unbounded.push_back(obj.Index());
+		}
+		else if (bBounded)
+		{
+			eraseUnbounded(objectTree, obj.Index());
+			objectTree.proxies.Add(obj.Index(), objectTree.tree.Insert(box, obj.Index()));
+		}
+	}
+
+	template <typename T>
+	void Remove(const T& obj)
+	{
+		Vector<uint32_t>& objects = m_objects[T::ObjectId()];
+		for (uint32_t i = 0; i < objects.size(); ++i)
+		{
+			if (objects[i] == obj.Index())
+			{
+				objects.erase(objects.begin() + i);
+				break;
+			}
+		}
+		ObjectTree& objectTree = m_trees[T::ObjectId()];
+		if (uint32_t* pProxy = objectTree.proxies.Find(obj.Index()))
+		{
+			objectTree.tree.Remove(*pProxy);
+			objectTree.proxies.Remove(obj.Index());
+		}
+		else
+		{
+			eraseUnbounded(objectTree, obj.Index());
+		}
+	}
+
+	/** @brief Rebuild the tree of a type for the best queries, e.g. after loading or many Move() */
+	template <typename T>
+	void Rebuild()
+	{
+		m_trees[T::ObjectId()].tree.Rebuild();
 	}
+
 	template <typename T>
-	void ForEach(std::function<void(T&)> func) 
+	void ForEach(std::function<void(T&)> func)
 	{
 		for (auto& obj : m_objects[T::ObjectId()])
 		{
-			func(T::Get(obj));
+			// skip objects destroyed after being added
+			if (T* pObj = T::Find(obj))
+			{
+				func(*pObj);
+			}
 		}
 	}
 
+	/** @brief Call func on the objects whose bounds intersect the frustum, plus the objects without bounds */
+	template <typename T>
+	void ForEachInFrustum(const Frustum& frustum, std::function<void(T&)> func)
+	{
+		forEachFound<T>([&](const AABBTree& tree, Vector<uint32_t>& result) { tree.Query(frustum, result); }, func);
+	}
+
+	/** @brief Call func on the objects whose bounds intersect the sphere, plus the objects without bounds */
+	template <typename T>
+	void ForEachInSphere(const Sphere& sphere, std::function<void(T&)> func)
+	{
+		forEachFound<T>([&](const AABBTree& tree, Vector<uint32_t>& result) { tree.Query(sphere, result); }, func);
+	}
+
+	/** @brief Call func on the objects whose bounds intersect the box, plus the objects without bounds */
+	template <typename T>
+	void ForEachInAABB(const AABB& box, std::function<void(T&)> func)
+	{
+		forEachFound<T>([&](const AABBTree& tree, Vector<uint32_t>& result) { tree.Query(box, result); }, func);
+	}
+
+	/** @brief	Call func on the objects whose bounds the segment from origin to origin + direction * fMaxDistance
+	*		hits, plus the objects without bounds
+	*/
+	template <typename T>
+	void ForEachOnRay(const Vector3& origin, const Vector3& direction, float fMaxDistance, std::function<void(T&)> func)
+	{
+		forEachFound<T>([&](const AABBTree& tree, Vector<uint32_t>& result) { tree.RayCast(origin, direction, fMaxDistance, result); }, func);
+	}
+
 private:
+
+	// the objects of one type by bounds, the tree user data is the object index
+	struct ObjectTree
+	{
+		AABBTree tree;
+		HashMap<uint32_t, uint32_t> proxies;	// object index to tree leaf
+		Vector<uint32_t> unbounded;
+	};
+
+	static void eraseUnbounded(ObjectTree& objectTree, uint32_t index)
+	{
+		for (uint32_t i = 0; i < objectTree.unbounded.size(); ++i)
+		{
+			if (objectTree.unbounded[i] == index)
+			{
+				objectTree.unbounded.erase(objectTree.unbounded.begin() + i);
+				return;
+			}
+		}
+	}
+
+	template <typename T, typename Query>
+	void forEachFound(Query&& query, std::function<void(T&)>& func)
+	{
+		const ObjectTree& objectTree = m_trees[T::ObjectId()];
+		m_found.clear();
+		query(objectTree.tree, m_found);
+		m_found.insert(m_found.end(), objectTree.unbounded.begin(), objectTree.unbounded.end());
+		for (uint32_t i = 0; i < m_found.size(); ++i)
+		{
+			// skip objects destroyed after being added
+			if (T* pObj = T::Find(m_found[i]))
+			{
+				func(*pObj);
+			}
+		}
+	}
+
 	Vector<Vector<uint32_t>> m_objects;
+	Vector<ObjectTree> m_trees;
+	Vector<uint32_t> m_found;		// the result of the current query, func must not query the scene again
 };
 
-}
\ No newline at end of file
+}
@@ -79,7 +79,8 @@ public:
 
 		m_mLocalTransform.SetPosition(m_vTranslation);
 
-		m_mView = m_mLocalTransform.Inverse();
+		// rotation and translation only
+		m_mView = m_mLocalTransform.InverseRigid();
 	}
 
 	// view matrix: world to camera
@@ -4,8 +4,12 @@
 #include <DERendering/Device/CopyCommandList.h>
 #include <DERendering/DataType/GraphicsDataType.h>
 #include <DECore/Container/Vector.h>
-#include <DECore/Container/HashMap.h>
+#include <DECore/Container/FlatMap.h>
+#include <DECore/Container/StableVector.h>
 #include <DECore/Job/JobScheduler.h>
+#include <DECore/Memory/MemoryTag.h>
+#include <DECore/Memory/MemoryResource.h>
+#include <DECore/String/StringId.h>
 
 #include "SceneLoader.h"
 #include "TextureLoader.h"
@@ -33,6 +37,7 @@ struct LoadToMaterialsData
 
 void LoadToMaterials(void *data)
 {
+	MemoryTagScope memoryScope(MemoryTag::Loader);
 	char tmp[256] = {};
 	LoadToMaterialsData *pData = reinterpret_cast<LoadToMaterialsData *>(data);
 	CopyCommandList &pCommandList = *pData->pCopyCommandList;
@@ -52,9 +57,10 @@ void LoadToMaterials(void *data)
 	uint32_t numTexture = 0;
 	fin >> numTexture;
 
+	ScratchMemoryResource scratch(PoolMemoryResource::Instance(MemoryTag::Loader));
+	std::pmr::string texturePath(&scratch);
 	for (uint32_t i = 0; i < ARRAYSIZE(mat.m_Textures); ++i)
 	{
-		std::string texturePath;
 		fin >> texturePath;
 		if (texturePath == "null")
 		{
@@ -80,17 +86,18 @@ struct LoadToMeshesData
 {
 	char path[256];
 	Mesh *pMesh;
-	HashMap<uint32_t> *pMatToID;
+	FlatMap<StringId, uint32_t> *pMatToID;
 	RenderDevice *pDevice;
 };
 
 void LoadToMeshes(void *data)
 {
+	MemoryTagScope memoryScope(MemoryTag::Mesh);
 	char tmp[256] = {};
 	LoadToMeshesData *pData = reinterpret_cast<LoadToMeshesData *>(data);
 	std::ifstream fin;
 	Mesh &mesh = *pData->pMesh;
-	HashMap<uint32_t> &matToID = *pData->pMatToID;
+	const FlatMap<StringId, uint32_t> &matToID = *pData->pMatToID;
 	uint32_t num;
 
 	// vertices
@@ -112,6 +119,28 @@ void LoadToMeshes(void *data)
 		mesh.m_Vertices.Update(vertices.data(), vertices.size() * sizeof(float3));
 
 		mesh.m_iNumVertices = vertices.size();
+
+		// bounds, computed here for meshes exported without them
+		sprintf(tmp, "%s.bounds", pData->path);
+		fin.open(tmp, std::fstream::in);
+		if (!fin.fail())
+		{
+			float min[3], max[3], center[3], radius;
+			fin >> min[0] >> min[1] >> min[2];
+			fin >> max[0] >> max[1] >> max[2];
+			fin >> center[0] >> center[1] >> center[2] >> radius;
+			fin.close();
+
+			mesh.m_AABB = AABB(Vector3(min[0], min[1], min[2]), Vector3(max[0], max[1], max[2]));
+			mesh.m_BoundingSphere = Sphere(Vector3(center[0], center[1], center[2]), radius);
+		}
+		else if (num > 0)
+		{
+			static_assert(sizeof(float3) == sizeof(float) * 3, "vertices are read as packed x, y, z");
+			const float* positions = &vertices[0].x;
+			mesh.m_AABB = AABB::FromPoints(positions, num);
+			mesh.m_BoundingSphere = Sphere::FromPoints(positions, num);
+		}
 	}
 
 	// normals
@@ -205,35 +234,43 @@ void LoadToMeshes(void *data)
 	fin.open(tmp, std::fstream::in);
 	assert(!fin.fail());
 
-	std::string materialName;
+	ScratchMemoryResource scratch(PoolMemoryResource::Instance(MemoryTag::Loader));
+	std::pmr::string materialName(&scratch);
 	fin >> materialName;
-	mesh.m_MaterialID = matToID[materialName.c_str()];
+	const uint32_t* pMaterialID = matToID.Find(StringId(materialName));
+	assert(pMaterialID && "material is not listed in the scene");
+	mesh.m_MaterialID = *pMaterialID;
 	fin.close();
 }
 
 void SceneLoader::Load(const char *sceneName, Scene &scene)
 {
+	MemoryTagScope memoryScope(MemoryTag::Loader);
 	char path[256];
 	std::fstream fin;
 
 	sprintf(path, "%s\\%s\\%s.scene", m_sRootPath.c_str(), sceneName, sceneName);
 	fin.open(path, std::fstream::in);
-	HashMap<uint32_t> materialToID(512);
+	// written once here, then read by every mesh job
+	FlatMap<StringId, uint32_t> materialToID;
 
 	// material
 	uint32_t numMat = 0;
 	fin >> numMat;
+	materialToID.Reserve(numMat);
 	Vector<Job::Desc> matJobDescs;
 	matJobDescs.reserve(numMat);
-	Vector<CopyCommandList> commandLists;
-	commandLists.reserve(numMat);
+	// jobs keep pointers to their command list, the elements must never move
+	StableVector<CopyCommandList> commandLists;
 	TextureLoader texLoader(m_pRenderDevice);
+	ScratchMemoryResource scratch(PoolMemoryResource::Instance(MemoryTag::Loader));
+	std::pmr::string name(&scratch);
 	for (uint32_t i = 0; i < numMat; ++i)
 	{
-		std::string name;
 		fin >> name;
+		const StringId nameId = StringId::Intern(name);
 
-		if (!materialToID.Contain(name.c_str()))
+		if (!materialToID.Contain(nameId))
 		{
 			LoadToMaterialsData *data = new LoadToMaterialsData();
 			sprintf(data->path, "%s\\%s\\Materials\\", m_sRootPath.c_str(), sceneName);
@@ -241,13 +278,12 @@ void SceneLoader::Load(const char *sceneName, Scene &scene)
 			const uint32_t index = Material::Create().Index();
 			data->pMaterial = &Material::Get(index);
 			data->pDevice = m_pRenderDevice;
-			commandLists.emplace_back(m_pRenderDevice);
-			data->pCopyCommandList = &commandLists.back();
+			data->pCopyCommandList = &commandLists.emplace_back(m_pRenderDevice);
 			data->pTexLoader = &texLoader;
 			Job::Desc desc(&LoadToMaterials, data, nullptr);
 			matJobDescs.push_back(std::move(desc));
 
-			materialToID.Add(name.c_str(), index);
+			materialToID.Add(nameId, index);
 		}
 	}
 	auto *loadMatCounter = JobScheduler::Instance()->Run(matJobDescs);
@@ -257,9 +293,9 @@ void SceneLoader::Load(const char *sceneName, Scene &scene)
 	uint32_t numModel = 0;
 	fin >> numModel;
 	Vector<Job::Desc> jobDescs(numModel);
+	Vector<uint32_t> meshes(numModel);
 	for (uint32_t i = 0; i < numModel; ++i)
 	{
-		std::string name;
 		fin >> name;
 
 		char fileName[256];
@@ -273,15 +309,23 @@ void SceneLoader::Load(const char *sceneName, Scene &scene)
 		data->pMatToID = &materialToID;
 		Job::Desc desc(&LoadToMeshes, data, nullptr);
 		jobDescs[i] = std::move(desc);
-
-		scene.Add(*data->pMesh);
+		meshes[i] = index;
 	}
 	fin.close();
 
 	auto *loadMeshCounter = JobScheduler::Instance()->Run(jobDescs);
 	JobScheduler::Instance()->WaitOnMainThread(loadMeshCounter);
 
-	m_pRenderDevice->Submit(commandLists.data(), static_cast<uint32_t>(commandLists.size()));
+	// added with their bounds loaded, then the tree is built once for the whole scene
+	for (uint32_t index : meshes)
+	{
+		scene.Add(Mesh::Get(index));
+	}
+	scene.Rebuild<Mesh>();
+
+	commandLists.ForEachChunk([&](CopyCommandList* pCommandLists, uint32_t num) {
+		m_pRenderDevice->Submit(pCommandLists, num);
+	});
 	m_pRenderDevice->Execute();
 	m_pRenderDevice->WaitForIdle();
 }
@@ -5,6 +5,7 @@
 #include <DERendering/DataType/GraphicsDataType.h>
 #include <DECore/Container/Vector.h>
 #include <DECore/Job/JobScheduler.h>
+#include <DECore/Memory/MemoryManager.h>
 
 #include "TextureLoader.h"
 
@@ -29,13 +30,80 @@ uint32_t GetPitch(DXGI_FORMAT format)
 }
 
 
+struct TextureLoader::CachedTexture
+{
+	enum State : uint32_t
+	{
+		LOADING, READY, FAILED
+	};
+
+	CachedTexture()
+	{
+		counter.m_iUnfinished = 1;
+	}
+
+	std::atomic<uint32_t> state = { LOADING };
+	Job counter;		// unfinished while a job loads the texture, for the others to wait on
+	Texture texture;
+};
+
 TextureLoader::TextureLoader(RenderDevice* device)
+	: m_Cache(256)
 {
 	m_pRenderDevice = device;
 }
 
+TextureLoader::~TextureLoader() = default;
+
 void TextureLoader::Load(CopyCommandList & commandList, Texture & texture, const char * path, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flag)
 {
+	const auto result = m_Cache.FindOrInsert(CacheKey{ StringId(path), format, flag });
+	CachedTexture& cached = *result.first;
+	if (!result.second)
+	{
+		uint32_t state = cached.state.load(std::memory_order_acquire);
+		bool bClaimed = false;
+		while (!bClaimed && state != CachedTexture::READY)
+		{
+			if (state == CachedTexture::FAILED)
+			{
+				// a failed load is tried again by the first job to claim it
+				bClaimed = cached.state.compare_exchange_strong(state, CachedTexture::LOADING, std::memory_order_acquire);
+			}
+			else
+			{
+				// the counter is raised only after the claim, so it may still read finished, the state decides
+				// the upload is recorded in the command list of the loading job, all are submitted together
+				JobScheduler::Instance()->WaitOnMainThread(&cached.counter);
+				state = cached.state.load(std::memory_order_acquire);
+				if (state == CachedTexture::FAILED)
+				{
+					// the texture stays empty so the material falls back, a later load tries again
+					return;
+				}
+			}
+		}
+		if (!bClaimed)
+		{
+			texture = cached.texture;
+			return;
+		}
+		cached.counter.m_iUnfinished = 1;
+	}
+
+	const bool bLoaded = load(commandList, texture, path, format, flag);
+	if (bLoaded)
+	{
+		cached.texture = texture;
+	}
+	// the counter drops before the state is published, a job claiming a failed entry raises it again
+	cached.counter.m_iUnfinished = 0;
+	cached.state.store(bLoaded ? CachedTexture::READY : CachedTexture::FAILED, std::memory_order_release);
+}
+
+bool TextureLoader::load(CopyCommandList & commandList, Texture & texture, const char * path, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flag)
+{
+	MemoryTagScope memoryScope(MemoryTag::Texture);
 	std::ifstream fin;
 	fin.open(path, std::ifstream::in | std::ifstream::binary);
 	assert(!fin.fail());
@@ -48,7 +116,15 @@ void TextureLoader::Load(CopyCommandList & commandList, Texture & texture, const
 	fin.read(reinterpret_cast<char*>(&numComponent), sizeof(numComponent));
 	fin.read(reinterpret_cast<char*>(&numMip), sizeof(numMip));
 	fin.read(reinterpret_cast<char*>(&size), sizeof(size));
-	char* data = new char[size];
+	// staging copy, large texture goes to the huge page backed large object allocator
+	Handle hData = MemoryManager::GetInstance()->TryAllocate(size, MEMORY_ALIGNMENT, MemoryTag::Texture);
+	char* data = reinterpret_cast<char*>(hData.Raw());
+	if (!data)
+	{
+		// texture budget exhausted even after eviction, leave the texture empty so the material falls back
+		fin.close();
+		return false;
+	}
 	fin.read(data, size);
 
 	assert(numComponent == 4);
@@ -82,7 +158,8 @@ void TextureLoader::Load(CopyCommandList & commandList, Texture & texture, const
 
 	commandList.GetCommandList().ptr->ResourceBarrier(1, &barrier);
 
-	delete data;
+	hData.Free();
+	return true;
 }
 
 void TextureLoader::Load(Texture& texture, const char* path, DXGI_FORMAT format/* = DXGI_FORMAT_R8G8B8A8_UNORM*/, D3D12_RESOURCE_FLAGS flag /*= D3D12_RESOURCE_FLAG_NONE*/)
@@ -2,6 +2,8 @@
 
 // Engine
 #include <DEGame/DEGame.h>
+#include <DECore/Container/ConcurrentHashMap.h>
+#include <DECore/String/StringId.h>
 // Cpp
 #include <string>
 
@@ -18,6 +20,14 @@ class TextureLoader
 public:
 
 	TextureLoader(RenderDevice* device);
+	~TextureLoader();
+
+	/** @brief	Load a texture file, thread safe. A path loaded before by this loader with the
+	*		same format and flags is shared instead of decoded again, a job asking for a
+	*		texture another job is loading runs other jobs until it is done. A load that
+	*		failed, e.g. over the texture budget, leaves the texture empty and is tried
+	*		again by the next call
+	*/
 	void Load(CopyCommandList& commandList, Texture& texture, const char* path, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM, D3D12_RESOURCE_FLAGS flag = D3D12_RESOURCE_FLAG_NONE);
 	void Load(Texture& texture, const char* path, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM, D3D12_RESOURCE_FLAGS flag = D3D12_RESOURCE_FLAG_NONE);
 
@@ -25,7 +35,33 @@ public:
 
 private:
 
+	struct CacheKey
+	{
+		bool operator==(const CacheKey& other) const
+		{
+			return path == other.path && format == other.format && flag == other.flag;
+		}
+
+		StringId path;
+		DXGI_FORMAT format;
+		D3D12_RESOURCE_FLAGS flag;
+	};
+
+	struct CacheKeyHash
+	{
+		size_t operator()(const CacheKey& key) const
+		{
+			return DefaultHash<uint64_t>()(key.path.Value() ^ (static_cast<uint64_t>(key.format) << 32 | static_cast<uint64_t>(key.flag)));
+		}
+	};
+
+	struct CachedTexture;
+
+	/** @return false if the texture could not be loaded, it is left empty */
+	bool load(CopyCommandList& commandList, Texture& texture, const char* path, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flag);
+
 	RenderDevice* m_pRenderDevice;
+	ConcurrentHashMap<CacheKey, CachedTexture, CacheKeyHash> m_Cache;		// loaded textures by path, format and flags
 };
 
 }
\ No newline at end of file
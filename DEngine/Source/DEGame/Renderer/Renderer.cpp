@@ -3,14 +3,43 @@
 #include <DERendering/Device/RenderDevice.h>
 #include <DEGame/Loader/TextureLoader.h>
 #include <DEGame/Component/Camera.h>
+#include <DECore/Memory/MemoryTag.h>
+#include <DERendering/DataType/LightType.h>
 // Windows
 #include <DXProgrammableCapture.h>
+// Cpp
+#include <algorithm>
 
 namespace DE
 {
 
+namespace
+{
+/** @brief Keep the maxNum lights nearest to the eye, return the number of lights dropped */
+template <class Light>
+uint32_t KeepNearestLights(Vector<uint32_t>& lights, uint32_t maxNum, const Vector3& eye)
+{
+	if (lights.size() <= maxNum)
+	{
+		return 0;
+	}
+	auto distanceSquared = [&eye](uint32_t index) {
+		const float3& pos = Light::Get(index).position;
+		const float dx = pos.x - eye.GetX(), dy = pos.y - eye.GetY(), dz = pos.z - eye.GetZ();
+		return dx * dx + dy * dy + dz * dz;
+	};
+	std::partial_sort(lights.begin(), lights.begin() + maxNum, lights.end(), [&](uint32_t a, uint32_t b) {
+		return distanceSquared(a) < distanceSquared(b);
+	});
+	const uint32_t dropped = static_cast<uint32_t>(lights.size()) - maxNum;
+	lights.resize(maxNum);
+	return dropped;
+}
+}
+
 void Renderer::Init(const Desc& desc)
 {
+	MemoryTagScope memoryScope(MemoryTag::Renderer);
 	RenderDevice::Desc rdDesc = {};
 	rdDesc.hWnd_ = desc.hWnd;
 	rdDesc.windowWidth_ = desc.windowWidth;
@@ -139,10 +168,11 @@ void Renderer::Init(const Desc& desc)
 
 void Renderer::Update(float dt)
 {
+	MemoryTagScope memoryScope(MemoryTag::FrameData);
 	m_Camera.ParseInput(dt);
 
 	// Prepare frame data
-	m_scene.ForEach<Mesh>([&](Mesh& mesh) {
+	auto addMesh = [&](const Mesh& mesh) {
 		const auto type = Material::Get(mesh.m_MaterialID).shadingType;
 		if (type == ShadingType::NoNormalMap)
 		{
@@ -156,8 +186,12 @@ void Renderer::Update(float dt)
 		{
 			m_frameData.batcher.Add(MaterialMeshBatcher::Flag::Unlit, mesh);
 		}
-	});
-	m_scene.ForEach<PointLight>([&](PointLight& light) {
+	};
+
+	// Frustum culling, the scene trees only walk the branches the camera sees
+	const Frustum frustum = Frustum::FromViewProjection(m_Camera.GetCameraToScreen());
+	m_scene.ForEachInFrustum<Mesh>(frustum, addMesh);
+	m_scene.ForEachInFrustum<PointLight>(frustum, [&](PointLight& light) {
 		if (light.enable)
 		{
 			m_frameData.pointLights.push_back(light.Index());
@@ -167,7 +201,7 @@ void Renderer::Update(float dt)
 			}
 		}
 	});
-	m_scene.ForEach<QuadLight>([&](QuadLight& light) {
+	m_scene.ForEachInFrustum<QuadLight>(frustum, [&](QuadLight& light) {
 		if (light.enable)
 		{
 			m_frameData.quadLights.push_back(light.Index());
@@ -181,6 +215,10 @@ void Renderer::Update(float dt)
 	m_frameData.camera.projection = m_Camera.GetP();
 	m_frameData.camera.pos = m_Camera.GetPosition();
 
+	// the light passes hold a fixed number of lights, the farthest ones beyond are left out and counted
+	m_frameData.droppedLightNum = KeepNearestLights<PointLight>(m_frameData.pointLights, MAX_POINT_LIGHT_NUM, m_frameData.camera.pos)
+		+ KeepNearestLights<QuadLight>(m_frameData.quadLights, MAX_QUAD_LIGHT_NUM, m_frameData.camera.pos);
+
 	const auto& clusteringPassData = m_clusterLightPass.GetData();
 	m_frameData.clusteringInfo.clusterSize = clusteringPassData.clusterSize;
 	m_frameData.clusteringInfo.numCluster = { clusteringPassData.resolutionX / clusteringPassData.clusterSize, clusteringPassData.resolutionY / clusteringPassData.clusterSize };
@@ -234,6 +272,8 @@ void Renderer::Destruct()
 	Texture::ReleaseDefault();
 	Material::Release();
 	Mesh::Release();
+	PointLight::Release();
+	QuadLight::Release();
 }
 
 }
\ No newline at end of file
@@ -45,6 +45,11 @@ public:
 		return m_scene;
 	}
 
+	const FrameData& GetFrameData() const
+	{
+		return m_frameData;
+	}
+
 private:
 	Desc m_Desc;
 	RenderDevice m_RenderDevice;
@@ -5,6 +5,7 @@
 
 #include <DERendering\DataType\GraphicsResourceType.h>
 #include <DERendering\DataType\Pool.h>
+#include <DECore/Math/BoundingVolume.h>
 
 namespace DE
 {
@@ -68,12 +69,14 @@ struct MaterialParameter
 	float4 params[2];
 };
 
-struct Material final : public Pool<Material, 512>
+struct Material final : public Pool<Material>
 {
 	Material() = default;
 	~Material() = default;
 	Material(const Material&) = delete;
 	Material& operator=(const Material&) = delete;
+	Material(Material&&) = default;
+	Material& operator=(Material&&) = default;
 
 	ShadingType shadingType;
 	Texture m_Textures[5] = {};
@@ -86,7 +89,7 @@ struct Material final : public Pool<Material, 512>
 };
 
 /**	@brief Contains vertex and index buffer of a mesh*/
-struct Mesh final : public Pool<Mesh, 512>
+struct Mesh final : public Pool<Mesh>
 {
 public:
 	VertexBuffer m_Vertices;
@@ -101,6 +104,10 @@ public:
 
 	float scale = 1.0f;
 	float3 translate;
+
+	// in model space, before scale and translate
+	AABB m_AABB;
+	Sphere m_BoundingSphere;
 };
 
 }
\ No newline at end of file
@@ -8,7 +8,7 @@ namespace DE
 {
 
 /**	@brief Contains point light definition*/
-struct PointLight final : public Pool<PointLight, 64>
+struct PointLight final : public Pool<PointLight>
 {
 public:
 	bool enable;
@@ -20,7 +20,7 @@ public:
 	uint32_t debugMesh;
 };
 
-struct QuadLight final : public Pool<QuadLight, 8>
+struct QuadLight final : public Pool<QuadLight>
 {
 public:
 	bool enable;
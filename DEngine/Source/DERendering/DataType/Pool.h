@@ -1,8 +1,9 @@
 #pragma once
 
+// Engine
+#include <DECore/Container/SlotMap.h>
 // Cpp
 #include <cassert>
-#include <atomic>
 
 namespace DE
 {
@@ -12,7 +13,13 @@ namespace detail
 	static uint32_t id = 0;
 }
 
-template <class T, uint32_t N>
+/** @brief	T is the class of the pooled object, derived from Pool<T>
+*		The objects are stored in a SlotMap and referred by the uint32_t of their
+*		SlotMapHandle, a destroyed object's id is detected as stale by Get() and
+*		Find(). Create and Destroy are main thread only, a reference to an object
+*		is stable until an object of the same type is destroyed
+*/
+template <class T>
 class Pool
 {
 public:
@@ -23,28 +30,41 @@ public:
 
 	static T& Create()
 	{
-		uint32_t i = m_iCount.fetch_add(1);
-		m_Objects[i].m_iIndex = i;
-		return Get(i);
+		SlotMapHandle handle = m_Objects.Add();
+		T& obj = m_Objects[handle];
+		obj.m_iIndex = handle.Value();
+		return obj;
+	}
+
+	static void Destroy(uint32_t i)
+	{
+		m_Objects.Remove(SlotMapHandle::FromValue(i));
 	}
 
 	static void Release()
 	{
-		for (const auto& obj : m_Objects)
-		{
-			obj.~T();
-		}
+		m_Objects = SlotMap<T>();
 	}
 
 	static T& Get(uint32_t i)
 	{
-		assert(i < m_iCount);
-		return m_Objects[i];
+		return m_Objects[SlotMapHandle::FromValue(i)];
+	}
+
+	static T* Find(uint32_t i)
+	{
+		return m_Objects.Find(SlotMapHandle::FromValue(i));
 	}
 
 	static uint32_t Size()
 	{
-		return N;
+		return m_Objects.Size();
+	}
+
+	template <class Func>
+	static void ForEach(Func&& func)
+	{
+		m_Objects.ForEachItem(std::forward<Func>(func));
 	}
 
 	uint32_t Index() const
@@ -53,15 +73,13 @@ public:
 	}
 
 private:
-	static T m_Objects[N];
-	static std::atomic_uint32_t m_iCount;
+	static SlotMap<T> m_Objects;
 	static uint32_t m_iID;
 
 	uint32_t m_iIndex;
 };
 
-template <class T, uint32_t N> T Pool<T, N>::m_Objects[N];
-template <class T, uint32_t N> std::atomic_uint32_t Pool<T, N>::m_iCount = 0;
-template <class T, uint32_t N> uint32_t Pool<T, N>::m_iID = detail::id++;
+template <class T> SlotMap<T> Pool<T>::m_Objects;
+template <class T> uint32_t Pool<T>::m_iID = detail::id++;
 
 }
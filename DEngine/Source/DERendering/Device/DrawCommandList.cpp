@@ -1,5 +1,6 @@
 #include <DERendering/DataType/GraphicsResourceType.h>
 #include <DERendering/Device/RenderDevice.h>
+#include <DECore/Container/SmallVector.h>
 #include "DrawCommandList.h"
 
 namespace DE
@@ -63,13 +64,12 @@ void DrawCommandList::SetScissorRect(uint32_t left, uint32_t top, uint32_t right
 
 void DrawCommandList::SetVertexBuffers(const VertexBuffer* buffers, uint32_t num)
 {
-	Vector<D3D12_VERTEX_BUFFER_VIEW> views(num);
+	SmallVector<D3D12_VERTEX_BUFFER_VIEW, 8> views(num);
 	for (uint32_t i = 0; i < num; ++i)
 	{
 		views[i] = buffers[i].view;
 	}
 	m_CommandList.ptr->IASetVertexBuffers(0, num, views.data());
-
 }
 
 void DrawCommandList::SetIndexBuffer(const IndexBuffer& buffer)
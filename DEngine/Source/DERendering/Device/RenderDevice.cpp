@@ -73,7 +73,6 @@ bool RenderDevice::Init(const Desc& desc)
 	// common upload buffer
 	m_UploadBufferPool.Init(this, D3D12_HEAP_TYPE_UPLOAD, 512 * 1024, 1);
 
-	m_ppCommandLists.reserve(256);
 	adapter->Release();
 
 	return true;
@@ -90,35 +89,50 @@ void RenderDevice::Reset()
 
 void RenderDevice::Submit(const CopyCommandList* commandLists, uint32_t num)
 {
-	std::lock_guard<std::mutex> lock(m_mutex);
-
 	for (uint32_t cnt = 0; cnt < num; ++cnt)
 	{
 		HRESULT hr = commandLists[cnt].GetCommandList().ptr->Close();
 		assert(hr == S_OK);
-		m_ppCommandLists.push_back(static_cast<ID3D12CommandList*>(commandLists[cnt].GetCommandList().ptr));
+		enqueue(static_cast<ID3D12CommandList*>(commandLists[cnt].GetCommandList().ptr));
 	}
 }
 
 void RenderDevice::Submit(const DrawCommandList* commandLists, uint32_t num)
 {
-	std::lock_guard<std::mutex> lock(m_mutex);
-
 	for (uint32_t cnt = 0; cnt < num; ++cnt)
 	{
 		HRESULT hr = commandLists[cnt].GetCommandList().ptr->Close();
 		assert(hr == S_OK);
-		m_ppCommandLists.push_back(static_cast<ID3D12CommandList*>(commandLists[cnt].GetCommandList().ptr));
+		enqueue(static_cast<ID3D12CommandList*>(commandLists[cnt].GetCommandList().ptr));
+	}
+}
+
+void RenderDevice::enqueue(ID3D12CommandList* pCommandList)
+{
+	// a full queue is sent to the GPU early rather than dropping the list
+	while (!m_CommandLists.TryEnqueue(pCommandList))
+	{
+		flush();
+	}
+}
+
+void RenderDevice::flush()
+{
+	// one thread at a time, so the batches reach the render queue in the order they were dequeued
+	std::lock_guard<std::mutex> lock(m_FlushMutex);
+	ID3D12CommandList* ppCommandLists[COMMAND_LIST_QUEUE_SIZE];
+	const uint32_t num = m_CommandLists.DequeueBatch(ppCommandLists, COMMAND_LIST_QUEUE_SIZE);
+	if (num > 0)
+	{
+		m_RenderQueue.ptr->ExecuteCommandLists(num, ppCommandLists);
 	}
 }
 
 void RenderDevice::Execute()
 {
-	m_RenderQueue.ptr->ExecuteCommandLists(static_cast<uint32_t>(m_ppCommandLists.size()), m_ppCommandLists.data());
+	flush();
 	m_RenderQueue.ptr->Signal(m_Fence.ptr, ++m_FenceValue);
 
-	m_ppCommandLists.clear();
-
 	Reset();
 }
 
@@ -127,11 +141,9 @@ void RenderDevice::ExecuteAndPresent()
 	// wait for swapchain
 	auto result = WaitForSingleObject(m_SwapChain.waitable, INFINITE);
 
-	m_RenderQueue.ptr->ExecuteCommandLists(m_ppCommandLists.size(), m_ppCommandLists.data());
+	flush();
 	m_RenderQueue.ptr->Signal(m_Fence.ptr, ++m_FenceValue);
 
-	m_ppCommandLists.clear();
-
 	m_SwapChain.ptr->Present(1, 0);
 
 	Reset();
@@ -10,7 +10,7 @@
 #include <DERendering/DataType/GraphicsViewType.h>
 #include <DERendering/Device/DescriptorHeapRing.h>
 #include <DERendering/Device/GpuBufferFencedPool.h>
-#include <DECore/Container/Vector.h>
+#include <DECore/Container/RingBuffer.h>
 // C++
 #include <mutex>
 
@@ -50,7 +50,8 @@ public:
 	/** @brief Reset any memory pointer or state */
 	void Reset();
 
-	/** @brief Submit command lists to a internal list
+	/** @brief Submit command lists to a internal list, from any thread. When the list is
+	*		full the lists queued so far are executed early, in the order submitted
 	*
 	*	@param commandLists
 	*	@param num
@@ -92,8 +93,17 @@ public:
 
 	GpuBufferFencedPool			m_UploadBufferPool;
 
-	std::mutex					m_mutex;
-	Vector<ID3D12CommandList*>	m_ppCommandLists;
+	static constexpr uint32_t	COMMAND_LIST_QUEUE_SIZE = 1024;
+	MPMCRingBuffer<ID3D12CommandList*, COMMAND_LIST_QUEUE_SIZE>	m_CommandLists;	// closed command lists submitted from any thread
+	std::mutex					m_FlushMutex;	// taken only to send the queued lists to the render queue
+
+private:
+
+	/** @brief Queue a closed command list, flushing the queue while it is full */
+	void enqueue(ID3D12CommandList* pCommandList);
+
+	/** @brief Execute the queued command lists on the render queue, without signaling the fence */
+	void flush();
 };
 
 };
\ No newline at end of file
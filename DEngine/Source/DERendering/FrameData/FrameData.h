@@ -9,6 +9,9 @@
 namespace DE
 {
 
+constexpr uint32_t MAX_POINT_LIGHT_NUM = 8;		// size of the point light array in the per view constants of the light passes
+constexpr uint32_t MAX_QUAD_LIGHT_NUM = 8;		// size of the quad light array in the per view constants of the light passes
+
 class FrameData
 {
 
@@ -17,9 +20,20 @@ class FrameData
 public:
 	FrameData() = default;
 
+	/** @brief	Return the number of lights to copy into a per view constant array of maxNum lights.
+	*		The renderer keeps at most MAX_POINT_LIGHT_NUM and MAX_QUAD_LIGHT_NUM lights, so a light
+	*		can only be dropped here by a pass with a smaller array, which asserts
+	*/
+	static uint32_t GetLightNum(const Vector<uint32_t>& lights, uint32_t maxNum)
+	{
+		assert(lights.size() <= maxNum && "lights dropped, the constant array is smaller than the frame limit");
+		return static_cast<uint32_t>(lights.size() < maxNum ? lights.size() : maxNum);
+	}
+
 	MaterialMeshBatcher batcher;
-	Vector<uint32_t> pointLights;
-	Vector<uint32_t> quadLights;
+	Vector<uint32_t> pointLights;		// at most MAX_POINT_LIGHT_NUM, the nearest to the camera
+	Vector<uint32_t> quadLights;		// at most MAX_QUAD_LIGHT_NUM, the nearest to the camera
+	uint32_t droppedLightNum = 0;		// lights in the frustum left out as the farthest beyond the limits
 
 	struct
 	{
@@ -112,7 +112,7 @@ void ClusterLightPass::Execute(DrawCommandList & commandList, const FrameData &
 			float falloffRadius;
 			float3 color;
 			float intensity;
-		} pointLights[8];
+		} pointLights[MAX_POINT_LIGHT_NUM];
 		struct
 		{
 			float4 vertices[4];
@@ -120,13 +120,13 @@ void ClusterLightPass::Execute(DrawCommandList & commandList, const FrameData &
 			float intensity;
 			float falloffRadius;
 			float3 centerWS;
-		} quadLights[8];
+		} quadLights[MAX_QUAD_LIGHT_NUM];
 	};
 	auto perViewConstants = RenderHelper::AllocateConstant<PerView>(m_pDevice, 1);
 
 	perViewConstants->viewMatrix = frameData.camera.view;
-	const uint32_t numPointLights = static_cast<uint32_t>(frameData.pointLights.size());
-	const uint32_t numQuadLights = static_cast<uint32_t>(frameData.quadLights.size());
+	const uint32_t numPointLights = FrameData::GetLightNum(frameData.pointLights, ARRAYSIZE(perViewConstants->pointLights));
+	const uint32_t numQuadLights = FrameData::GetLightNum(frameData.quadLights, ARRAYSIZE(perViewConstants->quadLights));
 	perViewConstants->eyePosWS = frameData.camera.pos;
 	perViewConstants->numPointLights = numPointLights;
 	for (uint32_t i = 0; i < numPointLights; ++i)
@@ -145,7 +145,7 @@ void ForwardPass::Execute(DrawCommandList &commandList, const FrameData &frameDa
 			float falloffRadius;
 			float3 color;
 			float intensity;
-		} pointLights[8];
+		} pointLights[MAX_POINT_LIGHT_NUM];
 		struct
 		{
 			float4 vertices[4];
@@ -153,7 +153,7 @@ void ForwardPass::Execute(DrawCommandList &commandList, const FrameData &frameDa
 			float intensity;
 			float falloffRadius;
 			float3 centerWS;
-		} quadLights[8];
+		} quadLights[MAX_QUAD_LIGHT_NUM];
 		struct
 		{
 			float zNear;
@@ -168,8 +168,8 @@ void ForwardPass::Execute(DrawCommandList &commandList, const FrameData &frameDa
 	auto perObjectConstants = RenderHelper::AllocateConstant<PerObject>(m_pDevice, totalMeshNum);
 	auto perMaterialConstants = RenderHelper::AllocateConstant<MaterialParameter>(m_pDevice, totalMeshNum);
 
-	const uint32_t numPointLights = static_cast<uint32_t>(frameData.pointLights.size());
-	const uint32_t numQuadLights = static_cast<uint32_t>(frameData.quadLights.size());
+	const uint32_t numPointLights = FrameData::GetLightNum(frameData.pointLights, ARRAYSIZE(perViewConstants->pointLights));
+	const uint32_t numQuadLights = FrameData::GetLightNum(frameData.quadLights, ARRAYSIZE(perViewConstants->quadLights));
 	perViewConstants->viewMatrix = frameData.camera.view;
 	perViewConstants->eyePosWS = { frameData.camera.pos.GetX(), frameData.camera.pos.GetY(), frameData.camera.pos.GetZ() };
 	perViewConstants->numPointLights = numPointLights;
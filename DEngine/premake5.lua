@@ -13,6 +13,13 @@ project "DECore"
 		"Source/DECore/**.natvis",
 	}
 
+	-- batch kernels of wider instruction sets, only called after a CPUID check
+	filter "files:Source/DECore/**AVX2.cpp"
+		buildoptions { "/arch:AVX2" }
+
+	filter "files:Source/DECore/**AVX512.cpp"
+		buildoptions { "/arch:AVX512" }
+
 	filter "configurations:Debug"
 		defines { "DEBUG" }
 		targetdir "Bin/Debug"
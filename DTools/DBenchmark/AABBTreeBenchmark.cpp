@@ -0,0 +1,296 @@
+// AABBTreeBenchmark.cpp: scene queries over 50k boxes, linear scans against AABBTree
+//
+// The boxes are spread in a cube of 2000 units, a level of 50k objects. The before rows test
+// every box per query the way Scene::ForEach over m_objects did, the frustum rows also run
+// FrustumCuller over the boxes in structure of arrays, the fastest linear scan there is.
+// The tree rows query a tree built by Insert() one box at a time, then the same tree after
+// Rebuild(). The queries are a camera frustum, spheres of radius 50 and segments of 500
+// units from random points. The note carries the microseconds per query, the objects found
+// and the number of objects whose result differs from the before row. The maintenance rows
+// time Insert(), Update() with small and large moves, Remove() and Rebuild()
+
+#include "Benchmark.h"
+
+#include <DECore/Container/Vector.h>
+#include <DECore/Math/AABBTree.h>
+#include <DECore/Math/FrustumCuller.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace DE;
+
+namespace
+{
+
+constexpr uint32_t OBJECT_NUM = 50000;
+constexpr uint32_t QUERY_NUM = 256;			// different spheres and rays, cycled by the samples
+constexpr uint32_t SAMPLE_NUM = 2000;		// timed queries per row, times the scale
+constexpr float WORLD_SIZE = 2000.0f;
+constexpr float SPHERE_RADIUS = 50.0f;
+constexpr float RAY_LENGTH = 500.0f;
+constexpr float MARGIN = 1.0f;				// fat box margin of the maintenance rows
+
+/** @brief Sink of the results, so the measured loops are not optimized out */
+volatile uint64_t s_iChecksum = 0;
+
+float Random(float min, float max)
+{
+	return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+struct Level
+{
+	Level()
+	{
+		boxes.reserve(OBJECT_NUM);
+		for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+		{
+			const Vector3 center(Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f), Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f), Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f));
+			const Vector3 extent(Random(0.5f, 10.0f), Random(0.5f, 10.0f), Random(0.5f, 10.0f));
+			boxes.push_back(AABB(center - extent, center + extent));
+			minX.push_back(boxes.back().GetMin().GetX());
+			minY.push_back(boxes.back().GetMin().GetY());
+			minZ.push_back(boxes.back().GetMin().GetZ());
+			maxX.push_back(boxes.back().GetMax().GetX());
+			maxY.push_back(boxes.back().GetMax().GetY());
+			maxZ.push_back(boxes.back().GetMax().GetZ());
+		}
+		for (uint32_t i = 0; i < QUERY_NUM; ++i)
+		{
+			spheres.push_back(Sphere(Vector3(Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f), Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f), Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f)), SPHERE_RADIUS));
+			rayOrigins.push_back(Vector3(Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f), Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f), Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f)));
+			Vector3 direction(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+			rayDirections.push_back(direction * (1.0f / direction.Length()));
+		}
+	}
+
+	std::vector<AABB> boxes;
+	std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+	std::vector<Sphere> spheres;
+	std::vector<Vector3> rayOrigins, rayDirections;
+};
+
+/** @brief The before frustum test, every box against the Plane array of a Frustum */
+void QueryLinear(const Level& level, const Frustum& frustum, Vector<uint32_t>& result)
+{
+	for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+	{
+		if (frustum.Cull(level.boxes[i]))
+		{
+			result.push_back(i);
+		}
+	}
+}
+
+/** @brief The before sphere test, the distance from the center to the nearest point of every box */
+void QueryLinear(const Level& level, const Sphere& sphere, Vector<uint32_t>& result)
+{
+	const Vector3 center = sphere.GetCenter();
+	const float c[3] = { center.GetX(), center.GetY(), center.GetZ() };
+	const float radiusSquared = sphere.GetRadius() * sphere.GetRadius();
+	for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+	{
+		const float min[3] = { level.minX[i], level.minY[i], level.minZ[i] };
+		const float max[3] = { level.maxX[i], level.maxY[i], level.maxZ[i] };
+		float distanceSquared = 0.0f;
+		for (uint32_t a = 0; a < 3; ++a)
+		{
+			const float d = std::max(std::max(min[a] - c[a], c[a] - max[a]), 0.0f);
+			distanceSquared += d * d;
+		}
+		if (distanceSquared <= radiusSquared)
+		{
+			result.push_back(i);
+		}
+	}
+}
+
+/** @brief The before ray test, the slabs of every box */
+void RayCastLinear(const Level& level, const Vector3& origin, const Vector3& direction, float fMaxDistance, Vector<uint32_t>& result)
+{
+	const float o[3] = { origin.GetX(), origin.GetY(), origin.GetZ() };
+	const float inverse[3] = { 1.0f / direction.GetX(), 1.0f / direction.GetY(), 1.0f / direction.GetZ() };
+	for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+	{
+		const float min[3] = { level.minX[i], level.minY[i], level.minZ[i] };
+		const float max[3] = { level.maxX[i], level.maxY[i], level.maxZ[i] };
+		float entry = 0.0f, exit = fMaxDistance;
+		for (uint32_t a = 0; a < 3; ++a)
+		{
+			const float t1 = (min[a] - o[a]) * inverse[a];
+			const float t2 = (max[a] - o[a]) * inverse[a];
+			entry = std::max(entry, std::min(t1, t2));
+			exit = std::min(exit, std::max(t1, t2));
+		}
+		if (entry <= exit)
+		{
+			result.push_back(i);
+		}
+	}
+}
+
+/** @brief Number of indices in only one of the two lists */
+uint32_t CountMismatches(Vector<uint32_t>& a, Vector<uint32_t>& b)
+{
+	std::sort(a.begin(), a.end());
+	std::sort(b.begin(), b.end());
+	uint32_t mismatches = 0;
+	uint32_t i = 0, j = 0;
+	while (i < a.size() && j < b.size())
+	{
+		if (a[i] == b[j])
+		{
+			++i;
+			++j;
+		}
+		else
+		{
+			++mismatches;
+			a[i] < b[j] ? ++i : ++j;
+		}
+	}
+	return mismatches + static_cast<uint32_t>(a.size() - i) + static_cast<uint32_t>(b.size() - j);
+}
+
+/** @brief	Time sampleNum queries, query(s, result) runs query number s. The first QUERY_NUM
+*		results are checked against reference(s, result)
+*/
+template <class Query, class Reference>
+void Run(const char* name, uint32_t sampleNum, Query&& query, Reference&& reference)
+{
+	Vector<uint32_t> result;
+	Vector<uint32_t> expected;
+	uint64_t found = 0;
+	uint32_t mismatches = 0;
+	const uint32_t checkNum = std::min(sampleNum, QUERY_NUM);
+	for (uint32_t s = 0; s < checkNum; ++s)
+	{
+		result.clear();
+		expected.clear();
+		query(s, result);
+		reference(s, expected);
+		found += result.size();
+		mismatches += CountMismatches(result, expected);
+	}
+
+	LatencyRecorder latency;
+	latency.Reserve(sampleNum);
+	const uint64_t start = NowNs();
+	for (uint32_t s = 0; s < sampleNum; ++s)
+	{
+		const uint64_t sampleStart = NowNs();
+		result.clear();
+		query(s, result);
+		s_iChecksum += result.size();
+		latency.Record(NowNs() - sampleStart);
+	}
+	const uint64_t elapsed = NowNs() - start;
+
+	char note[96];
+	snprintf(note, sizeof(note), "%.1f us/query, %.1f found, %u mismatch", elapsed * 1e-3 / sampleNum, static_cast<double>(found) / checkNum, mismatches);
+	Report(name, sampleNum, elapsed * 1e-9, latency, note);
+}
+
+/** @brief Time func(i) for i in [0, num), one operation per sample */
+template <class Func>
+void RunMaintenance(const char* name, uint32_t num, Func&& func)
+{
+	LatencyRecorder latency;
+	latency.Reserve(num);
+	const uint64_t start = NowNs();
+	for (uint32_t i = 0; i < num; ++i)
+	{
+		const uint64_t sampleStart = NowNs();
+		func(i);
+		latency.Record(NowNs() - sampleStart);
+	}
+	Report(name, num, (NowNs() - start) * 1e-9, latency);
+}
+
+void ReportTree(const char* name, const AABBTree& tree)
+{
+	printf("%s: %u leaves, height %u, area ratio %.1f\n", name, tree.GetLeafCount(), tree.GetHeight(), tree.GetAreaRatio());
+}
+
+}
+
+void RunAABBTreeBenchmark(const BenchmarkArgs& args)
+{
+	srand(1);
+	Level level;
+	const Matrix4 view = Matrix4::LookAtMatrix(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.3f, 0.1f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+	const Frustum frustum = Frustum::FromViewProjection(view * Matrix4::PerspectiveProjection(PI / 3.0f, 16.0f / 9.0f, 0.1f, 300.0f));
+	const FrustumCuller culler(frustum);
+	const Float3Stream boxMin = { level.minX.data(), level.minY.data(), level.minZ.data() };
+	const Float3Stream boxMax = { level.maxX.data(), level.maxY.data(), level.maxZ.data() };
+	const uint32_t sampleNum = SAMPLE_NUM * args.scale;
+
+	// no margin, so the tree finds exactly what the linear scans find
+	AABBTree tree(0.0f);
+	for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+	{
+		tree.Insert(level.boxes[i], i);
+	}
+	AABBTree rebuilt(0.0f);
+	for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+	{
+		rebuilt.Insert(level.boxes[i], i);
+	}
+	rebuilt.Rebuild();
+
+	ReportHeader("aabbtree");
+	ReportTree("inserted", tree);
+	ReportTree("rebuilt", rebuilt);
+
+	auto frustumReference = [&](uint32_t, Vector<uint32_t>& result) { QueryLinear(level, frustum, result); };
+	Run("frustum / linear Plane (before)", sampleNum / 20, frustumReference, frustumReference);
+	Run("frustum / linear FrustumCuller", sampleNum, [&](uint32_t, Vector<uint32_t>& result) {
+		result.resize(OBJECT_NUM);
+		result.resize(culler.CullAABBs(boxMin, boxMax, OBJECT_NUM, result.data()));
+	}, frustumReference);
+	Run("frustum / AABBTree inserted", sampleNum, [&](uint32_t, Vector<uint32_t>& result) { tree.Query(frustum, result); }, frustumReference);
+	Run("frustum / AABBTree rebuilt", sampleNum, [&](uint32_t, Vector<uint32_t>& result) { rebuilt.Query(frustum, result); }, frustumReference);
+
+	auto sphereReference = [&](uint32_t s, Vector<uint32_t>& result) { QueryLinear(level, level.spheres[s % QUERY_NUM], result); };
+	Run("sphere / linear (before)", sampleNum / 20, sphereReference, sphereReference);
+	Run("sphere / AABBTree inserted", sampleNum, [&](uint32_t s, Vector<uint32_t>& result) { tree.Query(level.spheres[s % QUERY_NUM], result); }, sphereReference);
+	Run("sphere / AABBTree rebuilt", sampleNum, [&](uint32_t s, Vector<uint32_t>& result) { rebuilt.Query(level.spheres[s % QUERY_NUM], result); }, sphereReference);
+
+	auto rayReference = [&](uint32_t s, Vector<uint32_t>& result) { RayCastLinear(level, level.rayOrigins[s % QUERY_NUM], level.rayDirections[s % QUERY_NUM], RAY_LENGTH, result); };
+	Run("ray / linear (before)", sampleNum / 20, rayReference, rayReference);
+	Run("ray / AABBTree inserted", sampleNum, [&](uint32_t s, Vector<uint32_t>& result) { tree.RayCast(level.rayOrigins[s % QUERY_NUM], level.rayDirections[s % QUERY_NUM], RAY_LENGTH, result); }, rayReference);
+	Run("ray / AABBTree rebuilt", sampleNum, [&](uint32_t s, Vector<uint32_t>& result) { rebuilt.RayCast(level.rayOrigins[s % QUERY_NUM], level.rayDirections[s % QUERY_NUM], RAY_LENGTH, result); }, rayReference);
+
+	// maintenance of a tree with fat boxes
+	AABBTree dynamic(MARGIN);
+	std::vector<uint32_t> proxies(OBJECT_NUM);
+	RunMaintenance("Insert", OBJECT_NUM, [&](uint32_t i) { proxies[i] = dynamic.Insert(level.boxes[i], i); });
+	std::vector<Vector3> moves(OBJECT_NUM);
+	for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+	{
+		moves[i] = Vector3(Random(-0.5f, 0.5f), Random(-0.5f, 0.5f), Random(-0.5f, 0.5f)) * MARGIN;
+	}
+	uint32_t reinserted = 0;
+	RunMaintenance("Update / within margin", OBJECT_NUM, [&](uint32_t i) {
+		reinserted += dynamic.Update(proxies[i], AABB(level.boxes[i].GetMin() + moves[i], level.boxes[i].GetMax() + moves[i]));
+	});
+	printf("within margin: %u reinserted\n", reinserted);
+	for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+	{
+		moves[i] = Vector3(Random(-20.0f, 20.0f), Random(-20.0f, 20.0f), Random(-20.0f, 20.0f));
+	}
+	reinserted = 0;
+	RunMaintenance("Update / 20 units", OBJECT_NUM, [&](uint32_t i) {
+		reinserted += dynamic.Update(proxies[i], AABB(level.boxes[i].GetMin() + moves[i], level.boxes[i].GetMax() + moves[i]));
+	});
+	printf("20 units: %u reinserted\n", reinserted);
+	ReportTree("after update", dynamic);
+	RunMaintenance("Refit / 20 units back", OBJECT_NUM, [&](uint32_t i) { dynamic.Refit(proxies[i], level.boxes[i]); });
+	ReportTree("after refit", dynamic);
+	RunMaintenance("Rebuild", args.scale, [&](uint32_t) { dynamic.Rebuild(); });
+	ReportTree("after rebuild", dynamic);
+	RunMaintenance("Remove", OBJECT_NUM, [&](uint32_t i) { dynamic.Remove(proxies[i]); });
+}
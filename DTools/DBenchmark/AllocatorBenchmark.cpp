@@ -0,0 +1,629 @@
+// AllocatorBenchmark.cpp: replays allocation patterns against MemoryManager, its pmr adapter and the system heap
+//
+// Every pattern is a list of allocate/free ops on numbered slots, generated or converted
+// from a trace recorded by MemoryManager::BeginTrace(). A pattern is replayed twice per
+// allocator: once untimed for ops/sec, once timing every op for the latency percentiles.
+// The pool simulator then replays the pattern against MEMORY_POOL_CONFIG on paper to show
+// the peak block usage and fragmentation of each size class, to tune the configuration
+
+#include "Benchmark.h"
+
+#include <DECore/Memory/MemoryManager.h>
+#include <DECore/Memory/MemoryResource.h>
+#include <DECore/Memory/MemoryTrace.h>
+
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <new>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using namespace DE;
+
+namespace
+{
+
+struct ReplayOp
+{
+	uint32_t slot;			// allocation referred by the op, unique among live allocations of the stream
+	uint32_t size;			// requested size, 0 for free
+	uint16_t alignment;		// requested alignment, 0 for free
+	MemoryTag tag;			// tag of the allocation
+	bool bAllocate;			// allocate or free
+};
+
+struct OpStream
+{
+	std::vector<ReplayOp> ops;
+	uint32_t slotNum = 0;
+};
+
+struct Pattern
+{
+	std::string name;
+	std::vector<OpStream> streams;	// one per thread, replayed concurrently
+};
+
+/** @brief Slot bookkeeping of one stream, allocated before the timed region */
+template <typename Allocator>
+struct StreamState
+{
+	std::vector<typename Allocator::Allocation> slots;
+	std::vector<uint8_t> live;
+	uint64_t failedNum = 0;
+	LatencyRecorder latency;
+};
+
+//-----------------------------------------------------------------------------
+// Allocators
+//-----------------------------------------------------------------------------
+
+struct SystemAllocator
+{
+	struct Allocation
+	{
+		void* ptr;
+		size_t alignment;	// 0 if from malloc
+	};
+	static constexpr const char* NAME = "malloc";
+
+	Allocation Allocate(size_t size, size_t alignment, MemoryTag)
+	{
+		if (alignment <= MEMORY_ALIGNMENT)
+		{
+			return { malloc(size), 0 };
+		}
+		return { ::operator new(size, std::align_val_t(alignment), std::nothrow), alignment };
+	}
+	static void* Address(const Allocation& allocation) { return allocation.ptr; }
+	void Free(const Allocation& allocation)
+	{
+		if (allocation.alignment == 0)
+		{
+			free(allocation.ptr);
+		}
+		else
+		{
+			::operator delete(allocation.ptr, std::align_val_t(allocation.alignment));
+		}
+	}
+};
+
+struct PoolAllocator
+{
+	using Allocation = Handle;
+	static constexpr const char* NAME = "MemoryManager";
+
+	Allocation Allocate(size_t size, size_t alignment, MemoryTag tag)
+	{
+		return MemoryManager::GetInstance()->Allocate(size, alignment, tag);
+	}
+	static void* Address(const Allocation& allocation) { return allocation.Raw(); }
+	void Free(const Allocation& allocation) { MemoryManager::GetInstance()->Free(allocation); }
+};
+
+struct ResourceAllocator
+{
+	struct Allocation
+	{
+		void* ptr;
+		uint32_t size;
+		uint16_t alignment;
+		MemoryTag tag;
+	};
+	static constexpr const char* NAME = "PoolMemoryResource";
+
+	Allocation Allocate(size_t size, size_t alignment, MemoryTag tag)
+	{
+		try
+		{
+			return { PoolMemoryResource::Instance(tag)->allocate(size, alignment), static_cast<uint32_t>(size), static_cast<uint16_t>(alignment), tag };
+		}
+		catch (const std::bad_alloc&)
+		{
+			return { nullptr, 0, 0, tag };
+		}
+	}
+	static void* Address(const Allocation& allocation) { return allocation.ptr; }
+	void Free(const Allocation& allocation)
+	{
+		PoolMemoryResource::Instance(allocation.tag)->deallocate(allocation.ptr, allocation.size, allocation.alignment);
+	}
+};
+
+//-----------------------------------------------------------------------------
+// Patterns
+//-----------------------------------------------------------------------------
+
+uint32_t LogUniformSize(std::mt19937& rng, uint32_t minSize, uint32_t maxSize)
+{
+	std::uniform_real_distribution<double> dist(std::log2(static_cast<double>(minSize)), std::log2(static_cast<double>(maxSize)));
+	return static_cast<uint32_t>(std::exp2(dist(rng)));
+}
+
+/** @brief Random sizes with random lifetime around a steady live set */
+OpStream GenerateRandom(uint32_t seed, uint32_t opNum, uint32_t liveMax, uint32_t minSize, uint32_t maxSize)
+{
+	OpStream stream;
+	stream.ops.reserve(opNum);
+	std::mt19937 rng(seed);
+	std::vector<uint32_t> live;
+	std::vector<uint32_t> freeSlots;
+	for (uint32_t i = 0; i < opNum; ++i)
+	{
+		if (live.empty() || (live.size() < liveMax && rng() % 2 == 0))
+		{
+			uint32_t slot = stream.slotNum;
+			if (freeSlots.empty())
+			{
+				stream.slotNum++;
+			}
+			else
+			{
+				slot = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			live.push_back(slot);
+			stream.ops.push_back({ slot, LogUniformSize(rng, minSize, maxSize), MEMORY_ALIGNMENT, MemoryTag::General, true });
+		}
+		else
+		{
+			const uint32_t index = rng() % live.size();
+			const uint32_t slot = live[index];
+			live[index] = live.back();
+			live.pop_back();
+			freeSlots.push_back(slot);
+			stream.ops.push_back({ slot, 0, 0, MemoryTag::General, false });
+		}
+	}
+	return stream;
+}
+
+/** @brief Arrays growing by doubling, allocating the new storage before freeing the old one */
+OpStream GenerateVectorGrowth(uint32_t seed, uint32_t opNum, uint32_t vectorNum, uint32_t maxSize)
+{
+	struct GrowingVector
+	{
+		uint32_t slot;
+		uint32_t capacity;
+		uint32_t target;
+	};
+	OpStream stream;
+	stream.ops.reserve(opNum);
+	stream.slotNum = vectorNum * 2; // the current and the next storage of each vector
+	std::mt19937 rng(seed);
+	std::vector<GrowingVector> vectors(vectorNum);
+	for (uint32_t v = 0; v < vectorNum; ++v)
+	{
+		vectors[v] = { v * 2, 0, LogUniformSize(rng, 256, maxSize) };
+	}
+	while (stream.ops.size() < opNum)
+	{
+		GrowingVector& vector = vectors[rng() % vectorNum];
+		if (vector.capacity == 0)
+		{
+			vector.capacity = 64;
+			stream.ops.push_back({ vector.slot, vector.capacity, MEMORY_ALIGNMENT, MemoryTag::Container, true });
+		}
+		else if (vector.capacity < vector.target)
+		{
+			const uint32_t next = vector.slot ^ 1;
+			vector.capacity *= 2;
+			stream.ops.push_back({ next, vector.capacity, MEMORY_ALIGNMENT, MemoryTag::Container, true });
+			stream.ops.push_back({ vector.slot, 0, 0, MemoryTag::Container, false });
+			vector.slot = next;
+		}
+		else
+		{
+			stream.ops.push_back({ vector.slot, 0, 0, MemoryTag::Container, false });
+			vector.capacity = 0;
+			vector.target = LogUniformSize(rng, 256, maxSize);
+		}
+	}
+	return stream;
+}
+
+/** @brief Per frame temporaries freed at the end of the frame, plus resources living for a number of frames */
+OpStream GenerateFrameChurn(uint32_t seed, uint32_t frameNum, uint32_t transientNum, uint32_t persistentNum, uint32_t persistentFrames)
+{
+	OpStream stream;
+	stream.ops.reserve(static_cast<size_t>(frameNum) * (transientNum + persistentNum) * 2);
+	stream.slotNum = transientNum + persistentNum * persistentFrames;
+	std::mt19937 rng(seed);
+	for (uint32_t frame = 0; frame < frameNum; ++frame)
+	{
+		for (uint32_t i = 0; i < transientNum; ++i)
+		{
+			stream.ops.push_back({ i, LogUniformSize(rng, 16, 1024), MEMORY_ALIGNMENT, MemoryTag::FrameData, true });
+		}
+		for (uint32_t i = 0; i < persistentNum; ++i)
+		{
+			const uint32_t slot = transientNum + (frame % persistentFrames) * persistentNum + i;
+			if (frame >= persistentFrames)
+			{
+				stream.ops.push_back({ slot, 0, 0, MemoryTag::Renderer, false });
+			}
+			stream.ops.push_back({ slot, LogUniformSize(rng, 64, 4096), MEMORY_ALIGNMENT, MemoryTag::Renderer, true });
+		}
+		for (uint32_t i = 0; i < transientNum; ++i)
+		{
+			stream.ops.push_back({ i, 0, 0, MemoryTag::FrameData, false });
+		}
+	}
+	return stream;
+}
+
+/** @brief Convert a recorded trace to one stream in recorded order, frees of allocation made before the trace began are dropped */
+bool LoadTrace(const char* path, Pattern& pattern)
+{
+	std::ifstream fin(path, std::ifstream::in | std::ifstream::binary);
+	MemoryTraceHeader header = {};
+	if (!fin.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.iMagic != MEMORY_TRACE_MAGIC || header.iVersion != MEMORY_TRACE_VERSION)
+	{
+		printf("%s is not a memory trace of version %u\n", path, MEMORY_TRACE_VERSION);
+		return false;
+	}
+	std::vector<MemoryTraceEvent> events(header.iEventNum);
+	if (!fin.read(reinterpret_cast<char*>(events.data()), sizeof(MemoryTraceEvent) * header.iEventNum))
+	{
+		printf("%s is truncated\n", path);
+		return false;
+	}
+
+	uint32_t threadNum = 0;
+	OpStream stream;
+	stream.ops.reserve(events.size());
+	std::unordered_map<uint32_t, uint32_t> idToSlot;
+	std::vector<uint32_t> freeSlots;
+	for (const MemoryTraceEvent& event : events)
+	{
+		threadNum = event.iThread + 1 > threadNum ? event.iThread + 1 : threadNum;
+		if (event.op == MemoryTraceOp::Allocate)
+		{
+			uint32_t slot = stream.slotNum;
+			if (freeSlots.empty())
+			{
+				stream.slotNum++;
+			}
+			else
+			{
+				slot = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			idToSlot[event.iId] = slot;
+			stream.ops.push_back({ slot, static_cast<uint32_t>(event.iSize), event.iAlignment, event.tag, true });
+		}
+		else
+		{
+			auto it = idToSlot.find(event.iId);
+			if (it == idToSlot.end())
+			{
+				continue;
+			}
+			stream.ops.push_back({ it->second, 0, 0, event.tag, false });
+			freeSlots.push_back(it->second);
+			idToSlot.erase(it);
+		}
+	}
+
+	pattern.name = "trace";
+	pattern.streams.push_back(std::move(stream));
+	printf("loaded %llu events from %u threads, replayed on one thread in recorded order\n", (unsigned long long) events.size(), threadNum);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Replay
+//-----------------------------------------------------------------------------
+
+template <typename Allocator, bool bTimed>
+void ReplayStream(const OpStream& stream, StreamState<Allocator>& state)
+{
+	Allocator allocator;
+	for (const ReplayOp& op : stream.ops)
+	{
+		const uint64_t start = bTimed ? NowNs() : 0;
+		if (op.bAllocate)
+		{
+			typename Allocator::Allocation allocation = allocator.Allocate(op.size, op.alignment, op.tag);
+			void* ptr = Allocator::Address(allocation);
+			if (ptr)
+			{
+				if (op.size > 0)
+				{
+					*static_cast<volatile char*>(ptr) = 0; // touch the memory like a real user
+				}
+				state.slots[op.slot] = allocation;
+				state.live[op.slot] = 1;
+			}
+			else
+			{
+				state.failedNum++;
+			}
+		}
+		else if (state.live[op.slot])
+		{
+			allocator.Free(state.slots[op.slot]);
+			state.live[op.slot] = 0;
+		}
+		if (bTimed)
+		{
+			state.latency.Record(NowNs() - start);
+		}
+	}
+}
+
+/** @brief Replay every stream on its own thread from a common start, return the wall time in seconds */
+template <typename Allocator, bool bTimed>
+double ReplayPattern(const Pattern& pattern, std::vector<StreamState<Allocator>>& states)
+{
+	const uint32_t streamNum = static_cast<uint32_t>(pattern.streams.size());
+	states.resize(streamNum);
+	for (uint32_t i = 0; i < streamNum; ++i)
+	{
+		states[i].slots.assign(pattern.streams[i].slotNum, typename Allocator::Allocation());
+		states[i].live.assign(pattern.streams[i].slotNum, 0);
+		states[i].failedNum = 0;
+		if (bTimed)
+		{
+			states[i].latency.Reserve(pattern.streams[i].ops.size());
+		}
+	}
+
+	std::atomic<uint32_t> readyNum(0);
+	std::atomic<bool> bStart(false);
+	std::vector<std::thread> threads;
+	for (uint32_t i = 1; i < streamNum; ++i)
+	{
+		threads.emplace_back([&, i]()
+		{
+			readyNum++;
+			while (!bStart)
+			{
+				std::this_thread::yield();
+			}
+			ReplayStream<Allocator, bTimed>(pattern.streams[i], states[i]);
+		});
+	}
+	while (readyNum != streamNum - 1)
+	{
+		std::this_thread::yield();
+	}
+
+	const uint64_t start = NowNs();
+	bStart = true;
+	ReplayStream<Allocator, bTimed>(pattern.streams[0], states[0]);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	const uint64_t end = NowNs();
+
+	// allocations still live at the end of the pattern are not part of the measure
+	Allocator allocator;
+	for (StreamState<Allocator>& state : states)
+	{
+		for (size_t slot = 0; slot < state.slots.size(); ++slot)
+		{
+			if (state.live[slot])
+			{
+				allocator.Free(state.slots[slot]);
+			}
+		}
+	}
+	return (end - start) * 1e-9;
+}
+
+template <typename Allocator>
+void RunPattern(const Pattern& pattern)
+{
+	uint64_t opNum = 0;
+	for (const OpStream& stream : pattern.streams)
+	{
+		opNum += stream.ops.size();
+	}
+
+	std::vector<StreamState<Allocator>> states;
+	const double seconds = ReplayPattern<Allocator, false>(pattern, states);
+	states.clear();
+	ReplayPattern<Allocator, true>(pattern, states);
+
+	LatencyRecorder latency;
+	latency.Reserve(opNum);
+	uint64_t failedNum = 0;
+	for (StreamState<Allocator>& state : states)
+	{
+		latency.Merge(state.latency);
+		failedNum += state.failedNum;
+	}
+
+	const std::string name = pattern.name + " / " + Allocator::NAME;
+	const std::string note = failedNum > 0 ? "failed " + std::to_string(failedNum) : "";
+	Report(name.c_str(), opNum, seconds, latency, note.c_str());
+}
+
+//-----------------------------------------------------------------------------
+// Pool simulator
+//-----------------------------------------------------------------------------
+
+/** @brief Replay the pattern on paper against MEMORY_POOL_CONFIG with the release build rules, streams interleaved op by op */
+void SimulatePools(const Pattern& pattern)
+{
+	struct SimulatedPool
+	{
+		std::vector<uint8_t> used;
+		uint32_t lowestFree = 0;
+		uint32_t liveNum = 0;
+		uint32_t peakNum = 0;
+		uint64_t failedNum = 0;
+		uint64_t wastedBytes = 0;
+		uint64_t peakWastedBytes = 0;
+	};
+	struct SimulatedSlot
+	{
+		uint32_t pool;
+		uint32_t block;
+		uint32_t size;
+	};
+
+	SimulatedPool pools[MEMORY_POOL_NUM + 1];
+	for (uint32_t i = 0; i < MEMORY_POOL_NUM; ++i)
+	{
+		pools[i].used.assign(MEMORY_POOL_CONFIG[i][1], 0);
+	}
+
+	std::vector<std::vector<SimulatedSlot>> slots(pattern.streams.size());
+	size_t maxOpNum = 0;
+	for (size_t s = 0; s < pattern.streams.size(); ++s)
+	{
+		slots[s].assign(pattern.streams[s].slotNum, { MEMORY_POOL_NUM + 1, 0, 0 });
+		maxOpNum = pattern.streams[s].ops.size() > maxOpNum ? pattern.streams[s].ops.size() : maxOpNum;
+	}
+
+	for (size_t i = 0; i < maxOpNum; ++i)
+	{
+		for (size_t s = 0; s < pattern.streams.size(); ++s)
+		{
+			if (i >= pattern.streams[s].ops.size())
+			{
+				continue;
+			}
+			const ReplayOp& op = pattern.streams[s].ops[i];
+			SimulatedSlot& slot = slots[s][op.slot];
+			if (op.bAllocate)
+			{
+				uint32_t poolIndex = 0;
+				while (poolIndex < MEMORY_POOL_NUM && (op.size > MEMORY_POOL_CONFIG[poolIndex][0] || op.alignment > MEMORY_POOL_CONFIG[poolIndex][0]))
+				{
+					poolIndex++;
+				}
+				SimulatedPool& pool = pools[poolIndex];
+				if (poolIndex < MEMORY_POOL_NUM)
+				{
+					while (pool.lowestFree < pool.used.size() && pool.used[pool.lowestFree])
+					{
+						pool.lowestFree++;
+					}
+					if (pool.lowestFree == pool.used.size())
+					{
+						pool.failedNum++;
+						slot.pool = MEMORY_POOL_NUM + 1;
+						continue;
+					}
+					pool.used[pool.lowestFree] = 1;
+					slot.block = pool.lowestFree;
+					pool.wastedBytes += MEMORY_POOL_CONFIG[poolIndex][0] - op.size;
+					pool.peakWastedBytes = pool.wastedBytes > pool.peakWastedBytes ? pool.wastedBytes : pool.peakWastedBytes;
+				}
+				slot.pool = poolIndex;
+				slot.size = op.size;
+				pool.liveNum++;
+				pool.peakNum = pool.liveNum > pool.peakNum ? pool.liveNum : pool.peakNum;
+			}
+			else if (slot.pool <= MEMORY_POOL_NUM)
+			{
+				SimulatedPool& pool = pools[slot.pool];
+				if (slot.pool < MEMORY_POOL_NUM)
+				{
+					pool.used[slot.block] = 0;
+					pool.lowestFree = slot.block < pool.lowestFree ? slot.block : pool.lowestFree;
+					pool.wastedBytes -= MEMORY_POOL_CONFIG[slot.pool][0] - slot.size;
+				}
+				pool.liveNum--;
+				slot.pool = MEMORY_POOL_NUM + 1;
+			}
+		}
+	}
+
+	printf("\n-- pool simulation: %s\n", pattern.name.c_str());
+	printf("%12s %10s %10s %10s %10s %14s %14s\n", "block size", "block num", "peak", "suggested", "failed", "peak waste KB", "fragmentation");
+	for (uint32_t i = 0; i <= MEMORY_POOL_NUM; ++i)
+	{
+		const SimulatedPool& pool = pools[i];
+		if (pool.peakNum == 0 && pool.failedNum == 0)
+		{
+			continue;
+		}
+		// share of the span up to the highest used block that is free at the end of the pattern
+		uint32_t span = 0;
+		for (uint32_t block = 0; block < pool.used.size(); ++block)
+		{
+			span = pool.used[block] ? block + 1 : span;
+		}
+		const double fragmentation = span > 0 ? 1.0 - static_cast<double>(pool.liveNum) / span : 0.0;
+		const uint32_t suggested = (pool.peakNum + pool.peakNum / 4 + 63) / 64 * 64; // 25% headroom, whole bitmap word
+		if (i == MEMORY_POOL_NUM)
+		{
+			printf("%12s %10u %10u %10s %10llu %14s %14s\n", "large", LARGE_OBJECT_MAX_NUM, pool.peakNum, "-", (unsigned long long) pool.failedNum, "-", "-");
+		}
+		else
+		{
+			printf("%12u %10u %10u %10u %10llu %14.1f %13.1f%%\n", MEMORY_POOL_CONFIG[i][0], MEMORY_POOL_CONFIG[i][1], pool.peakNum, suggested, (unsigned long long) pool.failedNum, pool.peakWastedBytes / 1024.0, fragmentation * 100.0);
+		}
+	}
+}
+
+}
+
+void RunAllocatorBenchmark(const BenchmarkArgs& args)
+{
+	std::vector<Pattern> patterns;
+
+	// sizes and live counts stay within the default pool configuration even with debug guard bands
+	Pattern random;
+	random.name = "random 16-2048B";
+	random.streams.push_back(GenerateRandom(1, 200000 * args.scale, 1024, 16, 2048));
+	patterns.push_back(std::move(random));
+
+	Pattern randomThreaded;
+	randomThreaded.name = "random 16-2048B x" + std::to_string(args.threadNum) + " threads";
+	for (uint32_t i = 0; i < args.threadNum; ++i)
+	{
+		randomThreaded.streams.push_back(GenerateRandom(100 + i, 100000 * args.scale, 2048 / args.threadNum, 16, 2048));
+	}
+	patterns.push_back(std::move(randomThreaded));
+
+	Pattern vectorGrowth;
+	vectorGrowth.name = "vector growth up to 64KB";
+	vectorGrowth.streams.push_back(GenerateVectorGrowth(2, 200000 * args.scale, 16, 65536));
+	patterns.push_back(std::move(vectorGrowth));
+
+	Pattern frameChurn;
+	frameChurn.name = "frame churn";
+	frameChurn.streams.push_back(GenerateFrameChurn(3, 200 * args.scale, 512, 8, 60));
+	patterns.push_back(std::move(frameChurn));
+
+	Pattern frameChurnThreaded;
+	frameChurnThreaded.name = "frame churn x" + std::to_string(args.threadNum) + " threads";
+	for (uint32_t i = 0; i < args.threadNum; ++i)
+	{
+		frameChurnThreaded.streams.push_back(GenerateFrameChurn(200 + i, 200 * args.scale, 512 / args.threadNum, 1, 60));
+	}
+	patterns.push_back(std::move(frameChurnThreaded));
+
+	if (args.tracePath)
+	{
+		Pattern trace;
+		if (LoadTrace(args.tracePath, trace))
+		{
+			patterns.push_back(std::move(trace));
+		}
+	}
+
+	ReportHeader("allocator");
+	for (const Pattern& pattern : patterns)
+	{
+		RunPattern<SystemAllocator>(pattern);
+		RunPattern<PoolAllocator>(pattern);
+		RunPattern<ResourceAllocator>(pattern);
+	}
+	for (const Pattern& pattern : patterns)
+	{
+		SimulatePools(pattern);
+	}
+}
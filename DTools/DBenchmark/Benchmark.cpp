@@ -0,0 +1,49 @@
+#include "Benchmark.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <stdio.h>
+
+uint64_t LatencyRecorder::Percentile(double percentile)
+{
+	if (m_Samples.empty())
+	{
+		return 0;
+	}
+	const size_t index = static_cast<size_t>(percentile / 100.0 * (m_Samples.size() - 1) + 0.5);
+	std::nth_element(m_Samples.begin(), m_Samples.begin() + index, m_Samples.end());
+	return m_Samples[index];
+}
+
+size_t GetPeakRSS()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters = {};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage = {};
+	getrusage(RUSAGE_SELF, &usage);
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+void ReportHeader(const char* suite)
+{
+	printf("\n== %s\n", suite);
+	printf("%-52s %14s %10s %10s %12s  %s\n", "name", "ops/s", "p50 ns", "p99 ns", "peakRSS MB", "note");
+}
+
+void Report(const char* name, uint64_t ops, double seconds, LatencyRecorder& latency, const char* note)
+{
+	const double opsPerSecond = seconds > 0.0 ? ops / seconds : 0.0;
+	const uint64_t p50 = latency.Percentile(50.0);
+	const uint64_t p99 = latency.Percentile(99.0);
+	printf("%-52s %14.0f %10llu %10llu %12.1f  %s\n", name, opsPerSecond, (unsigned long long) p50, (unsigned long long) p99, GetPeakRSS() / (1024.0 * 1024.0), note);
+}
@@ -0,0 +1,59 @@
+// Benchmark.h: timing and reporting shared by the benchmark suites
+#pragma once
+
+// Cpp
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+
+struct BenchmarkArgs
+{
+	const char* tracePath = nullptr;	// recorded MemoryManager trace to replay, see MemoryManager::BeginTrace()
+	uint32_t threadNum = 4;				// worker threads of the multi-threaded patterns
+	uint32_t scale = 1;					// multiplies the iteration count of every pattern
+};
+
+using BenchmarkSuite = void(*)(const BenchmarkArgs& args);
+
+// Suites, one per file
+void RunAllocatorBenchmark(const BenchmarkArgs& args);
+void RunRingBufferBenchmark(const BenchmarkArgs& args);
+void RunConcurrentMapBenchmark(const BenchmarkArgs& args);
+void RunContainerBenchmark(const BenchmarkArgs& args);
+void RunMatrixBenchmark(const BenchmarkArgs& args);
+void RunCullingBenchmark(const BenchmarkArgs& args);
+void RunAABBTreeBenchmark(const BenchmarkArgs& args);
+
+inline uint64_t NowNs()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/*
+*	class: LatencyRecorder
+*	Keeps every sample of one run to report percentiles,
+*	reserve up front so recording does not allocate
+*/
+class LatencyRecorder
+{
+public:
+	void Reserve(size_t num) { m_Samples.reserve(num); }
+	void Record(uint64_t ns) { m_Samples.push_back(static_cast<uint32_t>(ns < UINT32_MAX ? ns : UINT32_MAX)); }
+	void Merge(const LatencyRecorder& other) { m_Samples.insert(m_Samples.end(), other.m_Samples.begin(), other.m_Samples.end()); }
+	size_t Size() const { return m_Samples.size(); }
+
+	/** @brief Return the sample at the percentile in [0, 100], sorts the samples */
+	uint64_t Percentile(double percentile);
+
+private:
+	std::vector<uint32_t> m_Samples;
+};
+
+/** @brief Return the peak resident set size of the process so far in bytes, it never goes down between runs */
+size_t GetPeakRSS();
+
+/** @brief Print the column names of Report() */
+void ReportHeader(const char* suite);
+
+/** @brief Print one result row, ops per second is computed from the total time of an untimed run */
+void Report(const char* name, uint64_t ops, double seconds, LatencyRecorder& latency, const char* note = "");
@@ -0,0 +1,246 @@
+// ConcurrentMapBenchmark.cpp: lookup throughput of ConcurrentHashMap against std::unordered_map under a lock
+//
+// Every thread runs its share of a fixed operation count on one shared map, so ops/sec
+// shows how a map scales from 1 to MAX_THREAD_NUM threads. Read heavy is an asset cache
+// after loading: the keys are inserted up front and 1 in 20 operations asks for a key that
+// may be new. Mixed is a cache being filled: half the operations are FindOrInsert on a key
+// range of about an eighth of the operation count. A pattern is run twice per map: once
+// for ops/sec, once recording the latency of every operation
+
+#include "Benchmark.h"
+
+#include <DECore/Container/ConcurrentHashMap.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using namespace DE;
+
+namespace
+{
+
+constexpr uint32_t MAX_THREAD_NUM = 64;
+constexpr uint32_t BUCKET_NUM = 1 << 16;
+
+struct Asset
+{
+	Asset() = default;
+	explicit Asset(uint64_t key) : m_iKey(key) {}
+
+	uint64_t m_iKey = 0;
+};
+
+struct LockFreeMap
+{
+	static constexpr const char* NAME = "ConcurrentHashMap";
+
+	LockFreeMap() : m_Map(BUCKET_NUM) {}
+
+	bool Find(uint64_t key) const
+	{
+		return m_Map.Find(key) != nullptr;
+	}
+
+	bool FindOrInsert(uint64_t key)
+	{
+		return m_Map.FindOrInsert(key, key).second;
+	}
+
+	ConcurrentHashMap<uint64_t, Asset> m_Map;
+};
+
+/** @brief std::unordered_map under a reader writer lock, readers share it */
+struct SharedMutexMap
+{
+	static constexpr const char* NAME = "unordered_map + shared_mutex";
+
+	SharedMutexMap() { m_Map.reserve(BUCKET_NUM); }
+
+	bool Find(uint64_t key) const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+		return m_Map.find(key) != m_Map.end();
+	}
+
+	bool FindOrInsert(uint64_t key)
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock(m_Mutex);
+			if (m_Map.find(key) != m_Map.end())
+			{
+				return false;
+			}
+		}
+		std::unique_lock<std::shared_mutex> lock(m_Mutex);
+		return m_Map.try_emplace(key, key).second;
+	}
+
+	mutable std::shared_mutex m_Mutex;
+	std::unordered_map<uint64_t, Asset> m_Map;
+};
+
+/** @brief std::unordered_map under one mutex */
+struct MutexMap
+{
+	static constexpr const char* NAME = "unordered_map + mutex";
+
+	MutexMap() { m_Map.reserve(BUCKET_NUM); }
+
+	bool Find(uint64_t key) const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Map.find(key) != m_Map.end();
+	}
+
+	bool FindOrInsert(uint64_t key)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Map.try_emplace(key, key).second;
+	}
+
+	mutable std::mutex m_Mutex;
+	std::unordered_map<uint64_t, Asset> m_Map;
+};
+
+struct Pattern
+{
+	const char* name;
+	uint32_t prefillNum;	// keys inserted before the run
+	uint32_t keyNum;		// keys are drawn from [0, keyNum)
+	uint32_t insertEvery;	// one in insertEvery operations is FindOrInsert, the others Find
+	uint32_t opNum;			// over all threads
+};
+
+/** @brief xorshift64, each thread keeps its own state */
+inline uint64_t NextRandom(uint64_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+/** @brief Spread the key bits so adjacent keys do not land in adjacent buckets of every map alike */
+inline uint64_t MakeKey(uint64_t index)
+{
+	return index * 0x9e3779b97f4a7c15ull;
+}
+
+template <typename Map, bool bTimed>
+uint32_t RunOps(Map& map, const Pattern& pattern, uint32_t threadIndex, uint32_t opNum, LatencyRecorder& latency)
+{
+	uint64_t state = 0x2545f4914f6cdd1dull + threadIndex * 0x9e3779b97f4a7c15ull;
+	uint32_t hitNum = 0;
+	for (uint32_t i = 0; i < opNum; ++i)
+	{
+		const uint64_t random = NextRandom(state);
+		const uint64_t key = MakeKey((random >> 8) % pattern.keyNum);
+		const bool bInsert = (random & 0xff) % pattern.insertEvery == 0;
+		const uint64_t start = bTimed ? NowNs() : 0;
+		hitNum += bInsert ? !map.FindOrInsert(key) : map.Find(key);
+		if (bTimed)
+		{
+			latency.Record(NowNs() - start);
+		}
+	}
+	return hitNum;
+}
+
+/** @brief Run the operations on threadNum threads from a common start, return the wall time in seconds */
+template <typename Map, bool bTimed>
+double RunMap(const Pattern& pattern, uint32_t threadNum, std::vector<LatencyRecorder>& latencies)
+{
+	std::unique_ptr<Map> pMap(new Map());
+	for (uint32_t i = 0; i < pattern.prefillNum; ++i)
+	{
+		pMap->FindOrInsert(MakeKey(i));
+	}
+
+	const uint32_t opNum = pattern.opNum / threadNum;
+	latencies.resize(threadNum);
+	if (bTimed)
+	{
+		for (LatencyRecorder& latency : latencies)
+		{
+			latency.Reserve(opNum);
+		}
+	}
+
+	std::atomic<uint32_t> readyNum(0);
+	std::atomic<bool> bStart(false);
+	std::atomic<uint32_t> hitNum(0);
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < threadNum; ++i)
+	{
+		threads.emplace_back([&, i]()
+		{
+			readyNum++;
+			while (!bStart)
+			{
+				std::this_thread::yield();
+			}
+			hitNum += RunOps<Map, bTimed>(*pMap, pattern, i, opNum, latencies[i]);
+		});
+	}
+	while (readyNum != threadNum)
+	{
+		std::this_thread::yield();
+	}
+
+	const uint64_t start = NowNs();
+	bStart = true;
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	const uint64_t end = NowNs();
+	return (end - start) * 1e-9;
+}
+
+template <typename Map>
+void RunPattern(const Pattern& pattern, uint32_t threadNum)
+{
+	std::vector<LatencyRecorder> latencies;
+	const double seconds = RunMap<Map, false>(pattern, threadNum, latencies);
+	latencies.clear();
+	RunMap<Map, true>(pattern, threadNum, latencies);
+
+	const uint64_t opNum = static_cast<uint64_t>(pattern.opNum / threadNum) * threadNum;
+	LatencyRecorder latency;
+	latency.Reserve(opNum);
+	for (const LatencyRecorder& thread : latencies)
+	{
+		latency.Merge(thread);
+	}
+
+	const std::string name = std::string(pattern.name) + " " + std::to_string(threadNum) + "T / " + Map::NAME;
+	Report(name.c_str(), opNum, seconds, latency);
+}
+
+}
+
+void RunConcurrentMapBenchmark(const BenchmarkArgs& args)
+{
+	const Pattern patterns[] =
+	{
+		{ "read heavy", 1 << 14, 1 << 15, 20, 2000000 * args.scale },
+		{ "mixed", 0, 1 << 18, 2, 2000000 * args.scale },
+	};
+
+	ReportHeader("concurrentmap");
+	for (const Pattern& pattern : patterns)
+	{
+		for (uint32_t threadNum = 1; threadNum <= MAX_THREAD_NUM; threadNum *= 2)
+		{
+			RunPattern<LockFreeMap>(pattern, threadNum);
+			RunPattern<SharedMutexMap>(pattern, threadNum);
+			RunPattern<MutexMap>(pattern, threadNum);
+		}
+	}
+}
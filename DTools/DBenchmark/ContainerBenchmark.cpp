@@ -0,0 +1,728 @@
+// ContainerBenchmark.cpp: the engine containers against the standard library at sizes from 10 to 10M
+//
+// Arrays are measured on push_back with and without reserve, iteration and random reads.
+// Maps are measured on insertion from empty, lookups that hit and miss, churn (remove a
+// random key and add a new one at constant size) and iteration. Keys and items are 64-bit.
+// A sample times one operation over BATCH_OPS elements or more, spread over several
+// containers of the size when it is small, so the timer overhead stays out of the numbers;
+// the latency columns are the per element time of a sample. The note carries the bytes
+// per element held by the container right after filling it from empty: engine containers
+// are read from the Container tag of MemoryManager, standard ones from a counting
+// allocator, both include the size of the container object.
+// SoAVector is checked rather than raced: emplace_back, swap_remove, resize and moves over a
+// field with a heap allocating member, compared with a std::vector of tuples doing the same.
+// The note carries the elements that differ and the field instances left alive afterward
+
+#include "Benchmark.h"
+
+#include <DECore/Container/FlatMap.h>
+#include <DECore/Container/HashMap.h>
+#include <DECore/Container/SlotMap.h>
+#include <DECore/Container/SoAVector.h>
+#include <DECore/Container/StableVector.h>
+#include <DECore/Container/Vector.h>
+#include <DECore/Memory/MemoryManager.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+using namespace DE;
+
+namespace
+{
+
+constexpr uint32_t SIZES[] = { 10, 1000, 100000, 10000000 };
+constexpr uint64_t BATCH_OPS = 4096;			// minimum elements touched by one timed sample
+constexpr uint64_t OP_TARGET = 4000000;			// elements touched by all samples of one row, times the scale
+constexpr uint32_t MIN_SAMPLE_NUM = 3;
+constexpr uint64_t MAX_OPS_PER_CONTAINER = 1000000;	// lookups and churn per container and sample
+constexpr uint32_t MAX_CHECK_SIZE = 100000;			// largest size of the SoAVector check, every element owns a string
+
+//-----------------------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------------------
+
+/** @brief Bytes held by the standard containers, through CountingAllocator */
+size_t s_iCountedBytes = 0;
+
+/** @brief Sink of the results, so the measured loops are not optimized out */
+volatile uint64_t s_iChecksum = 0;
+
+template <class T>
+struct CountingAllocator
+{
+	using value_type = T;
+
+	CountingAllocator() = default;
+	template <class U>
+	CountingAllocator(const CountingAllocator<U>&) {}
+
+	T* allocate(size_t num)
+	{
+		s_iCountedBytes += num * sizeof(T);
+		return std::allocator<T>().allocate(num);
+	}
+
+	void deallocate(T* p, size_t num)
+	{
+		s_iCountedBytes -= num * sizeof(T);
+		std::allocator<T>().deallocate(p, num);
+	}
+
+	template <class U>
+	bool operator==(const CountingAllocator<U>&) const { return true; }
+	template <class U>
+	bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+size_t EngineBytes()
+{
+	return MemoryManager::GetInstance()->GetTagStatistics(MemoryTag::Container).iCurrentBytes;
+}
+
+size_t StdBytes()
+{
+	return s_iCountedBytes;
+}
+
+/** @brief Key of element index i: never 0, which the reference map reserves, and spread over all bits */
+inline uint64_t MakeKey(uint64_t index)
+{
+	return (index + 1) * 0x9e3779b97f4a7c15ull;
+}
+
+/** @brief xorshift64 */
+inline uint64_t NextRandom(uint64_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+/** @brief Random indices in [first, first + range) */
+std::vector<uint32_t> RandomIndices(uint64_t num, uint64_t first, uint64_t range, uint64_t seed)
+{
+	std::vector<uint32_t> indices(num);
+	uint64_t state = seed * 0x2545f4914f6cdd1dull + 1;
+	for (uint32_t& index : indices)
+	{
+		index = static_cast<uint32_t>(first + NextRandom(state) % range);
+	}
+	return indices;
+}
+
+struct Plan
+{
+	uint32_t containerNum;	// containers of the size filled per sample
+	uint32_t sampleNum;
+};
+
+/** @brief Spread OP_TARGET element operations over samples of at least BATCH_OPS */
+Plan MakePlan(uint64_t opsPerContainer, uint32_t scale)
+{
+	Plan plan;
+	plan.containerNum = static_cast<uint32_t>(opsPerContainer >= BATCH_OPS ? 1 : (BATCH_OPS + opsPerContainer - 1) / opsPerContainer);
+	const uint64_t opsPerSample = opsPerContainer * plan.containerNum;
+	const uint64_t sampleNum = OP_TARGET * scale / opsPerSample;
+	plan.sampleNum = static_cast<uint32_t>(sampleNum > MIN_SAMPLE_NUM ? sampleNum : MIN_SAMPLE_NUM);
+	return plan;
+}
+
+/** @brief	Run the samples, each constructing the containers and running setup untimed, then
+*		timing op on all of them. Report the row, with the bytes per element held after
+*		the first sample if asked
+*/
+template <typename Adapter, typename Setup, typename Op>
+void Measure(const std::string& name, uint32_t size, uint64_t opsPerContainer, const BenchmarkArgs& args, Setup&& setup, Op&& op, bool bReportBytes)
+{
+	const Plan plan = MakePlan(opsPerContainer, args.scale);
+	LatencyRecorder latency;
+	latency.Reserve(plan.sampleNum);
+	uint64_t elapsed = 0;
+	double bytesPerElement = 0.0;
+	uint64_t checksum = 0;
+	for (uint32_t sample = 0; sample < plan.sampleNum; ++sample)
+	{
+		const size_t bytesBefore = Adapter::HeldBytes();
+		std::vector<std::unique_ptr<Adapter>> containers(plan.containerNum);
+		for (std::unique_ptr<Adapter>& pContainer : containers)
+		{
+			pContainer.reset(new Adapter());
+			setup(*pContainer);
+		}
+
+		const uint64_t start = NowNs();
+		for (std::unique_ptr<Adapter>& pContainer : containers)
+		{
+			checksum += op(*pContainer);
+		}
+		const uint64_t sampleNs = NowNs() - start;
+		elapsed += sampleNs;
+		latency.Record(sampleNs / (opsPerContainer * plan.containerNum));
+
+		if (sample == 0)
+		{
+			const double held = static_cast<double>(Adapter::HeldBytes() - bytesBefore) + sizeof(Adapter) * static_cast<double>(plan.containerNum);
+			bytesPerElement = held / (static_cast<double>(size) * plan.containerNum);
+		}
+	}
+
+	s_iChecksum = s_iChecksum + checksum;
+
+	char note[64] = {};
+	if (bReportBytes)
+	{
+		snprintf(note, sizeof(note), "%.1f B/elem", bytesPerElement);
+	}
+	const std::string row = name + " " + std::to_string(size) + " / " + Adapter::NAME;
+	Report(row.c_str(), opsPerContainer * plan.containerNum * plan.sampleNum, elapsed * 1e-9, latency, note);
+}
+
+//-----------------------------------------------------------------------------
+// Arrays
+//-----------------------------------------------------------------------------
+
+struct EngineVector
+{
+	static constexpr const char* NAME = "Vector";
+	static size_t HeldBytes() { return EngineBytes(); }
+
+	void Reserve(size_t num) { m_Array.reserve(num); }
+	void PushBack(uint64_t item) { m_Array.push_back(item); }
+	uint64_t At(uint32_t index) const { return m_Array[index]; }
+	uint64_t Sum() const
+	{
+		uint64_t sum = 0;
+		for (uint64_t item : m_Array)
+		{
+			sum += item;
+		}
+		return sum;
+	}
+
+	Vector<uint64_t> m_Array;
+};
+
+struct StdVector
+{
+	static constexpr const char* NAME = "std::vector";
+	static size_t HeldBytes() { return StdBytes(); }
+
+	void Reserve(size_t num) { m_Array.reserve(num); }
+	void PushBack(uint64_t item) { m_Array.push_back(item); }
+	uint64_t At(uint32_t index) const { return m_Array[index]; }
+	uint64_t Sum() const
+	{
+		uint64_t sum = 0;
+		for (uint64_t item : m_Array)
+		{
+			sum += item;
+		}
+		return sum;
+	}
+
+	std::vector<uint64_t, CountingAllocator<uint64_t>> m_Array;
+};
+
+struct EngineStableVector
+{
+	static constexpr const char* NAME = "StableVector";
+	static size_t HeldBytes() { return EngineBytes(); }
+
+	void Reserve(size_t num) { m_Array.reserve(num); }
+	void PushBack(uint64_t item) { m_Array.push_back(item); }
+	uint64_t At(uint32_t index) const { return m_Array[index]; }
+	uint64_t Sum()
+	{
+		uint64_t sum = 0;
+		m_Array.ForEachChunk([&sum](const uint64_t* pItems, uint32_t num)
+		{
+			for (uint32_t i = 0; i < num; ++i)
+			{
+				sum += pItems[i];
+			}
+		});
+		return sum;
+	}
+
+	StableVector<uint64_t> m_Array;
+};
+
+template <typename Adapter>
+void RunArray(uint32_t size, const BenchmarkArgs& args)
+{
+	const auto fill = [size](Adapter& array)
+	{
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			array.PushBack(i);
+		}
+		return static_cast<uint64_t>(size);
+	};
+
+	Measure<Adapter>("push_back", size, size, args, [](Adapter&) {}, fill, true);
+	Measure<Adapter>("push_back reserved", size, size, args, [size](Adapter& array) { array.Reserve(size); }, fill, false);
+	Measure<Adapter>("iterate", size, size, args, fill, [](Adapter& array) { return array.Sum(); }, false);
+
+	const uint64_t readNum = size < MAX_OPS_PER_CONTAINER ? size : MAX_OPS_PER_CONTAINER;
+	const std::vector<uint32_t> indices = RandomIndices(readNum, 0, size, size);
+	Measure<Adapter>("random read", size, readNum, args, fill, [&indices](Adapter& array)
+	{
+		uint64_t sum = 0;
+		for (uint32_t index : indices)
+		{
+			sum += array.At(index);
+		}
+		return sum;
+	}, false);
+}
+
+//-----------------------------------------------------------------------------
+// SoAVector check
+//-----------------------------------------------------------------------------
+
+/** @brief Field that is not trivially relocatable, counts its live instances */
+struct TrackedName
+{
+	TrackedName() { ++s_iLiveNum; }
+	explicit TrackedName(uint64_t key) : m_Name("name of element " + std::to_string(key)) { ++s_iLiveNum; }
+	TrackedName(const TrackedName& other) : m_Name(other.m_Name) { ++s_iLiveNum; }
+	TrackedName(TrackedName&& other) : m_Name(std::move(other.m_Name)) { ++s_iLiveNum; }
+	TrackedName& operator=(const TrackedName& other) = default;
+	TrackedName& operator=(TrackedName&& other) = default;
+	~TrackedName() { --s_iLiveNum; }
+
+	std::string m_Name;	// longer than the small string buffer, so a lost or doubled element shows in the heap
+
+	static int64_t s_iLiveNum;
+};
+int64_t TrackedName::s_iLiveNum = 0;
+
+using CheckedSoA = SoAVector<uint64_t, TrackedName, float>;
+using CheckedReference = std::vector<std::tuple<uint64_t, std::string, float>>;
+
+/** @brief Number of elements of soa differing from reference, a size difference counts every missing element */
+uint32_t CountMismatches(const CheckedSoA& soa, const CheckedReference& reference)
+{
+	uint32_t mismatches = static_cast<uint32_t>(soa.size() > reference.size() ? soa.size() - reference.size() : reference.size() - soa.size());
+	const size_t num = soa.size() < reference.size() ? soa.size() : reference.size();
+	for (size_t i = 0; i < num; ++i)
+	{
+		const auto [key, name, weight] = soa[i];
+		if (key != std::get<0>(reference[i]) || name.m_Name != std::get<1>(reference[i]) || weight != std::get<2>(reference[i]))
+		{
+			++mismatches;
+		}
+	}
+	return mismatches;
+}
+
+/** @brief	Fill, swap_remove half of the elements at random, shrink and grow again, then move
+*		the container away and back, checking against the reference after every step
+*/
+uint32_t CheckSoAVectorPass(uint32_t size, const std::vector<uint32_t>& removals)
+{
+	uint32_t mismatches = 0;
+	CheckedSoA soa;
+	CheckedReference reference;
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		soa.emplace_back(MakeKey(i), TrackedName(MakeKey(i)), static_cast<float>(i));
+		reference.emplace_back(MakeKey(i), TrackedName(MakeKey(i)).m_Name, static_cast<float>(i));
+	}
+	mismatches += CountMismatches(soa, reference);
+
+	for (uint32_t removal : removals)
+	{
+		const size_t index = removal % soa.size();
+		soa.swap_remove(index);
+		reference[index] = std::move(reference.back());
+		reference.pop_back();
+	}
+	mismatches += CountMismatches(soa, reference);
+
+	soa.resize(soa.size() / 2);
+	reference.resize(reference.size() / 2);
+	soa.resize(size);
+	reference.resize(size);
+	mismatches += CountMismatches(soa, reference);
+
+	CheckedSoA moved(std::move(soa));
+	mismatches += static_cast<uint32_t>(soa.size()) + CountMismatches(moved, reference);
+	soa = std::move(moved);
+	mismatches += static_cast<uint32_t>(moved.size()) + CountMismatches(soa, reference);
+
+	// every column starts on a cache line for the SIMD kernels
+	mismatches += reinterpret_cast<uintptr_t>(soa.data<0>()) % 64 != 0 || reinterpret_cast<uintptr_t>(soa.data<2>()) % 64 != 0;
+	return mismatches;
+}
+
+void CheckSoAVector(uint32_t size, const BenchmarkArgs& args)
+{
+	const std::vector<uint32_t> removals = RandomIndices(size / 2, 0, size, size);
+	const uint32_t sampleNum = MIN_SAMPLE_NUM * args.scale;
+	LatencyRecorder latency;
+	latency.Reserve(sampleNum);
+	uint32_t mismatches = 0;
+	const uint64_t start = NowNs();
+	for (uint32_t sample = 0; sample < sampleNum; ++sample)
+	{
+		const uint64_t sampleStart = NowNs();
+		mismatches += CheckSoAVectorPass(size, removals);
+		latency.Record((NowNs() - sampleStart) / size);
+	}
+	const uint64_t elapsed = NowNs() - start;
+
+	char note[64];
+	snprintf(note, sizeof(note), "%u mismatch, %lld leaked", mismatches, static_cast<long long>(TrackedName::s_iLiveNum));
+	const std::string row = "check " + std::to_string(size) + " / SoAVector";
+	Report(row.c_str(), static_cast<uint64_t>(size) * sampleNum, elapsed * 1e-9, latency, note);
+}
+
+//-----------------------------------------------------------------------------
+// Maps, keyed by element index through MakeKey
+//-----------------------------------------------------------------------------
+
+struct EngineHashMap
+{
+	static constexpr const char* NAME = "HashMap";
+	static constexpr uint32_t MAX_SIZE = UINT32_MAX;
+	static constexpr uint32_t MAX_CHURN_SIZE = UINT32_MAX;
+	static constexpr bool bMiss = true;
+	static size_t HeldBytes() { return EngineBytes(); }
+
+	void Fill(uint32_t num) { for (uint32_t i = 0; i < num; ++i) Insert(i); }
+	void Insert(uint32_t index) { m_Map.Add(MakeKey(index), index); }
+	void Erase(uint32_t index) { m_Map.Remove(MakeKey(index)); }
+	bool Find(uint32_t index) const { return m_Map.Find(MakeKey(index)) != nullptr; }
+	uint64_t Sum()
+	{
+		uint64_t sum = 0;
+		m_Map.ForEachItem([&sum](uint64_t item) { sum += item; });
+		return sum;
+	}
+
+	HashMap<uint64_t, uint64_t> m_Map;
+};
+
+struct StdUnorderedMap
+{
+	static constexpr const char* NAME = "std::unordered_map";
+	static constexpr uint32_t MAX_SIZE = UINT32_MAX;
+	static constexpr uint32_t MAX_CHURN_SIZE = UINT32_MAX;
+	static constexpr bool bMiss = true;
+	static size_t HeldBytes() { return StdBytes(); }
+
+	void Fill(uint32_t num) { for (uint32_t i = 0; i < num; ++i) Insert(i); }
+	void Insert(uint32_t index) { m_Map.emplace(MakeKey(index), index); }
+	void Erase(uint32_t index) { m_Map.erase(MakeKey(index)); }
+	bool Find(uint32_t index) const { return m_Map.find(MakeKey(index)) != m_Map.end(); }
+	uint64_t Sum()
+	{
+		uint64_t sum = 0;
+		for (const auto& pair : m_Map)
+		{
+			sum += pair.second;
+		}
+		return sum;
+	}
+
+	std::unordered_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, CountingAllocator<std::pair<const uint64_t, uint64_t>>> m_Map;
+};
+
+/** @brief	Reference open addressing map: linear probing at up to 1/2 load, removal shifts
+*		the following run back instead of leaving a tombstone. Key 0 marks an empty slot
+*/
+class LinearProbingMap
+{
+	struct Slot
+	{
+		uint64_t key;
+		uint64_t item;
+	};
+
+public:
+	void Insert(uint64_t key, uint64_t item)
+	{
+		if ((m_iSize + 1) * 2 > m_Slots.size())
+		{
+			grow();
+		}
+		size_t index = find(key);
+		if (m_Slots[index].key == 0)
+		{
+			m_Slots[index] = { key, item };
+			m_iSize++;
+		}
+	}
+
+	void Erase(uint64_t key)
+	{
+		size_t hole = find(key);
+		if (m_Slots.empty() || m_Slots[hole].key == 0)
+		{
+			return;
+		}
+		const size_t mask = m_Slots.size() - 1;
+		for (size_t index = (hole + 1) & mask; m_Slots[index].key != 0; index = (index + 1) & mask)
+		{
+			// move back an item whose home is not between the hole and itself
+			const size_t home = hash(m_Slots[index].key) & mask;
+			if (((index - home) & mask) >= ((index - hole) & mask))
+			{
+				m_Slots[hole] = m_Slots[index];
+				hole = index;
+			}
+		}
+		m_Slots[hole].key = 0;
+		m_iSize--;
+	}
+
+	const uint64_t* Find(uint64_t key) const
+	{
+		if (m_Slots.empty())
+		{
+			return nullptr;
+		}
+		const Slot& slot = m_Slots[find(key)];
+		return slot.key != 0 ? &slot.item : nullptr;
+	}
+
+	template <typename F>
+	void ForEachItem(F function) const
+	{
+		for (const Slot& slot : m_Slots)
+		{
+			if (slot.key != 0)
+			{
+				function(slot.item);
+			}
+		}
+	}
+
+private:
+	static size_t hash(uint64_t key)
+	{
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdull;
+		key ^= key >> 33;
+		return static_cast<size_t>(key);
+	}
+
+	/** @brief Return the slot of the key, or the empty slot ending its probe */
+	size_t find(uint64_t key) const
+	{
+		const size_t mask = m_Slots.size() - 1;
+		size_t index = hash(key) & mask;
+		while (m_Slots[index].key != 0 && m_Slots[index].key != key)
+		{
+			index = (index + 1) & mask;
+		}
+		return index;
+	}
+
+	void grow()
+	{
+		std::vector<Slot, CountingAllocator<Slot>> old(m_Slots.empty() ? 16 : m_Slots.size() * 2, Slot{ 0, 0 });
+		old.swap(m_Slots);
+		for (const Slot& slot : old)
+		{
+			if (slot.key != 0)
+			{
+				m_Slots[find(slot.key)] = slot;
+			}
+		}
+	}
+
+	std::vector<Slot, CountingAllocator<Slot>> m_Slots;
+	size_t m_iSize = 0;
+};
+
+struct ReferenceMap
+{
+	static constexpr const char* NAME = "linear probing";
+	static constexpr uint32_t MAX_SIZE = UINT32_MAX;
+	static constexpr uint32_t MAX_CHURN_SIZE = UINT32_MAX;
+	static constexpr bool bMiss = true;
+	static size_t HeldBytes() { return StdBytes(); }
+
+	void Fill(uint32_t num) { for (uint32_t i = 0; i < num; ++i) Insert(i); }
+	void Insert(uint32_t index) { m_Map.Insert(MakeKey(index), index); }
+	void Erase(uint32_t index) { m_Map.Erase(MakeKey(index)); }
+	bool Find(uint32_t index) const { return m_Map.Find(MakeKey(index)) != nullptr; }
+	uint64_t Sum()
+	{
+		uint64_t sum = 0;
+		m_Map.ForEachItem([&sum](uint64_t item) { sum += item; });
+		return sum;
+	}
+
+	LinearProbingMap m_Map;
+};
+
+/** @brief	Filled with one Build. Churn shifts the arrays, and from 1024 keys rebuilds the
+*		Eytzinger copy, on every op so it stops at MAX_CHURN_SIZE
+*/
+struct EngineFlatMap
+{
+	static constexpr const char* NAME = "FlatMap";
+	static constexpr uint32_t MAX_SIZE = UINT32_MAX;
+	static constexpr uint32_t MAX_CHURN_SIZE = 1000;
+	static constexpr bool bMiss = true;
+	static size_t HeldBytes() { return EngineBytes(); }
+
+	void Fill(uint32_t num)
+	{
+		Vector<uint64_t> keys;
+		Vector<uint64_t> items;
+		keys.reserve(num);
+		items.reserve(num);
+		for (uint32_t i = 0; i < num; ++i)
+		{
+			keys.push_back(MakeKey(i));
+			items.push_back(i);
+		}
+		m_Map.Build(std::move(keys), std::move(items));
+	}
+	void Insert(uint32_t index) { m_Map.Add(MakeKey(index), static_cast<uint64_t>(index)); }
+	void Erase(uint32_t index) { m_Map.Remove(MakeKey(index)); }
+	bool Find(uint32_t index) const { return m_Map.Find(MakeKey(index)) != nullptr; }
+	uint64_t Sum()
+	{
+		uint64_t sum = 0;
+		m_Map.ForEachItem([&sum](uint64_t item) { sum += item; });
+		return sum;
+	}
+
+	FlatMap<uint64_t, uint64_t> m_Map;
+};
+
+/** @brief	Looked up by the handles it issued, kept beside it. It allocates a small block
+*		per 64 items and handles hold a 20-bit index, so it stops at MAX_SIZE
+*/
+struct EngineSlotMap
+{
+	static constexpr const char* NAME = "SlotMap";
+	static constexpr uint32_t MAX_SIZE = 100000;
+	static constexpr uint32_t MAX_CHURN_SIZE = 100000;
+	static constexpr bool bMiss = false;
+	static size_t HeldBytes() { return EngineBytes(); }
+
+	void Fill(uint32_t num)
+	{
+		// churn adds at most num more elements
+		m_Handles.resize(num * 2);
+		for (uint32_t i = 0; i < num; ++i)
+		{
+			Insert(i);
+		}
+	}
+	void Insert(uint32_t index) { m_Handles[index] = m_Map.Add(static_cast<uint64_t>(index)); }
+	void Erase(uint32_t index) { m_Map.Remove(m_Handles[index]); }
+	bool Find(uint32_t index) const { return m_Map.Find(m_Handles[index]) != nullptr; }
+	uint64_t Sum()
+	{
+		uint64_t sum = 0;
+		m_Map.ForEachItem([&sum](uint64_t item) { sum += item; });
+		return sum;
+	}
+
+	SlotMap<uint64_t> m_Map;
+	std::vector<SlotMapHandle> m_Handles;	// by element index, not counted as held bytes
+};
+
+template <typename Adapter>
+void RunMap(uint32_t size, const BenchmarkArgs& args)
+{
+	if (size > Adapter::MAX_SIZE)
+	{
+		return;
+	}
+	const auto fill = [size](Adapter& map) { map.Fill(size); };
+
+	Measure<Adapter>("insert", size, size, args, [](Adapter&) {}, [size](Adapter& map)
+	{
+		map.Fill(size);
+		return static_cast<uint64_t>(size);
+	}, true);
+
+	const uint64_t lookupNum = size < MAX_OPS_PER_CONTAINER ? size : MAX_OPS_PER_CONTAINER;
+	const std::vector<uint32_t> hits = RandomIndices(lookupNum, 0, size, size);
+	const auto lookup = [](const std::vector<uint32_t>& indices)
+	{
+		return [&indices](Adapter& map)
+		{
+			uint64_t found = 0;
+			for (uint32_t index : indices)
+			{
+				found += map.Find(index) ? 1 : 0;
+			}
+			return found;
+		};
+	};
+	Measure<Adapter>("lookup hit", size, lookupNum, args, fill, lookup(hits), false);
+	if (Adapter::bMiss)
+	{
+		const std::vector<uint32_t> misses = RandomIndices(lookupNum, size, size, size + 1);
+		Measure<Adapter>("lookup miss", size, lookupNum, args, fill, lookup(misses), false);
+	}
+
+	if (size <= Adapter::MAX_CHURN_SIZE)
+	{
+		// every churn op removes a random live element and adds a never used one in its place
+		std::vector<uint32_t> erased = RandomIndices(lookupNum, 0, size, size + 2);
+		std::vector<uint32_t> live(size);
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			live[i] = i;
+		}
+		for (uint32_t i = 0; i < lookupNum; ++i)
+		{
+			const uint32_t victim = erased[i];
+			erased[i] = live[victim];
+			live[victim] = size + i;
+		}
+		Measure<Adapter>("churn", size, lookupNum, args, fill, [&erased, size](Adapter& map)
+		{
+			for (uint32_t i = 0; i < erased.size(); ++i)
+			{
+				map.Erase(erased[i]);
+				map.Insert(size + i);
+			}
+			return static_cast<uint64_t>(erased.size());
+		}, false);
+	}
+
+	Measure<Adapter>("iterate", size, size, args, fill, [](Adapter& map) { return map.Sum(); }, false);
+}
+
+}
+
+void RunContainerBenchmark(const BenchmarkArgs& args)
+{
+	ReportHeader("container");
+	for (uint32_t size : SIZES)
+	{
+		RunArray<EngineVector>(size, args);
+		RunArray<StdVector>(size, args);
+		RunArray<EngineStableVector>(size, args);
+		if (size <= MAX_CHECK_SIZE)
+		{
+			CheckSoAVector(size, args);
+		}
+	}
+	for (uint32_t size : SIZES)
+	{
+		RunMap<EngineHashMap>(size, args);
+		RunMap<StdUnorderedMap>(size, args);
+		RunMap<ReferenceMap>(size, args);
+		RunMap<EngineFlatMap>(size, args);
+		RunMap<EngineSlotMap>(size, args);
+	}
+}
@@ -0,0 +1,215 @@
+// CullingBenchmark.cpp: frustum culling of 100k bounding spheres and boxes, before and after
+//
+// The objects are spread in a cube around a camera that sees about a tenth of them. The before
+// rows test one object at a time against the Plane array of a Frustum and stop at the first plane
+// the object is outside of, the way the commented out Frustum::Cull did. The FrustumCuller rows run
+// the kernels of every supported instruction set, then the parallel call over the job system.
+// The note carries the nanoseconds per object, the visible count and the number of objects whose
+// result differs from the before row, which can only be objects that touch a plane within rounding.
+// The FrustumCuller rows read the bounds from the columns of SoAVector, the way a scene keeps them
+
+#include "Benchmark.h"
+
+#include <DECore/Container/SoAVector.h>
+#include <DECore/Job/JobScheduler.h>
+#include <DECore/Math/FrustumCuller.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+using namespace DE;
+
+namespace
+{
+
+constexpr uint32_t OBJECT_NUM = 100000;
+constexpr uint32_t SAMPLE_NUM = 200;		// timed culls of every object, times the scale
+constexpr float WORLD_SIZE = 1000.0f;		// objects are in a cube of this size centered at the camera
+
+float Random(float min, float max)
+{
+	return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+struct Scene
+{
+	Scene()
+	{
+		spheres.reserve(OBJECT_NUM);
+		boxes.reserve(OBJECT_NUM);
+		centers.reserve(OBJECT_NUM);
+		boxMin.reserve(OBJECT_NUM);
+		boxMax.reserve(OBJECT_NUM);
+		for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+		{
+			const float x = Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f);
+			const float y = Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f);
+			const float z = Random(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f);
+			const float radius = Random(0.5f, 10.0f);
+			const float ex = Random(0.5f, 10.0f), ey = Random(0.5f, 10.0f), ez = Random(0.5f, 10.0f);
+			spheres.emplace_back(x, y, z, radius);
+			boxes.emplace_back(x - ex, y - ey, z - ez, x + ex, y + ey, z + ez);
+			centers.push_back(Vector3(x, y, z, radius));
+			boxMin.push_back(Vector3(x - ex, y - ey, z - ez));
+			boxMax.push_back(Vector3(x + ex, y + ey, z + ez));
+		}
+	}
+
+	Float3Stream Centers() { return Float3Stream{ spheres.data<0>(), spheres.data<1>(), spheres.data<2>() }; }
+	const float* Radii() { return spheres.data<3>(); }
+	Float3Stream Min() { return Float3Stream{ boxes.data<0>(), boxes.data<1>(), boxes.data<2>() }; }
+	Float3Stream Max() { return Float3Stream{ boxes.data<3>(), boxes.data<4>(), boxes.data<5>() }; }
+
+	// structure of arrays for FrustumCuller: center x, y, z and radius, minimum x, y, z and maximum x, y, z
+	SoAVector<float, float, float, float> spheres;
+	SoAVector<float, float, float, float, float, float> boxes;
+	// array of structures for the before rows, the sphere radius is in w
+	std::vector<Vector3> centers, boxMin, boxMax;
+};
+
+/** @brief The before sphere test, one object against one plane at a time */
+uint32_t CullSpheresAoS(const Frustum& frustum, const std::vector<Vector3>& centers, uint32_t* visible)
+{
+	const Plane* planes = frustum.GetPlanes();
+	uint32_t num = 0;
+	for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+	{
+		bool bInside = true;
+		for (uint32_t p = 0; p < 6 && bInside; ++p)
+		{
+			bInside = planes[p].Distance(centers[i]) >= -centers[i].GetW();
+		}
+		if (bInside)
+		{
+			visible[num++] = i;
+		}
+	}
+	return num;
+}
+
+/** @brief The before box test, the corner furthest along the normal of each plane */
+uint32_t CullAABBsAoS(const Frustum& frustum, const std::vector<Vector3>& boxMin, const std::vector<Vector3>& boxMax, uint32_t* visible)
+{
+	const Plane* planes = frustum.GetPlanes();
+	uint32_t num = 0;
+	for (uint32_t i = 0; i < OBJECT_NUM; ++i)
+	{
+		bool bInside = true;
+		for (uint32_t p = 0; p < 6 && bInside; ++p)
+		{
+			const Vector3& normal = planes[p].m_vNormal;
+			const Vector3 corner(normal.GetX() > 0.0f ? boxMax[i].GetX() : boxMin[i].GetX(),
+				normal.GetY() > 0.0f ? boxMax[i].GetY() : boxMin[i].GetY(),
+				normal.GetZ() > 0.0f ? boxMax[i].GetZ() : boxMin[i].GetZ());
+			bInside = planes[p].Distance(corner) >= 0.0f;
+		}
+		if (bInside)
+		{
+			visible[num++] = i;
+		}
+	}
+	return num;
+}
+
+/** @brief Number of indices in only one of the two sorted lists */
+uint32_t CountMismatches(const uint32_t* a, uint32_t numA, const uint32_t* b, uint32_t numB)
+{
+	uint32_t mismatches = 0;
+	uint32_t i = 0, j = 0;
+	while (i < numA && j < numB)
+	{
+		if (a[i] == b[j])
+		{
+			++i;
+			++j;
+		}
+		else
+		{
+			++mismatches;
+			a[i] < b[j] ? ++i : ++j;
+		}
+	}
+	return mismatches + (numA - i) + (numB - j);
+}
+
+/** @brief Time passes of func, which culls every object into visible and returns the visible count */
+template <class Func>
+void Run(const char* name, const BenchmarkArgs& args, const std::vector<uint32_t>& reference, uint32_t referenceNum, std::vector<uint32_t>& visible, Func&& func)
+{
+	const uint32_t visibleNum = func();
+	const uint32_t mismatches = CountMismatches(visible.data(), visibleNum, reference.data(), referenceNum);
+
+	const uint32_t sampleNum = SAMPLE_NUM * args.scale;
+	LatencyRecorder latency;
+	latency.Reserve(sampleNum);
+	uint64_t checksum = 0;
+	const uint64_t start = NowNs();
+	for (uint32_t s = 0; s < sampleNum; ++s)
+	{
+		const uint64_t sampleStart = NowNs();
+		checksum += func();
+		latency.Record((NowNs() - sampleStart) / OBJECT_NUM);
+	}
+	const uint64_t elapsed = NowNs() - start;
+	const double seconds = elapsed * 1e-9;
+	if (checksum != static_cast<uint64_t>(visibleNum) * sampleNum)
+	{
+		printf("%s: visible count changed between passes\n", name);
+	}
+
+	const uint64_t opNum = static_cast<uint64_t>(sampleNum) * OBJECT_NUM;
+	char note[96];
+	snprintf(note, sizeof(note), "%.2f ns/object, %u visible, %u mismatch", elapsed / static_cast<double>(opNum), visibleNum, mismatches);
+	Report(name, opNum, seconds, latency, note);
+}
+
+}
+
+void RunCullingBenchmark(const BenchmarkArgs& args)
+{
+	srand(1);
+	Scene scene;
+	const Matrix4 view = Matrix4::LookAtMatrix(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.3f, 0.1f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+	const Matrix4 viewProjection = view * Matrix4::PerspectiveProjection(PI / 3.0f, 16.0f / 9.0f, 0.1f, WORLD_SIZE * 0.5f);
+	const Frustum frustum = Frustum::FromViewProjection(viewProjection);
+	const FrustumCuller culler(frustum);
+
+	const Float3Stream centers = scene.Centers();
+	const Float3Stream boxMin = scene.Min();
+	const Float3Stream boxMax = scene.Max();
+	std::vector<uint32_t> visible(OBJECT_NUM);
+	std::vector<uint32_t> sphereReference(OBJECT_NUM);
+	std::vector<uint32_t> boxReference(OBJECT_NUM);
+	const uint32_t sphereReferenceNum = CullSpheresAoS(frustum, scene.centers, sphereReference.data());
+	const uint32_t boxReferenceNum = CullAABBsAoS(frustum, scene.boxMin, scene.boxMax, boxReference.data());
+
+	ReportHeader("culling");
+
+	const char* levelNames[] = { "baseline", "AVX2", "AVX-512" };
+	const SIMDLevel supportedLevel = BatchTransform::GetSupportedSIMDLevel();
+
+	Run("spheres / Plane early out (before)", args, sphereReference, sphereReferenceNum, visible, [&]() { return CullSpheresAoS(frustum, scene.centers, visible.data()); });
+	for (uint32_t level = 0; level <= static_cast<uint32_t>(supportedLevel); ++level)
+	{
+		BatchTransform::SetSIMDLevel(static_cast<SIMDLevel>(level));
+		const std::string name = std::string("spheres / FrustumCuller ") + levelNames[level];
+		Run(name.c_str(), args, sphereReference, sphereReferenceNum, visible, [&]() { return culler.CullSpheres(centers, scene.Radii(), OBJECT_NUM, visible.data()); });
+	}
+
+	Run("boxes / Plane early out (before)", args, boxReference, boxReferenceNum, visible, [&]() { return CullAABBsAoS(frustum, scene.boxMin, scene.boxMax, visible.data()); });
+	for (uint32_t level = 0; level <= static_cast<uint32_t>(supportedLevel); ++level)
+	{
+		BatchTransform::SetSIMDLevel(static_cast<SIMDLevel>(level));
+		const std::string name = std::string("boxes / FrustumCuller ") + levelNames[level];
+		Run(name.c_str(), args, boxReference, boxReferenceNum, visible, [&]() { return culler.CullAABBs(boxMin, boxMax, OBJECT_NUM, visible.data()); });
+	}
+
+	// the main thread is worker 0, threadNum - 1 more threads steal the chunks
+	JobScheduler::Instance()->StartUp(static_cast<uint8_t>(args.threadNum));
+	const std::string threads = std::to_string(args.threadNum) + " threads " + levelNames[static_cast<uint32_t>(supportedLevel)];
+	Run(("spheres / FrustumCuller parallel " + threads).c_str(), args, sphereReference, sphereReferenceNum, visible, [&]() { return culler.CullSpheresParallel(centers, scene.Radii(), OBJECT_NUM, visible.data()); });
+	Run(("boxes / FrustumCuller parallel " + threads).c_str(), args, boxReference, boxReferenceNum, visible, [&]() { return culler.CullAABBsParallel(boxMin, boxMax, OBJECT_NUM, visible.data()); });
+	JobScheduler::Instance()->ShutDown();
+}
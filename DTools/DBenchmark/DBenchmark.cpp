@@ -0,0 +1,83 @@
+// DBenchmark.cpp: runs the engine micro benchmarks, build Release for meaningful numbers
+//
+// Usage: DBenchmark [suite ...] [-trace MemoryTrace.bin] [-threads N] [-scale N]
+// Runs every suite if none is named
+
+#include "Benchmark.h"
+
+#include <DECore/Memory/MemoryManager.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+struct SuiteEntry
+{
+	const char* name;
+	BenchmarkSuite pfnRun;
+};
+
+static const SuiteEntry s_Suites[] =
+{
+	{ "allocator", &RunAllocatorBenchmark },
+	{ "ringbuffer", &RunRingBufferBenchmark },
+	{ "concurrentmap", &RunConcurrentMapBenchmark },
+	{ "container", &RunContainerBenchmark },
+	{ "matrix", &RunMatrixBenchmark },
+	{ "culling", &RunCullingBenchmark },
+	{ "aabbtree", &RunAABBTreeBenchmark },
+};
+
+int main(int argc, char* argv[])
+{
+	BenchmarkArgs args;
+	const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+	args.threadNum = hardwareThreads == 0 ? 4 : (hardwareThreads < 8 ? hardwareThreads : 8);
+
+	const char* selected[16] = {};
+	uint32_t selectedNum = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)
+		{
+			args.tracePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			args.threadNum = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-scale") == 0 && i + 1 < argc)
+		{
+			args.scale = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (selectedNum < 16)
+		{
+			selected[selectedNum++] = argv[i];
+		}
+	}
+	args.threadNum = args.threadNum == 0 ? 1 : args.threadNum;
+	args.scale = args.scale == 0 ? 1 : args.scale;
+
+#if DE_MEMORY_DEBUG
+	printf("warning: memory debugging is on, MemoryManager numbers include poisoning and guard bands\n");
+#endif
+
+	DE::MemoryManager::GetInstance()->ConstructDefaultPool();
+
+	for (const SuiteEntry& suite : s_Suites)
+	{
+		bool bRun = selectedNum == 0;
+		for (uint32_t i = 0; i < selectedNum; ++i)
+		{
+			bRun |= strcmp(selected[i], suite.name) == 0;
+		}
+		if (bRun)
+		{
+			suite.pfnRun(args);
+		}
+	}
+
+	DE::MemoryManager::GetInstance()->Destruct();
+	return 0;
+}
@@ -0,0 +1,543 @@
+// MatrixBenchmark.cpp: Matrix4 multiply and inverse kernels, before and after, with their accuracy
+//
+// Every row runs one kernel over an array of random affine matrices that stays in cache, so
+// the numbers are the cost of the arithmetic. Before rows are copies of the replaced code:
+// the _mm_dp_ps multiply, and the general Inverse() that used to be called for rigid
+// transforms and normal matrices. The note carries the TSC ticks (nanoseconds off x86) per matrix and the largest
+// error of any element against the same computation in double, relative to the largest
+// element of the reference so that it reads as units of float epsilon (1.2e-7).
+// The points, normals and boxes rows transform 100k elements per BatchTransform call at
+// every supported instruction set, ticks are per element and the error of a component is
+// relative to the sum of the magnitudes of its terms in double
+
+#include "Benchmark.h"
+
+#include <DECore/Math/BatchTransform.h>
+#include <DECore/Math/simdmath.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#if DE_SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#elif DE_SIMD_X86
+#include <x86intrin.h>
+#endif
+
+using namespace DE;
+
+namespace
+{
+
+constexpr uint32_t MATRIX_NUM = 1024;		// 64KB of input, stays in L2
+constexpr uint32_t SAMPLE_NUM = 2000;		// timed passes over the matrices, times the scale
+
+/** @brief Sink of the results, so the measured loops are not optimized out */
+volatile float s_fChecksum = 0.0f;
+
+struct Matrix4d
+{
+	double m[4][4];
+};
+
+Matrix4d ToDouble(const Matrix4& matrix)
+{
+	Matrix4d result;
+	const float* pRaw = matrix.Raw();
+	for (int i = 0; i < 16; ++i)
+	{
+		result.m[i / 4][i % 4] = pRaw[i];
+	}
+	return result;
+}
+
+Matrix4d Multiply(const Matrix4d& a, const Matrix4d& b)
+{
+	Matrix4d result = {};
+	for (int r = 0; r < 4; ++r)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			for (int k = 0; k < 4; ++k)
+			{
+				result.m[r][c] += a.m[r][k] * b.m[k][c];
+			}
+		}
+	}
+	return result;
+}
+
+/** @brief Gauss-Jordan elimination with partial pivoting */
+Matrix4d Inverse(const Matrix4d& matrix)
+{
+	double a[4][8];
+	for (int r = 0; r < 4; ++r)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			a[r][c] = matrix.m[r][c];
+			a[r][c + 4] = r == c ? 1.0 : 0.0;
+		}
+	}
+	for (int c = 0; c < 4; ++c)
+	{
+		int pivot = c;
+		for (int r = c + 1; r < 4; ++r)
+		{
+			pivot = fabs(a[r][c]) > fabs(a[pivot][c]) ? r : pivot;
+		}
+		for (int k = 0; k < 8; ++k)
+		{
+			const double tmp = a[c][k];
+			a[c][k] = a[pivot][k];
+			a[pivot][k] = tmp;
+		}
+		const double invPivot = 1.0 / a[c][c];
+		for (int k = 0; k < 8; ++k)
+		{
+			a[c][k] *= invPivot;
+		}
+		for (int r = 0; r < 4; ++r)
+		{
+			if (r != c)
+			{
+				const double factor = a[r][c];
+				for (int k = 0; k < 8; ++k)
+				{
+					a[r][k] -= factor * a[c][k];
+				}
+			}
+		}
+	}
+	Matrix4d result;
+	for (int r = 0; r < 4; ++r)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			result.m[r][c] = a[r][c + 4];
+		}
+	}
+	return result;
+}
+
+/** @brief The inverse transpose of the upper 3x3, the rest as in the identity */
+Matrix4d NormalMatrix(const Matrix4d& matrix)
+{
+	Matrix4d upper = matrix;
+	for (int i = 0; i < 3; ++i)
+	{
+		upper.m[i][3] = 0.0;
+		upper.m[3][i] = 0.0;
+	}
+	upper.m[3][3] = 1.0;
+	const Matrix4d inverse = Inverse(upper);
+	Matrix4d result;
+	for (int r = 0; r < 4; ++r)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			result.m[r][c] = inverse.m[c][r];
+		}
+	}
+	return result;
+}
+
+/** @brief Largest element error relative to the largest element of the reference */
+double RelativeError(const Matrix4& result, const Matrix4d& reference)
+{
+	double maxError = 0.0;
+	double maxElement = 0.0;
+	const float* pRaw = result.Raw();
+	for (int i = 0; i < 16; ++i)
+	{
+		const double expected = reference.m[i / 4][i % 4];
+		maxError = fmax(maxError, fabs(pRaw[i] - expected));
+		maxElement = fmax(maxElement, fabs(expected));
+	}
+	return maxError / maxElement;
+}
+
+float Random(float min, float max)
+{
+	return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+/** @brief Rotation about the three axes then translation, with a scale in [minScale, maxScale] per axis */
+Matrix4 RandomAffine(float minScale, float maxScale)
+{
+	Matrix4 scale;
+	float* pScale = scale.Raw();
+	pScale[0] = Random(minScale, maxScale);
+	pScale[5] = Random(minScale, maxScale);
+	pScale[10] = Random(minScale, maxScale);
+	Matrix4 rotationZ;
+	rotationZ.CreateRotationZ(Random(-PI, PI));
+	Matrix4 result = scale * Matrix4::RotationX(Random(-PI, PI)) * Matrix4::RotationY(Random(-PI, PI)) * rotationZ;
+	result.SetPosition(Vector3(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-100.0f, 100.0f)));
+	return result;
+}
+
+/** @brief TSC ticks on x86, nanoseconds elsewhere */
+inline uint64_t ReadTicks()
+{
+#if DE_SIMD_X86
+	return __rdtsc();
+#else
+	return NowNs();
+#endif
+}
+
+#if DE_SIMD_SSE
+/** @brief The multiply this change replaced: transpose the right hand side, then 16 _mm_dp_ps */
+Matrix4 MultiplyDotProduct(const Matrix4& lhs, const Matrix4& rhs)
+{
+	__m128 rhsRows0 = _mm_load_ps(rhs.Raw());
+	__m128 rhsRows1 = _mm_load_ps(rhs.Raw() + 4);
+	__m128 rhsRows2 = _mm_load_ps(rhs.Raw() + 8);
+	__m128 rhsRows3 = _mm_load_ps(rhs.Raw() + 12);
+	_MM_TRANSPOSE4_PS(rhsRows0, rhsRows1, rhsRows2, rhsRows3);
+
+	__m128 resultRows[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		const __m128 row = _mm_load_ps(lhs.Raw() + i * 4);
+		const __m128 x = _mm_dp_ps(rhsRows0, row, 0xF1);
+		const __m128 y = _mm_dp_ps(rhsRows1, row, 0xF2);
+		const __m128 z = _mm_dp_ps(rhsRows2, row, 0xF4);
+		const __m128 w = _mm_dp_ps(rhsRows3, row, 0xF8);
+		resultRows[i] = _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w));
+	}
+	return Matrix4(resultRows);
+}
+#endif
+
+struct Inputs
+{
+	std::vector<Matrix4> affine;	// non uniform scale in [0.5, 2]
+	std::vector<Matrix4> rigid;		// rotation and translation
+	std::vector<Matrix4> parent;
+};
+
+/**	@brief	Time passes of func over every matrix index and check func's results against the
+*		double reference, func(i) returns the result for matrix i
+*/
+template <class Func, class RefFunc>
+void Run(const char* name, const BenchmarkArgs& args, Func&& func, RefFunc&& reference)
+{
+	double maxError = 0.0;
+	for (uint32_t i = 0; i < MATRIX_NUM; ++i)
+	{
+		maxError = fmax(maxError, RelativeError(func(i), reference(i)));
+	}
+
+	const uint32_t sampleNum = SAMPLE_NUM * args.scale;
+	LatencyRecorder latency;
+	latency.Reserve(sampleNum);
+	float checksum = 0.0f;
+	uint64_t ticks = 0;
+	const uint64_t start = NowNs();
+	for (uint32_t s = 0; s < sampleNum; ++s)
+	{
+		const uint64_t sampleStart = NowNs();
+		const uint64_t tickStart = ReadTicks();
+		for (uint32_t i = 0; i < MATRIX_NUM; ++i)
+		{
+			checksum += func(i).Raw()[s & 15];
+		}
+		ticks += ReadTicks() - tickStart;
+		latency.Record((NowNs() - sampleStart) / MATRIX_NUM);
+	}
+	const double seconds = (NowNs() - start) * 1e-9;
+	s_fChecksum = checksum;
+
+	const uint64_t opNum = static_cast<uint64_t>(sampleNum) * MATRIX_NUM;
+	char note[64];
+	snprintf(note, sizeof(note), "%.1f ticks, max err %.1e", ticks / static_cast<double>(opNum), maxError);
+	Report(name, opNum, seconds, latency, note);
+}
+
+/** @brief BatchTransform::MultiplyMatrices over all matrices per call, at one instruction set */
+void RunBatch(const char* name, const BenchmarkArgs& args, const Inputs& inputs, std::vector<Matrix4>& out)
+{
+	const uint32_t sampleNum = SAMPLE_NUM * args.scale;
+	BatchTransform::MultiplyMatrices(inputs.affine.data(), inputs.parent.data(), out.data(), MATRIX_NUM);
+	double maxError = 0.0;
+	for (uint32_t i = 0; i < MATRIX_NUM; ++i)
+	{
+		maxError = fmax(maxError, RelativeError(out[i], Multiply(ToDouble(inputs.affine[i]), ToDouble(inputs.parent[i]))));
+	}
+
+	LatencyRecorder latency;
+	latency.Reserve(sampleNum);
+	uint64_t ticks = 0;
+	const uint64_t start = NowNs();
+	for (uint32_t s = 0; s < sampleNum; ++s)
+	{
+		const uint64_t sampleStart = NowNs();
+		const uint64_t tickStart = ReadTicks();
+		BatchTransform::MultiplyMatrices(inputs.affine.data(), inputs.parent.data(), out.data(), MATRIX_NUM);
+		ticks += ReadTicks() - tickStart;
+		latency.Record((NowNs() - sampleStart) / MATRIX_NUM);
+	}
+	const double seconds = (NowNs() - start) * 1e-9;
+	s_fChecksum = out[MATRIX_NUM - 1].Raw()[0];
+
+	const uint64_t opNum = static_cast<uint64_t>(sampleNum) * MATRIX_NUM;
+	char note[64];
+	snprintf(note, sizeof(note), "%.1f ticks, max err %.1e", ticks / static_cast<double>(opNum), maxError);
+	Report(name, opNum, seconds, latency, note);
+}
+
+constexpr uint32_t STREAM_NUM = 100000;		// points and boxes per batch call, the streams do not fit in L2
+constexpr uint32_t STREAM_SAMPLE_NUM = 100;	// timed batch calls, times the scale
+constexpr uint32_t STREAM_CHECK_NUM = STREAM_NUM - 5;	// leaves a tail at every lane width, the last 5 must stay untouched
+
+/** @brief x, y and z in three arrays, the storage behind a Float3Stream */
+struct Float3Array
+{
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+
+	explicit Float3Array(uint32_t num)
+		: x(num)
+		, y(num)
+		, z(num)
+	{}
+
+	Float3Stream Stream()
+	{
+		return Float3Stream{ x.data(), y.data(), z.data() };
+	}
+
+	double operator()(uint32_t axis, uint32_t i) const
+	{
+		return axis == 0 ? x[i] : (axis == 1 ? y[i] : z[i]);
+	}
+};
+
+struct StreamInputs
+{
+	Matrix4 matrix;						// affine, non uniform scale in [0.5, 2]
+	Matrix4 normalMatrix;				// the normal matrix of matrix
+	std::vector<Matrix4> matrices;		// one affine transform per box
+	Float3Array points = Float3Array(STREAM_NUM);
+	Float3Array normals = Float3Array(STREAM_NUM);
+	Float3Array boxMin = Float3Array(STREAM_NUM);
+	Float3Array boxMax = Float3Array(STREAM_NUM);
+};
+
+/**	@brief	Largest error of (v, w) * matrix against the computation in double, each component
+*		relative to the sum of the magnitudes of its terms, so cancellation does not inflate it
+*/
+double TransformError(const Matrix4& matrix, const Float3Array& in, const Float3Array& out, uint32_t i, double w)
+{
+	const Matrix4d m = ToDouble(matrix);
+	double maxError = 0.0;
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		double expected = w * m.m[3][c];
+		double magnitude = fabs(expected);
+		for (uint32_t r = 0; r < 3; ++r)
+		{
+			expected += in(r, i) * m.m[r][c];
+			magnitude += fabs(in(r, i) * m.m[r][c]);
+		}
+		maxError = fmax(maxError, fabs(out(c, i) - expected) / fmax(magnitude, 1e-30));
+	}
+	return maxError;
+}
+
+/**	@brief	Largest error of box i against the tight box in double: along each axis the
+*		translation plus the smaller, and the larger, of min * m and max * m per row
+*/
+double AABBError(const Matrix4& matrix, const StreamInputs& inputs, const Float3Array& outMin, const Float3Array& outMax, uint32_t i)
+{
+	const Matrix4d m = ToDouble(matrix);
+	double maxError = 0.0;
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		double expectedMin = m.m[3][c];
+		double expectedMax = m.m[3][c];
+		double magnitude = fabs(m.m[3][c]);
+		for (uint32_t r = 0; r < 3; ++r)
+		{
+			const double a = inputs.boxMin(r, i) * m.m[r][c];
+			const double b = inputs.boxMax(r, i) * m.m[r][c];
+			expectedMin += fmin(a, b);
+			expectedMax += fmax(a, b);
+			magnitude += fmax(fabs(a), fabs(b));
+		}
+		maxError = fmax(maxError, fabs(outMin(c, i) - expectedMin) / magnitude);
+		maxError = fmax(maxError, fabs(outMax(c, i) - expectedMax) / magnitude);
+	}
+	return maxError;
+}
+
+/**	@brief	Check one batch call of STREAM_CHECK_NUM elements against the double reference,
+*		then time batch calls over STREAM_NUM elements. func(num) makes the call,
+*		error(i) returns the error of element i, the outputs are checked for writes past num
+*/
+template <class Func, class ErrorFunc>
+void RunStream(const char* name, const BenchmarkArgs& args, Float3Array& out, Float3Array& outMax, Func&& func, ErrorFunc&& error)
+{
+	constexpr float SENTINEL = -1.0e30f;
+	for (Float3Array* pArray : { &out, &outMax })
+	{
+		for (uint32_t i = STREAM_CHECK_NUM; i < STREAM_NUM; ++i)
+		{
+			pArray->x[i] = pArray->y[i] = pArray->z[i] = SENTINEL;
+		}
+	}
+	func(STREAM_CHECK_NUM);
+	double maxError = 0.0;
+	for (uint32_t i = 0; i < STREAM_CHECK_NUM; ++i)
+	{
+		maxError = fmax(maxError, error(i));
+	}
+	for (uint32_t i = STREAM_CHECK_NUM; i < STREAM_NUM; ++i)
+	{
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			// a write past the end reads as an infinite error
+			maxError = out(axis, i) == SENTINEL && outMax(axis, i) == SENTINEL ? maxError : INFINITY;
+		}
+	}
+
+	const uint32_t sampleNum = STREAM_SAMPLE_NUM * args.scale;
+	LatencyRecorder latency;
+	latency.Reserve(sampleNum);
+	uint64_t ticks = 0;
+	const uint64_t start = NowNs();
+	for (uint32_t s = 0; s < sampleNum; ++s)
+	{
+		const uint64_t sampleStart = NowNs();
+		const uint64_t tickStart = ReadTicks();
+		func(STREAM_NUM);
+		ticks += ReadTicks() - tickStart;
+		latency.Record((NowNs() - sampleStart) / STREAM_NUM);
+	}
+	const double seconds = (NowNs() - start) * 1e-9;
+
+	const uint64_t opNum = static_cast<uint64_t>(sampleNum) * STREAM_NUM;
+	char note[64];
+	snprintf(note, sizeof(note), "%.1f ticks, max err %.1e", ticks / static_cast<double>(opNum), maxError);
+	Report(name, opNum, seconds, latency, note);
+}
+
+/** @brief The point, normal and box kernels of BatchTransform at every supported instruction set */
+void RunStreams(const BenchmarkArgs& args)
+{
+	StreamInputs inputs;
+	inputs.matrix = RandomAffine(0.5f, 2.0f);
+	inputs.normalMatrix = inputs.matrix.NormalMatrix();
+	inputs.matrices.reserve(STREAM_NUM);
+	for (uint32_t i = 0; i < STREAM_NUM; ++i)
+	{
+		inputs.matrices.push_back(RandomAffine(0.5f, 2.0f));
+		inputs.points.x[i] = Random(-100.0f, 100.0f);
+		inputs.points.y[i] = Random(-100.0f, 100.0f);
+		inputs.points.z[i] = Random(-100.0f, 100.0f);
+		inputs.normals.x[i] = Random(-1.0f, 1.0f);
+		inputs.normals.y[i] = Random(-1.0f, 1.0f);
+		inputs.normals.z[i] = Random(-1.0f, 1.0f);
+		const float extent[3] = { Random(0.0f, 10.0f), Random(0.0f, 10.0f), Random(0.0f, 10.0f) };
+		const float center[3] = { Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-100.0f, 100.0f) };
+		inputs.boxMin.x[i] = center[0] - extent[0];
+		inputs.boxMin.y[i] = center[1] - extent[1];
+		inputs.boxMin.z[i] = center[2] - extent[2];
+		inputs.boxMax.x[i] = center[0] + extent[0];
+		inputs.boxMax.y[i] = center[1] + extent[1];
+		inputs.boxMax.z[i] = center[2] + extent[2];
+	}
+	StreamInputs& in = inputs;
+	Float3Array out(STREAM_NUM);
+	Float3Array outMax(STREAM_NUM);
+
+	const char* levelNames[] = { "baseline", "AVX2", "AVX-512" };
+	for (uint32_t level = 0; level <= static_cast<uint32_t>(BatchTransform::GetSupportedSIMDLevel()); ++level)
+	{
+		BatchTransform::SetSIMDLevel(static_cast<SIMDLevel>(level));
+		std::string name = std::string("points / BatchTransform ") + levelNames[level];
+		RunStream(name.c_str(), args, out, outMax,
+			[&](uint32_t num) { BatchTransform::TransformPoints(in.matrix, in.points.Stream(), out.Stream(), num); },
+			[&](uint32_t i) { return TransformError(in.matrix, in.points, out, i, 1.0); });
+
+		name = std::string("normals / BatchTransform ") + levelNames[level];
+		RunStream(name.c_str(), args, out, outMax,
+			[&](uint32_t num) { BatchTransform::TransformNormals(in.normalMatrix, in.normals.Stream(), out.Stream(), num); },
+			[&](uint32_t i) { return TransformError(in.normalMatrix, in.normals, out, i, 0.0); });
+
+		name = std::string("boxes one matrix / BatchTransform ") + levelNames[level];
+		RunStream(name.c_str(), args, out, outMax,
+			[&](uint32_t num) { BatchTransform::TransformAABBs(in.matrix, in.boxMin.Stream(), in.boxMax.Stream(), out.Stream(), outMax.Stream(), num); },
+			[&](uint32_t i) { return AABBError(in.matrix, in, out, outMax, i); });
+
+		name = std::string("boxes matrix per box / BatchTransform ") + levelNames[level];
+		RunStream(name.c_str(), args, out, outMax,
+			[&](uint32_t num) { BatchTransform::TransformAABBs(in.matrices.data(), in.boxMin.Stream(), in.boxMax.Stream(), out.Stream(), outMax.Stream(), num); },
+			[&](uint32_t i) { return AABBError(in.matrices[i], in, out, outMax, i); });
+	}
+	BatchTransform::SetSIMDLevel(BatchTransform::GetSupportedSIMDLevel());
+	s_fChecksum = out.x[STREAM_NUM - 1] + outMax.x[STREAM_NUM - 1];
+}
+
+}
+
+void RunMatrixBenchmark(const BenchmarkArgs& args)
+{
+	srand(1);
+	Inputs inputs;
+	for (uint32_t i = 0; i < MATRIX_NUM; ++i)
+	{
+		inputs.affine.push_back(RandomAffine(0.5f, 2.0f));
+		inputs.rigid.push_back(RandomAffine(1.0f, 1.0f));
+		inputs.parent.push_back(RandomAffine(0.5f, 2.0f));
+	}
+	const Inputs& in = inputs;
+
+	ReportHeader("matrix");
+
+	auto multiplyReference = [&](uint32_t i) { return Multiply(ToDouble(in.affine[i]), ToDouble(in.parent[i])); };
+#if DE_SIMD_SSE
+	Run("multiply / _mm_dp_ps (before)", args, [&](uint32_t i) { return MultiplyDotProduct(in.affine[i], in.parent[i]); }, multiplyReference);
+#endif
+#if DE_SIMD_AVX2
+	Run("multiply / operator* AVX2 two rows", args, [&](uint32_t i) { return in.affine[i] * in.parent[i]; }, multiplyReference);
+#else
+	Run("multiply / operator* broadcast", args, [&](uint32_t i) { return in.affine[i] * in.parent[i]; }, multiplyReference);
+#endif
+
+	const char* levelNames[] = { "baseline", "AVX2", "AVX-512" };
+	std::vector<Matrix4> out(MATRIX_NUM);
+	for (uint32_t level = 0; level <= static_cast<uint32_t>(BatchTransform::GetSupportedSIMDLevel()); ++level)
+	{
+		BatchTransform::SetSIMDLevel(static_cast<SIMDLevel>(level));
+		const std::string name = std::string("multiply / BatchTransform ") + levelNames[level];
+		RunBatch(name.c_str(), args, inputs, out);
+	}
+	BatchTransform::SetSIMDLevel(BatchTransform::GetSupportedSIMDLevel());
+
+	auto affineInverse = [&](uint32_t i) { return Inverse(ToDouble(in.affine[i])); };
+	Run("inverse affine / Inverse (before)", args, [&](uint32_t i) { return in.affine[i].Inverse(); }, affineInverse);
+	Run("inverse affine / InverseAffine", args, [&](uint32_t i) { return in.affine[i].InverseAffine(); }, affineInverse);
+
+	auto rigidInverse = [&](uint32_t i) { return Inverse(ToDouble(in.rigid[i])); };
+	Run("inverse rigid / Inverse (before)", args, [&](uint32_t i) { return in.rigid[i].Inverse(); }, rigidInverse);
+	Run("inverse rigid / InverseRigid", args, [&](uint32_t i) { return in.rigid[i].InverseRigid(); }, rigidInverse);
+
+	// the old path also carried the translation into the last column, only the 3x3 is compared
+	auto normalReference = [&](uint32_t i) { return NormalMatrix(ToDouble(in.affine[i])); };
+	Run("normal matrix / Inverse().Transpose() (before)", args, [&](uint32_t i)
+	{
+		Matrix4 result = in.affine[i].Inverse().Transpose();
+		float* pRaw = result.Raw();
+		pRaw[3] = pRaw[7] = pRaw[11] = 0.0f;
+		return result;
+	}, normalReference);
+	Run("normal matrix / NormalMatrix", args, [&](uint32_t i) { return in.affine[i].NormalMatrix(); }, normalReference);
+
+	RunStreams(args);
+}
@@ -0,0 +1,267 @@
+// RingBufferBenchmark.cpp: producer/consumer throughput of the lock-free ring buffers against a mutex queue
+//
+// Producers push a fixed number of items each and consumers pop until every item is seen,
+// single items or batches of BATCH_SIZE. A pattern is run twice per queue: once moving
+// plain counters for items/sec, once moving the enqueue timestamp so the consumer records
+// the handoff latency of every item
+
+#include "Benchmark.h"
+
+#include <DECore/Container/RingBuffer.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+
+using namespace DE;
+
+namespace
+{
+
+constexpr uint32_t QUEUE_CAPACITY = 1024;
+constexpr uint32_t BATCH_SIZE = 32;
+
+/** @brief The same ring under one mutex, the way RenderDevice used to collect command lists */
+template <class T, uint32_t Capacity>
+class MutexRingBuffer
+{
+public:
+	bool TryEnqueue(const T& item)
+	{
+		return EnqueueBatch(&item, 1) == 1;
+	}
+
+	uint32_t EnqueueBatch(const T* pItems, uint32_t num)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		const uint32_t space = Capacity - (m_iTail - m_iHead);
+		num = num < space ? num : space;
+		for (uint32_t i = 0; i < num; ++i)
+		{
+			m_Items[(m_iTail + i) % Capacity] = pItems[i];
+		}
+		m_iTail += num;
+		return num;
+	}
+
+	bool TryDequeue(T& item)
+	{
+		return DequeueBatch(&item, 1) == 1;
+	}
+
+	uint32_t DequeueBatch(T* pItems, uint32_t maxNum)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		const uint32_t available = m_iTail - m_iHead;
+		const uint32_t num = maxNum < available ? maxNum : available;
+		for (uint32_t i = 0; i < num; ++i)
+		{
+			pItems[i] = m_Items[(m_iHead + i) % Capacity];
+		}
+		m_iHead += num;
+		return num;
+	}
+
+private:
+	std::mutex m_Mutex;
+	T m_Items[Capacity];
+	uint32_t m_iHead = 0;
+	uint32_t m_iTail = 0;
+};
+
+struct SPSCQueue
+{
+	static constexpr const char* NAME = "spsc";
+	static constexpr bool bMultiProducer = false;
+	using Type = SPSCRingBuffer<uint64_t, QUEUE_CAPACITY>;
+};
+
+struct MPMCQueue
+{
+	static constexpr const char* NAME = "mpmc";
+	static constexpr bool bMultiProducer = true;
+	using Type = MPMCRingBuffer<uint64_t, QUEUE_CAPACITY>;
+};
+
+struct MutexQueue
+{
+	static constexpr const char* NAME = "mutex";
+	static constexpr bool bMultiProducer = true;
+	using Type = MutexRingBuffer<uint64_t, QUEUE_CAPACITY>;
+};
+
+struct Pattern
+{
+	std::string name;
+	uint32_t producerNum;
+	uint32_t consumerNum;
+	uint32_t itemNum;		// per producer
+	bool bBatch;
+};
+
+template <typename Queue, bool bTimed>
+void Produce(typename Queue::Type& queue, const Pattern& pattern)
+{
+	uint64_t items[BATCH_SIZE];
+	uint32_t sent = 0;
+	while (sent < pattern.itemNum)
+	{
+		if (pattern.bBatch)
+		{
+			const uint32_t remain = pattern.itemNum - sent;
+			const uint32_t num = remain < BATCH_SIZE ? remain : BATCH_SIZE;
+			for (uint32_t i = 0; i < num; ++i)
+			{
+				items[i] = bTimed ? NowNs() : sent + i;
+			}
+			uint32_t queued = 0;
+			while (queued < num)
+			{
+				const uint32_t n = queue.EnqueueBatch(items + queued, num - queued);
+				if (n == 0)
+				{
+					std::this_thread::yield();
+				}
+				queued += n;
+			}
+			sent += num;
+		}
+		else
+		{
+			const uint64_t item = bTimed ? NowNs() : sent;
+			while (!queue.TryEnqueue(item))
+			{
+				std::this_thread::yield();
+			}
+			sent++;
+		}
+	}
+}
+
+template <typename Queue, bool bTimed>
+void Consume(typename Queue::Type& queue, const Pattern& pattern, std::atomic<uint64_t>& remainNum, LatencyRecorder& latency)
+{
+	uint64_t items[BATCH_SIZE];
+	while (remainNum.load(std::memory_order_relaxed) > 0)
+	{
+		const uint32_t num = pattern.bBatch ? queue.DequeueBatch(items, BATCH_SIZE) : (queue.TryDequeue(items[0]) ? 1 : 0);
+		if (num == 0)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		if (bTimed)
+		{
+			const uint64_t now = NowNs();
+			for (uint32_t i = 0; i < num; ++i)
+			{
+				latency.Record(now - items[i]);
+			}
+		}
+		remainNum.fetch_sub(num, std::memory_order_relaxed);
+	}
+}
+
+/** @brief Run producers and consumers on their own threads from a common start, return the wall time in seconds */
+template <typename Queue, bool bTimed>
+double RunQueue(const Pattern& pattern, std::vector<LatencyRecorder>& latencies)
+{
+	std::unique_ptr<typename Queue::Type> pQueue(new typename Queue::Type());
+	const uint64_t itemNum = static_cast<uint64_t>(pattern.itemNum) * pattern.producerNum;
+	std::atomic<uint64_t> remainNum(itemNum);
+	latencies.resize(pattern.consumerNum);
+	if (bTimed)
+	{
+		for (LatencyRecorder& latency : latencies)
+		{
+			latency.Reserve(itemNum);
+		}
+	}
+
+	const uint32_t threadNum = pattern.producerNum + pattern.consumerNum;
+	std::atomic<uint32_t> readyNum(0);
+	std::atomic<bool> bStart(false);
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < threadNum; ++i)
+	{
+		threads.emplace_back([&, i]()
+		{
+			readyNum++;
+			while (!bStart)
+			{
+				std::this_thread::yield();
+			}
+			if (i < pattern.producerNum)
+			{
+				Produce<Queue, bTimed>(*pQueue, pattern);
+			}
+			else
+			{
+				Consume<Queue, bTimed>(*pQueue, pattern, remainNum, latencies[i - pattern.producerNum]);
+			}
+		});
+	}
+	while (readyNum != threadNum)
+	{
+		std::this_thread::yield();
+	}
+
+	const uint64_t start = NowNs();
+	bStart = true;
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	const uint64_t end = NowNs();
+	return (end - start) * 1e-9;
+}
+
+template <typename Queue>
+void RunPattern(const Pattern& pattern)
+{
+	if (!Queue::bMultiProducer && (pattern.producerNum > 1 || pattern.consumerNum > 1))
+	{
+		return;
+	}
+
+	std::vector<LatencyRecorder> latencies;
+	const double seconds = RunQueue<Queue, false>(pattern, latencies);
+	latencies.clear();
+	RunQueue<Queue, true>(pattern, latencies);
+
+	const uint64_t itemNum = static_cast<uint64_t>(pattern.itemNum) * pattern.producerNum;
+	LatencyRecorder latency;
+	latency.Reserve(itemNum);
+	for (const LatencyRecorder& consumer : latencies)
+	{
+		latency.Merge(consumer);
+	}
+
+	const std::string name = pattern.name + " / " + Queue::NAME;
+	Report(name.c_str(), itemNum, seconds, latency, "latency is enqueue to dequeue");
+}
+
+}
+
+void RunRingBufferBenchmark(const BenchmarkArgs& args)
+{
+	const uint32_t half = args.threadNum / 2 > 2 ? args.threadNum / 2 : 2;
+	const std::string contended = std::to_string(half) + "P" + std::to_string(half) + "C";
+
+	std::vector<Pattern> patterns;
+	patterns.push_back({ "1P1C single", 1, 1, 2000000 * args.scale, false });
+	patterns.push_back({ "1P1C batch " + std::to_string(BATCH_SIZE), 1, 1, 2000000 * args.scale, true });
+	patterns.push_back({ contended + " single", half, half, 500000 * args.scale, false });
+	patterns.push_back({ contended + " batch " + std::to_string(BATCH_SIZE), half, half, 500000 * args.scale, true });
+
+	ReportHeader("ringbuffer");
+	for (const Pattern& pattern : patterns)
+	{
+		RunPattern<SPSCQueue>(pattern);
+		RunPattern<MPMCQueue>(pattern);
+		RunPattern<MutexQueue>(pattern);
+	}
+}
@@ -0,0 +1,25 @@
+-- DBenchmark
+project "DBenchmark"
+	location "Build"
+	kind "ConsoleApp"
+	defines {"_CRT_SECURE_NO_WARNINGS"}
+	includedirs { "../../DEngine/Source/", "../../DEngine/Source/DECore/" }
+	links { "DECore", "Psapi" }
+
+	files 
+	{ 
+		"**.h", 
+		"**.cpp",
+	}
+
+	filter "configurations:Debug"
+		defines { "DEBUG" }
+		targetdir "../Bin/Debug"
+		objdir "Intermediate/Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines { "NDEBUG" }
+		optimize "Full"
+		targetdir "../Bin/Release"
+		objdir "Intermediate/Release"
@@ -11,6 +11,8 @@
 
 #include "picojson.h"
 
+#include <DECore/Math/BoundingVolume.h>
+
 #include <sstream>
 #include <fstream>
 #include <iostream>
@@ -91,6 +93,8 @@ struct Mesh
 	std::vector<float2> uvs;
 	std::vector<uintfloat> weights;
 	std::vector<uint3> indices;
+	DE::AABB aabb;
+	DE::Sphere sphere;
 
 	std::string materialName;
 };
@@ -273,6 +277,14 @@ void ProcessMesh(const aiMesh* mesh, const aiScene *scene, std::vector<Mesh>& ou
 		}
 	}
 
+	if (!outMesh.vertices.empty())
+	{
+		const float* positions = &outMesh.vertices[0].x;
+		const uint32_t num = static_cast<uint32_t>(outMesh.vertices.size());
+		outMesh.aabb = DE::AABB::FromPoints(positions, num);
+		outMesh.sphere = DE::Sphere::FromPoints(positions, num);
+	}
+
 	for (uint32_t i = 0; i < mesh->mNumFaces; i++)
 	{
 		uint3 index;
@@ -444,6 +456,20 @@ void Export(const std::vector<Mesh>& meshes, const char* path)
 		}
 		fout.close();
 
+		// bounds
+		if (!mesh.vertices.empty())
+		{
+			sprintf_s(fileOut, "%s\\Models\\%s.bounds", path, mesh.name.c_str());
+			fout.open(fileOut, std::fstream::out);
+			const DE::Vector3& min = mesh.aabb.GetMin();
+			const DE::Vector3& max = mesh.aabb.GetMax();
+			const DE::Vector3 center = mesh.sphere.GetCenter();
+			fout << min.GetX() << " " << min.GetY() << " " << min.GetZ() << std::endl;
+			fout << max.GetX() << " " << max.GetY() << " " << max.GetZ() << std::endl;
+			fout << center.GetX() << " " << center.GetY() << " " << center.GetZ() << " " << mesh.sphere.GetRadius() << std::endl;
+			fout.close();
+		}
+
 		// material
 		sprintf_s(fileOut, "%s\\Models\\%s.mate", path, mesh.name.c_str());
 		fout.open(fileOut, std::fstream::out);
@@ -7,13 +7,14 @@ project "DExporter"
 	systemversion "10.0.19041.0"
 
 	defines {"_CRT_SECURE_NO_WARNINGS"}
-	includedirs { "../External/Assimp/include/" }
+	includedirs { "../External/Assimp/include/", "../../DEngine/Source/" }
 	links { "../External/Assimp/lib/Release/assimp-vc143-mt.lib" }
 
 	files 
 	{ 
 		"**.h", 
 		"**.cpp",
+		"../../DEngine/Source/DECore/Math/BoundingVolume.cpp",
 	}
 
 	filter "configurations:Debug"
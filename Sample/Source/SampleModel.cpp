@@ -1,5 +1,6 @@
 // Engine
 #include <DECore/FileSystem/FileLoader.h>
+#include <DECore/Memory/MemoryManager.h>
 #include <DERendering/DataType/GraphicsDataType.h>
 #include <DERendering/DataType/LightType.h>
 #include <DERendering/Imgui/imgui.h>
@@ -21,12 +22,12 @@ void SampleModel::Setup(Renderer* renderer)
 	for (uint32_t i = 0; i < 8; ++i)
 	{
 		auto& light = PointLight::Create();
-		scene.Add(light);
 		light.position = float3{ -16.0f + i * 4, 5.0f, 0.0f };
 		light.color = float3{ static_cast<float>(i % 2), 1.0f, 1.0f };
 		light.falloffRadius = 3.0f;
 		light.intensity = 10.0f;
 		light.enable = true;
+		scene.Add(light);
 
 		Mesh& mesh = Mesh::Create();
 		light.debugMesh = mesh.Index();
@@ -46,7 +47,6 @@ void SampleModel::Setup(Renderer* renderer)
 	}
 	{
 		QuadLight& light = QuadLight::Create();
-		scene.Add(light);
 		light.position = float3{ 0.0f, 3.0f, 5.0f };
 		light.width = 4.0f;
 		light.height = 4.0f;
@@ -54,6 +54,7 @@ void SampleModel::Setup(Renderer* renderer)
 		light.intensity = 1.0f;
 		light.enable = true;
 		light.falloffRadius = 100.0f;
+		scene.Add(light);
 
 		Mesh& mesh = Mesh::Create();
 		light.mesh = mesh.Index();
@@ -115,6 +116,19 @@ void SampleModel::SetupUI(float dt)
 	ImGui::Text("frame/second: %.4f", 1.0f / dt);
 	ImGui::Text("resize: disabled");
 	ImGui::Text("Hold Mouse Right & WASD to move");
+	for (MemoryTag tag : { MemoryTag::Texture, MemoryTag::Mesh, MemoryTag::FrameData })
+	{
+		const BudgetStatus status = MemoryManager::GetInstance()->GetBudgetStatus(tag);
+		ImGui::Text("%s: %.1f / %.1f MB%s", MEMORY_TAG_NAMES[static_cast<uint32_t>(tag)], status.iCurrentBytes / (1024.0f * 1024.0f), status.iBudgetBytes / (1024.0f * 1024.0f), status.bWarning ? " (near budget)" : "");
+	}
+	if (m_pRenderer->GetFrameData().droppedLightNum > 0)
+	{
+		ImGui::Text("lights dropped: %u, only the nearest %u point and %u quad lights are shaded", m_pRenderer->GetFrameData().droppedLightNum, MAX_POINT_LIGHT_NUM, MAX_QUAD_LIGHT_NUM);
+	}
+	if (ImGui::Button("Dump memory statistics"))
+	{
+		MemoryManager::GetInstance()->DumpStatistics("MemoryStatistics.json");
+	}
 	ImGui::End();
 
 	auto& scene = m_pRenderer->GetScene();
@@ -159,6 +173,7 @@ void SampleModel::SetupUI(float dt)
 				Mesh& mesh = Mesh::Get(light.debugMesh);
 				mesh.translate = light.position;
 				mesh.scale = light.falloffRadius;
+				scene.Move(light);
 			}
 		});
 		if (ImGui::Button("All debug shape ON"))
@@ -206,6 +221,7 @@ void SampleModel::SetupUI(float dt)
 				mesh.m_Vertices.Update(vertices, sizeof(vertices));
 				Material& material = Material::Get(mesh.m_MaterialID);
 				material.albedo = float3{ light.intensity, light.intensity, light.intensity };
+				scene.Move(light);
 				ImGui::TreePop();
 			}
 		});
@@ -52,7 +52,7 @@ LRESULT WINAPI MsgProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 // Name: wWinMain()
 // Desc: The application's entry point
 //-----------------------------------------------------------------------------
-INT WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, INT)
+INT WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR lpCmdLine, INT)
 {
 	constexpr uint32_t WINDOW_WIDTH = 1024;
 	constexpr uint32_t WINDOW_HEIGHT = 768;
@@ -97,6 +97,16 @@ INT WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, INT)
 
 	// Memory
 	MemoryManager::GetInstance()->ConstructDefaultPool();
+	MemoryManager::GetInstance()->SetBudget(MemoryTag::Texture, 1024ull * 1024 * 1024);
+	MemoryManager::GetInstance()->SetBudget(MemoryTag::Mesh, 512ull * 1024 * 1024);
+	MemoryManager::GetInstance()->SetBudget(MemoryTag::FrameData, 64ull * 1024 * 1024);
+
+	// -memorytrace records every allocation for replay in DBenchmark
+	const bool bMemoryTrace = wcsstr(lpCmdLine, L"-memorytrace") != nullptr;
+	if (bMemoryTrace)
+	{
+		MemoryManager::GetInstance()->BeginTrace();
+	}
 
 	SYSTEM_INFO sysInfo;
 	GetSystemInfo(&sysInfo);
@@ -125,6 +135,9 @@ INT WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, INT)
 	float elaspedTime = 0.0f;
 	auto start = std::chrono::high_resolution_clock::now();
 
+	// Memory defragmentation runs between frames
+	const float DEFRAGMENT_BUDGET_MS = 0.5f;
+
 	// Main loop
 	bool bQuit = false;
 	while (!bQuit)
@@ -162,6 +175,9 @@ INT WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, INT)
 			renderer->Update(elaspedTime);
 			renderer->Render();
 
+			// Render() waited for the GPU and its jobs, nothing reads movable memory until the next frame
+			MemoryManager::GetInstance()->Defragment(DEFRAGMENT_BUDGET_MS);
+
 			elaspedTime = 0.0f;
 			start = end;
 
@@ -181,6 +197,11 @@ INT WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, INT)
 	renderer = nullptr;
 
 	JobScheduler::Instance()->ShutDown();
+	if (bMemoryTrace)
+	{
+		MemoryManager::GetInstance()->EndTrace("MemoryTrace.bin");
+	}
+	MemoryManager::GetInstance()->DumpStatistics("MemoryStatistics.json");
 	MemoryManager::GetInstance()->Destruct();
 
 	UnregisterClass(wc.lpszClassName, wc.hInstance);
@@ -9,8 +9,9 @@ workspace "Sample"
 	platforms { "x64" }
 	systemversion "10.0.19041.0"
 	
--- DEngine
+-- DTools
 include("../DTools/DExporter/premake5.lua")
+include("../DTools/DBenchmark/premake5.lua")
 
 -- DEngine
 include("../DEngine/premake5.lua")